@@ -0,0 +1,56 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// Compiles the text video traces of a directory (all resolutions and
+// bitrates) into the binary trace file the trace-based codecs memory-map
+// at startup:
+//
+//   ./waf --run "bbr-compile-traces --dir=src/bbr/model/videocodecs/video_traces/chat_firefox_h264"
+//
+// Run it again whenever the text traces change.
+
+#include "ns3/core-module.h"
+#include "ns3/video-codecs.h"
+
+#include <iostream>
+#include <string>
+
+using namespace ns3;
+
+int main(int argc, char *argv[])
+{
+    std::string dir = "src/bbr/model/videocodecs/video_traces/chat_firefox_h264";
+    std::string prefix = "chat";
+    std::string out;
+
+    CommandLine cmd;
+    cmd.AddValue("dir", "Directory of the text trace files", dir);
+    cmd.AddValue("prefix", "File name prefix of the text trace files", prefix);
+    cmd.AddValue("out", "Binary trace file (default: <dir>/<prefix>" BINARY_TRACE_SUFFIX ")", out);
+    cmd.Parse(argc, argv);
+
+    if (out.empty())
+    {
+        out = dir + "/" + prefix + BINARY_TRACE_SUFFIX;
+    }
+    if (!VideoCodecs::TraceStore::compile(dir, prefix, out))
+    {
+        std::cerr << "Cannot compile traces " << dir << "/" << prefix << "_* into " << out << std::endl;
+        return 1;
+    }
+    std::cout << "Compiled traces " << dir << "/" << prefix << "_* into " << out << std::endl;
+    return 0;
+}
@@ -56,6 +56,9 @@ static const float kDuration = 60.0f;
 static const float kClientStart = kServerStart + 1.0;
 static const float kClientStop = kClientStart + kDuration;
 static const float kServerStop = kClientStop + 1.0;
+// Traces given to the flows in turn with --traceFamily=Mixed.
+static const char *const kMixedTraceFamilies[] = {"Chat", "BigBuckBunny", "Foreman", "ElephantsDream",
+                                                  "News", "Suzie", "Concat"};
 
 
 NodeContainer linkNodes;
@@ -170,6 +173,16 @@ int main(int argc, char *argv[])
     int users = 1;
     bool useDropTailQueue = false;
     std::string queueSize = "0MB";
+    uint32_t layers = 1;
+    bool simulcast = false;
+    bool audio = false;
+    uint64_t dataBytes = 0;
+    std::string traceFamily = "Chat";
+    bool randomTraceStart = true;
+    std::string keyFrameShaping = "Unshaped";
+    std::string codec = "Trace";
+    uint32_t gopSize = 0;
+    uint32_t gopBFrames = 0;
 
     int useLte = 0;
     std::string modeStr = "point-to-point";
@@ -188,6 +201,16 @@ int main(int argc, char *argv[])
     cmd.AddValue("users", "Tell which test case", users);
     cmd.AddValue("queueSize", "Tell the DropTailQueue size of test case 2", queueSize);
     cmd.AddValue("mode", "Using LTE module(LTE, wifi, p2p)", modeStr);
+    cmd.AddValue("layers", "Video layers of each frame", layers);
+    cmd.AddValue("simulcast", "Send simulcast rather than SVC layers", simulcast);
+    cmd.AddValue("audio", "Send an audio stream along with the video", audio);
+    cmd.AddValue("dataBytes", "Size of a bulk data stream sent along with the video", dataBytes);
+    cmd.AddValue("traceFamily", "Video traces of the flows, or Mixed for different ones per flow", traceFamily);
+    cmd.AddValue("randomTraceStart", "Start the video traces of each flow at a random frame", randomTraceStart);
+    cmd.AddValue("keyFrameShaping", "Keyframe shaping: Unshaped, Spread or IntraRefresh", keyFrameShaping);
+    cmd.AddValue("codec", "Video codec: Trace, or Gop for the GOP-structured clip", codec);
+    cmd.AddValue("gopSize", "Keyframe interval in frames of the Gop codec, 0 for the clip's", gopSize);
+    cmd.AddValue("gopBFrames", "B-frames between anchors of the Gop codec", gopBFrames);
 
     cmd.Parse(argc, argv);
 
@@ -328,6 +351,18 @@ int main(int argc, char *argv[])
         bbrClient.SetAttribute("Duration", TimeValue(Seconds(0)));
         bbrClient.SetAttribute("DataRate", DataRateValue(DataRate("1.0Mb/s")));
         bbrClient.SetAttribute("PacketSize", UintegerValue(1024));
+        bbrClient.SetAttribute("VideoLayers", UintegerValue(layers));
+        bbrClient.SetAttribute("LayerMode", StringValue(simulcast ? "Simulcast" : "Svc"));
+        bbrClient.SetAttribute("AudioStream", BooleanValue(audio));
+        bbrClient.SetAttribute("DataStreamBytes", UintegerValue(dataBytes));
+        const size_t numMixed = sizeof(kMixedTraceFamilies) / sizeof(kMixedTraceFamilies[0]);
+        bbrClient.SetAttribute("TraceFamily",
+                               StringValue(traceFamily == "Mixed" ? kMixedTraceFamilies[i % numMixed] : traceFamily));
+        bbrClient.SetAttribute("RandomTraceStart", BooleanValue(randomTraceStart));
+        bbrClient.SetAttribute("KeyFrameShaping", StringValue(keyFrameShaping));
+        bbrClient.SetAttribute("VideoCodec", StringValue(codec));
+        bbrClient.SetAttribute("GopSize", UintegerValue(gopSize));
+        bbrClient.SetAttribute("GopBFrames", UintegerValue(gopBFrames));
 
         ApplicationContainer clientApp = bbrClient.Install(linkNodes.Get(0));
         clientApp.Start(Seconds(kClientStart + i * 20));
@@ -7,6 +7,7 @@
 #include <algorithm>
 #include "ns3/core-module.h"
 #include "ack-frame.h"
+#include "varint.h"
 
 namespace ns3
 {
@@ -44,15 +45,23 @@ bool IsAwaitingPacket(const AckFrame &ack_frame,
 const PacketType AckFrame::m_type = kAckPacket;
 
 AckFrame::AckFrame()
-    : largest_observed(0), ack_delay_time(INFINITETIME), last_update_time(0) {}
+    : connection_id(0),
+      largest_observed(0),
+      ack_delay_time(INFINITETIME),
+      ack_delay_exponent(kDefaultAckDelayExponent),
+      last_update_time(0),
+      delivery_rate(Bandwidth::Zero()) {}
 
 AckFrame::AckFrame(const AckFrame &other) = default;
 
+AckFrame &AckFrame::operator=(const AckFrame &other) = default;
+
 AckFrame::~AckFrame() {}
 
 std::ostream &operator<<(std::ostream &os, const AckFrame &ack_frame)
 {
-    os << "{ largest_observed: " << ack_frame.largest_observed
+    os << "{ connection_id: " << ack_frame.connection_id
+       << ", largest_observed: " << ack_frame.largest_observed
        << ", ack_delay_time: " << ack_frame.ack_delay_time
        << ", last_update_time: " << ack_frame.last_update_time
        << ", packets: [ " << ack_frame.packets << " ]"
@@ -62,7 +71,12 @@ std::ostream &operator<<(std::ostream &os, const AckFrame &ack_frame)
     {
         os << p.first << " at " << p.second << " ";
     }
-    os << " ] }";
+    os << " ], recovered_packets: [ ";
+    for (PacketNumber packet_number : ack_frame.recovered_packets)
+    {
+        os << packet_number << " ";
+    }
+    os << " ], delivery_rate: " << ack_frame.delivery_rate.ToDebugValue() << " }";
     return os;
 }
 PacketNumberQueue::PacketNumberQueue() {}
@@ -375,66 +389,113 @@ void AckFrame::Print(std::ostream &os) const
     os << this;
 }
 
-uint32_t AckFrame::GetSerializedSize(void) const
+namespace
+{
+// Sent instead of the ack delay when it is unknown.
+const uint64_t kUnknownAckDelay = kVarIntMax;
+
+uint64_t EncodeAckDelay(uint64_t ack_delay_time, uint8_t exponent)
 {
-    return 1 + 8 + 2 + 1 + 2 + std::min(int(packets.NumIntervals() - 1), 255) * 4 
-             + 1 + 8 + 4 * received_packet_times.size();
+    if (ack_delay_time == INFINITETIME)
+    {
+        return kUnknownAckDelay;
+    }
+    return std::min(kUnknownAckDelay - 1, ack_delay_time >> exponent);
+}
 }
 
-void AckFrame::Serialize(Buffer::Iterator start) const
+uint32_t AckFrame::GetSerializedSize(void) const
 {
-    Buffer::Iterator i = start;
-    i.WriteU8(m_type);
-    i.WriteHtonU64(largest_observed);
-    NS_ASSERT_MSG(ack_delay_time < 0xFFFF, "ack_delay_time invalid " << ack_delay_time);
-    i.WriteHtonU16(ack_delay_time);
-    
-    NS_ASSERT_MSG(packets.NumIntervals() > 0, "empty ack blocks");
-    if (packets.NumIntervals() > 256)
+    NS_ASSERT_MSG(!packets.Empty(), "empty ack blocks");
+    uint32_t size = 2 * sizeof(uint8_t) + GetVarIntLength(connection_id) +
+                    GetVarIntLength(largest_observed) +
+                    GetVarIntLength(EncodeAckDelay(ack_delay_time, ack_delay_exponent)) +
+                    GetVarIntLength(packets.NumIntervals() - 1);
+    PacketNumber smallest = largest_observed + 1;
+    for (auto it = packets.rbegin(); it != packets.rend(); ++it)
     {
-        NS_LOG_WARN("ack blocks " << packets.NumIntervals() << " > 255");
+        if (it == packets.rbegin())
+        {
+            size += GetVarIntLength(largest_observed - it->min());
+        }
+        else
+        {
+            size += GetVarIntLength(smallest - it->max() - 1) + GetVarIntLength(it->Length() - 1);
+        }
+        smallest = it->min();
     }
-    int max_num_ack_blocks = std::min(PacketNumber(255), packets.NumIntervals() - 1);
-    i.WriteU8(max_num_ack_blocks);
-    // First ack block
-    i.WriteHtonU16(packets.LastIntervalLength());
-    // Remaining ack blocks
-    auto iter0 = packets.rbegin();
-    int num_ack_blocks_written = 0;
-    uint16_t delta_seq;
-    for (; iter0 != packets.rend() && num_ack_blocks_written < max_num_ack_blocks; ++iter0)
+
+    size += GetVarIntLength(received_packet_times.size());
+    if (!received_packet_times.empty())
     {
-        delta_seq = largest_observed - iter0->min();
-        i.WriteHtonU16(delta_seq);
-        i.WriteHtonU16(iter0->Length());
-        num_ack_blocks_written++;
+        size += GetVarIntLength(last_update_time);
+        for (const auto &p : received_packet_times)
+        {
+            size += GetVarIntLength(largest_observed - p.first) + GetVarIntLength(last_update_time - p.second);
+        }
     }
 
-    // Append Timestamps
-    NS_ASSERT(received_packet_times.size() <= std::numeric_limits<uint8_t>::max());
+    size += GetVarIntLength(recovered_packets.size());
+    for (PacketNumber recovered : recovered_packets)
+    {
+        size += GetVarIntLength(largest_observed - recovered);
+    }
 
-    uint8_t num_received_packets = received_packet_times.size();
+    size += GetVarIntLength(delivery_rate.ToBytesPerSecond());
+    return size;
+}
 
-    i.WriteU8(num_received_packets);
-    if (num_received_packets == 0)
+void AckFrame::Serialize(Buffer::Iterator start) const
+{
+    // Ranges are written from the largest down, each as the gap below the
+    // previous one and its length, as in the QUIC ACK frame (RFC 9000,
+    // section 19.3).
+    NS_ASSERT_MSG(!packets.Empty(), "empty ack blocks");
+    NS_ASSERT_MSG(packets.Max() == largest_observed,
+                  "largest observed " << largest_observed << " not acked");
+    Buffer::Iterator i = start;
+    i.WriteU8(m_type);
+    WriteVarInt(i, connection_id);
+    WriteVarInt(i, largest_observed);
+    i.WriteU8(ack_delay_exponent);
+    WriteVarInt(i, EncodeAckDelay(ack_delay_time, ack_delay_exponent));
+
+    WriteVarInt(i, packets.NumIntervals() - 1);
+    PacketNumber smallest = largest_observed + 1;
+    for (auto it = packets.rbegin(); it != packets.rend(); ++it)
     {
-        return;
+        if (it == packets.rbegin())
+        {
+            WriteVarInt(i, largest_observed - it->min());
+        }
+        else
+        {
+            // Gaps are at least one packet long.
+            WriteVarInt(i, smallest - it->max() - 1);
+            WriteVarInt(i, it->Length() - 1);
+        }
+        smallest = it->min();
     }
-    i.WriteHtonU64(last_update_time);
 
-    PacketTimeVector::const_iterator iter = received_packet_times.begin();
-    PacketNumber packet_number;
-    uint16_t delta_from_largest_observed;
-    uint16_t delta_time;
+    WriteVarInt(i, received_packet_times.size());
+    if (!received_packet_times.empty())
+    {
+        WriteVarInt(i, last_update_time);
+        for (const auto &p : received_packet_times)
+        {
+            WriteVarInt(i, largest_observed - p.first);
+            WriteVarInt(i, last_update_time - p.second);
+        }
+    }
 
-    for (; iter != received_packet_times.end(); ++iter)
+    WriteVarInt(i, recovered_packets.size());
+    for (PacketNumber recovered : recovered_packets)
     {
-        packet_number = iter->first;
-        delta_from_largest_observed = largest_observed - packet_number;
-        i.WriteHtonU16(delta_from_largest_observed);
-        delta_time = last_update_time - iter->second;
-        i.WriteHtonU16(delta_time);
+        WriteVarInt(i, largest_observed - recovered);
     }
+
+    // In bytes per second, zero when unknown.
+    WriteVarInt(i, delivery_rate.ToBytesPerSecond());
 }
 
 uint32_t AckFrame::Deserialize(Buffer::Iterator start)
@@ -442,40 +503,47 @@ uint32_t AckFrame::Deserialize(Buffer::Iterator start)
     Buffer::Iterator i = start;
     uint8_t type = i.ReadU8();
     NS_ASSERT(type == kAckPacket);
-    largest_observed = i.ReadNtohU64();
-    ack_delay_time = i.ReadNtohU16();
-    uint8_t num_ack_blocks = i.ReadU8();
-    uint16_t first_block_length = i.ReadNtohU16();
-    PacketNumber first_received =
-        largest_observed + 1 - first_block_length;
-    packets.Add(first_received, largest_observed + 1);
-
-    for (size_t k = 0; k < num_ack_blocks; ++k)
-    {
-        uint16_t delta_seq = i.ReadNtohU16();
-        uint16_t current_block_length = i.ReadNtohU16();
-        first_received = largest_observed - delta_seq;
-        if (current_block_length > 0)
-        {
-            packets.Add(first_received, first_received + current_block_length);
-        }
+    connection_id = ReadVarInt(i);
+    largest_observed = ReadVarInt(i);
+    ack_delay_exponent = i.ReadU8();
+    const uint64_t ack_delay = ReadVarInt(i);
+    ack_delay_time = ack_delay == kUnknownAckDelay
+                         ? INFINITETIME
+                         : ack_delay << ack_delay_exponent;
+
+    // Ranges arrive largest first, so each one goes to the front of
+    // |packets|.
+    uint64_t num_ranges = ReadVarInt(i);
+    PacketNumber smallest = largest_observed - ReadVarInt(i);
+    packets.Add(smallest, largest_observed + 1);
+    for (; num_ranges > 0; --num_ranges)
+    {
+        const PacketNumber largest = smallest - ReadVarInt(i) - 1;
+        smallest = largest - ReadVarInt(i) - 1;
+        packets.Add(smallest, largest);
     }
 
-    //read timestamps
-    uint8_t num_received_packets = i.ReadU8();
-    last_update_time = i.ReadNtohU64();
-    PacketNumber seq_num;
-    while (num_received_packets > 0)
+    uint64_t num_received_packets = ReadVarInt(i);
+    if (num_received_packets > 0)
     {
-        uint16_t delta_seq = i.ReadNtohU16();
-        seq_num = largest_observed - delta_seq;
-        uint64_t delta_time = i.ReadNtohU16();
-        received_packet_times.push_back(
-            std::make_pair(seq_num, delta_time));
-        num_received_packets--;
+        last_update_time = ReadVarInt(i);
     }
+    for (; num_received_packets > 0; --num_received_packets)
+    {
+        const PacketNumber packet_number = largest_observed - ReadVarInt(i);
+        const uint64_t receipt_time = last_update_time - ReadVarInt(i);
+        received_packet_times.push_back(std::make_pair(packet_number, receipt_time));
+    }
+
+    uint64_t num_recovered_packets = ReadVarInt(i);
+    for (; num_recovered_packets > 0; --num_recovered_packets)
+    {
+        recovered_packets.push_back(largest_observed - ReadVarInt(i));
+    }
+
+    delivery_rate = Bandwidth::FromBytesPerSecond(ReadVarInt(i));
 
-    return GetSerializedSize();
+    return i.GetDistanceFrom(start);
 }
 }
 }
\ No newline at end of file
@@ -13,6 +13,7 @@
 
 #include "ns3/header.h"
 
+#include "bandwidth.h"
 #include "interval.h"
 
 namespace ns3
@@ -207,6 +208,7 @@ class AckFrame : public Header
   public:
     AckFrame();
     AckFrame(const AckFrame &other);
+    AckFrame &operator=(const AckFrame &other);
     ~AckFrame();
 
     friend std::ostream &operator<<(
@@ -225,19 +227,32 @@ class AckFrame : public Header
     virtual void Serialize(Buffer::Iterator start) const;
     virtual uint32_t Deserialize(Buffer::Iterator start);
 
+    ConnectionId connection_id;
     // The highest packet number we've observed from the peer.
     PacketNumber largest_observed;
-    // Time elapsed since largest_observed was received until this Ack frame was sent.
+    // Time elapsed since largest_observed was received until this Ack frame was
+    // sent, in microseconds.
     uint64_t ack_delay_time;
+    // |ack_delay_time| is sent in units of 2^ack_delay_exponent microseconds.
+    uint8_t ack_delay_exponent;
 
+    // Time the frame was last updated, in microseconds.
     uint64_t last_update_time;
 
-    // Vector of <packet_number, time> for when packets arrived.
+    // Vector of <packet_number, time> for when packets arrived, in
+    // microseconds.
     PacketTimeVector received_packet_times;
 
     // Set of packets.
     PacketNumberQueue packets;
 
+    // Packets in |packets| which were restored from FEC repair packets
+    // rather than received, since the previous ack.
+    std::vector<PacketNumber> recovered_packets;
+
+    // Rate the receiver sees packets arrive at, zero if it has no estimate.
+    Bandwidth delivery_rate;
+
     static const PacketType m_type;
 };
 
@@ -0,0 +1,92 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2008 INRIA
+ *
+ * Author: daibo <daibo@yy.com>
+ */
+
+#include "ns3/core-module.h"
+
+#include "ack-frequency-frame.h"
+#include "varint.h"
+
+namespace ns3
+{
+namespace bbr
+{
+NS_LOG_COMPONENT_DEFINE("AckFrequencyFrame");
+
+const PacketType AckFrequencyFrame::m_type = kAckFrequencyPacket;
+
+AckFrequencyFrame::AckFrequencyFrame()
+    : connection_id(0),
+      sequence_number(0),
+      ack_eliciting_threshold(0),
+      max_ack_delay(0),
+      reordering_threshold(0)
+{
+}
+
+bool AckFrequencyFrame::SamePolicy(const AckFrequencyFrame &other) const
+{
+    return ack_eliciting_threshold == other.ack_eliciting_threshold &&
+           max_ack_delay == other.max_ack_delay &&
+           reordering_threshold == other.reordering_threshold;
+}
+
+TypeId AckFrequencyFrame::GetTypeId(void)
+{
+    static TypeId tid = TypeId("ns3::AckFrequencyFrame")
+                            .SetParent<Header>()
+                            .SetGroupName("Applications")
+                            .AddConstructor<AckFrequencyFrame>();
+    return tid;
+}
+
+TypeId AckFrequencyFrame::GetInstanceTypeId(void) const
+{
+    return GetTypeId();
+}
+
+void AckFrequencyFrame::Print(std::ostream &os) const
+{
+    os << "(seq=" << sequence_number
+       << " threshold=" << ack_eliciting_threshold
+       << " max_ack_delay=" << max_ack_delay
+       << " reordering=" << reordering_threshold << ")";
+}
+
+uint32_t AckFrequencyFrame::GetSerializedSize(void) const
+{
+    return sizeof(uint8_t) + GetVarIntLength(connection_id) + GetVarIntLength(sequence_number) +
+           GetVarIntLength(ack_eliciting_threshold) +
+           GetVarIntLength(max_ack_delay * kNumMicrosPerMilli) +
+           GetVarIntLength(reordering_threshold);
+}
+
+void AckFrequencyFrame::Serialize(Buffer::Iterator start) const
+{
+    Buffer::Iterator i = start;
+    i.WriteU8(m_type);
+    WriteVarInt(i, connection_id);
+    WriteVarInt(i, sequence_number);
+    WriteVarInt(i, ack_eliciting_threshold);
+    // Microseconds on the wire, as in QUIC.
+    WriteVarInt(i, max_ack_delay * kNumMicrosPerMilli);
+    WriteVarInt(i, reordering_threshold);
+}
+
+uint32_t AckFrequencyFrame::Deserialize(Buffer::Iterator start)
+{
+    Buffer::Iterator i = start;
+    uint8_t type = i.ReadU8();
+    NS_ASSERT(type == kAckFrequencyPacket);
+    connection_id = ReadVarInt(i);
+    sequence_number = ReadVarInt(i);
+    ack_eliciting_threshold = ReadVarInt(i);
+    max_ack_delay = ReadVarInt(i) / kNumMicrosPerMilli;
+    reordering_threshold = ReadVarInt(i);
+    return i.GetDistanceFrom(start);
+}
+}
+}
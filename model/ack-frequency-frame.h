@@ -0,0 +1,58 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2008 INRIA
+ *
+ * Author: daibo <daibo@yy.com>
+ */
+#ifndef ACK_FREQUENCY_FRAME_H
+#define ACK_FREQUENCY_FRAME_H
+
+#include "ns3/header.h"
+
+#include "bbr-common.h"
+
+namespace ns3
+{
+namespace bbr
+{
+// Sent by the sender to set the ack policy of the receiver, after the QUIC
+// ACK_FREQUENCY frame.  The receiver applies the request with the highest
+// sequence number as soon as it arrives.
+class AckFrequencyFrame : public Header
+{
+  public:
+    AckFrequencyFrame();
+    virtual ~AckFrequencyFrame() {}
+
+    // True if both frames request the same policy.
+    bool SamePolicy(const AckFrequencyFrame &other) const;
+
+    ConnectionId connection_id;
+    // Orders the requests; older ones are ignored.
+    uint64_t sequence_number;
+    // Packets received before an ack is sent without waiting for the delay.
+    PacketCount ack_eliciting_threshold;
+    // Longest an ack may be delayed, in ms.
+    uint64_t max_ack_delay;
+    // Sends an ack at once when a packet is missing this many packets below
+    // the largest received.  Zero disables it.
+    PacketCount reordering_threshold;
+
+    static const PacketType m_type;
+
+  public:
+    /**
+       * \brief Get the type ID.
+       * \return The object TypeId.
+       */
+    static TypeId GetTypeId(void);
+    virtual TypeId GetInstanceTypeId(void) const;
+    virtual void Print(std::ostream &os) const;
+    virtual uint32_t GetSerializedSize(void) const;
+    virtual void Serialize(Buffer::Iterator start) const;
+    virtual uint32_t Deserialize(Buffer::Iterator start);
+};
+}
+}
+
+#endif
@@ -5,12 +5,28 @@
  * Author: daibo <daibo@yy.com>
  */
 #include "bbr-common.h"
+#include "varint.h"
 
 namespace ns3
 {
 namespace bbr
 {
-
+ConnectionId PeekConnectionId(Ptr<Packet> packet)
+{
+    // The type byte and the longest varint.
+    uint8_t bytes[1 + sizeof(ConnectionId)];
+    const uint32_t size = packet->CopyData(bytes, sizeof(bytes));
+    if (size < 2)
+    {
+        return 0;
+    }
+    Buffer buffer;
+    buffer.AddAtStart(size);
+    buffer.Begin().Write(bytes, size);
+    Buffer::Iterator i = buffer.Begin();
+    i.ReadU8();
+    return ReadVarInt(i);
+}
 
 }
 }
\ No newline at end of file
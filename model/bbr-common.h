@@ -17,8 +17,6 @@ namespace ns3
 namespace bbr
 {
 
-const uint32_t kStopWaitingThreshold = 3;
-
 #define SEQ_LT(a, b) (int64_t((a) - (b)) < 0)
 #define SEQ_LE(a, b) (int64_t((a) - (b)) <= 0)
 #define SEQ_GT(a, b) (int64_t((a) - (b)) > 0)
@@ -51,6 +49,7 @@ enum LossDetectionType
   kTime,         // Time based loss detection.
   kAdaptiveTime, // Adaptive time based loss detection.
   kLazyFack,     // Nack based but with FACK disabled for the first ack.
+  kRack,         // Time based on the most recently delivered packet (RACK).
 };
 
 enum CongestionControlType
@@ -68,7 +67,8 @@ enum PacketType
   kPaddingPacket = 0,
   kStreamPacket,
   kAckPacket,
-  kStopWaiting,
+  kAckFrequencyPacket,
+  kNackPacket,
 };
 
 inline uint8_t PeekPackeType(Ptr<Packet> packet)
@@ -78,6 +78,9 @@ inline uint8_t PeekPackeType(Ptr<Packet> packet)
   return type;
 }
 
+// Every packet type is followed by the varint connection ID.
+ConnectionId PeekConnectionId(Ptr<Packet> packet);
+
 enum TransmissionType : int8_t {
   NOT_RETRANSMISSION,
   FIRST_TRANSMISSION_TYPE = NOT_RETRANSMISSION,
@@ -87,7 +90,8 @@ enum TransmissionType : int8_t {
   LOSS_RETRANSMISSION,         // Retransmits due to loss detection.
   RTO_RETRANSMISSION,          // Retransmits due to retransmit time out.
   TLP_RETRANSMISSION,          // Tail loss probes.
-  LAST_TRANSMISSION_TYPE = TLP_RETRANSMISSION,
+  PTO_RETRANSMISSION,          // Probes sent when the probe timeout fires.
+  LAST_TRANSMISSION_TYPE = PTO_RETRANSMISSION,
 };
 
 enum HasRetransmittableData : int8_t {
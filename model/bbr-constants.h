@@ -15,12 +15,19 @@ typedef uint32_t PacketLength;
 typedef uint64_t ByteCount;
 typedef uint64_t PacketNumber;
 typedef uint64_t PacketCount;
+// Identifies a connection to the receiver, which may serve many senders on
+// one port.
+typedef uint64_t ConnectionId;
+// Identifies a stream within a connection.  Each stream numbers its frames
+// on its own, stream 0 being the video.
+typedef uint32_t StreamId;
 
 // Simple time constants.
 const uint64_t kNumSecondsPerMinute = 60;
 const uint64_t kNumSecondsPerHour = kNumSecondsPerMinute * 60;
 const uint64_t kNumSecondsPerWeek = kNumSecondsPerHour * 24 * 7;
 const uint64_t kNumMillisPerSecond = 1000;
+const uint64_t kNumMicrosPerMilli = 1000;
 
 // Default maximum packet size used in the Linux TCP implementation.
 // Used in QUIC for congestion window computations in bytes.
@@ -55,6 +62,27 @@ const uint32_t kMaxInitialRoundTripTimeMs = 15 * kNumMillisPerSecond;
 // Maximum delayed ack time, in ms.
 const int64_t kMaxDelayedAckTimeMs = 25;
 
+// Ack delays are sent in units of 2^kDefaultAckDelayExponent microseconds.
+const uint8_t kDefaultAckDelayExponent = 3;
+
+// Number of ack ranges reported by default.  Older ranges are dropped.
+const size_t kDefaultMaxAckRanges = 256;
+
+// Receive timestamps reported by default in each ack.
+const size_t kDefaultMaxAckTimestamps = 64;
+// Receive timestamps further below the newest one are not reported.
+const PacketCount kMaxAckTimestampGap = 255;
+
+// Acks per round trip requested from the peer outside slow start.
+const PacketCount kAcksPerRoundTrip = 4;
+// Bounds of the ack-eliciting threshold requested from the peer.  Slow
+// start asks for the lower one.
+const PacketCount kMinAckElicitingThreshold = 2;
+const PacketCount kMaxAckElicitingThreshold = 64;
+// An unchanged ack frequency request is repeated this often, in ms, in case
+// it was lost.
+const uint64_t kAckFrequencyRefreshMs = 1000;
+
 // Minimum tail loss probe time in ms.
 static const int64_t kMinTailLossProbeTimeoutMs = 10;
 
@@ -75,6 +103,13 @@ const size_t kMinTimeoutsBeforePathDegrading = 2;
 // Sends up to two tail loss probes before firing an RTO,
 // per draft RFC draft-dukkipati-tcpm-tcp-loss-probe.
 static const size_t kDefaultMaxTailLossProbes = 2;
+
+// Timer granularity assumed when computing the probe timeout, per RFC 9002.
+static const int64_t kTimerGranularityMs = 1;
+// Number of probe packets sent when the probe timeout fires.
+static const size_t kPtoProbePackets = 2;
+// Losses spanning this many probe timeouts indicate persistent congestion.
+static const size_t kPersistentCongestionThreshold = 3;
 }
 }
 
@@ -66,6 +66,13 @@ const float kStartupGrowthTarget = 1.25;
 const RoundTripCount kRoundTripsWithoutGrowthBeforeExitingStartup = 3;
 const float kBbrCwndGain = 2.0f;
 const float kBbrRttVariationWeight = 0.0f;
+// Bandwidth samples inflated by ack aggregation are capped at this factor of
+// the peer's delivery rate, which leaves room for probing at kPacingGain[0].
+const float kDeliveryRateSampleCap = 1.25f;
+// The bandwidth estimate drops to the peer's delivery rate once it stayed
+// below this fraction of the estimate for kDeliveryRateDropRounds.
+const float kDeliveryRateDropFraction = 0.7f;
+const RoundTripCount kDeliveryRateDropRounds = 3;
 
 BbrSender::DebugState::DebugState(const BbrSender &sender)
     : mode(sender.mode_),
@@ -113,10 +120,6 @@ BbrSender::BbrSender(const RttStats *rtt_stats,
       high_gain_(kDefaultHighGain),
       high_cwnd_gain_(kDefaultHighGain),
       drain_gain_(1.f / kDefaultHighGain),
-      has_non_app_limited_sample_(false),
-      is_app_limited_recovery_(false),
-      enable_ack_aggregation_during_startup_(false),
-      drain_to_target_(false),
     //-------------------------------------add by dd stop-----------------------------------//
       pacing_rate_(Bandwidth::Zero()),
       pacing_gain_(1),
@@ -134,10 +137,21 @@ BbrSender::BbrSender(const RttStats *rtt_stats,
       exit_probe_rtt_at_(0),
       probe_rtt_round_passed_(false),
       last_sample_is_app_limited_(false),
+      has_non_app_limited_sample_(false),
+      enable_ack_aggregation_during_startup_(false),
+      drain_to_target_(false),
+      is_app_limited_recovery_(false),
+      slower_startup_(false),
+      rate_based_startup_(false),
+      initial_conservation_in_startup_(CONSERVATION),
       recovery_state_(NOT_IN_RECOVERY),
       end_recovery_at_(0),
       recovery_window_(max_congestion_window_),
-      rate_based_recovery_(false)
+      prior_congestion_window_(0),
+      rate_based_recovery_(false),
+      peer_delivery_rate_(Bandwidth::Zero()),
+      rounds_below_delivery_rate_(0),
+      bandwidth_resumption_(kBbrBandwidthResumption)
 {
     random_ = CreateObject<UniformRandomVariable> ();
     EnterStartupMode();
@@ -308,12 +322,12 @@ bool BbrSender::IsProbingForMoreBandwidth() const
 
 void BbrSender::AdjustNetworkParameters(Bandwidth bandwidth, uint64_t rtt)
 {
-    if (!kBbrBandwidthResumption)
+    if (!bandwidth_resumption_)
     {
         return;
     }
 
-    NS_LOG_DEBUG("kBbrBandwidthResumption:" << kBbrBandwidthResumption);
+    NS_LOG_DEBUG("bandwidth_resumption_:" << bandwidth_resumption_);
 
     if (!bandwidth.IsZero())
     {
@@ -325,6 +339,37 @@ void BbrSender::AdjustNetworkParameters(Bandwidth bandwidth, uint64_t rtt)
     }
 }
 
+void BbrSender::OnPersistentCongestion()
+{
+    // Nothing sent for several PTOs got through, so the model no longer
+    // describes the path.  Fall back to the minimum window and let the
+    // recovery window grow it again from what gets acked.
+    if (prior_congestion_window_ == 0)
+    {
+        prior_congestion_window_ = congestion_window_;
+    }
+    congestion_window_ = min_congestion_window_;
+    if (recovery_state_ != NOT_IN_RECOVERY)
+    {
+        recovery_window_ = min_congestion_window_;
+    }
+}
+
+void BbrSender::UndoLossRecovery()
+{
+    NS_LOG_INFO("undo recovery, cwnd " << congestion_window_ << " prior " << prior_congestion_window_);
+    recovery_state_ = NOT_IN_RECOVERY;
+    is_app_limited_recovery_ = false;
+    end_recovery_at_ = 0;
+    congestion_window_ = std::max(congestion_window_, prior_congestion_window_);
+    prior_congestion_window_ = 0;
+}
+
+void BbrSender::OnPeerDeliveryRate(Bandwidth delivery_rate)
+{
+    peer_delivery_rate_ = delivery_rate;
+}
+
 void BbrSender::OnCongestionEvent(bool /*rtt_updated*/, ByteCount prior_in_flight, uint64_t event_time,const CongestionVector &acked_packets, const CongestionVector &lost_packets)                                 
 {
     const ByteCount total_bytes_acked_before = sampler_->total_bytes_acked();
@@ -341,6 +386,7 @@ void BbrSender::OnCongestionEvent(bool /*rtt_updated*/, ByteCount prior_in_fligh
         PacketNumber last_acked_packet = acked_packets.rbegin()->first;
         is_round_start = UpdateRoundTripCounter(last_acked_packet);
         min_rtt_expired = UpdateBandwidthAndMinRtt(event_time, acked_packets);
+        MaybeLowerBandwidthToDeliveryRate(is_round_start);
         UpdateRecoveryState(last_acked_packet, !lost_packets.empty(), is_round_start);
 
         const ByteCount bytes_acked = sampler_->total_bytes_acked() - total_bytes_acked_before;
@@ -481,6 +527,11 @@ bool BbrSender::UpdateBandwidthAndMinRtt(
     const CongestionVector &acked_packets)
 {
     uint64_t sample_min_rtt = INFINITETIME;
+    // Only samples inflated by ack compression are capped by the peer's
+    // delivery rate.  STARTUP is left alone: the peer's rate lags behind a
+    // sending rate that doubles every round, and capping would end STARTUP
+    // at 1.25x a stale rate.
+    const bool cap_by_delivery_rate = mode_ != STARTUP && !peer_delivery_rate_.IsZero() && IsAckAggregated(now);
     for (const auto &packet : acked_packets)
     {   /*-------------------------------------add by dd start---------------------------------------*/
         if (packet.second == 0) {
@@ -499,6 +550,14 @@ bool BbrSender::UpdateBandwidthAndMinRtt(
             sample_min_rtt = std::min(sample_min_rtt, bandwidth_sample.rtt);
         }
 
+        if (cap_by_delivery_rate && !bandwidth_sample.is_app_limited &&
+            bandwidth_sample.bandwidth > peer_delivery_rate_ * kDeliveryRateSampleCap)
+        {
+            NS_LOG_DEBUG("sample " << bandwidth_sample.bandwidth.ToDebugValue()
+                         << " capped by delivery rate " << peer_delivery_rate_.ToDebugValue());
+            bandwidth_sample.bandwidth = peer_delivery_rate_ * kDeliveryRateSampleCap;
+        }
+
         if (!bandwidth_sample.is_app_limited || bandwidth_sample.bandwidth > BandwidthEstimate())
         {
             max_bandwidth_.Update(bandwidth_sample.bandwidth, round_trip_count_);
@@ -527,6 +586,28 @@ bool BbrSender::UpdateBandwidthAndMinRtt(
     return min_rtt_expired;
 }
 
+void BbrSender::MaybeLowerBandwidthToDeliveryRate(bool is_round_start)
+{
+    if (!is_round_start)
+    {
+        return;
+    }
+    if (mode_ != PROBE_BW || peer_delivery_rate_.IsZero() || last_sample_is_app_limited_ ||
+        peer_delivery_rate_ >= BandwidthEstimate() * kDeliveryRateDropFraction)
+    {
+        rounds_below_delivery_rate_ = 0;
+        return;
+    }
+    if (++rounds_below_delivery_rate_ < kDeliveryRateDropRounds)
+    {
+        return;
+    }
+    NS_LOG_INFO("bandwidth " << BandwidthEstimate().ToDebugValue()
+                << " lowered to delivery rate " << peer_delivery_rate_.ToDebugValue());
+    max_bandwidth_.Reset(peer_delivery_rate_, round_trip_count_);
+    rounds_below_delivery_rate_ = 0;
+}
+
 void BbrSender::UpdateGainCyclePhase(uint64_t now, ByteCount prior_in_flight, bool has_losses)
 {
     const ByteCount bytes_in_flight = unacked_packets_->bytes_in_flight(); // added by dd
@@ -697,6 +778,7 @@ void BbrSender::UpdateRecoveryState(PacketNumber last_acked_packet, bool has_los
         if (has_losses)
         {
             recovery_state_ = CONSERVATION;
+            prior_congestion_window_ = congestion_window_;
             // This will cause the |recovery_window_| to be set to the correct
             // value in CalculateRecoveryWindow().
             
@@ -732,6 +814,7 @@ void BbrSender::UpdateRecoveryState(PacketNumber last_acked_packet, bool has_los
         {
             recovery_state_ = NOT_IN_RECOVERY;
             is_app_limited_recovery_ = false;   // add by dd
+            prior_congestion_window_ = 0;
         }
 
         break;
@@ -769,6 +852,12 @@ ByteCount BbrSender::UpdateAckAggregationBytes(uint64_t ack_time, ByteCount newl
     return aggregation_epoch_bytes_ - expected_bytes_acked; // add by dd
 }
 
+bool BbrSender::IsAckAggregated(uint64_t ack_time) const
+{
+    const ByteCount expected_bytes_acked = max_bandwidth_.GetBest() * (ack_time - aggregation_epoch_start_time_);
+    return aggregation_epoch_bytes_ > expected_bytes_acked;
+}
+
 void BbrSender::CalculatePacingRate()
 {
     if (BandwidthEstimate().IsZero())
@@ -108,6 +108,7 @@ class BbrSender : public SendAlgorithmInterface
     void SetInitialCongestionWindowInPackets(PacketCount congestion_window) override; // by dd
 
     void AdjustNetworkParameters(Bandwidth bandwidth, uint64_t rtt) override;
+    void SetBandwidthResumption(bool enabled) override { bandwidth_resumption_ = enabled; }
 
     void OnCongestionEvent(bool rtt_updated,
                            ByteCount prior_in_flight,
@@ -120,6 +121,9 @@ class BbrSender : public SendAlgorithmInterface
                       ByteCount bytes,
                       HasRetransmittableData is_retransmittable) override;
     void OnRetransmissionTimeout(bool packets_retransmitted) override {}
+    void OnPersistentCongestion() override;
+    void UndoLossRecovery() override;
+    void OnPeerDeliveryRate(Bandwidth delivery_rate) override;
     void OnConnectionMigration() override {}
     uint64_t TimeUntilSend(uint64_t now, ByteCount bytes_in_flight) override;
     Bandwidth PacingRate(ByteCount bytes_in_flight) const override;
@@ -215,6 +219,11 @@ class BbrSender : public SendAlgorithmInterface
     // Updates the current bandwidth and min_rtt estimate based on the samples for
     // the received acknowledgements.  Returns true if min_rtt has expired.
     bool UpdateBandwidthAndMinRtt(uint64_t now, const CongestionVector &acked_packets);
+
+    // Drops the bandwidth estimate to the peer's delivery rate when it has
+    // stayed well below it for several round trips in PROBE_BW, rather than
+    // waiting for the max filter to expire.
+    void MaybeLowerBandwidthToDeliveryRate(bool is_round_start);
     
     // Updates the current gain used in PROBE_BW mode.
     void UpdateGainCyclePhase(uint64_t now, ByteCount prior_in_flight, bool has_losses);
@@ -235,6 +244,10 @@ class BbrSender : public SendAlgorithmInterface
     // void UpdateAckAggregationBytes(uint64_t ack_time, ByteCount newly_acked_bytes); // com by dd
     ByteCount UpdateAckAggregationBytes(uint64_t ack_time, ByteCount newly_acked_bytes);    // change return value by dd: void-->ByteCount
 
+    // Whether acks arriving at |ack_time| belong to an aggregation epoch,
+    // i.e. more bytes have been acked than the bandwidth estimate explains.
+    bool IsAckAggregated(uint64_t ack_time) const;
+
     // Determines the appropriate pacing rate for the connection.
     void CalculatePacingRate();
 
@@ -409,10 +422,23 @@ class BbrSender : public SendAlgorithmInterface
     PacketNumber end_recovery_at_;
     // A window used to limit the number of bytes in flight during loss recovery.
     ByteCount recovery_window_;
+    // Congestion window when the current recovery started, restored if the
+    // recovery is undone.  Zero outside recovery.
+    ByteCount prior_congestion_window_;
 
     // When true, recovery is rate based rather than congestion window based.
     bool rate_based_recovery_;
 
+    // Delivery rate last measured by the peer, zero if unknown.  Bandwidth
+    // samples above it by more than the probing gain come from ack
+    // compression and are capped.
+    Bandwidth peer_delivery_rate_;
+    // Consecutive round trips the peer's delivery rate stayed well below
+    // the bandwidth estimate.
+    RoundTripCount rounds_below_delivery_rate_;
+
+    // Whether AdjustNetworkParameters seeds max_bandwidth_ and min_rtt_.
+    bool bandwidth_resumption_;
 
 
     DISALLOW_COPY_AND_ASSIGN(BbrSender);
@@ -25,6 +25,8 @@ ConnectionStats::ConnectionStats()
       bytes_spuriously_retransmitted(0),
       packets_spuriously_retransmitted(0),
       packets_lost(0),
+      packets_fec_recovered(0),
+      packets_nacked(0),
       slowstart_packets_sent(0),
       slowstart_packets_lost(0),
       slowstart_bytes_lost(0),
@@ -33,18 +35,26 @@ ConnectionStats::ConnectionStats()
       loss_timeout_count(0),
       tlp_count(0),
       rto_count(0),
+      pto_count(0),
+      persistent_congestion_count(0),
+      loss_recoveries_undone(0),
       min_rtt_us(0),
       srtt_us(0),
       max_packet_size(0),
       max_received_packet_size(0),
       estimated_bandwidth(Bandwidth::Zero()),
+      peer_delivery_rate(Bandwidth::Zero()),
       packets_reordered(0),
       max_sequence_reordering(0),
       max_time_reordering_us(0),
       tcp_loss_events(0),
       connection_creation_time(0),
       blocked_frames_received(0),
-      blocked_frames_sent(0) {}
+      blocked_frames_sent(0),
+      frames_expired(0),
+      packets_expired(0),
+      bytes_expired(0),
+      congestion_control_switches(0) {}
 
 ConnectionStats::ConnectionStats(const ConnectionStats &other) = default;
 
@@ -65,6 +75,8 @@ std::ostream &operator<<(std::ostream &os, const ConnectionStats &s)
     os << " bytes_spuriously_retransmitted: " << s.bytes_spuriously_retransmitted;
     os << " packets_spuriously_retransmitted: " << s.packets_spuriously_retransmitted;
     os << " packets_lost: " << s.packets_lost;
+    os << " packets_fec_recovered: " << s.packets_fec_recovered;
+    os << " packets_nacked: " << s.packets_nacked;
     os << " slowstart_packets_sent: " << s.slowstart_packets_sent;
     os << " slowstart_packets_lost: " << s.slowstart_packets_lost;
     os << " slowstart_bytes_lost: " << s.slowstart_bytes_lost;
@@ -73,18 +85,26 @@ std::ostream &operator<<(std::ostream &os, const ConnectionStats &s)
     os << " loss_timeout_count: " << s.loss_timeout_count;
     os << " tlp_count: " << s.tlp_count;
     os << " rto_count: " << s.rto_count;
+    os << " pto_count: " << s.pto_count;
+    os << " persistent_congestion_count: " << s.persistent_congestion_count;
+    os << " loss_recoveries_undone: " << s.loss_recoveries_undone;
     os << " min_rtt_us: " << s.min_rtt_us;
     os << " srtt_us: " << s.srtt_us;
     os << " max_packet_size: " << s.max_packet_size;
     os << " max_received_packet_size: " << s.max_received_packet_size;
     os << " estimated_bandwidth: " << s.estimated_bandwidth.ToBitsPerSecond();
+    os << " peer_delivery_rate: " << s.peer_delivery_rate.ToBitsPerSecond();
     os << " packets_reordered: " << s.packets_reordered;
     os << " max_sequence_reordering: " << s.max_sequence_reordering;
     os << " max_time_reordering_us: " << s.max_time_reordering_us;
     os << " tcp_loss_events: " << s.tcp_loss_events;
     os << " connection_creation_time: " << s.connection_creation_time;
     os << " blocked_frames_received: " << s.blocked_frames_received;
-    os << " blocked_frames_sent: " << s.blocked_frames_sent << " }";
+    os << " blocked_frames_sent: " << s.blocked_frames_sent;
+    os << " frames_expired: " << s.frames_expired;
+    os << " packets_expired: " << s.packets_expired;
+    os << " bytes_expired: " << s.bytes_expired;
+    os << " congestion_control_switches: " << s.congestion_control_switches << " }";
 
     return os;
 }
@@ -48,6 +48,10 @@ struct ConnectionStats
     PacketCount packets_spuriously_retransmitted;
     // Number of packets abandoned as lost by the loss detection algorithm.
     PacketCount packets_lost;
+    // Number of packets the peer restored from FEC repair packets.
+    PacketCount packets_fec_recovered;
+    // Packets declared lost because the peer nacked them.
+    PacketCount packets_nacked;
 
     // Number of packets sent in slow start.
     PacketCount slowstart_packets_sent;
@@ -63,12 +67,19 @@ struct ConnectionStats
     size_t loss_timeout_count;
     size_t tlp_count;
     size_t rto_count; // Count of times the rto timer fired.
+    size_t pto_count; // Count of times the probe timeout fired.
+    // Count of times persistent congestion was declared.
+    size_t persistent_congestion_count;
+    // Count of loss recoveries undone because every loss proved spurious.
+    size_t loss_recoveries_undone;
 
     int64_t min_rtt_us; // Minimum RTT in microseconds.
     int64_t srtt_us;    // Smoothed RTT in microseconds.
     ByteCount max_packet_size;
     ByteCount max_received_packet_size;
     Bandwidth estimated_bandwidth;
+    // Delivery rate last measured by the peer, zero if never reported.
+    Bandwidth peer_delivery_rate;
 
     // Reordering stats for received packets.
     // Number of packets received out of packet number order.
@@ -88,6 +99,15 @@ struct ConnectionStats
 
     uint64_t blocked_frames_received;
     uint64_t blocked_frames_sent;
+
+    // Frames which passed their deadline before being fully delivered, and
+    // the packets and bytes of them which were dropped or not retransmitted.
+    uint64_t frames_expired;
+    PacketCount packets_expired;
+    ByteCount bytes_expired;
+
+    // Number of times the send algorithm was replaced at runtime.
+    size_t congestion_control_switches;
 };
 }
 }
@@ -0,0 +1,235 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2008 INRIA
+ *
+ * Author: daibo <daibo@yy.com>
+ */
+#include "ns3/core-module.h"
+
+#include <algorithm>
+
+#include "controller-policy.h"
+#include "rtt-stats.h"
+
+namespace ns3
+{
+NS_LOG_COMPONENT_DEFINE("ControllerPolicy");
+namespace bbr
+{
+namespace
+{
+// Rounds shorter than this are merged, so that tiny RTTs do not make the
+// classifier react to individual acks.
+const uint64_t kMinRoundTimeMs = 20;
+// Gain of the EWMAs kept across rounds.
+const float kRoundSmoothingGain = 0.25f;
+// Loss rate above which a round is considered lossy.
+const float kLossyRoundRate = 0.01f;
+// Loss rate above which a lossy round without queueing is attributed to a
+// policer rather than to random loss.
+const float kPolicedRoundRate = 0.1f;
+// RTT inflation, relative to min_rtt, above which queueing delay is assumed.
+const float kBufferbloatRttInflation = 0.5f;
+// Excess acked bytes, as a fraction of the BDP, above which RTT inflation is
+// attributed to ACK aggregation rather than to a standing queue.
+const float kAggregationBdpFraction = 0.5f;
+// Number of consecutive rounds a class must be observed before it is adopted.
+const size_t kRoundsBeforeClassChange = 4;
+// Minimum time a controller stays in use before it may be replaced.
+const uint64_t kMinControllerDwellTimeMs = SECOND(5);
+}
+
+const char *PathClassToString(PathClass path_class)
+{
+    switch (path_class)
+    {
+    case kPathUnknown:
+        return "UNKNOWN";
+    case kPathClean:
+        return "CLEAN";
+    case kPathRandomLoss:
+        return "RANDOM_LOSS";
+    case kPathBufferbloat:
+        return "BUFFERBLOAT";
+    case kPathPoliced:
+        return "POLICED";
+    default:
+        break;
+    }
+    return "???";
+}
+
+ControllerPolicy::ControllerPolicy()
+    : path_class_(kPathUnknown),
+      candidate_class_(kPathUnknown),
+      candidate_rounds_(0),
+      round_start_time_(0),
+      last_event_time_(0),
+      round_bytes_acked_(0),
+      round_bytes_lost_(0),
+      round_max_excess_acked_(0),
+      round_max_excess_in_flight_(0),
+      round_app_limited_(false),
+      round_probing_(false),
+      smoothed_loss_rate_(0),
+      smoothed_rtt_inflation_(0),
+      smoothed_aggregation_(0),
+      last_switch_time_(0)
+{
+    // BBR bounds the queue it builds itself, which a loss-based controller
+    // would keep full, so that a bufferbloated path would never clear.
+    for (int i = 0; i < kNumPathClasses; ++i)
+    {
+        controller_for_class_[i] = kBBR;
+    }
+}
+
+void ControllerPolicy::SetControllerForPathClass(PathClass path_class, CongestionControlType type)
+{
+    NS_ASSERT(path_class < kNumPathClasses);
+    controller_for_class_[path_class] = type;
+}
+
+void ControllerPolicy::OnApplicationLimited()
+{
+    round_app_limited_ = true;
+}
+
+void ControllerPolicy::OnProbingForBandwidth()
+{
+    round_probing_ = true;
+}
+
+void ControllerPolicy::OnCongestionEvent(uint64_t event_time,
+                                         const RttStats &rtt_stats,
+                                         Bandwidth bandwidth,
+                                         ByteCount bytes_in_flight,
+                                         ByteCount bytes_acked,
+                                         ByteCount bytes_lost)
+{
+    if (round_start_time_ == 0)
+    {
+        round_start_time_ = event_time;
+        last_event_time_ = event_time;
+    }
+
+    round_bytes_acked_ += bytes_acked;
+    round_bytes_lost_ += bytes_lost;
+
+    // Bytes acked beyond what the estimated bandwidth would have delivered
+    // since the previous event indicate aggregation on the ack path.
+    const ByteCount expected_acked = bandwidth.ToBytesPerPeriod(event_time - last_event_time_);
+    if (bytes_acked > expected_acked)
+    {
+        round_max_excess_acked_ = std::max(round_max_excess_acked_, bytes_acked - expected_acked);
+    }
+    last_event_time_ = event_time;
+
+    const ByteCount bdp = bandwidth.ToBytesPerPeriod(rtt_stats.min_rtt());
+    if (bytes_in_flight > bdp)
+    {
+        round_max_excess_in_flight_ = std::max(round_max_excess_in_flight_, bytes_in_flight - bdp);
+    }
+
+    const uint64_t round_time = std::max<uint64_t>(kMinRoundTimeMs, rtt_stats.smoothed_rtt());
+    if (event_time - round_start_time_ >= round_time)
+    {
+        EndRound(event_time, rtt_stats, bandwidth);
+    }
+}
+
+void ControllerPolicy::EndRound(uint64_t now, const RttStats &rtt_stats, Bandwidth bandwidth)
+{
+    const ByteCount round_bytes = round_bytes_acked_ + round_bytes_lost_;
+    if (!round_app_limited_ && round_bytes > 0 && rtt_stats.min_rtt() > 0)
+    {
+        const float loss_rate = static_cast<float>(round_bytes_lost_) / round_bytes;
+        // The delay of the sender's own excess in flight says nothing about
+        // other flows filling the buffer.
+        const int64_t own_queue_delay = bandwidth.TransferTime(round_max_excess_in_flight_);
+        const int64_t queue_delay = rtt_stats.smoothed_rtt() - rtt_stats.min_rtt() - own_queue_delay;
+        const float rtt_inflation = static_cast<float>(std::max<int64_t>(0, queue_delay)) / rtt_stats.min_rtt();
+        const ByteCount bdp = bandwidth.ToBytesPerPeriod(rtt_stats.min_rtt());
+        const float aggregation = bdp > 0 ? static_cast<float>(round_max_excess_acked_) / bdp : 0;
+
+        smoothed_loss_rate_ += kRoundSmoothingGain * (loss_rate - smoothed_loss_rate_);
+        if (!round_probing_)
+        {
+            smoothed_rtt_inflation_ += kRoundSmoothingGain * (rtt_inflation - smoothed_rtt_inflation_);
+        }
+        smoothed_aggregation_ += kRoundSmoothingGain * (aggregation - smoothed_aggregation_);
+
+        const PathClass round_class = ClassifyRound();
+        if (round_class == candidate_class_)
+        {
+            ++candidate_rounds_;
+        }
+        else
+        {
+            candidate_class_ = round_class;
+            candidate_rounds_ = 1;
+        }
+        if (candidate_rounds_ >= kRoundsBeforeClassChange && candidate_class_ != path_class_)
+        {
+            NS_LOG_INFO("path class " << PathClassToString(path_class_)
+                                      << " -> " << PathClassToString(candidate_class_)
+                                      << " loss " << smoothed_loss_rate_
+                                      << " rtt_inflation " << smoothed_rtt_inflation_
+                                      << " aggregation " << smoothed_aggregation_);
+            path_class_ = candidate_class_;
+        }
+    }
+
+    round_start_time_ = now;
+    round_bytes_acked_ = 0;
+    round_bytes_lost_ = 0;
+    round_max_excess_acked_ = 0;
+    round_max_excess_in_flight_ = 0;
+    round_app_limited_ = false;
+    round_probing_ = false;
+}
+
+PathClass ControllerPolicy::ClassifyRound() const
+{
+    // RTT inflation which can be explained by ack aggregation is not treated
+    // as a standing queue.
+    const bool queueing = smoothed_rtt_inflation_ >= kBufferbloatRttInflation &&
+                          smoothed_aggregation_ < kAggregationBdpFraction;
+    if (smoothed_loss_rate_ >= kLossyRoundRate && !queueing)
+    {
+        return smoothed_loss_rate_ >= kPolicedRoundRate ? kPathPoliced : kPathRandomLoss;
+    }
+    if (queueing)
+    {
+        return kPathBufferbloat;
+    }
+    return kPathClean;
+}
+
+bool ControllerPolicy::ShouldSwitch(CongestionControlType current,
+                                    uint64_t now,
+                                    CongestionControlType *target) const
+{
+    if (path_class_ == kPathUnknown)
+    {
+        return false;
+    }
+    if (last_switch_time_ != 0 && now - last_switch_time_ < kMinControllerDwellTimeMs)
+    {
+        return false;
+    }
+    const CongestionControlType recommended = controller_for_class_[path_class_];
+    if (recommended == current)
+    {
+        return false;
+    }
+    *target = recommended;
+    return true;
+}
+
+void ControllerPolicy::OnSwitched(uint64_t now)
+{
+    last_switch_time_ = now;
+}
+}
+}
@@ -0,0 +1,132 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2008 INRIA
+ *
+ * Author: daibo <daibo@yy.com>
+ */
+#ifndef CONTROLLER_POLICY_H
+#define CONTROLLER_POLICY_H
+
+#include "bbr-common.h"
+#include "bandwidth.h"
+
+namespace ns3
+{
+namespace bbr
+{
+class RttStats;
+
+// Coarse description of the bottleneck path, derived online from the
+// connection's own loss and delay signals.
+enum PathClass
+{
+    // Not enough non-app-limited samples have been collected yet.
+    kPathUnknown = 0,
+    // Little loss and little queueing delay.
+    kPathClean,
+    // Loss which is not accompanied by queueing delay, e.g. wireless links.
+    kPathRandomLoss,
+    // Queueing delay builds up well above min_rtt, e.g. deep access buffers.
+    kPathBufferbloat,
+    // Heavy loss without queueing delay, typical of a token bucket policer.
+    kPathPoliced,
+    kNumPathClasses,
+};
+
+const char *PathClassToString(PathClass path_class);
+
+// ControllerPolicy classifies the path once per round trip from the loss
+// rate, the RTT inflation above min_rtt, the ACK aggregation and whether the
+// sender was app-limited, and recommends the congestion controller configured
+// for the resulting class.  Only RTT inflation the sender's own queue cannot
+// explain counts as queueing on the path.  A class must be observed for several consecutive
+// rounds, and a controller must have been in use for a minimum dwell time,
+// before a switch is recommended.
+class ControllerPolicy
+{
+  public:
+    ControllerPolicy();
+    ~ControllerPolicy() {}
+
+    // Feeds the outcome of a congestion event into the classifier.
+    // |bandwidth| is the current estimate of the active send algorithm and
+    // |bytes_in_flight| what the sender had in flight before the event.
+    void OnCongestionEvent(uint64_t event_time,
+                           const RttStats &rtt_stats,
+                           Bandwidth bandwidth,
+                           ByteCount bytes_in_flight,
+                           ByteCount bytes_acked,
+                           ByteCount bytes_lost);
+
+    // Called when the sender had nothing to send.  The current round is not
+    // used for classification, since delay and loss say little about the path
+    // while the sender is app-limited.
+    void OnApplicationLimited();
+
+    // Called when the sender probes for bandwidth, e.g. in BBR's STARTUP or
+    // PROBE_BW up-gain phase.  The RTT inflation of the current round is not
+    // used for classification, since the sender builds that queue itself.
+    void OnProbingForBandwidth();
+
+    // Returns true and sets |target| if a controller other than |current|
+    // should be used at |now|.
+    bool ShouldSwitch(CongestionControlType current,
+                      uint64_t now,
+                      CongestionControlType *target) const;
+
+    // Must be called after the send algorithm has been replaced.
+    void OnSwitched(uint64_t now);
+
+    // Sets the controller recommended for |path_class|.
+    void SetControllerForPathClass(PathClass path_class, CongestionControlType type);
+
+    CongestionControlType controller_for_path_class(PathClass path_class) const
+    {
+        return controller_for_class_[path_class];
+    }
+
+    PathClass path_class() const { return path_class_; }
+
+    // Smoothed loss rate and RTT inflation over the classified rounds.
+    float smoothed_loss_rate() const { return smoothed_loss_rate_; }
+    float smoothed_rtt_inflation() const { return smoothed_rtt_inflation_; }
+
+  private:
+    // Classifies the round that has just ended.
+    void EndRound(uint64_t now, const RttStats &rtt_stats, Bandwidth bandwidth);
+
+    PathClass ClassifyRound() const;
+
+    CongestionControlType controller_for_class_[kNumPathClasses];
+
+    PathClass path_class_;
+    // Class observed in the most recent rounds, and for how many rounds in a
+    // row it has been observed.
+    PathClass candidate_class_;
+    size_t candidate_rounds_;
+
+    // Per-round accumulators.
+    uint64_t round_start_time_;
+    uint64_t last_event_time_;
+    ByteCount round_bytes_acked_;
+    ByteCount round_bytes_lost_;
+    // Largest number of bytes acked beyond what |bandwidth| would explain.
+    ByteCount round_max_excess_acked_;
+    // Largest number of bytes in flight beyond the BDP, which queue at the
+    // bottleneck whatever else shares it.
+    ByteCount round_max_excess_in_flight_;
+    bool round_app_limited_;
+    bool round_probing_;
+
+    float smoothed_loss_rate_;
+    float smoothed_rtt_inflation_;
+    float smoothed_aggregation_;
+
+    uint64_t last_switch_time_;
+
+    DISALLOW_COPY_AND_ASSIGN(ControllerPolicy);
+};
+}
+}
+
+#endif
@@ -0,0 +1,88 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2008 INRIA
+ *
+ * Author: daibo <daibo@yy.com>
+ */
+#include "ns3/core-module.h"
+
+#include <algorithm>
+
+#include "delivery-rate-estimator.h"
+
+namespace ns3
+{
+NS_LOG_COMPONENT_DEFINE("DeliveryRateEstimator");
+namespace bbr
+{
+namespace
+{
+const uint64_t kDefaultDeliveryRateWindowUs = 200000;
+// Gaps above this factor of the average one are idle time.
+const uint64_t kIdleGapFactor = 4;
+// Gaps up to this long are never taken for idle time.
+const uint64_t kMinIdleGapUs = 2000;
+// Without an average gap yet, gaps above this are idle time.
+const uint64_t kMaxFirstGapUs = 50000;
+// Inter-arrival gaps needed for an estimate.
+const size_t kMinDeliveryRateGaps = 8;
+}
+
+DeliveryRateEstimator::DeliveryRateEstimator()
+    : window_(kDefaultDeliveryRateWindowUs),
+      bytes_(0),
+      busy_time_(0),
+      num_gaps_(0)
+{
+}
+
+void DeliveryRateEstimator::OnPacketReceived(uint64_t receipt_time, ByteCount bytes)
+{
+    Arrival arrival = {receipt_time, bytes, 0};
+    if (!arrivals_.empty() && receipt_time > arrivals_.back().time)
+    {
+        const uint64_t gap = receipt_time - arrivals_.back().time;
+        const uint64_t idle_gap = num_gaps_ > 0
+                                      ? std::max(kMinIdleGapUs, kIdleGapFactor * busy_time_ / num_gaps_)
+                                      : kMaxFirstGapUs;
+        if (gap <= idle_gap)
+        {
+            arrival.gap = gap;
+            bytes_ += bytes;
+            busy_time_ += gap;
+            ++num_gaps_;
+        }
+    }
+    arrivals_.push_back(arrival);
+
+    while (arrivals_.front().time + window_ < receipt_time)
+    {
+        const Arrival &oldest = arrivals_.front();
+        if (oldest.gap > 0)
+        {
+            bytes_ -= oldest.bytes;
+            busy_time_ -= oldest.gap;
+            --num_gaps_;
+        }
+        arrivals_.pop_front();
+    }
+}
+
+void DeliveryRateEstimator::Clear()
+{
+    arrivals_.clear();
+    bytes_ = 0;
+    busy_time_ = 0;
+    num_gaps_ = 0;
+}
+
+Bandwidth DeliveryRateEstimator::GetDeliveryRate() const
+{
+    if (num_gaps_ < kMinDeliveryRateGaps || busy_time_ == 0)
+    {
+        return Bandwidth::Zero();
+    }
+    return Bandwidth::FromBytesPerSecond(bytes_ * kNumMillisPerSecond * kNumMicrosPerMilli / busy_time_);
+}
+}
+}
@@ -0,0 +1,61 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2008 INRIA
+ *
+ * Author: daibo <daibo@yy.com>
+ */
+#ifndef DELIVERY_RATE_ESTIMATOR_H
+#define DELIVERY_RATE_ESTIMATOR_H
+
+#include <deque>
+
+#include "bandwidth.h"
+#include "bbr-common.h"
+
+namespace ns3
+{
+namespace bbr
+{
+// Measures at the receiver the rate packets arrive at, over the packets of
+// a sliding time window.  Gaps much longer than the usual inter-arrival
+// time are the sender going idle, not the path, and are left out, so the
+// estimate is the rate the path delivers bursts at.  Unlike ack-based
+// samples it is not inflated by acks bunching on the way back.
+class DeliveryRateEstimator
+{
+  public:
+    DeliveryRateEstimator();
+
+    // Length of the window, in microseconds.
+    void set_window(uint64_t window) { window_ = window; }
+
+    // |receipt_time| is in microseconds.
+    void OnPacketReceived(uint64_t receipt_time, ByteCount bytes);
+
+    // Zero until enough packets have arrived within the window.
+    Bandwidth GetDeliveryRate() const;
+
+    void Clear();
+
+  private:
+    struct Arrival
+    {
+        uint64_t time;
+        ByteCount bytes;
+        // Time since the previous arrival, zero if it was an idle gap.
+        uint64_t gap;
+    };
+
+    uint64_t window_;
+    std::deque<Arrival> arrivals_;
+    // Sums over the arrivals after a non-idle gap.
+    ByteCount bytes_;
+    uint64_t busy_time_;
+    size_t num_gaps_;
+
+    DISALLOW_COPY_AND_ASSIGN(DeliveryRateEstimator);
+};
+}
+}
+
+#endif
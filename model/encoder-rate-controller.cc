@@ -0,0 +1,136 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2008 INRIA
+ *
+ * Author: daibo <daibo@yy.com>
+ */
+#include "ns3/core-module.h"
+
+#include <algorithm>
+
+#include "encoder-rate-controller.h"
+
+namespace ns3
+{
+NS_LOG_COMPONENT_DEFINE("EncoderRateController");
+namespace bbr
+{
+namespace
+{
+// Gain of the bandwidth EWMA on increases.  Decreases are taken at once.
+const float kBandwidthSmoothingGain = 0.25f;
+// Relative change of the target below which it is left alone.
+const float kRateHysteresis = 0.05f;
+// Lowest factor the target is multiplied by on a queue delay backoff.
+const float kMinQueueBackoff = 0.5f;
+// Increases wait this long after a decrease.
+const uint64_t kIncreaseHoldTimeMs = SECOND(1);
+}
+
+EncoderRateController::EncoderRateController()
+    : min_rate_(Bandwidth::FromKBitsPerSecond(100)),
+      max_rate_(Bandwidth::FromKBitsPerSecond(6000)),
+      headroom_(0.1f),
+      max_increase_step_(0.1f),
+      target_queue_delay_(100),
+      max_increases_per_second_(2),
+      target_rate_(Bandwidth::Zero()),
+      smoothed_bandwidth_(Bandwidth::Zero()),
+      last_increase_time_(INFINITETIME),
+      last_decrease_time_(INFINITETIME)
+{
+}
+
+void EncoderRateController::Reset(Bandwidth initial_rate)
+{
+    target_rate_ = ClampRate(initial_rate);
+    smoothed_bandwidth_ = Bandwidth::Zero();
+    last_increase_time_ = INFINITETIME;
+    last_decrease_time_ = INFINITETIME;
+}
+
+Bandwidth EncoderRateController::ClampRate(Bandwidth rate) const
+{
+    return std::min(max_rate_, std::max(min_rate_, rate));
+}
+
+void EncoderRateController::UpdateSmoothedBandwidth(Bandwidth bandwidth, bool app_limited)
+{
+    if (smoothed_bandwidth_.IsZero() || (!app_limited && bandwidth < smoothed_bandwidth_))
+    {
+        smoothed_bandwidth_ = bandwidth;
+    }
+    else if (bandwidth > smoothed_bandwidth_)
+    {
+        // App-limited samples are lower bounds, they only raise the estimate.
+        smoothed_bandwidth_ = smoothed_bandwidth_ +
+                              (bandwidth - smoothed_bandwidth_) * kBandwidthSmoothingGain;
+    }
+}
+
+bool EncoderRateController::OnUpdate(uint64_t now,
+                                     Bandwidth bandwidth,
+                                     uint64_t queue_delay,
+                                     bool app_limited,
+                                     Bandwidth *target)
+{
+    if (bandwidth.IsZero())
+    {
+        return false;
+    }
+    UpdateSmoothedBandwidth(bandwidth, app_limited);
+
+    Bandwidth desired = smoothed_bandwidth_ * (1 - headroom_);
+    if (app_limited)
+    {
+        desired = std::max(desired, target_rate_ * (1 + max_increase_step_));
+    }
+    bool queue_backoff = false;
+    if (queue_delay > target_queue_delay_)
+    {
+        // Give the queue one target delay to drain after each backoff.
+        if (last_decrease_time_ != INFINITETIME &&
+            now < last_decrease_time_ + target_queue_delay_)
+        {
+            return false;
+        }
+        const float backoff = std::max(kMinQueueBackoff,
+                                       static_cast<float>(target_queue_delay_) / queue_delay);
+        desired = std::min(desired, target_rate_) * backoff;
+        queue_backoff = true;
+    }
+    desired = ClampRate(desired);
+
+    if (desired < target_rate_ * (1 - kRateHysteresis) ||
+        (queue_backoff && desired < target_rate_))
+    {
+        NS_LOG_DEBUG("decrease " << target_rate_.ToKBitsPerSecond() << " -> "
+                     << desired.ToKBitsPerSecond() << " kbps, bandwidth "
+                     << smoothed_bandwidth_.ToKBitsPerSecond() << " queue_delay " << queue_delay);
+        target_rate_ = desired;
+        last_decrease_time_ = now;
+        *target = target_rate_;
+        return true;
+    }
+
+    if (desired > target_rate_ * (1 + kRateHysteresis) &&
+        queue_delay <= target_queue_delay_ / 2 &&
+        (last_decrease_time_ == INFINITETIME ||
+         now >= last_decrease_time_ + kIncreaseHoldTimeMs) &&
+        max_increases_per_second_ > 0 &&
+        (last_increase_time_ == INFINITETIME ||
+         now >= last_increase_time_ + SECOND(1) / max_increases_per_second_))
+    {
+        const Bandwidth increased = std::min(desired, target_rate_ * (1 + max_increase_step_));
+        NS_LOG_DEBUG("increase " << target_rate_.ToKBitsPerSecond() << " -> "
+                     << increased.ToKBitsPerSecond() << " kbps, bandwidth "
+                     << smoothed_bandwidth_.ToKBitsPerSecond() << " queue_delay " << queue_delay);
+        target_rate_ = increased;
+        last_increase_time_ = now;
+        *target = target_rate_;
+        return true;
+    }
+    return false;
+}
+}
+}
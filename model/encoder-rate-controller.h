@@ -0,0 +1,86 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2008 INRIA
+ *
+ * Author: daibo <daibo@yy.com>
+ */
+#ifndef ENCODER_RATE_CONTROLLER_H
+#define ENCODER_RATE_CONTROLLER_H
+
+#include "bbr-common.h"
+#include "bandwidth.h"
+
+namespace ns3
+{
+namespace bbr
+{
+// EncoderRateController turns the send algorithm's bandwidth estimate and
+// the age of the oldest queued frame into the encoder's target rate.
+//
+// The target leaves some headroom below the smoothed bandwidth.  Decreases
+// are applied at once: a drop of the estimate, or a frame queue older than
+// the target queue delay.  Increases are limited in size and in number per
+// second, and wait for a while after a decrease.  Changes smaller than the
+// hysteresis band are ignored, so the encoder is not retuned on every ack.
+//
+// While the sender is app-limited the estimate only measures the encoder's
+// own rate, so it is used as a lower bound and the target is probed upward.
+class EncoderRateController
+{
+  public:
+    EncoderRateController();
+
+    // Restarts from |initial_rate|, keeping the configuration.
+    void Reset(Bandwidth initial_rate);
+
+    void set_min_rate(Bandwidth min_rate) { min_rate_ = min_rate; }
+    void set_max_rate(Bandwidth max_rate) { max_rate_ = max_rate; }
+    // Fraction of the smoothed bandwidth left unused by the encoder.
+    void set_headroom(float headroom) { headroom_ = headroom; }
+    // Largest increase of the target, as a fraction of it.
+    void set_max_increase_step(float step) { max_increase_step_ = step; }
+    // Age of the oldest queued frame above which the target is lowered.
+    void set_target_queue_delay(uint64_t delay) { target_queue_delay_ = delay; }
+    // Number of increases allowed per second.
+    void set_max_increases_per_second(size_t increases)
+    {
+        max_increases_per_second_ = increases;
+    }
+
+    // Feeds the current bandwidth estimate and the age of the oldest queued
+    // frame at |now|.  Returns true and sets |target| if the encoder rate
+    // should change.
+    bool OnUpdate(uint64_t now,
+                  Bandwidth bandwidth,
+                  uint64_t queue_delay,
+                  bool app_limited,
+                  Bandwidth *target);
+
+    Bandwidth target_rate() const { return target_rate_; }
+    Bandwidth smoothed_bandwidth() const { return smoothed_bandwidth_; }
+
+  private:
+    void UpdateSmoothedBandwidth(Bandwidth bandwidth, bool app_limited);
+
+    Bandwidth ClampRate(Bandwidth rate) const;
+
+    Bandwidth min_rate_;
+    Bandwidth max_rate_;
+    float headroom_;
+    float max_increase_step_;
+    uint64_t target_queue_delay_;
+    size_t max_increases_per_second_;
+
+    Bandwidth target_rate_;
+    Bandwidth smoothed_bandwidth_;
+    // INFINITETIME until the first increase and decrease, so neither the
+    // increase budget nor the hold after a decrease delays a new flow.
+    uint64_t last_increase_time_;
+    uint64_t last_decrease_time_;
+
+    DISALLOW_COPY_AND_ASSIGN(EncoderRateController);
+};
+}
+}
+
+#endif
@@ -0,0 +1,281 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2008 INRIA
+ *
+ * Author: daibo <daibo@yy.com>
+ */
+#include "ns3/core-module.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "fec-codec.h"
+#include "udp-bbr-constants.h"
+
+namespace ns3
+{
+NS_LOG_COMPONENT_DEFINE("FecCodec");
+namespace bbr
+{
+namespace
+{
+// Packets sent per loss rate sample.
+const PacketCount kLossSamplePackets = 100;
+// Gain of the loss rate EWMA.
+const float kLossRateGain = 0.25f;
+// No repair packets are sent below this loss rate.
+const float kMinFecLossRate = 0.005f;
+// Repair packets per lost packet, to cover loss bursts within a frame.
+const float kFecRedundancyGain = 3.0f;
+// Upper bound on the fraction of repair packets.
+const float kMaxFecRedundancy = 0.5f;
+// Reed-Solomon over GF(2^8) is limited to 255 symbols per frame.
+const size_t kMaxReedSolomonSymbols = 255;
+// Frames the decoder keeps state for.
+const size_t kMaxFecGroups = 64;
+}
+
+FecEncoder::FecEncoder()
+    : scheme_(kFecNone),
+      smoothed_loss_rate_(0),
+      sample_start_packets_sent_(0),
+      sample_start_packets_lost_(0),
+      pic_index_(0),
+      max_length_(0)
+{
+}
+
+void FecEncoder::UpdateLossRate(const ConnectionStats &stats)
+{
+    const PacketCount sent = stats.packets_sent - sample_start_packets_sent_;
+    if (sent < kLossSamplePackets)
+    {
+        return;
+    }
+    const PacketCount packets_lost = stats.packets_lost + stats.packets_fec_recovered;
+    const PacketCount lost = packets_lost - sample_start_packets_lost_;
+    const float loss_rate = std::min(1.0f, static_cast<float>(lost) / sent);
+    smoothed_loss_rate_ += kLossRateGain * (loss_rate - smoothed_loss_rate_);
+    sample_start_packets_sent_ = stats.packets_sent;
+    sample_start_packets_lost_ = packets_lost;
+}
+
+float FecEncoder::GetRedundancyRatio() const
+{
+    if (scheme_ == kFecNone || smoothed_loss_rate_ < kMinFecLossRate)
+    {
+        return 0;
+    }
+    return std::min(kMaxFecRedundancy, kFecRedundancyGain * smoothed_loss_rate_);
+}
+
+size_t FecEncoder::GetNumRepairPackets(size_t num_source) const
+{
+    const float ratio = GetRedundancyRatio();
+    if (ratio <= 0 || num_source == 0)
+    {
+        return 0;
+    }
+    size_t num_repair = static_cast<size_t>(std::ceil(num_source * ratio));
+    if (scheme_ == kFecXor)
+    {
+        // Further repair packets would cover no source packet.
+        num_repair = std::min(num_repair, num_source);
+    }
+    else
+    {
+        num_repair = num_source < kMaxReedSolomonSymbols
+                         ? std::min(num_repair, kMaxReedSolomonSymbols - num_source)
+                         : 0;
+    }
+    return num_repair;
+}
+
+void FecEncoder::OnSourcePacketSent(const PacketHeader &header, std::deque<FecRepairPacket> *repairs)
+{
+    if (scheme_ == kFecNone || !header.m_data_packet)
+    {
+        return;
+    }
+    const PicDataPacket &data = *header.m_data_packet;
+    if (data.PicCurPktSeq == 0 || data.PicIndex != pic_index_)
+    {
+        // Any unfinished frame expired before its last packet was sent.
+        pic_index_ = data.PicIndex;
+        packet_numbers_.clear();
+        max_length_ = 0;
+    }
+    if (data.PicCurPktSeq != packet_numbers_.size())
+    {
+        // Packets of this frame were dropped, leave it unprotected.
+        return;
+    }
+    packet_numbers_.push_back(header.m_packet_seq);
+    max_length_ = std::max<PacketLength>(max_length_, header.m_data_length);
+    if (packet_numbers_.size() < data.PicPktNum)
+    {
+        return;
+    }
+
+    const size_t num_repair = GetNumRepairPackets(packet_numbers_.size());
+    for (size_t j = 0; j < num_repair; ++j)
+    {
+        FecRepairPacket repair;
+        repair.header.m_transmission_type = NOT_RETRANSMISSION;
+        repair.header.m_data_length = max_length_;
+        repair.header.PicType = pic_type_fec;
+        repair.header.PicIndex = data.PicIndex;
+        repair.header.PicDataLen = data.PicDataLen;
+        repair.header.PicPktNum = data.PicPktNum;
+        // Past the last source packet, so it is never taken for one.
+        repair.header.PicCurPktSeq = data.PicPktNum;
+        repair.header.PicGenTime = data.PicGenTime;
+        repair.frame.scheme = scheme_;
+        repair.frame.repair_index = j;
+        repair.frame.num_repair = num_repair;
+        repair.frame.protected_packets = packet_numbers_;
+        repair.expire_time = data.expire_time;
+        repairs->push_back(repair);
+    }
+    NS_LOG_DEBUG("PicIndex " << data.PicIndex << " source " << packet_numbers_.size()
+                 << " repair " << num_repair << " loss " << smoothed_loss_rate_);
+    packet_numbers_.clear();
+}
+
+FecDecoder::FecDecoder()
+    : packets_recovered_(0)
+{
+}
+
+void FecDecoder::Clear()
+{
+    groups_.clear();
+    packets_recovered_ = 0;
+}
+
+FecDecoder::FecGroup *FecDecoder::GetGroup(PacketNumber pic_index, uint16_t pic_pkt_num)
+{
+    std::map<PacketNumber, FecGroup>::iterator it = groups_.find(pic_index);
+    if (it == groups_.end())
+    {
+        if (!groups_.empty() && pic_index < groups_.begin()->first &&
+            groups_.size() >= kMaxFecGroups)
+        {
+            // Older than every frame kept.
+            return nullptr;
+        }
+        it = groups_.insert(std::make_pair(pic_index, FecGroup())).first;
+        it->second.received.assign(pic_pkt_num, false);
+        if (groups_.size() > kMaxFecGroups)
+        {
+            groups_.erase(groups_.begin());
+        }
+    }
+    if (it->second.received.size() != pic_pkt_num)
+    {
+        return nullptr;
+    }
+    return &it->second;
+}
+
+void FecDecoder::OnSourcePacket(PacketNumber pic_index,
+                                uint16_t pic_pkt_num,
+                                uint16_t pic_cur_pkt_seq,
+                                RecoveredVector *recovered)
+{
+    FecGroup *group = GetGroup(pic_index, pic_pkt_num);
+    if (group == nullptr || pic_cur_pkt_seq >= pic_pkt_num || group->received[pic_cur_pkt_seq])
+    {
+        return;
+    }
+    group->received[pic_cur_pkt_seq] = true;
+    ++group->num_received;
+    TryRecover(group, recovered);
+}
+
+void FecDecoder::OnRepairPacket(PacketNumber pic_index,
+                                uint16_t pic_pkt_num,
+                                const FecFrame &frame,
+                                RecoveredVector *recovered)
+{
+    FecGroup *group = GetGroup(pic_index, pic_pkt_num);
+    if (group == nullptr || frame.protected_packets.size() != pic_pkt_num ||
+        frame.repair_index >= frame.num_repair)
+    {
+        return;
+    }
+    if (group->repair_received.empty())
+    {
+        group->scheme = frame.scheme;
+        group->repair_received.assign(frame.num_repair, false);
+        group->packet_numbers = frame.protected_packets;
+    }
+    if (frame.repair_index >= group->repair_received.size() ||
+        group->repair_received[frame.repair_index])
+    {
+        return;
+    }
+    group->repair_received[frame.repair_index] = true;
+    ++group->num_repair_received;
+    TryRecover(group, recovered);
+}
+
+void FecDecoder::TryRecover(FecGroup *group, RecoveredVector *recovered)
+{
+    const size_t num_source = group->received.size();
+    if (group->num_repair_received == 0 || group->num_received == num_source)
+    {
+        return;
+    }
+    if (group->scheme == kFecReedSolomon)
+    {
+        // Any |num_source| symbols of a frame restore it.
+        if (group->num_received + group->num_repair_received < num_source)
+        {
+            return;
+        }
+        for (size_t seq = 0; seq < num_source; ++seq)
+        {
+            if (!group->received[seq])
+            {
+                Recover(group, seq, recovered);
+            }
+        }
+    }
+    else if (group->scheme == kFecXor)
+    {
+        // Each parity restores the single missing packet of its class.
+        const size_t num_repair = group->repair_received.size();
+        for (size_t j = 0; j < num_repair; ++j)
+        {
+            if (!group->repair_received[j])
+            {
+                continue;
+            }
+            size_t num_missing = 0;
+            size_t missing = 0;
+            for (size_t seq = j; seq < num_source; seq += num_repair)
+            {
+                if (!group->received[seq])
+                {
+                    ++num_missing;
+                    missing = seq;
+                }
+            }
+            if (num_missing == 1)
+            {
+                Recover(group, missing, recovered);
+            }
+        }
+    }
+}
+
+void FecDecoder::Recover(FecGroup *group, uint16_t seq, RecoveredVector *recovered)
+{
+    group->received[seq] = true;
+    ++group->num_received;
+    ++packets_recovered_;
+    recovered->push_back(std::make_pair(group->packet_numbers[seq], seq));
+}
+}
+}
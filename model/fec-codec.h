@@ -0,0 +1,133 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2008 INRIA
+ *
+ * Author: daibo <daibo@yy.com>
+ */
+#ifndef FEC_CODEC_H
+#define FEC_CODEC_H
+
+#include <deque>
+#include <map>
+#include <utility>
+#include <vector>
+
+#include "bbr-common.h"
+#include "connection-stats.h"
+#include "fec-frame.h"
+#include "packet-header.h"
+
+namespace ns3
+{
+namespace bbr
+{
+// A repair packet waiting to be sent.  |header| carries the Pic* fields of
+// the protected frame; the packet number and send time are set on sending.
+struct FecRepairPacket
+{
+    PacketHeader header;
+    FecFrame frame;
+    uint64_t expire_time;
+};
+
+// Protects each frame with repair packets sent right after its last source
+// packet.  The number of repair packets follows the loss rate observed by
+// the sender, and is zero on a loss-free path.
+//
+// Packets carry no real payload in the simulation, so the repair packets
+// only describe which source packets they cover; the decoder restores a
+// packet whenever the scheme's erasure bound allows it.
+class FecEncoder
+{
+  public:
+    FecEncoder();
+
+    void set_scheme(FecScheme scheme) { scheme_ = scheme; }
+    FecScheme scheme() const { return scheme_; }
+
+    // Updates the loss rate from the cumulative connection counters.  Lost
+    // packets include those the receiver recovered.
+    void UpdateLossRate(const ConnectionStats &stats);
+
+    float loss_rate() const { return smoothed_loss_rate_; }
+
+    // Fraction of repair packets added to each frame.
+    float GetRedundancyRatio() const;
+
+    // Number of repair packets protecting a frame of |num_source| packets.
+    size_t GetNumRepairPackets(size_t num_source) const;
+
+    // Records the first transmission of a source packet.  When it is the
+    // last packet of its frame, appends the frame's repair packets to
+    // |repairs|.
+    void OnSourcePacketSent(const PacketHeader &header, std::deque<FecRepairPacket> *repairs);
+
+  private:
+    FecScheme scheme_;
+
+    float smoothed_loss_rate_;
+    // Counters at the start of the current loss sample.
+    PacketCount sample_start_packets_sent_;
+    PacketCount sample_start_packets_lost_;
+
+    // Frame being sent, with the packet numbers of its source packets.
+    PacketNumber pic_index_;
+    std::vector<PacketNumber> packet_numbers_;
+    PacketLength max_length_;
+
+    DISALLOW_COPY_AND_ASSIGN(FecEncoder);
+};
+
+// Collects the source and repair packets of recent frames and restores
+// missing source packets without waiting for retransmissions.
+class FecDecoder
+{
+  public:
+    // <packet number, PicCurPktSeq> of restored source packets.
+    typedef std::vector<std::pair<PacketNumber, uint16_t>> RecoveredVector;
+
+    FecDecoder();
+
+    void OnSourcePacket(PacketNumber pic_index,
+                        uint16_t pic_pkt_num,
+                        uint16_t pic_cur_pkt_seq,
+                        RecoveredVector *recovered);
+
+    void OnRepairPacket(PacketNumber pic_index,
+                        uint16_t pic_pkt_num,
+                        const FecFrame &frame,
+                        RecoveredVector *recovered);
+
+    PacketCount packets_recovered() const { return packets_recovered_; }
+
+    void Clear();
+
+  private:
+    struct FecGroup
+    {
+        FecGroup() : scheme(kFecNone), num_received(0), num_repair_received(0) {}
+
+        FecScheme scheme;
+        std::vector<bool> received;
+        size_t num_received;
+        std::vector<bool> repair_received;
+        size_t num_repair_received;
+        std::vector<PacketNumber> packet_numbers;
+    };
+
+    FecGroup *GetGroup(PacketNumber pic_index, uint16_t pic_pkt_num);
+
+    // Restores what the received repair packets allow.
+    void TryRecover(FecGroup *group, RecoveredVector *recovered);
+
+    void Recover(FecGroup *group, uint16_t seq, RecoveredVector *recovered);
+
+    std::map<PacketNumber, FecGroup> groups_;
+    PacketCount packets_recovered_;
+
+    DISALLOW_COPY_AND_ASSIGN(FecDecoder);
+};
+}
+}
+
+#endif
@@ -0,0 +1,115 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2008 INRIA
+ *
+ * Author: daibo <daibo@yy.com>
+ */
+
+#include "ns3/core-module.h"
+
+#include "fec-frame.h"
+
+namespace ns3
+{
+namespace bbr
+{
+NS_LOG_COMPONENT_DEFINE("FecFrame");
+
+const char *FecSchemeToString(FecScheme scheme)
+{
+    switch (scheme)
+    {
+    case kFecNone:
+        return "NONE";
+    case kFecXor:
+        return "XOR";
+    case kFecReedSolomon:
+        return "REED_SOLOMON";
+    default:
+        break;
+    }
+    return "???";
+}
+
+FecFrame::FecFrame()
+    : scheme(kFecNone),
+      repair_index(0),
+      num_repair(0)
+{
+}
+
+TypeId FecFrame::GetTypeId(void)
+{
+    static TypeId tid = TypeId("ns3::FecFrame")
+                            .SetParent<Header>()
+                            .SetGroupName("Applications")
+                            .AddConstructor<FecFrame>();
+    return tid;
+}
+
+TypeId FecFrame::GetInstanceTypeId(void) const
+{
+    return GetTypeId();
+}
+
+void FecFrame::Print(std::ostream &os) const
+{
+    os << "(scheme=" << FecSchemeToString(scheme)
+       << " repair=" << int(repair_index) << "/" << int(num_repair)
+       << " protected=" << protected_packets.size() << ")";
+}
+
+uint32_t FecFrame::GetSerializedSize(void) const
+{
+    uint32_t size = 3 * sizeof(uint8_t) + sizeof(uint16_t);
+    if (!protected_packets.empty())
+    {
+        // The first packet number, then deltas from it.
+        size += sizeof(PacketNumber) + (protected_packets.size() - 1) * sizeof(uint16_t);
+    }
+    return size;
+}
+
+void FecFrame::Serialize(Buffer::Iterator start) const
+{
+    Buffer::Iterator i = start;
+    i.WriteU8(scheme);
+    i.WriteU8(repair_index);
+    i.WriteU8(num_repair);
+    NS_ASSERT(protected_packets.size() <= 0xFFFF);
+    i.WriteHtonU16(protected_packets.size());
+    if (protected_packets.empty())
+    {
+        return;
+    }
+    const PacketNumber first = protected_packets.front();
+    i.WriteHtonU64(first);
+    for (size_t k = 1; k < protected_packets.size(); ++k)
+    {
+        NS_ASSERT_MSG(protected_packets[k] > first && protected_packets[k] - first <= 0xFFFF,
+                      "protected packet " << protected_packets[k] << " too far from " << first);
+        i.WriteHtonU16(protected_packets[k] - first);
+    }
+}
+
+uint32_t FecFrame::Deserialize(Buffer::Iterator start)
+{
+    Buffer::Iterator i = start;
+    scheme = static_cast<FecScheme>(i.ReadU8());
+    repair_index = i.ReadU8();
+    num_repair = i.ReadU8();
+    uint16_t num_protected = i.ReadNtohU16();
+    protected_packets.clear();
+    if (num_protected > 0)
+    {
+        const PacketNumber first = i.ReadNtohU64();
+        protected_packets.push_back(first);
+        for (uint16_t k = 1; k < num_protected; ++k)
+        {
+            protected_packets.push_back(first + i.ReadNtohU16());
+        }
+    }
+    return GetSerializedSize();
+}
+}
+}
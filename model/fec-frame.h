@@ -0,0 +1,64 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2008 INRIA
+ *
+ * Author: daibo <daibo@yy.com>
+ */
+#ifndef FEC_FRAME_H
+#define FEC_FRAME_H
+
+#include <vector>
+
+#include "ns3/header.h"
+
+#include "bbr-common.h"
+
+namespace ns3
+{
+namespace bbr
+{
+enum FecScheme
+{
+  kFecNone = 0,
+  // Each repair packet is the XOR of the source packets whose index in the
+  // frame is congruent to its repair index, and restores one of them.
+  kFecXor,
+  // Reed-Solomon over GF(2^8): any PicPktNum of the source and repair
+  // packets of a frame restore the whole frame.
+  kFecReedSolomon,
+};
+
+const char *FecSchemeToString(FecScheme scheme);
+
+// Follows the PacketHeader of a repair packet, whose Pic* fields describe
+// the protected frame.
+class FecFrame : public Header
+{
+  public:
+    FecFrame();
+    virtual ~FecFrame() {}
+
+    FecScheme scheme;
+    // Index of this repair packet, and number of repair packets of the frame.
+    uint8_t repair_index;
+    uint8_t num_repair;
+    // Packet numbers of the first transmission of each source packet,
+    // indexed by PicCurPktSeq.  Recovered packets are acked by these.
+    std::vector<PacketNumber> protected_packets;
+
+  public:
+    /**
+       * \brief Get the type ID.
+       * \return The object TypeId.
+       */
+    static TypeId GetTypeId(void);
+    virtual TypeId GetInstanceTypeId(void) const;
+    virtual void Print(std::ostream &os) const;
+    virtual uint32_t GetSerializedSize(void) const;
+    virtual void Serialize(Buffer::Iterator start) const;
+    virtual uint32_t Deserialize(Buffer::Iterator start);
+};
+}
+}
+
+#endif
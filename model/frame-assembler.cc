@@ -0,0 +1,110 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2008 INRIA
+ *
+ * Author: daibo <daibo@yy.com>
+ */
+#include "ns3/core-module.h"
+
+#include <algorithm>
+
+#include "frame-assembler.h"
+#include "udp-bbr-constants.h"
+
+namespace ns3
+{
+NS_LOG_COMPONENT_DEFINE("FrameAssembler");
+namespace bbr
+{
+namespace
+{
+// Incomplete frames kept; older ones are dropped beyond it.
+const size_t kMaxIncompleteFrames = 256;
+}
+
+FrameAssembler::FrameAssembler()
+    : least_pending_(0)
+{
+}
+
+bool FrameAssembler::OnPacket(const PacketHeader &header,
+                              uint16_t pic_cur_pkt_seq,
+                              uint64_t now,
+                              AssembledFrame *frame)
+{
+    const PacketNumber pic_index = header.PicIndex;
+    if (pic_index < least_pending_ || header.PicPktNum == 0 ||
+        std::find(completed_.begin(), completed_.end(), pic_index) != completed_.end())
+    {
+        return false;
+    }
+    std::map<PacketNumber, PendingFrame>::iterator it = frames_.find(pic_index);
+    if (it == frames_.end())
+    {
+        it = frames_.insert(std::make_pair(pic_index, PendingFrame())).first;
+        it->second.received.assign(header.PicPktNum, false);
+        it->second.first_packet_time = now;
+        if (frames_.size() > kMaxIncompleteFrames)
+        {
+            RemoveFramesBefore(frames_.begin()->first + 1);
+            if (pic_index < least_pending_)
+            {
+                return false;
+            }
+        }
+    }
+    PendingFrame &pending = it->second;
+    if (header.PicType != pic_type_fec)
+    {
+        pending.type = header.PicType;
+    }
+    if (pic_cur_pkt_seq >= pending.received.size() || pending.received[pic_cur_pkt_seq])
+    {
+        return false;
+    }
+    pending.received[pic_cur_pkt_seq] = true;
+    if (++pending.num_received < pending.received.size())
+    {
+        return false;
+    }
+
+    frame->pic_index = pic_index;
+    frame->type = pending.type;
+    frame->data_len = header.PicDataLen;
+    frame->gen_time = header.PicGenTime;
+    frame->first_packet_time = pending.first_packet_time;
+    frame->complete_time = now;
+    frames_.erase(it);
+    completed_.push_back(pic_index);
+    if (completed_.size() > kMaxIncompleteFrames)
+    {
+        completed_.erase(completed_.begin());
+    }
+    NS_LOG_DEBUG("PicIndex " << pic_index << " complete after " << now - frame->first_packet_time << "ms");
+    return true;
+}
+
+void FrameAssembler::Clear()
+{
+    frames_.clear();
+    least_pending_ = 0;
+    completed_.clear();
+}
+
+size_t FrameAssembler::RemoveFramesBefore(PacketNumber pic_index)
+{
+    if (pic_index <= least_pending_)
+    {
+        return 0;
+    }
+    least_pending_ = pic_index;
+    std::map<PacketNumber, PendingFrame>::iterator end = frames_.lower_bound(pic_index);
+    const size_t dropped = std::distance(frames_.begin(), end);
+    frames_.erase(frames_.begin(), end);
+    completed_.erase(std::remove_if(completed_.begin(), completed_.end(),
+                                    [pic_index](PacketNumber completed) { return completed < pic_index; }),
+                     completed_.end());
+    return dropped;
+}
+}
+}
@@ -0,0 +1,81 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2008 INRIA
+ *
+ * Author: daibo <daibo@yy.com>
+ */
+#ifndef FRAME_ASSEMBLER_H
+#define FRAME_ASSEMBLER_H
+
+#include <map>
+#include <vector>
+
+#include "bbr-common.h"
+#include "packet-header.h"
+
+namespace ns3
+{
+namespace bbr
+{
+// A frame whose packets have all been received or recovered.
+struct AssembledFrame
+{
+    AssembledFrame()
+        : pic_index(0), type(0), data_len(0), gen_time(0), first_packet_time(0), complete_time(0)
+    {
+    }
+
+    PacketNumber pic_index;
+    uint8_t type;
+    uint32_t data_len;
+    uint64_t gen_time;
+    // Arrival of the first packet of the frame, and of the one completing it.
+    uint64_t first_packet_time;
+    uint64_t complete_time;
+};
+
+// Collects the packets of each frame, keyed by PicIndex, and tells when a
+// frame is complete regardless of the order its packets arrive in.
+class FrameAssembler
+{
+  public:
+    FrameAssembler();
+
+    // Records packet |pic_cur_pkt_seq| of the frame described by |header|,
+    // received or recovered at |now|.  Returns true and fills in |frame| if
+    // it completes the frame.
+    bool OnPacket(const PacketHeader &header, uint16_t pic_cur_pkt_seq, uint64_t now, AssembledFrame *frame);
+
+    // Forgets the frames below |pic_index|, which will never complete.
+    // Returns the number of incomplete frames dropped.
+    size_t RemoveFramesBefore(PacketNumber pic_index);
+
+    size_t num_incomplete_frames() const { return frames_.size(); }
+
+    void Clear();
+
+  private:
+    struct PendingFrame
+    {
+        PendingFrame() : type(0), num_received(0), first_packet_time(0) {}
+
+        // From the source packets, repair packets carry pic_type_fec.
+        uint8_t type;
+        std::vector<bool> received;
+        uint16_t num_received;
+        uint64_t first_packet_time;
+    };
+
+    // Incomplete frames.
+    std::map<PacketNumber, PendingFrame> frames_;
+    // Frames below this one completed or were given up on.  Completed frames
+    // above it are in |completed_|.
+    PacketNumber least_pending_;
+    std::vector<PacketNumber> completed_;
+
+    DISALLOW_COPY_AND_ASSIGN(FrameAssembler);
+};
+}
+}
+
+#endif
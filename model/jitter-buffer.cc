@@ -0,0 +1,233 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2008 INRIA
+ *
+ * Author: daibo <daibo@yy.com>
+ */
+#include "ns3/core-module.h"
+
+#include <algorithm>
+
+#include "jitter-buffer.h"
+
+namespace ns3
+{
+NS_LOG_COMPONENT_DEFINE("JitterBuffer");
+namespace bbr
+{
+namespace
+{
+const uint64_t kDefaultMinPlayoutDelayMs = 50;
+const uint64_t kDefaultMaxPlayoutDelayMs = 500;
+// Frame interval assumed until two frames completed, 30 fps.
+const uint64_t kDefaultFrameIntervalMs = 33;
+// A render gap this much longer than a frame interval is a freeze.
+const uint64_t kFreezeExtraMs = 150;
+}
+
+PlayoutStats::PlayoutStats()
+    : frames_completed(0),
+      frames_rendered(0),
+      frames_skipped(0),
+      frames_late(0),
+      total_completion_latency(0),
+      max_completion_latency(0),
+      total_assembly_time(0),
+      freeze_count(0),
+      total_freeze_duration(0),
+      max_freeze_duration(0),
+      first_render_time(0),
+      last_render_time(0),
+      playout_delay(0)
+{
+}
+
+double PlayoutStats::RenderedFrameRate() const
+{
+    if (frames_rendered < 2 || last_render_time <= first_render_time)
+    {
+        return 0;
+    }
+    return (frames_rendered - 1) * 1000.0 / (last_render_time - first_render_time);
+}
+
+std::ostream &operator<<(std::ostream &os, const PlayoutStats &s)
+{
+    os << "{ frames_completed: " << s.frames_completed;
+    os << " frames_rendered: " << s.frames_rendered;
+    os << " frames_skipped: " << s.frames_skipped;
+    os << " frames_late: " << s.frames_late;
+    os << " avg_completion_latency: "
+       << (s.frames_completed > 0 ? s.total_completion_latency / s.frames_completed : 0);
+    os << " max_completion_latency: " << s.max_completion_latency;
+    os << " avg_assembly_time: "
+       << (s.frames_completed > 0 ? s.total_assembly_time / s.frames_completed : 0);
+    os << " freeze_count: " << s.freeze_count;
+    os << " total_freeze_duration: " << s.total_freeze_duration;
+    os << " max_freeze_duration: " << s.max_freeze_duration;
+    os << " rendered_frame_rate: " << s.RenderedFrameRate();
+    os << " playout_delay: " << s.playout_delay;
+    os << " }";
+    return os;
+}
+
+JitterBuffer::JitterBuffer()
+    : min_delay_(kDefaultMinPlayoutDelayMs),
+      max_delay_(kDefaultMaxPlayoutDelayMs),
+      smoothed_latency_(0),
+      latency_deviation_(0),
+      frame_interval_(kDefaultFrameIntervalMs),
+      last_completed_index_(0),
+      last_completed_gen_time_(0),
+      started_(false),
+      next_pic_index_(0),
+      least_unexpired_(0)
+{
+    stats_.playout_delay = min_delay_;
+}
+
+void JitterBuffer::Clear()
+{
+    smoothed_latency_ = 0;
+    latency_deviation_ = 0;
+    frame_interval_ = kDefaultFrameIntervalMs;
+    last_completed_index_ = 0;
+    last_completed_gen_time_ = 0;
+    frames_.clear();
+    started_ = false;
+    next_pic_index_ = 0;
+    least_unexpired_ = 0;
+    stats_ = PlayoutStats();
+    stats_.playout_delay = min_delay_;
+}
+
+void JitterBuffer::SetPlayoutDelayBounds(uint64_t min_delay, uint64_t max_delay)
+{
+    NS_ASSERT(min_delay <= max_delay);
+    min_delay_ = min_delay;
+    max_delay_ = max_delay;
+    stats_.playout_delay = std::max(min_delay_, std::min(max_delay_, stats_.playout_delay));
+}
+
+void JitterBuffer::OnFrameComplete(const AssembledFrame &frame)
+{
+    const uint64_t latency = frame.complete_time > frame.gen_time ? frame.complete_time - frame.gen_time : 0;
+    ++stats_.frames_completed;
+    stats_.total_completion_latency += latency;
+    stats_.max_completion_latency = std::max(stats_.max_completion_latency, latency);
+    stats_.total_assembly_time += frame.complete_time - frame.first_packet_time;
+
+    // Smoothed as the RTT is (RFC 6298), and the delay covers four
+    // deviations above it.
+    if (stats_.frames_completed == 1)
+    {
+        smoothed_latency_ = latency;
+        latency_deviation_ = latency / 2;
+    }
+    else
+    {
+        const uint64_t deviation = latency > smoothed_latency_ ? latency - smoothed_latency_
+                                                               : smoothed_latency_ - latency;
+        latency_deviation_ = (3 * latency_deviation_ + deviation) / 4;
+        smoothed_latency_ = (7 * smoothed_latency_ + latency) / 8;
+    }
+    stats_.playout_delay = std::max(min_delay_, std::min(max_delay_, smoothed_latency_ + 4 * latency_deviation_));
+
+    if (last_completed_gen_time_ > 0 && frame.pic_index > last_completed_index_ &&
+        frame.gen_time > last_completed_gen_time_)
+    {
+        const uint64_t interval = (frame.gen_time - last_completed_gen_time_) /
+                                  (frame.pic_index - last_completed_index_);
+        frame_interval_ = std::max<uint64_t>(1, (7 * frame_interval_ + interval) / 8);
+    }
+    if (frame.pic_index > last_completed_index_ || last_completed_gen_time_ == 0)
+    {
+        last_completed_index_ = frame.pic_index;
+        last_completed_gen_time_ = frame.gen_time;
+    }
+
+    if (started_ && frame.pic_index < next_pic_index_)
+    {
+        // A later frame was rendered already.
+        ++stats_.frames_late;
+        return;
+    }
+    if (frame.complete_time > frame.gen_time + stats_.playout_delay)
+    {
+        ++stats_.frames_late;
+    }
+    frames_[frame.pic_index] = frame;
+}
+
+void JitterBuffer::OnFramesExpired(PacketNumber pic_index)
+{
+    least_unexpired_ = std::max(least_unexpired_, pic_index);
+}
+
+void JitterBuffer::Update(uint64_t now)
+{
+    while (!frames_.empty())
+    {
+        std::map<PacketNumber, AssembledFrame>::iterator it = frames_.begin();
+        const AssembledFrame frame = it->second;
+        if (!started_)
+        {
+            started_ = true;
+            next_pic_index_ = frame.pic_index;
+        }
+        // Due at its playout time, but not before it completed nor before
+        // the previous frame was rendered.
+        uint64_t render_time = std::max(frame.gen_time + stats_.playout_delay, frame.complete_time);
+        render_time = std::max(render_time, stats_.last_render_time);
+        // Missing frames below the least unexpired one will never come, so
+        // only the others are waited for, one frame interval.
+        if (frame.pic_index != next_pic_index_ && frame.pic_index > least_unexpired_)
+        {
+            if (now < render_time + frame_interval_)
+            {
+                break;
+            }
+            render_time += frame_interval_;
+        }
+        if (now < render_time)
+        {
+            break;
+        }
+        if (frame.pic_index != next_pic_index_)
+        {
+            stats_.frames_skipped += frame.pic_index - next_pic_index_;
+            NS_LOG_INFO("skip PicIndex " << next_pic_index_ << " to " << frame.pic_index);
+        }
+        frames_.erase(it);
+        Render(frame, render_time);
+        next_pic_index_ = frame.pic_index + 1;
+    }
+}
+
+void JitterBuffer::Render(const AssembledFrame &frame, uint64_t render_time)
+{
+    if (stats_.frames_rendered > 0)
+    {
+        const uint64_t gap = render_time - stats_.last_render_time;
+        if (gap > FreezeThreshold())
+        {
+            ++stats_.freeze_count;
+            stats_.total_freeze_duration += gap;
+            stats_.max_freeze_duration = std::max(stats_.max_freeze_duration, gap);
+            NS_LOG_INFO("freeze of " << gap << "ms before PicIndex " << frame.pic_index);
+        }
+    }
+    else
+    {
+        stats_.first_render_time = render_time;
+    }
+    ++stats_.frames_rendered;
+    stats_.last_render_time = render_time;
+}
+
+uint64_t JitterBuffer::FreezeThreshold() const
+{
+    return std::max(3 * frame_interval_, frame_interval_ + kFreezeExtraMs);
+}
+}
+}
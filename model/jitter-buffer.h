@@ -0,0 +1,108 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2008 INRIA
+ *
+ * Author: daibo <daibo@yy.com>
+ */
+#ifndef JITTER_BUFFER_H
+#define JITTER_BUFFER_H
+
+#include <map>
+#include <ostream>
+
+#include "bbr-common.h"
+#include "frame-assembler.h"
+
+namespace ns3
+{
+namespace bbr
+{
+// Playout quality seen by the receiver.  Times are in ms.
+struct PlayoutStats
+{
+    PlayoutStats();
+
+    friend std::ostream &operator<<(std::ostream &os, const PlayoutStats &s);
+
+    // Average number of frames rendered per second.
+    double RenderedFrameRate() const;
+
+    PacketCount frames_completed;
+    PacketCount frames_rendered;
+    // Frames never rendered: incomplete when a later frame was played, or
+    // complete too late.
+    PacketCount frames_skipped;
+    // Frames completed after the time they were due to be rendered.
+    PacketCount frames_late;
+    // Generation to completion of each frame.
+    uint64_t total_completion_latency;
+    uint64_t max_completion_latency;
+    // First packet to completion of each frame.
+    uint64_t total_assembly_time;
+    // Renders further apart than the freeze threshold.
+    size_t freeze_count;
+    uint64_t total_freeze_duration;
+    uint64_t max_freeze_duration;
+    uint64_t first_render_time;
+    uint64_t last_render_time;
+    // Playout delay currently applied.
+    uint64_t playout_delay;
+};
+
+// Holds complete frames until their playout time, the generation time plus
+// a playout delay which adapts to the completion latency, and renders them
+// in order.  A missing frame is waited for until the next complete frame
+// is a frame interval overdue, then skipped.  Renders further apart than
+// max(3 frame intervals, a frame interval + 150 ms) count as freezes.
+class JitterBuffer
+{
+  public:
+    JitterBuffer();
+
+    // Bounds of the playout delay, in ms.
+    void SetPlayoutDelayBounds(uint64_t min_delay, uint64_t max_delay);
+
+    void OnFrameComplete(const AssembledFrame &frame);
+
+    // Frames below |pic_index| will never complete.
+    void OnFramesExpired(PacketNumber pic_index);
+
+    // Renders the frames due by |now|.
+    void Update(uint64_t now);
+
+    const PlayoutStats &stats() const { return stats_; }
+
+    // Forgets every frame and the stats, keeping the playout delay bounds.
+    void Clear();
+
+  private:
+    void Render(const AssembledFrame &frame, uint64_t render_time);
+
+    uint64_t FreezeThreshold() const;
+
+    uint64_t min_delay_;
+    uint64_t max_delay_;
+    // Completion latency statistics the playout delay follows.
+    uint64_t smoothed_latency_;
+    uint64_t latency_deviation_;
+    // Average time between the generation of two frames.
+    uint64_t frame_interval_;
+    PacketNumber last_completed_index_;
+    uint64_t last_completed_gen_time_;
+
+    // Complete frames not rendered yet.
+    std::map<PacketNumber, AssembledFrame> frames_;
+    bool started_;
+    // Next frame to render.
+    PacketNumber next_pic_index_;
+    // Frames below this index expired at the sender.
+    PacketNumber least_unexpired_;
+
+    PlayoutStats stats_;
+
+    DISALLOW_COPY_AND_ASSIGN(JitterBuffer);
+};
+}
+}
+
+#endif
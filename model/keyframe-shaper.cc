@@ -0,0 +1,98 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2008 INRIA
+ *
+ * Author: daibo <daibo@yy.com>
+ */
+#include "ns3/core-module.h"
+
+#include <algorithm>
+
+#include "keyframe-shaper.h"
+
+namespace ns3
+{
+NS_LOG_COMPONENT_DEFINE("KeyFrameShaper");
+namespace bbr
+{
+namespace
+{
+// A frame this many times the average size is taken for a keyframe.
+const ByteCount kKeyFrameSizeRatio = 3;
+// Frames averaged before large frames are taken for keyframes.
+const PacketCount kMinAveragedFrames = 8;
+// Gain of the frame size EWMA, as a divisor.
+const ByteCount kAverageGainDivisor = 8;
+}
+
+KeyFrameShaper::KeyFrameShaper()
+    : shaping_(kKeyFrameUnshaped),
+      spread_frames_(3),
+      num_frames_(0),
+      average_frame_bytes_(0),
+      refresh_bytes_(0),
+      refresh_frames_(0)
+{
+}
+
+void KeyFrameShaper::Reset()
+{
+    num_frames_ = 0;
+    average_frame_bytes_ = 0;
+    refresh_bytes_ = 0;
+    refresh_frames_ = 0;
+}
+
+void KeyFrameShaper::set_spread_frames(uint32_t frames)
+{
+    spread_frames_ = std::max<uint32_t>(frames, 1);
+}
+
+void KeyFrameShaper::OnFrame(ByteCount bytes, bool key_frame, ShapedFrame *frame)
+{
+    const bool first = num_frames_ == 0;
+    const bool large = num_frames_ > kMinAveragedFrames &&
+                       bytes > kKeyFrameSizeRatio * average_frame_bytes_;
+    ++num_frames_;
+    key_frame = key_frame || first || large;
+
+    frame->bytes = bytes;
+    frame->key_frame = key_frame;
+    frame->release_frames = 0;
+    if (!key_frame)
+    {
+        average_frame_bytes_ = average_frame_bytes_ == 0
+                                   ? bytes
+                                   : average_frame_bytes_ + bytes / kAverageGainDivisor -
+                                         average_frame_bytes_ / kAverageGainDivisor;
+    }
+    if (first)
+    {
+        return;
+    }
+
+    if (key_frame && shaping_ == kKeyFrameSpread && spread_frames_ > 1)
+    {
+        frame->release_frames = spread_frames_;
+        NS_LOG_DEBUG("Spread keyframe of " << bytes << " bytes over " << spread_frames_ << " frames");
+    }
+    else if (key_frame && shaping_ == kKeyFrameIntraRefresh && average_frame_bytes_ > 0)
+    {
+        // The keyframe keeps the size of a frame but its intra data.
+        frame->bytes = std::min(bytes, average_frame_bytes_);
+        refresh_bytes_ += bytes - frame->bytes;
+        refresh_frames_ = spread_frames_;
+        NS_LOG_DEBUG("Refresh " << refresh_bytes_ << " intra bytes over " << spread_frames_ << " frames");
+    }
+
+    if (refresh_frames_ > 0)
+    {
+        const ByteCount refresh = refresh_bytes_ / refresh_frames_;
+        frame->bytes += refresh;
+        frame->key_frame = true;
+        refresh_bytes_ -= refresh;
+        --refresh_frames_;
+    }
+}
+}
+}
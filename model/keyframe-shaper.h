@@ -0,0 +1,84 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2008 INRIA
+ *
+ * Author: daibo <daibo@yy.com>
+ */
+#ifndef KEYFRAME_SHAPER_H
+#define KEYFRAME_SHAPER_H
+
+#include "bbr-common.h"
+
+namespace ns3
+{
+namespace bbr
+{
+enum KeyFrameShaping
+{
+  // Keyframes are queued whole, as the codec emits them.
+  kKeyFrameUnshaped = 0,
+  // The packets of a keyframe are released evenly over several frame
+  // intervals rather than at once.
+  kKeyFrameSpread,
+  // The intra data of a keyframe is spread over it and the next frames, as
+  // an encoder with intra refresh does, so no frame is much larger than the
+  // others.
+  kKeyFrameIntraRefresh,
+};
+
+// A frame as it is to be queued.
+struct ShapedFrame
+{
+    ByteCount bytes;
+    // Carries intra data the following frames depend on.
+    bool key_frame;
+    // Frame intervals over which its packets are released, 0 for at once.
+    uint32_t release_frames;
+};
+
+// KeyFrameShaper tells keyframes from the other frames of a codec, and
+// reshapes them so that they do not fill the path's queue at once.  A
+// frame is a keyframe if the codec says so, or if it is much larger than
+// the recent frames, which catches the I-frames of codecs that do not
+// report frame types.
+//
+// The first frame is never reshaped: nothing can be played out before all
+// of it arrives, so the sender rather sends it in one burst.
+class KeyFrameShaper
+{
+  public:
+    KeyFrameShaper();
+
+    // Restarts with the next frame taken as the first, keeping the
+    // configuration.
+    void Reset();
+
+    void set_shaping(KeyFrameShaping shaping) { shaping_ = shaping; }
+    KeyFrameShaping shaping() const { return shaping_; }
+    // Frames a keyframe is spread over, itself included.
+    void set_spread_frames(uint32_t frames);
+    uint32_t spread_frames() const { return spread_frames_; }
+
+    // Takes the next frame of |bytes| from the codec, |key_frame| if the
+    // codec knows it is one, and sets |frame| to how it is to be queued.
+    void OnFrame(ByteCount bytes, bool key_frame, ShapedFrame *frame);
+
+    // Average size of the recent frames but keyframes, 0 before the first.
+    ByteCount average_frame_bytes() const { return average_frame_bytes_; }
+
+  private:
+    KeyFrameShaping shaping_;
+    uint32_t spread_frames_;
+
+    PacketCount num_frames_;
+    ByteCount average_frame_bytes_;
+    // Intra data of the last keyframe left to add to the next frames.
+    ByteCount refresh_bytes_;
+    uint32_t refresh_frames_;
+
+    DISALLOW_COPY_AND_ASSIGN(KeyFrameShaper);
+};
+}
+}
+
+#endif
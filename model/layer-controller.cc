@@ -0,0 +1,96 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2008 INRIA
+ *
+ * Author: daibo <daibo@yy.com>
+ */
+#include "ns3/core-module.h"
+
+#include <algorithm>
+
+#include "layer-controller.h"
+
+namespace ns3
+{
+NS_LOG_COMPONENT_DEFINE("LayerController");
+namespace bbr
+{
+namespace
+{
+// Layers are added back this long after the last drop.
+const uint64_t kAddHoldTimeMs = SECOND(2);
+// At most one layer is added back per interval.
+const uint64_t kAddIntervalMs = SECOND(1);
+}
+
+LayerController::LayerController()
+    : headroom_(0.1f),
+      target_queue_delay_(100),
+      num_layers_(1),
+      active_layers_(1),
+      last_drop_time_(0),
+      last_add_time_(0)
+{
+}
+
+void LayerController::Reset(size_t num_layers)
+{
+    num_layers_ = std::max<size_t>(num_layers, 1);
+    active_layers_ = num_layers_;
+    last_drop_time_ = 0;
+    last_add_time_ = 0;
+}
+
+bool LayerController::OnUpdate(uint64_t now,
+                               Bandwidth bandwidth,
+                               uint64_t queue_delay,
+                               bool app_limited,
+                               const std::vector<Bandwidth> &layer_rates,
+                               size_t *active_layers)
+{
+    if (bandwidth.IsZero() || layer_rates.size() < num_layers_)
+    {
+        return false;
+    }
+
+    size_t layers = active_layers_;
+    if (!app_limited)
+    {
+        while (layers > 1 && layer_rates[layers - 1] > bandwidth)
+        {
+            --layers;
+        }
+    }
+    // Give the queue one target delay to drain after each drop.
+    if (layers == active_layers_ && layers > 1 && queue_delay > target_queue_delay_ &&
+        now >= last_drop_time_ + target_queue_delay_)
+    {
+        --layers;
+    }
+    if (layers < active_layers_)
+    {
+        NS_LOG_DEBUG("drop layers " << active_layers_ << " -> " << layers << ", bandwidth "
+                     << bandwidth.ToKBitsPerSecond() << " queue_delay " << queue_delay);
+        active_layers_ = layers;
+        last_drop_time_ = now;
+        *active_layers = active_layers_;
+        return true;
+    }
+
+    if (active_layers_ < num_layers_ &&
+        (app_limited || layer_rates[active_layers_] <= bandwidth * (1 - headroom_)) &&
+        queue_delay <= target_queue_delay_ / 2 &&
+        now >= last_drop_time_ + kAddHoldTimeMs &&
+        now >= last_add_time_ + kAddIntervalMs)
+    {
+        ++active_layers_;
+        NS_LOG_DEBUG("add layer " << active_layers_ << ", bandwidth "
+                     << bandwidth.ToKBitsPerSecond() << " queue_delay " << queue_delay);
+        last_add_time_ = now;
+        *active_layers = active_layers_;
+        return true;
+    }
+    return false;
+}
+}
+}
@@ -0,0 +1,74 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2008 INRIA
+ *
+ * Author: daibo <daibo@yy.com>
+ */
+#ifndef LAYER_CONTROLLER_H
+#define LAYER_CONTROLLER_H
+
+#include <vector>
+
+#include "bbr-common.h"
+#include "bandwidth.h"
+
+namespace ns3
+{
+namespace bbr
+{
+// LayerController picks how many layers of a layered (SVC or simulcast)
+// video stream are sent, the base layer always included.  Layers are only
+// ever dropped from the top, so the layers sent never miss one they are
+// predicted from.
+//
+// Dropping a layer takes effect at once, also on the frames already
+// queued, so it reacts to the network well before the encoder rate does.
+// Layers are dropped while their rate exceeds the bandwidth estimate, and
+// one at a time while the frame queue is older than the target queue
+// delay.  A layer is added back once it fits below the bandwidth with some
+// headroom, the queue is short, and no layer was dropped for a while.
+//
+// While the sender is app-limited the estimate only measures the layers
+// sent, so it never drops a layer, and layers are probed back upward.
+class LayerController
+{
+  public:
+    LayerController();
+
+    // Restarts with all |num_layers| layers sent, keeping the configuration.
+    void Reset(size_t num_layers);
+
+    // Fraction of the bandwidth left unused when adding a layer.
+    void set_headroom(float headroom) { headroom_ = headroom; }
+    // Age of the oldest queued frame above which a layer is dropped.
+    void set_target_queue_delay(uint64_t delay) { target_queue_delay_ = delay; }
+
+    // Feeds the current bandwidth estimate and the age of the oldest queued
+    // frame at |now|.  |layer_rates[i]| is the rate of layers 0 to i
+    // together.  Returns true and sets |active_layers| if the number of
+    // layers sent should change.
+    bool OnUpdate(uint64_t now,
+                  Bandwidth bandwidth,
+                  uint64_t queue_delay,
+                  bool app_limited,
+                  const std::vector<Bandwidth> &layer_rates,
+                  size_t *active_layers);
+
+    size_t num_layers() const { return num_layers_; }
+    size_t active_layers() const { return active_layers_; }
+
+  private:
+    float headroom_;
+    uint64_t target_queue_delay_;
+
+    size_t num_layers_;
+    size_t active_layers_;
+    uint64_t last_drop_time_;
+    uint64_t last_add_time_;
+
+    DISALLOW_COPY_AND_ASSIGN(LayerController);
+};
+}
+}
+
+#endif
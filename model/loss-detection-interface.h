@@ -42,6 +42,10 @@ class LossDetectionInterface
         uint64_t time,
         const RttStats &rtt_stats,
         PacketNumber spurious_retransmission) = 0;
+
+    // Called when |packet_number|, previously declared lost, is put back in
+    // flight because its loss was undone.
+    virtual void OnPacketRestoredToInFlight(PacketNumber packet_number) {}
 };
 }
 }
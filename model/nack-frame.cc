@@ -0,0 +1,90 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2008 INRIA
+ *
+ * Author: daibo <daibo@yy.com>
+ */
+
+#include "ns3/core-module.h"
+
+#include "nack-frame.h"
+#include "varint.h"
+
+namespace ns3
+{
+namespace bbr
+{
+NS_LOG_COMPONENT_DEFINE("NackFrame");
+
+const PacketType NackFrame::m_type = kNackPacket;
+
+NackFrame::NackFrame()
+    : connection_id(0)
+{
+}
+
+TypeId NackFrame::GetTypeId(void)
+{
+    static TypeId tid = TypeId("ns3::NackFrame")
+                            .SetParent<Header>()
+                            .SetGroupName("Applications")
+                            .AddConstructor<NackFrame>();
+    return tid;
+}
+
+TypeId NackFrame::GetInstanceTypeId(void) const
+{
+    return GetTypeId();
+}
+
+void NackFrame::Print(std::ostream &os) const
+{
+    os << "(missing=[ ";
+    for (PacketNumber packet_number : missing_packets)
+    {
+        os << packet_number << " ";
+    }
+    os << "])";
+}
+
+uint32_t NackFrame::GetSerializedSize(void) const
+{
+    uint32_t size = sizeof(uint8_t) + GetVarIntLength(connection_id) + GetVarIntLength(missing_packets.size());
+    for (size_t k = 0; k < missing_packets.size(); ++k)
+    {
+        size += GetVarIntLength(k == 0 ? missing_packets[k] : missing_packets[k] - missing_packets[k - 1] - 1);
+    }
+    return size;
+}
+
+void NackFrame::Serialize(Buffer::Iterator start) const
+{
+    Buffer::Iterator i = start;
+    i.WriteU8(m_type);
+    WriteVarInt(i, connection_id);
+    // The first packet number, then the gap below each of the others.
+    WriteVarInt(i, missing_packets.size());
+    for (size_t k = 0; k < missing_packets.size(); ++k)
+    {
+        NS_ASSERT(k == 0 || missing_packets[k] > missing_packets[k - 1]);
+        WriteVarInt(i, k == 0 ? missing_packets[k] : missing_packets[k] - missing_packets[k - 1] - 1);
+    }
+}
+
+uint32_t NackFrame::Deserialize(Buffer::Iterator start)
+{
+    Buffer::Iterator i = start;
+    uint8_t type = i.ReadU8();
+    NS_ASSERT(type == kNackPacket);
+    connection_id = ReadVarInt(i);
+    uint64_t num_missing = ReadVarInt(i);
+    missing_packets.clear();
+    for (uint64_t k = 0; k < num_missing; ++k)
+    {
+        const uint64_t value = ReadVarInt(i);
+        missing_packets.push_back(k == 0 ? value : missing_packets.back() + value + 1);
+    }
+    return i.GetDistanceFrom(start);
+}
+}
+}
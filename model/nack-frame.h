@@ -4,8 +4,10 @@
  *
  * Author: daibo <daibo@yy.com>
  */
-#ifndef STOP_WAITING_H
-#define STOP_WAITING_H
+#ifndef NACK_FRAME_H
+#define NACK_FRAME_H
+
+#include <vector>
 
 #include "ns3/header.h"
 
@@ -15,27 +17,21 @@ namespace ns3
 {
 namespace bbr
 {
-class StopWaitingFrame : public Header
+// Sent by the receiver as soon as it finds packets missing within a frame,
+// so the sender retransmits them without waiting for its own loss
+// detection.
+class NackFrame : public Header
 {
   public:
-    StopWaitingFrame();
-    virtual ~StopWaitingFrame() {}
-
-    void SetLeastSeq(PacketNumber seq)
-    {
-        least_unacked = seq;
-    }
+    NackFrame();
+    virtual ~NackFrame() {}
 
-    PacketNumber GetLeastSeq(void) const
-    {
-        return least_unacked;
-    }
-
-  PacketNumber least_unacked; // by dd
-  private:
-    //PacketNumber least_unacked; // by dd
+    ConnectionId connection_id;
+    // Missing packets, in increasing order.
+    std::vector<PacketNumber> missing_packets;
 
     static const PacketType m_type;
+
   public:
     /**
        * \brief Get the type ID.
@@ -51,4 +47,4 @@ class StopWaitingFrame : public Header
 }
 }
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,167 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2008 INRIA
+ *
+ * Author: daibo <daibo@yy.com>
+ */
+#include "ns3/core-module.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "nack-tracker.h"
+
+namespace ns3
+{
+NS_LOG_COMPONENT_DEFINE("NackTracker");
+namespace bbr
+{
+namespace
+{
+const PacketCount kDefaultNackReorderingThreshold = 2;
+// Frames and nacked packets remembered.
+const size_t kMaxNackFrames = 256;
+const size_t kMaxNackedPackets = 1024;
+const size_t kMaxRepairPackets = 256;
+// Longest gap looked at between two packets of a stream.
+const PacketCount kMaxNackRange = 256;
+
+// Packets below the peer's least awaiting ack are no longer tracked, so
+// they look missing without being so.
+bool IsMissing(ReceivedPacketManager *received_packet_manager, PacketNumber packet_number)
+{
+    return received_packet_manager->IsMissing(packet_number) &&
+           received_packet_manager->IsAwaitingPacket(packet_number);
+}
+}
+
+NackTracker::NackTracker()
+    : reordering_threshold_(kDefaultNackReorderingThreshold),
+      largest_received_(0),
+      packets_nacked_(0)
+{
+}
+
+void NackTracker::OnFramePacket(PacketNumber pic_index,
+                                uint16_t pic_cur_pkt_seq,
+                                PacketNumber packet_number,
+                                ReceivedPacketManager *received_packet_manager)
+{
+    PacketNumber lower = packet_number;
+    PacketCount frame_packets_missing = 0;
+    std::map<PacketNumber, FramePacket>::iterator it = frames_.find(pic_index);
+    if (it == frames_.end())
+    {
+        // The earlier packets of the frame went out after the last packet
+        // received on the stream, among packets of the other streams.
+        lower = largest_received_ + 1;
+        frame_packets_missing = pic_cur_pkt_seq;
+        FramePacket packet = {pic_cur_pkt_seq, packet_number};
+        frames_.insert(std::make_pair(pic_index, packet));
+        if (frames_.size() > kMaxNackFrames)
+        {
+            frames_.erase(frames_.begin());
+        }
+    }
+    else if (pic_cur_pkt_seq > it->second.pic_cur_pkt_seq && packet_number > it->second.packet_number)
+    {
+        lower = it->second.packet_number + 1;
+        frame_packets_missing = pic_cur_pkt_seq - it->second.pic_cur_pkt_seq - 1;
+        it->second.pic_cur_pkt_seq = pic_cur_pkt_seq;
+        it->second.packet_number = packet_number;
+    }
+    largest_received_ = std::max(largest_received_, packet_number);
+    if (frame_packets_missing > 0 && lower < packet_number)
+    {
+        MaybeAddCandidates(lower, packet_number, frame_packets_missing, received_packet_manager);
+    }
+}
+
+void NackTracker::OnRepairPacket(PacketNumber packet_number)
+{
+    largest_received_ = std::max(largest_received_, packet_number);
+    repair_packets_.insert(packet_number);
+    while (repair_packets_.size() > kMaxRepairPackets)
+    {
+        repair_packets_.erase(repair_packets_.begin());
+    }
+}
+
+void NackTracker::MaybeAddCandidates(PacketNumber lower,
+                                     PacketNumber upper,
+                                     PacketCount frame_packets_missing,
+                                     ReceivedPacketManager *received_packet_manager)
+{
+    if (upper - lower > kMaxNackRange)
+    {
+        return;
+    }
+    // A repair packet in the gap means the missing packets may be repair
+    // packets too, or recovered from it.
+    std::set<PacketNumber>::const_iterator repair = repair_packets_.lower_bound(lower);
+    if (repair != repair_packets_.end() && *repair < upper)
+    {
+        return;
+    }
+    std::vector<PacketNumber> missing_packets;
+    for (PacketNumber missing = lower; missing < upper; ++missing)
+    {
+        if (IsMissing(received_packet_manager, missing))
+        {
+            missing_packets.push_back(missing);
+        }
+    }
+    // More missing packets than the frame skipped: some belong to other
+    // streams and there is no telling which.
+    if (missing_packets.size() != frame_packets_missing)
+    {
+        return;
+    }
+    for (PacketNumber missing : missing_packets)
+    {
+        if (nacked_.count(missing) == 0)
+        {
+            candidates_.insert(missing);
+        }
+    }
+}
+
+bool NackTracker::GetNackFrame(ReceivedPacketManager *received_packet_manager, NackFrame *frame)
+{
+    frame->missing_packets.clear();
+    const PacketNumber largest_observed = received_packet_manager->GetLargestObserved();
+    while (!candidates_.empty() && *candidates_.begin() + reordering_threshold_ <= largest_observed)
+    {
+        const PacketNumber packet_number = *candidates_.begin();
+        candidates_.erase(candidates_.begin());
+        if (!IsMissing(received_packet_manager, packet_number))
+        {
+            continue;
+        }
+        frame->missing_packets.push_back(packet_number);
+        nacked_.insert(packet_number);
+        ++packets_nacked_;
+    }
+    while (nacked_.size() > kMaxNackedPackets)
+    {
+        nacked_.erase(nacked_.begin());
+    }
+    return !frame->missing_packets.empty();
+}
+
+void NackTracker::Clear()
+{
+    frames_.clear();
+    repair_packets_.clear();
+    candidates_.clear();
+    nacked_.clear();
+    largest_received_ = 0;
+    packets_nacked_ = 0;
+}
+
+void NackTracker::RemoveFramesBefore(PacketNumber pic_index)
+{
+    frames_.erase(frames_.begin(), frames_.lower_bound(pic_index));
+}
+}
+}
@@ -0,0 +1,91 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2008 INRIA
+ *
+ * Author: daibo <daibo@yy.com>
+ */
+#ifndef NACK_TRACKER_H
+#define NACK_TRACKER_H
+
+#include <map>
+#include <set>
+
+#include "bbr-common.h"
+#include "nack-frame.h"
+#include "received-packet-manager.h"
+
+namespace ns3
+{
+namespace bbr
+{
+// Finds packets missing within a frame of one stream at the receiver.
+// Packet numbers are shared by the streams of a connection and by repair
+// packets, so a gap between two received packets of the stream belongs to
+// it only when it holds exactly as many missing packets as the frame
+// sequence numbers skipped and no repair packet.  Other gaps are left to
+// the sender's loss detection.  The packets of a gap are nacked once
+// packets |reordering_threshold| above them have arrived, each at most once.
+class NackTracker
+{
+  public:
+    NackTracker();
+
+    void set_reordering_threshold(PacketCount reordering_threshold)
+    {
+        reordering_threshold_ = reordering_threshold;
+    }
+
+    // Records that source packet |pic_cur_pkt_seq| of frame |pic_index|
+    // arrived as |packet_number|.
+    void OnFramePacket(PacketNumber pic_index,
+                       uint16_t pic_cur_pkt_seq,
+                       PacketNumber packet_number,
+                       ReceivedPacketManager *received_packet_manager);
+
+    // Records that a repair packet of the stream arrived as |packet_number|.
+    void OnRepairPacket(PacketNumber packet_number);
+
+    // Fills in |frame| with the packets to nack now.  Returns false if there
+    // are none.
+    bool GetNackFrame(ReceivedPacketManager *received_packet_manager, NackFrame *frame);
+
+    // Forgets the frames below |pic_index|, which will never complete.
+    void RemoveFramesBefore(PacketNumber pic_index);
+
+    PacketCount packets_nacked() const { return packets_nacked_; }
+
+    void Clear();
+
+  private:
+    struct FramePacket
+    {
+        uint16_t pic_cur_pkt_seq;
+        PacketNumber packet_number;
+    };
+
+    // Adds the packets missing in [lower, upper) as candidates if they are
+    // the |frame_packets_missing| packets of the stream skipped there.
+    void MaybeAddCandidates(PacketNumber lower,
+                            PacketNumber upper,
+                            PacketCount frame_packets_missing,
+                            ReceivedPacketManager *received_packet_manager);
+
+    PacketCount reordering_threshold_;
+    // Largest packet number received on the stream, source or repair.
+    PacketNumber largest_received_;
+    // Highest packet received of each recent frame.
+    std::map<PacketNumber, FramePacket> frames_;
+    // Recent repair packets of the stream.
+    std::set<PacketNumber> repair_packets_;
+    // Missing packets waiting for the reordering threshold.
+    std::set<PacketNumber> candidates_;
+    // Recently nacked packets, not nacked again.
+    std::set<PacketNumber> nacked_;
+    PacketCount packets_nacked_;
+
+    DISALLOW_COPY_AND_ASSIGN(NackTracker);
+};
+}
+}
+
+#endif
@@ -36,6 +36,18 @@ void PacingSender::set_sender(SendAlgorithmInterface *sender)
     sender_ = sender;
 }
 
+void PacingSender::AddBurstTokens(PacketCount tokens)
+{
+    NS_ASSERT(sender_ != nullptr);
+    if (sender_->InRecovery())
+    {
+        return;
+    }
+    const PacketCount cwnd_packets = sender_->GetCongestionWindow() / kDefaultTCPMSS;
+    burst_tokens_ = std::max<uint32_t>(burst_tokens_, std::min(tokens, cwnd_packets));
+    NS_LOG_DEBUG("Burst tokens " << burst_tokens_);
+}
+
 void PacingSender::OnCongestionEvent(
     bool rtt_updated,
     ByteCount bytes_in_flight,
@@ -67,8 +79,9 @@ bool PacingSender::OnPacketSent(
     {
         // Add more burst tokens anytime the connection is leaving quiescence, but
         // limit it to the equivalent of a single bulk write, not exceeding the
-        // current CWND in packets.
-        burst_tokens_ = std::min(kInitialUnpacedBurst, static_cast<uint32_t>(sender_->GetCongestionWindow() / kDefaultTCPMSS));
+        // current CWND in packets.  Tokens granted for this burst are kept.
+        burst_tokens_ = std::max(burst_tokens_,
+                                 std::min(kInitialUnpacedBurst, static_cast<uint32_t>(sender_->GetCongestionWindow() / kDefaultTCPMSS)));
     }
     if (burst_tokens_ > 0)
     {
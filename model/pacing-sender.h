@@ -31,6 +31,10 @@ class PacingSender
         max_pacing_rate_ = max_pacing_rate;
     }
 
+    // Lets up to |tokens| packets, but no more than the congestion window,
+    // go out unpaced.  Has no effect in recovery.
+    void AddBurstTokens(PacketCount tokens);
+
     void OnCongestionEvent(
         bool rtt_updated,
         ByteCount bytes_in_flight,
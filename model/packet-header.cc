@@ -7,7 +7,11 @@
 
 #include "ns3/core-module.h"
 
+#include <algorithm>
+
 #include "packet-header.h"
+#include "udp-bbr-constants.h"
+#include "varint.h"
 
 namespace ns3
 {
@@ -17,19 +21,62 @@ NS_LOG_COMPONENT_DEFINE("PacketHeader");
 
 NS_OBJECT_ENSURE_REGISTERED(PacketHeader);
 
+namespace
+{
+// The lowest two bits of the flags give the packet number length, 1 << x
+// bytes.
+const uint8_t kPacketNumberLengthMask = 0x03;
+const uint8_t kFrameMetadataFlag = 0x04;
+const uint8_t kStreamIdFlag = 0x08;
+// Frames of each stream the receiver keeps the metadata of.
+const size_t kMaxFrameMetadata = 256;
+
+uint8_t PacketNumberLengthToFlags(uint32_t length)
+{
+    switch (length)
+    {
+    case 1:
+        return 0;
+    case 2:
+        return 1;
+    case 4:
+        return 2;
+    default:
+        return 3;
+    }
+}
+}
+
 const PacketType PacketHeader::m_type = kStreamPacket;
 
 PacketHeader::PacketHeader()
-    : m_packet_seq(0),
+    : m_connection_id(0),
+      m_packet_seq(0),
       m_old_packet_seq(0),
       m_transmission_type(NOT_RETRANSMISSION),
       m_sent_time(0),
       m_data_length(0),
       m_data_packet(nullptr),
-      m_data_seq(0)
+      m_data_seq(0),
+      m_largest_acked(0),
+      m_stream_id(0),
+      m_least_unexpired_pic(0),
+      PicType(0),
+      PicIndex(0),
+      PicDataLen(0),
+      PicPktNum(0),
+      PicCurPktSeq(0),
+      PicGenTime(0),
+      m_context(nullptr),
+      m_has_frame_metadata(true)
 {
 }
 
+bool PacketHeader::SendsFrameMetadata() const
+{
+    return PicCurPktSeq == 0 || m_transmission_type != NOT_RETRANSMISSION || PicType == pic_type_fec;
+}
+
 TypeId PacketHeader::GetTypeId(void)
 {
     static TypeId tid = TypeId("ns3::PacketHeader")
@@ -47,29 +94,78 @@ TypeId PacketHeader::GetInstanceTypeId(void) const
 void PacketHeader::Print(std::ostream &os) const
 {
     os << "(seq=" << m_data_seq << ", " << m_packet_seq << ")";
+    if (m_stream_id != 0)
+    {
+        os << " stream " << m_stream_id;
+    }
 }
 
 uint32_t PacketHeader::GetSerializedSize(void) const
 {
-    return sizeof(uint8_t) + sizeof(PacketNumber) + sizeof(PacketNumber) + sizeof(uint64_t) +
-           sizeof(uint8_t) + sizeof(PacketNumber) + 3*sizeof(uint16_t) + sizeof(uint64_t);
+    uint32_t size = 2 * sizeof(uint8_t) + GetVarIntLength(m_connection_id) +
+                    GetPacketNumberLength(m_packet_seq, m_largest_acked) +
+                    GetVarIntLength(m_packet_seq - m_largest_acked) +
+                    GetVarIntLength(m_data_seq) +
+                    GetVarIntLength(PicIndex) +
+                    GetVarIntLength(PicIndex - std::min(m_least_unexpired_pic, PicIndex)) +
+                    GetVarIntLength(PicCurPktSeq) +
+                    GetVarIntLength(m_sent_time - std::min(PicGenTime, m_sent_time));
+    if (m_stream_id != 0)
+    {
+        size += GetVarIntLength(m_stream_id);
+    }
+    if (SendsFrameMetadata())
+    {
+        size += sizeof(uint8_t) + GetVarIntLength(PicDataLen) + GetVarIntLength(PicPktNum) +
+                GetVarIntLength(PicGenTime);
+    }
+    return size;
 }
 
 void PacketHeader::Serialize(Buffer::Iterator start) const
 {
+    NS_ASSERT(SEQ_LT(m_largest_acked, m_packet_seq));
     Buffer::Iterator i = start;
+    const uint32_t length = GetPacketNumberLength(m_packet_seq, m_largest_acked);
+    const bool frame_metadata = SendsFrameMetadata();
     i.WriteU8(m_type);
-    i.WriteHtonU64(m_packet_seq);
-    i.WriteHtonU64(m_sent_time);
-    i.WriteHtonU64(m_data_seq);
-
-    i.WriteU8(PicType);
-    i.WriteHtonU64(PicIndex);
-    i.WriteHtonU16(PicDataLen);
-    i.WriteHtonU16(PicPktNum);
-    i.WriteHtonU16(PicCurPktSeq);
-    i.WriteHtonU64(PicGenTime);
-
+    WriteVarInt(i, m_connection_id);
+    i.WriteU8(PacketNumberLengthToFlags(length) | (frame_metadata ? kFrameMetadataFlag : 0) |
+              (m_stream_id != 0 ? kStreamIdFlag : 0));
+    switch (length)
+    {
+    case 1:
+        i.WriteU8(m_packet_seq);
+        break;
+    case 2:
+        i.WriteHtonU16(m_packet_seq);
+        break;
+    case 4:
+        i.WriteHtonU32(m_packet_seq);
+        break;
+    default:
+        i.WriteHtonU64(m_packet_seq);
+        break;
+    }
+    WriteVarInt(i, m_packet_seq - m_largest_acked);
+    WriteVarInt(i, m_data_seq);
+    if (m_stream_id != 0)
+    {
+        WriteVarInt(i, m_stream_id);
+    }
+    WriteVarInt(i, PicIndex);
+    // A lower bound is all the receiver needs, so a pic that expired after
+    // this packet was queued does not make the delta negative.
+    WriteVarInt(i, PicIndex - std::min(m_least_unexpired_pic, PicIndex));
+    WriteVarInt(i, PicCurPktSeq);
+    WriteVarInt(i, m_sent_time - std::min(PicGenTime, m_sent_time));
+    if (frame_metadata)
+    {
+        i.WriteU8(PicType);
+        WriteVarInt(i, PicDataLen);
+        WriteVarInt(i, PicPktNum);
+        WriteVarInt(i, PicGenTime);
+    }
 }
 
 uint32_t PacketHeader::Deserialize(Buffer::Iterator start)
@@ -77,20 +173,171 @@ uint32_t PacketHeader::Deserialize(Buffer::Iterator start)
     Buffer::Iterator i = start;
     uint8_t type = i.ReadU8();
     NS_ASSERT(type == kStreamPacket);
-    m_packet_seq = i.ReadNtohU64();
-    m_sent_time = i.ReadNtohU64();
-    m_data_seq = i.ReadNtohU64();
+    m_connection_id = ReadVarInt(i);
+    const uint8_t flags = i.ReadU8();
+    const uint32_t length = 1u << (flags & kPacketNumberLengthMask);
+    uint64_t truncated = 0;
+    switch (length)
+    {
+    case 1:
+        truncated = i.ReadU8();
+        break;
+    case 2:
+        truncated = i.ReadNtohU16();
+        break;
+    case 4:
+        truncated = i.ReadNtohU32();
+        break;
+    default:
+        truncated = i.ReadNtohU64();
+        break;
+    }
+    m_packet_seq = DecodePacketNumber(truncated, length, m_context ? m_context->largest_received() : 0);
+    m_largest_acked = m_packet_seq - ReadVarInt(i);
+    m_data_seq = ReadVarInt(i);
+    m_stream_id = (flags & kStreamIdFlag) ? ReadVarInt(i) : 0;
+    PicIndex = ReadVarInt(i);
+    m_least_unexpired_pic = PicIndex - ReadVarInt(i);
+    PicCurPktSeq = ReadVarInt(i);
+    m_sent_time = ReadVarInt(i);
+
+    if (flags & kFrameMetadataFlag)
+    {
+        PicType = i.ReadU8();
+        PicDataLen = ReadVarInt(i);
+        PicPktNum = ReadVarInt(i);
+        PicGenTime = ReadVarInt(i);
+        m_sent_time += PicGenTime;
+        m_has_frame_metadata = true;
+        if (m_context)
+        {
+            m_context->RecordFrameMetadata(*this);
+        }
+    }
+    else
+    {
+        m_has_frame_metadata = false;
+        if (m_context)
+        {
+            m_context->ExpandFrameMetadata(this);
+        }
+    }
+    if (m_context)
+    {
+        m_context->OnPacketNumber(m_packet_seq);
+    }
+
+    return i.GetDistanceFrom(start);
+}
+
+uint32_t GetPacketNumberLength(PacketNumber packet_number, PacketNumber largest_acked)
+{
+    // RFC 9000, appendix A.2.
+    const uint64_t num_unacked = packet_number - largest_acked;
+    if (num_unacked < (UINT64_C(1) << 7))
+    {
+        return 1;
+    }
+    if (num_unacked < (UINT64_C(1) << 15))
+    {
+        return 2;
+    }
+    if (num_unacked < (UINT64_C(1) << 31))
+    {
+        return 4;
+    }
+    return 8;
+}
 
+PacketNumber DecodePacketNumber(uint64_t truncated, uint32_t length, PacketNumber largest_received)
+{
+    // RFC 9000, appendix A.3.
+    if (length >= sizeof(PacketNumber))
+    {
+        return truncated;
+    }
+    const PacketNumber expected = largest_received + 1;
+    const uint64_t window = UINT64_C(1) << (length * 8);
+    const uint64_t half_window = window / 2;
+    const PacketNumber candidate = (expected & ~(window - 1)) | truncated;
+    if (candidate + half_window <= expected)
+    {
+        return candidate + window;
+    }
+    if (candidate > expected + half_window && candidate >= window)
+    {
+        return candidate - window;
+    }
+    return candidate;
+}
 
-    PicType = i.ReadU8();
-    PicIndex = i.ReadNtohU64();
-    PicDataLen = i.ReadNtohU16();
-    PicPktNum = i.ReadNtohU16();
-    PicCurPktSeq = i.ReadNtohU16();
-    PicGenTime = i.ReadNtohU64();
+PacketHeaderContext::PacketHeaderContext()
+    : largest_received_(0)
+{
+}
 
+void PacketHeaderContext::OnPacketNumber(PacketNumber packet_number)
+{
+    largest_received_ = std::max(largest_received_, packet_number);
+}
 
-    return GetSerializedSize();
+void PacketHeaderContext::RecordFrameMetadata(const PacketHeader &header)
+{
+    FrameMap &frames = frames_[header.m_stream_id];
+    FrameMetadata &frame = frames[header.PicIndex];
+    // Repair packets describe the frame, but not the type of its source
+    // packets.
+    if (header.PicType != pic_type_fec)
+    {
+        frame.type = header.PicType;
+    }
+    frame.data_len = header.PicDataLen;
+    frame.pkt_num = header.PicPktNum;
+    frame.gen_time = header.PicGenTime;
+    while (frames.size() > kMaxFrameMetadata)
+    {
+        frames.erase(frames.begin());
+    }
+}
+
+bool PacketHeaderContext::ExpandFrameMetadata(PacketHeader *header) const
+{
+    if (header->m_has_frame_metadata)
+    {
+        return true;
+    }
+    std::map<StreamId, FrameMap>::const_iterator stream = frames_.find(header->m_stream_id);
+    if (stream == frames_.end())
+    {
+        return false;
+    }
+    FrameMap::const_iterator it = stream->second.find(header->PicIndex);
+    if (it == stream->second.end())
+    {
+        return false;
+    }
+    header->PicType = it->second.type;
+    header->PicDataLen = it->second.data_len;
+    header->PicPktNum = it->second.pkt_num;
+    header->PicGenTime = it->second.gen_time;
+    header->m_sent_time += it->second.gen_time;
+    header->m_has_frame_metadata = true;
+    return true;
+}
+
+void PacketHeaderContext::Clear()
+{
+    largest_received_ = 0;
+    frames_.clear();
+}
+
+void PacketHeaderContext::RemoveFramesBefore(StreamId stream_id, PacketNumber pic_index)
+{
+    std::map<StreamId, FrameMap>::iterator it = frames_.find(stream_id);
+    if (it != frames_.end())
+    {
+        it->second.erase(it->second.begin(), it->second.lower_bound(pic_index));
+    }
 }
 }
 }
\ No newline at end of file
@@ -6,6 +6,7 @@
  */
 #ifndef PACKET_HEADER_H
 #define PACKET_HEADER_H
+#include <map>
 #include <memory>
 #include "ns3/header.h"
 #include "packets.h"
@@ -15,6 +16,15 @@ namespace ns3
 {
 namespace bbr
 {
+class PacketHeaderContext;
+
+// On the wire, numbers are QUIC varints and the packet number is truncated
+// relative to |m_largest_acked|.  The stream ID is only sent when nonzero,
+// so a single stream connection does not pay for it.  The frame metadata,
+// PicType, PicDataLen, PicPktNum and PicGenTime, is only sent in the first
+// packet of a frame, in retransmissions and in repair packets; the other
+// packets carry PicIndex and PicCurPktSeq alone, and the receiver restores
+// the rest from the PacketHeaderContext.
 class PacketHeader : public Header
 {
   public:
@@ -22,6 +32,7 @@ class PacketHeader : public Header
     virtual ~PacketHeader() {}
 
   public:
+    ConnectionId m_connection_id;
     PacketNumber m_packet_seq; //!< current Sequence number
     PacketNumber m_old_packet_seq;
     TransmissionType m_transmission_type;
@@ -30,14 +41,33 @@ class PacketHeader : public Header
     //std::shared_ptr<DataPacket> m_data_packet;
     std::shared_ptr<PicDataPacket> m_data_packet;
     PacketNumber m_data_seq;
+    // Largest packet acked by the newest ack the sender received.  Packets
+    // below it need not be reported in acks any more.
+    PacketNumber m_largest_acked;
+    // Stream of the pic, whose PicIndex and m_least_unexpired_pic are
+    // numbered per stream.
+    StreamId m_stream_id;
+    // Pics below this index expired at the sender and will not be sent.
+    PacketNumber m_least_unexpired_pic;
 
     uint8_t      PicType;        // Frame Type for this encoded picture
     PacketNumber PicIndex;       // Global frame index for this picture
-    uint16_t     PicDataLen;
+    uint32_t     PicDataLen;
     uint16_t     PicPktNum;      // How many pkt needed for transmit this picture
     uint16_t     PicCurPktSeq;   // Current pkt seq for this pic
     uint64_t     PicGenTime;     // Current pkt data len
 
+    // Receiver state used to expand the compact header.  Not on the wire.
+    PacketHeaderContext *m_context;
+    // Set by Deserialize: false if the frame metadata was neither on the
+    // wire nor known to |m_context|, in which case the Pic* fields other than
+    // PicIndex and PicCurPktSeq are unset and |m_sent_time| is relative to
+    // PicGenTime until PacketHeaderContext::ExpandFrameMetadata succeeds.
+    bool m_has_frame_metadata;
+
+    // True if the frame metadata is sent with this packet.
+    bool SendsFrameMetadata() const;
+
     static const PacketType m_type;
   public:
     /**
@@ -51,6 +81,53 @@ class PacketHeader : public Header
     virtual void Serialize(Buffer::Iterator start) const;
     virtual uint32_t Deserialize(Buffer::Iterator start);
 };
+
+// Bytes the packet number is truncated to, enough for the receiver to tell
+// it apart from any packet between |largest_acked| and twice the distance.
+uint32_t GetPacketNumberLength(PacketNumber packet_number, PacketNumber largest_acked);
+
+// Restores the packet number closest to the one following |largest_received|
+// whose lowest |length| bytes are |truncated|.
+PacketNumber DecodePacketNumber(uint64_t truncated, uint32_t length, PacketNumber largest_received);
+
+// Frame metadata and packet number state of the receiver.
+class PacketHeaderContext
+{
+  public:
+    PacketHeaderContext();
+
+    PacketNumber largest_received() const { return largest_received_; }
+    void OnPacketNumber(PacketNumber packet_number);
+
+    // Remembers the metadata of the frame of |header|.
+    void RecordFrameMetadata(const PacketHeader &header);
+
+    // Fills in the frame metadata of |header| if known.  Returns
+    // |header->m_has_frame_metadata|.
+    bool ExpandFrameMetadata(PacketHeader *header) const;
+
+    // Forgets the frames of |stream_id| below |pic_index|.
+    void RemoveFramesBefore(StreamId stream_id, PacketNumber pic_index);
+
+    void Clear();
+
+  private:
+    struct FrameMetadata
+    {
+        uint8_t type;
+        uint32_t data_len;
+        uint16_t pkt_num;
+        uint64_t gen_time;
+    };
+
+    typedef std::map<PacketNumber, FrameMetadata> FrameMap;
+
+    PacketNumber largest_received_;
+    // By stream, then PicIndex.
+    std::map<StreamId, FrameMap> frames_;
+
+    DISALLOW_COPY_AND_ASSIGN(PacketHeaderContext);
+};
 }
 }
 
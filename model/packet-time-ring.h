@@ -0,0 +1,101 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2008 INRIA
+ *
+ * Author: daibo <daibo@yy.com>
+ */
+#ifndef PACKET_TIME_RING_H
+#define PACKET_TIME_RING_H
+
+#include <utility>
+#include <vector>
+
+#include "bbr-common.h"
+
+namespace ns3
+{
+namespace bbr
+{
+// A fixed-capacity ring of <packet number, receive time> pairs, in arrival
+// order.  Pushing into a full ring overwrites the oldest entry, so inserting,
+// expiring and clearing are all O(1) and the memory used never grows past
+// the capacity.
+class PacketTimeRing
+{
+  public:
+    typedef std::pair<PacketNumber, uint64_t> Entry;
+
+    explicit PacketTimeRing(size_t capacity)
+        : entries_(capacity), head_(0), size_(0) {}
+
+    // Resizes the ring, dropping its entries.
+    void set_capacity(size_t capacity)
+    {
+        entries_.assign(capacity, Entry());
+        Clear();
+    }
+
+    size_t capacity() const { return entries_.size(); }
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+    // Appends an entry, overwriting the oldest one if the ring is full.
+    void Push(PacketNumber packet_number, uint64_t time)
+    {
+        if (entries_.empty())
+        {
+            return;
+        }
+        if (size_ == entries_.size())
+        {
+            PopFront();
+        }
+        entries_[(head_ + size_) % entries_.size()] = Entry(packet_number, time);
+        ++size_;
+    }
+
+    // Oldest entry.  It is undefined behavior to call this if the ring is
+    // empty.
+    const Entry &front() const { return entries_[head_]; }
+
+    void PopFront()
+    {
+        head_ = (head_ + 1) % entries_.size();
+        --size_;
+    }
+
+    // Drops the oldest entries while they are below |packet_number|.
+    void RemoveBefore(PacketNumber packet_number)
+    {
+        while (!empty() && front().first < packet_number)
+        {
+            PopFront();
+        }
+    }
+
+    void Clear()
+    {
+        head_ = 0;
+        size_ = 0;
+    }
+
+    // Replaces |times| with the entries, oldest first.
+    void CopyTo(std::vector<Entry> *times) const
+    {
+        times->clear();
+        for (size_t k = 0; k < size_; ++k)
+        {
+            times->push_back(entries_[(head_ + k) % entries_.size()]);
+        }
+    }
+
+  private:
+    std::vector<Entry> entries_;
+    // Index of the oldest entry.
+    size_t head_;
+    size_t size_;
+};
+}
+}
+
+#endif
@@ -20,30 +20,60 @@ namespace ns3
 namespace bbr
 {
 
+// Classes of packets the send scheduler chooses from, in decreasing order of
+// strict priority.
 enum ProtocolSendPriority
 {
-    P0,
-    P1,
-    END,
+    // First transmission of an audio frame, small and the first to be heard
+    // missing.
+    kPriorityAudio = 0,
+    // First transmission of a keyframe, which every later frame depends on.
+    kPriorityKeyFrame,
+    // Retransmission of a lost packet.
+    kPriorityRetransmission,
+    // FEC repair packet of the frame just sent.
+    kPriorityFecRepair,
+    // First transmission of any other frame.
+    kPriorityFreshData,
+    // First transmission of bulk data, sent with what the media leaves.
+    kPriorityBulkData,
+    kNumSendPriorities,
 };
 
+// How the sender handles the lost packets of a stream.
+enum StreamReliability
+{
+    // Retransmitted until acked.
+    kReliable = 0,
+    // Retransmitted until the frame expires or is too old to be worth it.
+    kPartiallyReliable,
+    // Never retransmitted: the packet expires as soon as it is sent.
+    kUnreliable,
+};
+
+// Most layers a layered (SVC or simulcast) pic is made of.
+const uint8_t kMaxVideoLayers = 4;
+
 struct PicData{
 
     uint8_t      CurType;           // Frame Type for this encoded picture
     PacketNumber PicSeq;            // Global frame index for this picture
-    uint16_t     PicDataLen;
+    uint32_t     PicDataLen;
     uint16_t     PicPktNum;         // How many pkt needed for transmit this picture
-    uint16_t     PicCurPktSeq;      // Current pkt seq for this pic
+    uint16_t     PicCurPktSeq;      // Next pkt seq of this pic to send
+    uint16_t     PicLastPktLen;     // Payload of the last pkt, the others carry DEFAULT_PAYLOAD_SIZE
+    ProtocolSendPriority Priority;  // Send class of the pkts of this pic
+    uint8_t      PicNumLayers;      // Layers of this pic, the base layer first
+    uint32_t     PicLayerEnd[kMaxVideoLayers]; // End of each layer in the pic data
     uint64_t     PicGenTime;        // Current pkt data len
     uint64_t     PicExpireTime;     // Current pkt data len
-
-    std::deque<uint16_t> PktDataLen;
+    uint64_t     PicReleaseSpan;    // ms over which the pkts are released evenly, 0 for at once
 };
 
 struct DataPacket
 {
     DataPacket()
-        : data_seq(0), data_length(0), priority(P0)
+        : data_seq(0), data_length(0), priority(kPriorityFreshData)
         , expire_time(0), last_send_time(0), send_count(0), useless(false)
     {
     }
@@ -64,16 +94,19 @@ struct DataPacket
 struct PicDataPacket
 {
     PicDataPacket()
-         : data_seq(0), data_length(0), priority(P0)
-         , expire_time(0), last_send_time(0), send_count(0), useless(false),
+         : stream_id(0), reliability(kPartiallyReliable),
            PicType(0),PicIndex(0),PicPktNum(0),PicCurPktSeq(0)
+         , data_seq(0), data_length(0), priority(kPriorityFreshData)
+         , expire_time(0), last_send_time(0), send_count(0), useless(false)
     {
     }
     ~PicDataPacket() {}
 
+    StreamId     stream_id;      // Stream the picture belongs to
+    StreamReliability reliability;
     uint8_t      PicType;        // Frame Type for this encoded picture
     PacketNumber PicIndex;       // Global frame index for this picture
-    uint16_t     PicDataLen;
+    uint32_t     PicDataLen;
     uint16_t     PicPktNum;      // How many pkt needed for transmit this picture
     uint16_t     PicCurPktSeq;   // Current pkt seq for this pic
     uint64_t     PicGenTime;     // Current pkt data len
@@ -0,0 +1,131 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2008 INRIA
+ *
+ * Author: daibo <daibo@yy.com>
+ */
+#ifndef PIC_QUEUE_H
+#define PIC_QUEUE_H
+
+#include <vector>
+
+#include "bbr-common.h"
+#include "packets.h"
+#include "udp-bbr-constants.h"
+
+namespace ns3
+{
+namespace bbr
+{
+// Frames waiting to be sent, in generation order.
+//
+// Queued frames live in a ring that doubles when full, so pushing and
+// popping are amortized O(1).  Each frame keeps a cursor on its next packet
+// (PicCurPktSeq) rather than a list of packet lengths.
+class PicQueue
+{
+  public:
+    PicQueue() : frames_(8), head_(0), size_(0) {}
+
+    // Payload of packet |seq| of |pic|.
+    static PacketLength GetPacketLength(const PicData &pic, uint16_t seq)
+    {
+        return seq + 1 < pic.PicPktNum ? DEFAULT_PAYLOAD_SIZE : pic.PicLastPktLen;
+    }
+
+    // Packets and bytes of |pic| not sent yet.
+    static uint16_t GetUnsentPackets(const PicData &pic)
+    {
+        return pic.PicPktNum - pic.PicCurPktSeq;
+    }
+    static ByteCount GetUnsentBytes(const PicData &pic)
+    {
+        const uint16_t unsent = GetUnsentPackets(pic);
+        if (unsent == 0)
+        {
+            return 0;
+        }
+        return (unsent - 1) * static_cast<ByteCount>(DEFAULT_PAYLOAD_SIZE) + pic.PicLastPktLen;
+    }
+
+    // Time from which packet |seq| of |pic| may be sent.
+    static uint64_t GetReleaseTime(const PicData &pic, uint16_t seq)
+    {
+        return pic.PicGenTime + pic.PicReleaseSpan * seq / pic.PicPktNum;
+    }
+
+    // Sets the length of |pic| and splits it into packets.
+    static void SetDataLen(PicData *pic, uint32_t data_len)
+    {
+        pic->PicDataLen = data_len;
+        pic->PicPktNum = (data_len + DEFAULT_PAYLOAD_SIZE - 1) / DEFAULT_PAYLOAD_SIZE;
+        pic->PicLastPktLen = data_len - (pic->PicPktNum - 1) * DEFAULT_PAYLOAD_SIZE;
+    }
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+    // Oldest queued frame.  It is undefined behavior to call these if the
+    // queue is empty.
+    PicData &front() { return frames_[head_]; }
+    const PicData &front() const { return frames_[head_]; }
+
+    void Push(const PicData &pic)
+    {
+        if (size_ == frames_.size())
+        {
+            Grow();
+        }
+        frames_[(head_ + size_) % frames_.size()] = pic;
+        ++size_;
+    }
+
+    void PopFront()
+    {
+        head_ = (head_ + 1) % frames_.size();
+        --size_;
+    }
+
+    // Drops the layers from |num_layers| (at least one) up of the queued
+    // frames none of whose packets were sent.  Returns the bytes dropped.
+    ByteCount DropLayers(uint8_t num_layers)
+    {
+        ByteCount dropped = 0;
+        for (size_t k = 0; k < size_; ++k)
+        {
+            PicData &pic = frames_[(head_ + k) % frames_.size()];
+            if (pic.PicCurPktSeq > 0 || pic.PicNumLayers <= num_layers)
+            {
+                continue;
+            }
+            const uint32_t data_len = pic.PicLayerEnd[num_layers - 1];
+            dropped += pic.PicDataLen - data_len;
+            pic.PicNumLayers = num_layers;
+            SetDataLen(&pic, data_len);
+        }
+        return dropped;
+    }
+
+  private:
+    void Grow()
+    {
+        std::vector<PicData> frames(frames_.size() * 2);
+        for (size_t k = 0; k < size_; ++k)
+        {
+            frames[k] = frames_[(head_ + k) % frames_.size()];
+        }
+        frames_.swap(frames);
+        head_ = 0;
+    }
+
+    std::vector<PicData> frames_;
+    // Index of the oldest queued frame.
+    size_t head_;
+    size_t size_;
+
+    DISALLOW_COPY_AND_ASSIGN(PicQueue);
+};
+}
+}
+
+#endif
@@ -0,0 +1,152 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2008 INRIA
+ *
+ * Author: daibo <daibo@yy.com>
+ */
+
+#include "ns3/core-module.h"
+#include "rack-loss-algorithm.h"
+#include "rtt-stats.h"
+
+namespace ns3
+{
+NS_LOG_COMPONENT_DEFINE("RackLossAlgorithm");
+namespace bbr
+{
+// The minimum reordering window, regardless of min_rtt.
+static const uint64_t kMinReorderingWindowMs = 1;
+// Number of loss recoveries an enlarged reordering window survives.
+static const size_t kReorderingWindowPersist = 16;
+
+RackLossAlgorithm::RackLossAlgorithm()
+    : loss_detection_timeout_(0),
+      rack_sent_time_(0),
+      rack_packet_(0),
+      reo_wnd_mult_(1),
+      reo_wnd_persist_(0),
+      largest_sent_on_spurious_retransmit_(0),
+      recovery_end_(0),
+      cursor_(0) {}
+
+LossDetectionType RackLossAlgorithm::GetLossDetectionType() const
+{
+    return kRack;
+}
+
+uint64_t RackLossAlgorithm::GetReorderingWindow(const RttStats &rtt_stats) const
+{
+    uint64_t min_rtt = rtt_stats.min_rtt();
+    if (min_rtt == 0)
+    {
+        min_rtt = rtt_stats.initial_rtt_ms();
+    }
+    uint64_t reo_wnd = reo_wnd_mult_ * (min_rtt >> 2);
+    if (rtt_stats.smoothed_rtt() > 0)
+    {
+        reo_wnd = std::min<uint64_t>(reo_wnd, rtt_stats.smoothed_rtt());
+    }
+    return std::max(kMinReorderingWindowMs, reo_wnd);
+}
+
+void RackLossAlgorithm::DetectLosses(
+    const UnackedPacketMap &unacked_packets,
+    uint64_t time,
+    const RttStats &rtt_stats,
+    PacketNumber largest_newly_acked,
+    SendAlgorithmInterface::CongestionVector *packets_lost)
+{
+    loss_detection_timeout_ = 0;
+
+    // Packet numbers grow with send time, so the largest newly acked packet
+    // is also the most recently sent one among those just delivered.
+    if (largest_newly_acked > rack_packet_ &&
+        largest_newly_acked >= unacked_packets.GetLeastUnacked() &&
+        largest_newly_acked <= unacked_packets.largest_sent_packet())
+    {
+        rack_packet_ = largest_newly_acked;
+        rack_sent_time_ = std::max(rack_sent_time_, unacked_packets.GetTransmissionInfo(largest_newly_acked).sent_time);
+    }
+    if (rack_packet_ == 0 || !unacked_packets.HasInFlightPackets())
+    {
+        return;
+    }
+
+    const uint64_t reo_wnd = GetReorderingWindow(rtt_stats);
+    const uint64_t rack_rtt = rtt_stats.latest_rtt();
+    const size_t lost_before = packets_lost->size();
+
+    cursor_ = std::max(cursor_, unacked_packets.GetLeastUnacked());
+    for (PacketNumber packet_number = cursor_;
+         packet_number <= unacked_packets.largest_sent_packet() && packet_number < rack_packet_;
+         ++packet_number)
+    {
+        const TransmissionInfo &info = unacked_packets.GetTransmissionInfo(packet_number);
+        if (!info.in_flight)
+        {
+            // Acked or already declared lost.
+            cursor_ = packet_number + 1;
+            continue;
+        }
+        if (info.sent_time > rack_sent_time_)
+        {
+            break;
+        }
+        const uint64_t when_lost = info.sent_time + rack_rtt + reo_wnd;
+        if (time < when_lost)
+        {
+            // Every later packet was sent no earlier, so none of them can be
+            // lost before this one.
+            loss_detection_timeout_ = when_lost;
+            break;
+        }
+        // The caller removes lost packets from flight, so the cursor can move
+        // past them.
+        packets_lost->push_back(std::make_pair(packet_number, info.bytes_sent));
+        cursor_ = packet_number + 1;
+    }
+
+    if (packets_lost->size() > lost_before && rack_packet_ > recovery_end_)
+    {
+        // A new loss recovery episode.
+        recovery_end_ = unacked_packets.largest_sent_packet();
+        if (reo_wnd_persist_ > 0 && --reo_wnd_persist_ == 0)
+        {
+            reo_wnd_mult_ = 1;
+        }
+    }
+}
+
+uint64_t RackLossAlgorithm::GetLossTimeout() const
+{
+    return loss_detection_timeout_;
+}
+
+void RackLossAlgorithm::SpuriousRetransmitDetected(
+    const UnackedPacketMap &unacked_packets,
+    uint64_t time,
+    const RttStats &rtt_stats,
+    PacketNumber spurious_retransmission)
+{
+    // Like a DSACK, a spurious retransmission shows the reordering window was
+    // too small.  Widen it at most once per round trip.
+    if (spurious_retransmission <= largest_sent_on_spurious_retransmit_)
+    {
+        return;
+    }
+    largest_sent_on_spurious_retransmit_ = unacked_packets.largest_sent_packet();
+    if (rtt_stats.smoothed_rtt() == 0 || GetReorderingWindow(rtt_stats) < static_cast<uint64_t>(rtt_stats.smoothed_rtt()))
+    {
+        ++reo_wnd_mult_;
+    }
+    reo_wnd_persist_ = kReorderingWindowPersist;
+    NS_LOG_DEBUG("spurious retransmission " << spurious_retransmission
+                 << " reordering window " << GetReorderingWindow(rtt_stats));
+}
+
+void RackLossAlgorithm::OnPacketRestoredToInFlight(PacketNumber packet_number)
+{
+    cursor_ = std::min(cursor_, packet_number);
+}
+}
+}
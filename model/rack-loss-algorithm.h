@@ -0,0 +1,90 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2008 INRIA
+ *
+ * Author: daibo <daibo@yy.com>
+ */
+#ifndef RACK_LOSS_ALGORITHM_H
+#define RACK_LOSS_ALGORITHM_H
+
+#include "bbr-common.h"
+#include "loss-detection-interface.h"
+
+namespace ns3
+{
+namespace bbr
+{
+class RttStats;
+
+// RACK (Recent ACKnowledgment) loss detection, after RFC 8985.  A packet is
+// lost once a packet sent after it has been delivered and it has been
+// outstanding for longer than the RTT of that delivery plus a reordering
+// window.  The reordering window starts at a quarter of min_rtt and grows
+// each time a loss retransmission turns out to be spurious, and shrinks back
+// after a number of loss recoveries without spurious retransmissions.
+//
+// Packets are sent in packet number order, so packets older than the oldest
+// packet still in flight never need to be looked at again.  The algorithm
+// keeps a cursor on that packet, which makes the cost of each detection
+// proportional to the packets that became eligible since the previous one.
+class RackLossAlgorithm : public LossDetectionInterface
+{
+  public:
+    RackLossAlgorithm();
+    ~RackLossAlgorithm() override {}
+
+    LossDetectionType GetLossDetectionType() const override;
+
+    void DetectLosses(
+        const UnackedPacketMap &unacked_packets,
+        uint64_t time,
+        const RttStats &rtt_stats,
+        PacketNumber largest_newly_acked,
+        SendAlgorithmInterface::CongestionVector *packets_lost) override;
+
+    uint64_t GetLossTimeout() const override;
+
+    // Widens the reordering window so |spurious_retransmission| would not
+    // have been declared lost.
+    void SpuriousRetransmitDetected(
+        const UnackedPacketMap &unacked_packets,
+        uint64_t time,
+        const RttStats &rtt_stats,
+        PacketNumber spurious_retransmission) override;
+
+    void OnPacketRestoredToInFlight(PacketNumber packet_number) override;
+
+    // Returns the reordering window for the given RTT stats.
+    uint64_t GetReorderingWindow(const RttStats &rtt_stats) const;
+
+    size_t reordering_window_multiplier() const { return reo_wnd_mult_; }
+
+    PacketNumber first_in_flight_cursor() const { return cursor_; }
+
+  private:
+    uint64_t loss_detection_timeout_;
+
+    // Send time and packet number of the most recently sent packet which has
+    // been delivered.
+    uint64_t rack_sent_time_;
+    PacketNumber rack_packet_;
+
+    // The reordering window is |reo_wnd_mult_| quarters of min_rtt.
+    size_t reo_wnd_mult_;
+    // Number of loss recoveries left before the window is reset.
+    size_t reo_wnd_persist_;
+    // Largest sent packet when a spurious retransmit was detected.  Limits
+    // widening the window to once per round trip.
+    PacketNumber largest_sent_on_spurious_retransmit_;
+    // Largest sent packet when the current loss recovery started.
+    PacketNumber recovery_end_;
+
+    // No packet below this one is in flight, so scans start here.
+    PacketNumber cursor_;
+
+    DISALLOW_COPY_AND_ASSIGN(RackLossAlgorithm);
+};
+}
+}
+
+#endif
@@ -24,7 +24,11 @@ const size_t kMaxPacketsAfterNewMissing = 4;
 ReceivedPacketManager::ReceivedPacketManager()
     : peer_least_packet_awaiting_ack_(0),
       ack_frame_updated_(false),
-      max_ack_ranges_(0),
+      received_packet_times_(kDefaultMaxAckTimestamps),
+      timestamp_policy_(kAckTimestampsAll),
+      timestamp_interval_(1),
+      packets_since_timestamp_(0),
+      max_ack_ranges_(kDefaultMaxAckRanges),
       time_largest_observed_(0)
 {
     ack_frame_.largest_observed = 0;
@@ -32,6 +36,16 @@ ReceivedPacketManager::ReceivedPacketManager()
 
 ReceivedPacketManager::~ReceivedPacketManager() {}
 
+void ReceivedPacketManager::Clear()
+{
+    peer_least_packet_awaiting_ack_ = 0;
+    ack_frame_ = AckFrame();
+    ack_frame_updated_ = false;
+    received_packet_times_.Clear();
+    packets_since_timestamp_ = 0;
+    time_largest_observed_ = 0;
+}
+
 void ReceivedPacketManager::RecordPacketReceived(
     const PacketHeader &header,
     uint64_t receipt_time)
@@ -44,18 +58,61 @@ void ReceivedPacketManager::RecordPacketReceived(
     }
     if (!ack_frame_updated_)
     {
-        ack_frame_.received_packet_times.clear();
+        received_packet_times_.Clear();
+        ack_frame_.recovered_packets.clear();
     }
     ack_frame_updated_ = true;
     ack_frame_.packets.Add(header.m_packet_seq);
 
-    if (SEQ_GT(packet_number, ack_frame_.largest_observed))
+    const bool largest = SEQ_GT(packet_number, ack_frame_.largest_observed);
+    if (largest)
     {
         ack_frame_.largest_observed = packet_number;
         time_largest_observed_ = receipt_time;
     }
 
-    ack_frame_.received_packet_times.push_back(std::make_pair(packet_number, receipt_time));
+    switch (timestamp_policy_)
+    {
+    case kAckTimestampsAll:
+        break;
+    case kAckTimestampsEveryNth:
+        if (++packets_since_timestamp_ < timestamp_interval_)
+        {
+            return;
+        }
+        packets_since_timestamp_ = 0;
+        break;
+    case kAckTimestampsLargest:
+        if (!largest)
+        {
+            return;
+        }
+        received_packet_times_.Clear();
+        break;
+    }
+    if (packet_number > kMaxAckTimestampGap)
+    {
+        received_packet_times_.RemoveBefore(packet_number - kMaxAckTimestampGap);
+    }
+    received_packet_times_.Push(packet_number, receipt_time);
+}
+
+void ReceivedPacketManager::RecordPacketRecovered(PacketNumber packet_number)
+{
+    if (!IsAwaitingPacket(packet_number))
+    {
+        return;
+    }
+    if (!ack_frame_updated_)
+    {
+        received_packet_times_.Clear();
+        ack_frame_.recovered_packets.clear();
+    }
+    ack_frame_updated_ = true;
+    ack_frame_.packets.Add(packet_number);
+    // Repair packets follow the packets they protect, so a recovered packet
+    // is never the largest observed.
+    ack_frame_.recovered_packets.push_back(packet_number);
 }
 
 bool ReceivedPacketManager::IsMissing(PacketNumber packet_number)
@@ -90,20 +147,7 @@ const AckFrame* ReceivedPacketManager::GetUpdatedAckFrame(uint64_t approximate_n
     {
         ack_frame_.packets.RemoveSmallestInterval();
     }
-
-    // Clear all packet times if any are too far from largest observed.
-    for (PacketTimeVector::iterator it = ack_frame_.received_packet_times.begin();
-         it != ack_frame_.received_packet_times.end();)
-    {
-        if (ack_frame_.largest_observed - it->first >= std::numeric_limits<uint8_t>::max())
-        {
-            it = ack_frame_.received_packet_times.erase(it);
-        }
-        else
-        {
-            ++it;
-        }
-    }
+    received_packet_times_.CopyTo(&ack_frame_.received_packet_times);
 
     return &ack_frame_;
 }
@@ -126,6 +170,17 @@ void ReceivedPacketManager::DontWaitForPacketsBefore(PacketNumber least_unacked)
     NS_ASSERT(ack_frame_.packets.Empty() || SEQ_GE(ack_frame_.packets.Min(), peer_least_packet_awaiting_ack_));
 }
 
+void ReceivedPacketManager::OnAckOfAck(PacketNumber largest_acked)
+{
+    if (!SEQ_GT(largest_acked, peer_least_packet_awaiting_ack_))
+    {
+        return;
+    }
+    peer_least_packet_awaiting_ack_ = largest_acked;
+    // Unlike a stop waiting, pruning alone does not call for a new ack.
+    ack_frame_.packets.RemoveUpTo(largest_acked);
+}
+
 bool ReceivedPacketManager::HasMissingPackets() const
 {
     return ack_frame_.packets.NumIntervals() > 1 ||
@@ -138,6 +193,12 @@ bool ReceivedPacketManager::HasNewMissingPackets() const
     return HasMissingPackets() && ack_frame_.packets.LastIntervalLength() <= kMaxPacketsAfterNewMissing;
 }
 
+bool ReceivedPacketManager::ReachedReorderingThreshold(PacketCount reordering_threshold) const
+{
+    return ack_frame_.packets.NumIntervals() > 1 &&
+           ack_frame_.packets.LastIntervalLength() == reordering_threshold;
+}
+
 bool ReceivedPacketManager::ack_frame_updated() const
 {
     return ack_frame_updated_;
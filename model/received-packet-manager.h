@@ -7,16 +7,27 @@
 #ifndef RECEIVED_PACKET_MANAGER_H
 #define RECEIVED_PACKET_MANAGER_H
 
+#include <algorithm>
 #include <deque>
 
 #include "bbr-common.h"
 #include "packet-header.h"
 #include "ack-frame.h"
+#include "packet-time-ring.h"
 
 namespace ns3
 {
 namespace bbr
 {
+// Which received packets have their receive time reported in acks.
+enum AckTimestampPolicy
+{
+  kAckTimestampsAll = 0,
+  // One packet in every |timestamp_interval|.
+  kAckTimestampsEveryNth,
+  // Only the largest observed packet of each ack.
+  kAckTimestampsLargest,
+};
 
 class ReceivedPacketManager
 {
@@ -26,9 +37,13 @@ class ReceivedPacketManager
     virtual ~ReceivedPacketManager();
     // Updates the internal state concerning which packets have been received.
     // header: the packet header.
-    // timestamp: the arrival time of the packet.
+    // receipt_time: the arrival time of the packet, in microseconds.
     virtual void RecordPacketReceived(const PacketHeader &header, uint64_t receipt_time);
 
+    // Records that |packet_number| was restored from FEC repair packets.  It
+    // is acked like a received packet and listed as recovered.
+    void RecordPacketRecovered(PacketNumber packet_number);
+
     // Checks whether |packet_number| is missing and less than largest observed.
     virtual bool IsMissing(PacketNumber packet_number);
 
@@ -37,7 +52,8 @@ class ReceivedPacketManager
 
     // Retrieves a frame containing a AckFrame.  The ack frame may not be
     // changed outside ReceivedPacketManager and must be serialized before
-    // another packet is received, or it will change.
+    // another packet is received, or it will change.  |approximate_now| is in
+    // microseconds.
     const AckFrame* GetUpdatedAckFrame(uint64_t approximate_now);
 
     // Deletes all missing packets before least unacked. The connection won't
@@ -45,6 +61,11 @@ class ReceivedPacketManager
     // received after this call.
     void DontWaitForPacketsBefore(PacketNumber least_unacked);
 
+    // Called with the largest acked packet echoed by the peer.  The peer has
+    // received an ack covering every packet below it, so they are no longer
+    // reported.  Echoes may arrive out of order.
+    void OnAckOfAck(PacketNumber largest_acked);
+
     // Returns true if there are any missing packets.
     bool HasMissingPackets() const;
 
@@ -52,6 +73,10 @@ class ReceivedPacketManager
     // packets of the largest observed.
     virtual bool HasNewMissingPackets() const;
 
+    // Returns true when the newest missing packet has just fallen
+    // |reordering_threshold| packets below the largest observed.
+    bool ReachedReorderingThreshold(PacketCount reordering_threshold) const;
+
     PacketNumber peer_least_packet_awaiting_ack()
     {
         return peer_least_packet_awaiting_ack_;
@@ -64,11 +89,39 @@ class ReceivedPacketManager
     // For logging purposes.
     const AckFrame &ack_frame() const { return ack_frame_; }
 
+    // Forgets every packet received, keeping the ack settings.
+    void Clear();
+
+    void set_connection_id(ConnectionId connection_id)
+    {
+        ack_frame_.connection_id = connection_id;
+    }
+
     void set_max_ack_ranges(size_t max_ack_ranges)
     {
         max_ack_ranges_ = max_ack_ranges;
     }
 
+    // Receive times are kept for at most |max_timestamps| packets per ack,
+    // the oldest being dropped first.
+    void set_max_ack_timestamps(size_t max_timestamps)
+    {
+        received_packet_times_.set_capacity(max_timestamps);
+    }
+
+    // Rate the receiver measured packets arriving at, reported in acks.
+    void set_delivery_rate(Bandwidth delivery_rate)
+    {
+        ack_frame_.delivery_rate = delivery_rate;
+    }
+
+    // |interval| only matters to kAckTimestampsEveryNth.
+    void set_ack_timestamp_policy(AckTimestampPolicy policy, PacketCount interval)
+    {
+        timestamp_policy_ = policy;
+        timestamp_interval_ = std::max<PacketCount>(1, interval);
+    }
+
   private:
     // Least packet number of the the packet sent by the peer for which it
     // hasn't received an ack.
@@ -81,10 +134,20 @@ class ReceivedPacketManager
     // last called.
     bool ack_frame_updated_;
 
-    // Maximum number of ack ranges allowed to be stored in the ack frame.
+    // Receive times of the packets sampled since the last ack, copied into
+    // |ack_frame_| when it is sent.
+    PacketTimeRing received_packet_times_;
+    AckTimestampPolicy timestamp_policy_;
+    PacketCount timestamp_interval_;
+    // Packets received since the last one sampled.
+    PacketCount packets_since_timestamp_;
+
+    // Maximum number of ack ranges allowed to be stored in the ack frame, or
+    // zero for no limit.  The oldest ranges are dropped first.
     size_t max_ack_ranges_;
 
-    // The time we received the largest_observed packet number, or zero if
+    // The time we received the largest_observed packet number, in
+    // microseconds, or zero if
     // no packet numbers have been received since UpdateReceivedPacketInfo.
     // Needed for calculating ack_delay_time.
     uint64_t time_largest_observed_;
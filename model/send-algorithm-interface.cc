@@ -8,6 +8,7 @@
 
 #include "send-algorithm-interface.h"
 #include "bbr-sender.h"
+#include "tcp-reno-sender.h"
 
 namespace ns3
 {
@@ -29,6 +30,8 @@ SendAlgorithmInterface *SendAlgorithmInterface::Create(
     {
     case kBBR:
         return new BbrSender(rtt_stats, unacked_packets, initial_congestion_window, max_congestion_window);
+    case kRenoBytes:
+        return new TcpRenoSender(rtt_stats, unacked_packets, initial_congestion_window, max_congestion_window);
     default:
         break;
     }
@@ -65,6 +65,18 @@ class SendAlgorithmInterface
     // nor OnPacketLost will be called for these packets.
     virtual void OnRetransmissionTimeout(bool packets_retransmitted) = 0;
 
+    // Called when every packet sent over a period of several probe timeouts
+    // has been declared lost.
+    virtual void OnPersistentCongestion() = 0;
+
+    // Called when every loss that started the current recovery proved
+    // spurious.  Restores the state from before the recovery.
+    virtual void UndoLossRecovery() = 0;
+
+    // Called with the rate the peer measured packets arriving at.  Unlike
+    // the ack-based samples, it is not inflated by ack compression.
+    virtual void OnPeerDeliveryRate(Bandwidth delivery_rate) = 0;
+
     // Called when connection migrates and cwnd needs to be reset.
     virtual void OnConnectionMigration() = 0;
 
@@ -102,6 +114,10 @@ class SendAlgorithmInterface
     // sample is available.
     virtual void AdjustNetworkParameters(Bandwidth bandwidth, uint64_t rtt) = 0;
 
+    // Whether AdjustNetworkParameters seeds the model, e.g. when the
+    // algorithm takes over from another one at runtime.  Off by default.
+    virtual void SetBandwidthResumption(bool enabled) = 0;
+
     // Retrieves debugging information about the current state of the
     // send algorithm.
     virtual std::string GetDebugState() const = 0;
@@ -0,0 +1,127 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2008 INRIA
+ *
+ * Author: daibo <daibo@yy.com>
+ */
+#include "ns3/core-module.h"
+
+#include <algorithm>
+
+#include "send-scheduler.h"
+
+namespace ns3
+{
+NS_LOG_COMPONENT_DEFINE("SendScheduler");
+namespace bbr
+{
+namespace
+{
+// Bytes a class of weight one may send per deficit round robin round.
+const int64_t kQuantumBytes = kMaxPacketSize;
+}
+
+const char *SendPriorityToString(ProtocolSendPriority priority)
+{
+    switch (priority)
+    {
+    case kPriorityAudio:
+        return "AUDIO";
+    case kPriorityKeyFrame:
+        return "KEY_FRAME";
+    case kPriorityRetransmission:
+        return "RETRANSMISSION";
+    case kPriorityFecRepair:
+        return "FEC_REPAIR";
+    case kPriorityFreshData:
+        return "FRESH_DATA";
+    case kPriorityBulkData:
+        return "BULK_DATA";
+    default:
+        break;
+    }
+    return "???";
+}
+
+SendScheduler::SendScheduler()
+    : mode_(kStrictPriority),
+      current_(0)
+{
+    for (int i = 0; i < kNumSendPriorities; ++i)
+    {
+        weights_[i] = 1;
+        deadlines_[i] = 0;
+        deficits_[i] = 0;
+    }
+}
+
+void SendScheduler::set_weight(ProtocolSendPriority priority, uint32_t weight)
+{
+    weights_[priority] = std::max<uint32_t>(weight, 1);
+}
+
+bool SendScheduler::IsWithinDeadline(ProtocolSendPriority priority,
+                                     uint64_t gen_time,
+                                     uint64_t now) const
+{
+    return deadlines_[priority] == 0 || now < gen_time + deadlines_[priority];
+}
+
+bool SendScheduler::SelectNext(const bool backlogged[kNumSendPriorities],
+                               ProtocolSendPriority *priority)
+{
+    bool any_backlogged = false;
+    for (int i = 0; i < kNumSendPriorities; ++i)
+    {
+        if (backlogged[i])
+        {
+            any_backlogged = true;
+        }
+        else
+        {
+            // Idle classes do not save up credit.
+            deficits_[i] = 0;
+        }
+    }
+    if (!any_backlogged)
+    {
+        return false;
+    }
+
+    if (mode_ == kStrictPriority)
+    {
+        for (int i = 0; i < kNumSendPriorities; ++i)
+        {
+            if (backlogged[i])
+            {
+                *priority = static_cast<ProtocolSendPriority>(i);
+                return true;
+            }
+        }
+    }
+
+    // Every backlogged class gains a quantum per visit, so this ends within
+    // a few rounds.
+    while (!backlogged[current_] || deficits_[current_] <= 0)
+    {
+        current_ = (current_ + 1) % kNumSendPriorities;
+        if (backlogged[current_])
+        {
+            deficits_[current_] += weights_[current_] * kQuantumBytes;
+        }
+    }
+    *priority = static_cast<ProtocolSendPriority>(current_);
+    return true;
+}
+
+void SendScheduler::OnPacketSent(ProtocolSendPriority priority, ByteCount bytes)
+{
+    if (mode_ == kWeightedPriority)
+    {
+        deficits_[priority] -= bytes;
+    }
+    NS_LOG_DEBUG(SendPriorityToString(priority) << " sent " << bytes
+                 << " deficit " << deficits_[priority]);
+}
+}
+}
@@ -0,0 +1,84 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2008 INRIA
+ *
+ * Author: daibo <daibo@yy.com>
+ */
+#ifndef SEND_SCHEDULER_H
+#define SEND_SCHEDULER_H
+
+#include "bbr-common.h"
+#include "packets.h"
+
+namespace ns3
+{
+namespace bbr
+{
+enum SchedulingMode
+{
+  // The backlogged class of highest priority is always served first.  The
+  // owner of a class cancels its packets past their deadline before they
+  // are served, so that stale retransmissions cannot starve fresh data.
+  kStrictPriority = 0,
+  // Backlogged classes share the sent bytes in proportion to their weights
+  // (deficit round robin).
+  kWeightedPriority,
+};
+
+const char *SendPriorityToString(ProtocolSendPriority priority);
+
+// SendScheduler chooses the class of each packet the pacing sender lets
+// through, among the classes with data to send.  Each class also has a
+// deadline: packets of a frame older than it are not worth sending any
+// more, and are dropped by their owner instead.
+//
+// The scheduler is consulted once per packet, so it never sends ahead of
+// the congestion window or the pacing rate.
+class SendScheduler
+{
+  public:
+    SendScheduler();
+
+    void set_mode(SchedulingMode mode) { mode_ = mode; }
+    SchedulingMode mode() const { return mode_; }
+
+    // Share of the bytes sent for |priority| in weighted mode.  A weight of
+    // zero is raised to one, so that no class starves.
+    void set_weight(ProtocolSendPriority priority, uint32_t weight);
+    uint32_t weight(ProtocolSendPriority priority) const { return weights_[priority]; }
+
+    // Age of a frame since its generation after which packets of
+    // |priority| are no longer sent.  Zero means no deadline.
+    void set_deadline(ProtocolSendPriority priority, uint64_t deadline)
+    {
+        deadlines_[priority] = deadline;
+    }
+    uint64_t deadline(ProtocolSendPriority priority) const { return deadlines_[priority]; }
+
+    // Returns true if a packet of |priority| of a frame generated at
+    // |gen_time| may still be sent at |now|.
+    bool IsWithinDeadline(ProtocolSendPriority priority, uint64_t gen_time, uint64_t now) const;
+
+    // Picks the class of the next packet among those with |backlogged| set.
+    // Returns false if no class has data to send.
+    bool SelectNext(const bool backlogged[kNumSendPriorities], ProtocolSendPriority *priority);
+
+    // Charges a packet of |bytes| sent for |priority|.
+    void OnPacketSent(ProtocolSendPriority priority, ByteCount bytes);
+
+  private:
+    SchedulingMode mode_;
+    uint32_t weights_[kNumSendPriorities];
+    uint64_t deadlines_[kNumSendPriorities];
+
+    // Deficit round robin state: bytes each class may still send in the
+    // current round, and the class being served.
+    int64_t deficits_[kNumSendPriorities];
+    size_t current_;
+
+    DISALLOW_COPY_AND_ASSIGN(SendScheduler);
+};
+}
+}
+
+#endif
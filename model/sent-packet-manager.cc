@@ -22,17 +22,22 @@ SentPacketManager::SentPacketManager(ConnectionStats *stats,
       stats_(stats),
       initial_congestion_window_(kInitialCongestionWindow),
       general_loss_algorithm_(loss_type),
-      loss_algorithm_(&general_loss_algorithm_),
+      loss_algorithm_(loss_type == kRack
+                          ? static_cast<LossDetectionInterface *>(&rack_loss_algorithm_)
+                          : &general_loss_algorithm_),
       least_packet_awaited_by_peer_(1),
       first_rto_transmission_(0),
       consecutive_rto_count_(0),
       consecutive_tlp_count_(0),
+      consecutive_pto_count_(0),
       pending_timer_transmission_count_(0),
       max_tail_loss_probes_(kDefaultMaxTailLossProbes),
       enable_half_rtt_tail_loss_probe_(false),
       using_pacing_(true),
       largest_newly_acked_(0),
-      largest_packet_peer_knows_is_acked_(0)
+      largest_packet_peer_knows_is_acked_(0),
+      enable_controller_switching_(false),
+      bandwidth_resumption_(false)
 {
     SetSendAlgorithm(congestion_control_type);
     rtt_stats_.set_initial_rtt_ms(std::max(kMinInitialRoundTripTimeMs, std::min(kMaxInitialRoundTripTimeMs, 100u)));       
@@ -40,6 +45,8 @@ SentPacketManager::SentPacketManager(ConnectionStats *stats,
     enable_half_rtt_tail_loss_probe_ = false;
     use_new_rto_ = true;
     undo_pending_retransmits_ = false;
+    use_pto_ = true;
+    first_rtt_sample_time_ = 0;
 }
 
 SentPacketManager::~SentPacketManager()
@@ -51,6 +58,14 @@ void SentPacketManager::SetMaxPacingRate(Bandwidth max_pacing_rate)
     pacing_sender_.set_max_pacing_rate(max_pacing_rate);
 }
 
+void SentPacketManager::AllowUnpacedBurst(PacketCount packets)
+{
+    if (using_pacing_)
+    {
+        pacing_sender_.AddBurstTokens(packets);
+    }
+}
+
 void SentPacketManager::OnIncomingAck(const AckFrame &ack_frame, uint64_t ack_receive_time)
 {
     NS_ASSERT(SEQ_LE(ack_frame.largest_observed, unacked_packets_.largest_sent_packet()));
@@ -59,7 +74,21 @@ void SentPacketManager::OnIncomingAck(const AckFrame &ack_frame, uint64_t ack_re
     bool rtt_updated = MaybeUpdateRTT(ack_frame, ack_receive_time);
     NS_ASSERT(SEQ_GE(ack_frame.largest_observed, unacked_packets_.largest_observed()));
     unacked_packets_.IncreaseLargestObserved(ack_frame.largest_observed);
+    largest_packet_peer_knows_is_acked_ = std::max(largest_packet_peer_knows_is_acked_, ack_frame.largest_observed);
+    if (!ack_frame.delivery_rate.IsZero())
+    {
+        stats_->peer_delivery_rate = ack_frame.delivery_rate;
+        send_algorithm_->OnPeerDeliveryRate(ack_frame.delivery_rate);
+    }
 
+    for (PacketNumber packet_number : ack_frame.recovered_packets)
+    {
+        // Acking it below also cancels a pending retransmission.
+        if (unacked_packets_.IsUnacked(packet_number))
+        {
+            ++stats_->packets_fec_recovered;
+        }
+    }
     HandleAckForSentPackets(ack_frame);
     InvokeLossDetection(ack_receive_time);
     // Ignore losses in RTO mode.
@@ -67,8 +96,12 @@ void SentPacketManager::OnIncomingAck(const AckFrame &ack_frame, uint64_t ack_re
     {
         packets_lost_.clear();
     }
-    MaybeInvokeCongestionEvent(rtt_updated, prior_in_flight, ack_receive_time);
+    OnLossesDetected(rtt_updated, prior_in_flight, ack_receive_time);
     unacked_packets_.RemoveObsoletePackets();
+    if (enable_controller_switching_)
+    {
+        MaybeSwitchSendAlgorithm(ack_receive_time);
+    }
 
     // Anytime we are making forward progress and have a new RTT estimate, reset
     // the backoff counters.
@@ -95,6 +128,7 @@ void SentPacketManager::OnIncomingAck(const AckFrame &ack_frame, uint64_t ack_re
         // Reset all retransmit counters any time a new packet is acked.
         consecutive_rto_count_ = 0;
         consecutive_tlp_count_ = 0;
+        consecutive_pto_count_ = 0;
     }
     // TODO(ianswett): Consider replacing the pending_retransmissions_ with a
     // fast way to retrieve the next pending retransmission, if there are any.
@@ -106,6 +140,7 @@ void SentPacketManager::OnIncomingAck(const AckFrame &ack_frame, uint64_t ack_re
     {
         // Cancel any pending retransmissions larger than largest_newly_acked_.
         unacked_packets_.RestoreToInFlight(pending_retransmissions_.front().first);
+        loss_algorithm_->OnPacketRestoredToInFlight(pending_retransmissions_.front().first);
         pending_retransmissions_.pop_front();
     }
 }
@@ -131,6 +166,25 @@ void SentPacketManager::MaybeInvokeCongestionEvent(
     {
         return;
     }
+    if (enable_controller_switching_)
+    {
+        ByteCount bytes_acked = 0;
+        ByteCount bytes_lost = 0;
+        for (const auto &packet : packets_acked_)
+        {
+            bytes_acked += packet.second;
+        }
+        for (const auto &packet : packets_lost_)
+        {
+            bytes_lost += packet.second;
+        }
+        if (send_algorithm_->InSlowStart() || send_algorithm_->IsProbingForMoreBandwidth())
+        {
+            controller_policy_.OnProbingForBandwidth();
+        }
+        controller_policy_.OnCongestionEvent(event_time, rtt_stats_, send_algorithm_->BandwidthEstimate(),
+                                             prior_in_flight, bytes_acked, bytes_lost);
+    }
     if (using_pacing_)
     {
         pacing_sender_.OnCongestionEvent(rtt_updated, prior_in_flight, event_time, packets_acked_, packets_lost_);
@@ -143,6 +197,108 @@ void SentPacketManager::MaybeInvokeCongestionEvent(
     packets_lost_.clear();
 }
 
+void SentPacketManager::OnIncomingNack(const NackFrame &nack_frame, uint64_t receive_time)
+{
+    const ByteCount prior_in_flight = unacked_packets_.bytes_in_flight();
+    for (PacketNumber packet_number : nack_frame.missing_packets)
+    {
+        // Already acked, declared lost or retransmitted on a timeout.
+        if (!unacked_packets_.IsUnacked(packet_number) ||
+            !unacked_packets_.GetTransmissionInfo(packet_number).in_flight ||
+            ContainsKey(pending_retransmissions_, packet_number))
+        {
+            continue;
+        }
+        const TransmissionInfo &info = unacked_packets_.GetTransmissionInfo(packet_number);
+        NS_LOG_DEBUG("packet " << packet_number << " nacked");
+        ++stats_->packets_nacked;
+        packets_lost_.push_back(std::make_pair(packet_number, info.bytes_sent));
+        OnPacketLost(packet_number, receive_time);
+    }
+    OnLossesDetected(false, prior_in_flight, receive_time);
+}
+
+void SentPacketManager::OnLossesDetected(bool rtt_updated, ByteCount prior_in_flight, uint64_t event_time)
+{
+    const bool persistent_congestion = DetectPersistentCongestion();
+    const bool was_in_recovery = send_algorithm_->InRecovery();
+    std::vector<PacketNumber> lost_packets;
+    for (const auto &packet : packets_lost_)
+    {
+        lost_packets.push_back(packet.first);
+    }
+    MaybeInvokeCongestionEvent(rtt_updated, prior_in_flight, event_time);
+    if (!send_algorithm_->InRecovery() || !was_in_recovery)
+    {
+        loss_episode_packets_.clear();
+    }
+    if (send_algorithm_->InRecovery())
+    {
+        loss_episode_packets_.insert(lost_packets.begin(), lost_packets.end());
+    }
+    if (persistent_congestion)
+    {
+        NS_LOG_INFO("persistent congestion at " << event_time);
+        ++stats_->persistent_congestion_count;
+        send_algorithm_->OnPersistentCongestion();
+    }
+}
+
+void SentPacketManager::OnLossProvedSpurious(PacketNumber packet_number)
+{
+    if (loss_episode_packets_.erase(packet_number) == 0)
+    {
+        return;
+    }
+    if (loss_episode_packets_.empty() && send_algorithm_->InRecovery())
+    {
+        NS_LOG_INFO("loss recovery undone by " << packet_number);
+        ++stats_->loss_recoveries_undone;
+        send_algorithm_->UndoLossRecovery();
+    }
+}
+
+bool SentPacketManager::DetectPersistentCongestion() const
+{
+    if (packets_lost_.empty() || first_rtt_sample_time_ == 0)
+    {
+        return false;
+    }
+    const uint64_t congestion_period = GetProbeTimeoutDelay() * kPersistentCongestionThreshold;
+    PacketNumber previous_lost = 0;
+    uint64_t run_start_time = 0;
+    for (const auto &packet : packets_lost_)
+    {
+        const TransmissionInfo &info = unacked_packets_.GetTransmissionInfo(packet.first);
+        // Packets sent before there was an RTT sample say nothing about the
+        // path.
+        if (info.sent_time <= first_rtt_sample_time_)
+        {
+            continue;
+        }
+        bool contiguous = previous_lost != 0;
+        for (PacketNumber packet_number = previous_lost + 1;
+             contiguous && packet_number < packet.first; ++packet_number)
+        {
+            // Acked packets are marked unackable.
+            if (unacked_packets_.GetTransmissionInfo(packet_number).is_unackable)
+            {
+                contiguous = false;
+            }
+        }
+        if (!contiguous)
+        {
+            run_start_time = info.sent_time;
+        }
+        else if (info.sent_time - run_start_time >= congestion_period)
+        {
+            return true;
+        }
+        previous_lost = packet.first;
+    }
+    return false;
+}
+
 void SentPacketManager::HandleAckForSentPackets(const AckFrame &ack_frame)
 {
     const bool skip_unackable_packets_early = false;
@@ -190,9 +346,10 @@ void SentPacketManager::MarkForRetransmission(
 {
     const TransmissionInfo &transmission_info = unacked_packets_.GetTransmissionInfo(packet_number);
     NS_ASSERT_MSG(transmission_info.data_packet, "data_packet null: " << packet_number);
-    // Both TLP and the new RTO leave the packets in flight and let the loss
+    // TLP, PTO and the new RTO leave the packets in flight and let the loss
     // detection decide if packets are lost.
-    if (transmission_type != TLP_RETRANSMISSION && transmission_type != RTO_RETRANSMISSION)
+    if (transmission_type != TLP_RETRANSMISSION && transmission_type != RTO_RETRANSMISSION &&
+        transmission_type != PTO_RETRANSMISSION)
     {
         unacked_packets_.RemoveFromInFlight(packet_number);
     }
@@ -248,6 +405,7 @@ PacketHeader SentPacketManager::NextPendingRetransmission() {
   header.m_data_length = transmission_info.data_packet->data_length;
   header.m_data_packet = transmission_info.data_packet;
   header.m_data_seq = transmission_info.data_packet->data_seq;
+  header.m_stream_id = transmission_info.data_packet->stream_id;
 
     // by dd
     header.PicType = transmission_info.data_packet->PicType;
@@ -281,6 +439,7 @@ void SentPacketManager::MarkPacketHandled(PacketNumber packet_number, Transmissi
   {
     RecordSpuriousRetransmissions(*info, packet_number);
   }
+  OnLossProvedSpurious(packet_number);
 
   unacked_packets_.RemoveFromInFlight(info);
   unacked_packets_.RemoveRetransmittability(info);
@@ -348,9 +507,17 @@ void SentPacketManager::OnRetransmissionTimeout() {
       ByteCount prior_in_flight = unacked_packets_.bytes_in_flight();
       const uint64_t now = Simulator::Now().GetMilliSeconds();
       InvokeLossDetection(now);
-      MaybeInvokeCongestionEvent(false, prior_in_flight, now);
+      OnLossesDetected(false, prior_in_flight, now);
       return;
     }
+    case PTO_MODE:
+      // Nothing is declared lost.  Up to two probes are allowed past the
+      // congestion window; new data is preferred, and the sender falls back
+      // to MaybeRetransmitOldestPacketAsProbe if it has none.
+      ++stats_->pto_count;
+      ++consecutive_pto_count_;
+      pending_timer_transmission_count_ = kPtoProbePackets;
+      return;
     case TLP_MODE:
       // If no tail loss probe can be sent, because there are no retransmittable
       // packets, execute a conventional RTO to abandon old packets.
@@ -368,7 +535,7 @@ void SentPacketManager::OnRetransmissionTimeout() {
 }
 
 bool SentPacketManager::MaybeRetransmitTailLossProbe() {
-  if (pending_timer_transmission_count_ == 0) {
+  if (use_pto_ || pending_timer_transmission_count_ == 0) {
     return false;
   }
   PacketNumber packet_number = unacked_packets_.GetLeastUnacked();
@@ -385,6 +552,141 @@ bool SentPacketManager::MaybeRetransmitTailLossProbe() {
   return false;
 }
 
+bool SentPacketManager::MaybeRetransmitOldestPacketAsProbe() {
+  if (pending_timer_transmission_count_ == 0) {
+    return false;
+  }
+  PacketNumber packet_number = unacked_packets_.GetLeastUnacked();
+  for (UnackedPacketMap::const_iterator it = unacked_packets_.begin();
+       it != unacked_packets_.end(); ++it, ++packet_number) {
+    if (!it->in_flight || !it->data_packet ||
+        ContainsKey(pending_retransmissions_, packet_number) ||
+        IsExpired(*it, Simulator::Now().GetMilliSeconds())) {
+      continue;
+    }
+    MarkForRetransmission(packet_number, PTO_RETRANSMISSION);
+    return true;
+  }
+  // Nothing is left to probe with, e.g. all outstanding data expired.  Give
+  // up on the owed probes so that pacing resumes and the PTO is re-armed.
+  NS_LOG_INFO("No retransmittable packets, so the probe cannot be sent.");
+  pending_timer_transmission_count_ = 0;
+  return false;
+}
+
+bool SentPacketManager::HasPendingProbes() const {
+  return pending_timer_transmission_count_ > 0;
+}
+
+bool SentPacketManager::IsExpired(const TransmissionInfo& info, uint64_t now) {
+  if (!info.data_packet || info.data_packet->reliability == kReliable) {
+    return false;
+  }
+  return info.data_packet->reliability == kUnreliable ||
+         (info.data_packet->expire_time != 0 && info.data_packet->expire_time <= now);
+}
+
+void SentPacketManager::DiscardExpiredPacket(PacketNumber packet_number, const TransmissionInfo& info) {
+  NS_LOG_DEBUG("discard expired packet " << packet_number
+               << " PicIndex " << info.data_packet->PicIndex);
+  RecordExpiredFrame(info.data_packet->stream_id, info.data_packet->PicIndex, 1, info.bytes_sent);
+  unacked_packets_.RemoveRetransmittability(packet_number);
+}
+
+bool SentPacketManager::IsExpiredRetransmission(const TransmissionInfo& info, uint64_t now,
+                                                uint64_t max_frame_age) const {
+  if (IsExpired(info, now)) {
+    return true;
+  }
+  if (!info.data_packet || info.data_packet->reliability != kPartiallyReliable) {
+    return false;
+  }
+  const bool too_old = max_frame_age != INFINITETIME &&
+                       now >= info.data_packet->PicGenTime + max_frame_age;
+  // The frame cannot complete once the stream gave up on it or a later one.
+  return too_old ||
+         info.data_packet->PicIndex < GetLeastUnexpiredPicIndex(info.data_packet->stream_id);
+}
+
+SentPacketManager::PendingRetransmissionMap::iterator
+SentPacketManager::CancelExpiredRetransmission(PendingRetransmissionMap::iterator it) {
+  const PacketNumber packet_number = it->first;
+  it = pending_retransmissions_.erase(it);
+  if (pending_timer_transmission_count_ > 0) {
+    --pending_timer_transmission_count_;
+  }
+  DiscardExpiredPacket(packet_number, unacked_packets_.GetTransmissionInfo(packet_number));
+  return it;
+}
+
+size_t SentPacketManager::DiscardExpiredRetransmissions(uint64_t now, uint64_t max_frame_age) {
+  size_t discarded = 0;
+  PendingRetransmissionMap::iterator it = pending_retransmissions_.begin();
+  while (it != pending_retransmissions_.end()) {
+    if (!IsExpiredRetransmission(unacked_packets_.GetTransmissionInfo(it->first), now, max_frame_age)) {
+      ++it;
+      continue;
+    }
+    it = CancelExpiredRetransmission(it);
+    ++discarded;
+  }
+  if (discarded > 0) {
+    unacked_packets_.RemoveObsoletePackets();
+  }
+  return discarded;
+}
+
+bool SentPacketManager::DiscardNextRetransmissionIfExpired(uint64_t now, uint64_t max_frame_age) {
+  if (pending_retransmissions_.empty() ||
+      !IsExpiredRetransmission(unacked_packets_.GetTransmissionInfo(pending_retransmissions_.begin()->first),
+                               now, max_frame_age)) {
+    return false;
+  }
+  CancelExpiredRetransmission(pending_retransmissions_.begin());
+  unacked_packets_.RemoveObsoletePackets();
+  return true;
+}
+
+void SentPacketManager::RecordExpiredFrame(StreamId stream_id, PacketNumber pic_index,
+                                           PacketCount packets, ByteCount bytes) {
+  stats_->packets_expired += packets;
+  stats_->bytes_expired += bytes;
+  // Frames of a stream expire in the order they were generated, so each
+  // frame is counted the first time any of its packets expires.
+  PacketNumber& least_unexpired_pic_index = least_unexpired_pic_index_[stream_id];
+  if (pic_index >= least_unexpired_pic_index) {
+    ++stats_->frames_expired;
+    least_unexpired_pic_index = pic_index + 1;
+  }
+}
+
+void SentPacketManager::GetAckFrequency(AckFrequencyFrame *frame) const
+{
+    const uint64_t srtt = rtt_stats_.smoothed_rtt() > 0 ? rtt_stats_.smoothed_rtt()
+                                                        : rtt_stats_.initial_rtt_ms();
+    // Only packet threshold loss detection declares reordered packets lost;
+    // immediate acks on reordering would be wasted on the time based ones.
+    const LossDetectionType loss_type = loss_algorithm_->GetLossDetectionType();
+    frame->reordering_threshold = loss_type == kNack || loss_type == kLazyFack
+                                      ? GeneralLossAlgorithm::kNumberOfNacksBeforeRetransmission
+                                      : 0;
+    if (send_algorithm_->InSlowStart())
+    {
+        frame->ack_eliciting_threshold = kMinAckElicitingThreshold;
+        frame->max_ack_delay = std::max<uint64_t>(1, std::min<uint64_t>(kMaxDelayedAckTimeMs, srtt / (2 * kAcksPerRoundTrip)));
+        return;
+    }
+    const PacketCount packets_per_rtt = send_algorithm_->GetCongestionWindow() / kMaxPacketSize;
+    frame->ack_eliciting_threshold = std::max(kMinAckElicitingThreshold,
+                                              std::min(kMaxAckElicitingThreshold, packets_per_rtt / kAcksPerRoundTrip));
+    frame->max_ack_delay = std::max<uint64_t>(1, std::min<uint64_t>(kMaxDelayedAckTimeMs, srtt / kAcksPerRoundTrip));
+}
+
+PacketNumber SentPacketManager::GetLeastUnexpiredPicIndex(StreamId stream_id) const {
+  std::map<StreamId, PacketNumber>::const_iterator it = least_unexpired_pic_index_.find(stream_id);
+  return it == least_unexpired_pic_index_.end() ? 0 : it->second;
+}
+
 void SentPacketManager::RetransmitRtoPackets() {
     NS_ASSERT_MSG(pending_timer_transmission_count_ <= 0, "Retransmissions already queued:" << pending_timer_transmission_count_);                 
     // Mark two packets for retransmission.
@@ -424,6 +726,9 @@ SentPacketManager::GetRetransmissionMode() const {
   if (loss_algorithm_->GetLossTimeout() != 0) {
     return LOSS_MODE;
   }
+  if (use_pto_) {
+    return PTO_MODE;
+  }
   if (consecutive_tlp_count_ < max_tail_loss_probes_) {
     if (unacked_packets_.HasUnackedRetransmittableFrames()) {
       return TLP_MODE;
@@ -439,18 +744,27 @@ void SentPacketManager::InvokeLossDetection(uint64_t time) {
   }
   loss_algorithm_->DetectLosses(unacked_packets_, time, rtt_stats_, largest_newly_acked_, &packets_lost_);
   for (const auto& pair : packets_lost_) {
-    ++stats_->packets_lost;
+    OnPacketLost(pair.first, time);
+  }
+}
 
-    // TODO(ianswett): This could be optimized.
-    if (unacked_packets_.HasRetransmittableFrames(pair.first)) {
-      MarkForRetransmission(pair.first, LOSS_RETRANSMISSION);
-    } else {
-      // Since we will not retransmit this, we need to remove it from
-      // unacked_packets_.   This is either the current transmission of
-      // a packet whose previous transmission has been acked or a packet that
-      // has been TLP retransmitted.
-      unacked_packets_.RemoveFromInFlight(pair.first);
-    }
+void SentPacketManager::OnPacketLost(PacketNumber packet_number, uint64_t time) {
+  ++stats_->packets_lost;
+
+  // TODO(ianswett): This could be optimized.
+  const TransmissionInfo& info = unacked_packets_.GetTransmissionInfo(packet_number);
+  if (IsExpired(info, time)) {
+    // The receiver can no longer use the data, so do not resend it.
+    unacked_packets_.RemoveFromInFlight(packet_number);
+    DiscardExpiredPacket(packet_number, info);
+  } else if (unacked_packets_.HasRetransmittableFrames(packet_number)) {
+    MarkForRetransmission(packet_number, LOSS_RETRANSMISSION);
+  } else {
+    // Since we will not retransmit this, we need to remove it from
+    // unacked_packets_.   This is either the current transmission of
+    // a packet whose previous transmission has been acked or a packet that
+    // has been TLP retransmitted.
+    unacked_packets_.RemoveFromInFlight(packet_number);
   }
 }
 
@@ -472,7 +786,14 @@ bool SentPacketManager::MaybeUpdateRTT(const AckFrame& ack_frame, uint64_t ack_r
   }
 
   uint64_t send_delta = ack_receive_time - transmission_info.sent_time;
-  rtt_stats_.UpdateRtt(send_delta, ack_frame.ack_delay_time, ack_receive_time);
+  // The peer reports the ack delay in microseconds.
+  const uint64_t ack_delay = ack_frame.ack_delay_time == INFINITETIME
+                                 ? 0
+                                 : ack_frame.ack_delay_time / kNumMicrosPerMilli;
+  rtt_stats_.UpdateRtt(send_delta, ack_delay, ack_receive_time);
+  if (first_rtt_sample_time_ == 0) {
+    first_rtt_sample_time_ = ack_receive_time;
+  }
 
   return true;
 }
@@ -521,6 +842,15 @@ const uint64_t SentPacketManager::GetRetransmissionTime() const {
           unacked_packets_.GetLastPacketSentTime() + GetTailLossProbeDelay();
       return std::max(tlp_time, rto_time);
     }
+    case PTO_MODE: {
+      // The PTO is based on the last packet in flight and backs off
+      // exponentially while probes go unanswered.
+      const uint64_t sent_time = unacked_packets_.GetLastPacketSentTime();
+      uint64_t pto_delay = GetProbeTimeoutDelay() *
+          (1 << std::min<size_t>(consecutive_pto_count_, kMaxRetransmissions));
+      pto_delay = std::min<uint64_t>(pto_delay, kMaxRetransmissionTimeMs);
+      return std::max<uint64_t>(Simulator::Now().GetMilliSeconds(), sent_time + pto_delay);
+    }
     default:
         NS_LOG_WARN("GetRetransmissionTime invalid mode");
   }
@@ -571,6 +901,18 @@ const uint64_t SentPacketManager::GetRetransmissionDelay() const
     return retransmission_delay;
 }
 
+const uint64_t SentPacketManager::GetProbeTimeoutDelay() const
+{
+    if (rtt_stats_.smoothed_rtt() == 0)
+    {
+        // No RTT sample yet, so use twice the initial RTT.
+        return 2 * rtt_stats_.initial_rtt_ms();
+    }
+    return rtt_stats_.smoothed_rtt() +
+           std::max(4 * rtt_stats_.mean_deviation(), kTimerGranularityMs) +
+           kMaxDelayedAckTimeMs;
+}
+
 const RttStats* SentPacketManager::GetRttStats() const {
     return &rtt_stats_;
 }
@@ -585,6 +927,63 @@ ByteCount SentPacketManager::GetBytesInFlight() const {
   return unacked_packets_.bytes_in_flight();
 }
 
+void SentPacketManager::EnableControllerSwitching(bool enable) {
+  enable_controller_switching_ = enable;
+}
+
+void SentPacketManager::SetBandwidthResumption(bool enabled) {
+  bandwidth_resumption_ = enabled;
+  send_algorithm_->SetBandwidthResumption(enabled);
+}
+
+const ControllerPolicy& SentPacketManager::GetControllerPolicy() const {
+  return controller_policy_;
+}
+
+void SentPacketManager::MaybeSwitchSendAlgorithm(uint64_t now) {
+  const CongestionControlType current = send_algorithm_->GetCongestionControlType();
+  CongestionControlType target = current;
+  if (!controller_policy_.ShouldSwitch(current, now, &target)) {
+    return;
+  }
+  if (!SwitchSendAlgorithm(target)) {
+    // Keep the current controller for this class instead of retrying on
+    // every ack.
+    controller_policy_.SetControllerForPathClass(controller_policy_.path_class(), current);
+    return;
+  }
+  controller_policy_.OnSwitched(now);
+}
+
+bool SentPacketManager::SwitchSendAlgorithm(CongestionControlType congestion_control_type) {
+  if (send_algorithm_->GetCongestionControlType() == congestion_control_type) {
+    return false;
+  }
+  SendAlgorithmInterface* send_algorithm = SendAlgorithmInterface::Create(
+      &rtt_stats_, &unacked_packets_, congestion_control_type,
+      stats_, initial_congestion_window_);
+  if (send_algorithm == nullptr) {
+    NS_LOG_WARN("congestion control type " << congestion_control_type << " is not available");
+    return false;
+  }
+  // Carry the path model over, so the new controller does not start from
+  // scratch on a connection that is already running.
+  const Bandwidth bandwidth = send_algorithm_->BandwidthEstimate();
+  const uint64_t min_rtt = rtt_stats_.min_rtt();
+  NS_LOG_INFO("switch congestion control " << send_algorithm_->GetCongestionControlType()
+              << " -> " << congestion_control_type
+              << " path " << PathClassToString(controller_policy_.path_class())
+              << " bandwidth " << bandwidth.ToBitsPerSecond()
+              << " min_rtt " << min_rtt);
+  SetSendAlgorithm(send_algorithm);
+  send_algorithm_->AdjustNetworkParameters(bandwidth, min_rtt);
+  if (!stats_->peer_delivery_rate.IsZero()) {
+    send_algorithm_->OnPeerDeliveryRate(stats_->peer_delivery_rate);
+  }
+  ++stats_->congestion_control_switches;
+  return true;
+}
+
 void SentPacketManager::SetSendAlgorithm(CongestionControlType congestion_control_type) {
   SetSendAlgorithm(SendAlgorithmInterface::Create(
       &rtt_stats_, &unacked_packets_, congestion_control_type,
@@ -593,6 +992,7 @@ void SentPacketManager::SetSendAlgorithm(CongestionControlType congestion_contro
 
 void SentPacketManager::SetSendAlgorithm(SendAlgorithmInterface* send_algorithm) {   
   send_algorithm_.reset(send_algorithm);
+  send_algorithm_->SetBandwidthResumption(bandwidth_resumption_);
   pacing_sender_.set_sender(send_algorithm);
 }
 
@@ -621,8 +1021,21 @@ size_t SentPacketManager::GetConsecutiveTlpCount() const {
   return consecutive_tlp_count_;
 }
 
+size_t SentPacketManager::GetConsecutivePtoCount() const {
+  return consecutive_pto_count_;
+}
+
+void SentPacketManager::SetUsePto(bool use_pto) {
+  use_pto_ = use_pto;
+}
+
+bool SentPacketManager::UsePto() const {
+  return use_pto_;
+}
+
 void SentPacketManager::OnApplicationLimited() {
   send_algorithm_->OnApplicationLimited(unacked_packets_.bytes_in_flight());
+  controller_policy_.OnApplicationLimited();
 }
 
 const SendAlgorithmInterface* SentPacketManager::GetSendAlgorithm() const {
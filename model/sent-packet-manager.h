@@ -6,7 +6,9 @@
  */
 #ifndef SENT_PACKET_MANAGER_H
 #define SENT_PACKET_MANAGER_H
+#include <map>
 #include <memory>
+#include <set>
 
 #include "video-common.h"
 #include "bandwidth.h"
@@ -15,11 +17,15 @@
 #include "unacked-packet-map.h"
 #include "send-algorithm-interface.h"
 #include "general-loss-algorithm.h"
+#include "rack-loss-algorithm.h"
 #include "pacing-sender.h"
 #include "packet-header.h"
 #include "ack-frame.h"
+#include "ack-frequency-frame.h"
+#include "nack-frame.h"
 #include "connection-stats.h"
 #include "linked-hash-map.h"
+#include "controller-policy.h"
 
 namespace ns3
 {
@@ -34,13 +40,50 @@ public:
 
   void SetMaxPacingRate(Bandwidth max_pacing_rate);
 
+  // Lets up to |packets| packets go out unpaced, as far as the congestion
+  // window allows, e.g. for a frame nothing can be played out without.
+  void AllowUnpacedBurst(PacketCount packets);
+
   // Processes the incoming ack.
   void OnIncomingAck(const AckFrame &ack_frame, uint64_t receive_time);
 
+  // Declares the packets the peer nacked lost and queues them for
+  // retransmission, ahead of the loss detection.
+  void OnIncomingNack(const NackFrame &nack_frame, uint64_t receive_time);
+
   // Retransmits the oldest pending packet there is still a tail loss probe
-  // pending.  Invoked after OnRetransmissionTimeout.
+  // pending.  Invoked after OnRetransmissionTimeout in legacy TLP/RTO mode
+  // only; probe timeout probes go through MaybeRetransmitOldestPacketAsProbe.
   bool MaybeRetransmitTailLossProbe();
 
+  // Retransmits the oldest in flight packet as a probe if the probe timeout
+  // fired and no new data was available to probe with.  If there is no
+  // packet to probe with, the owed probes are dropped.
+  bool MaybeRetransmitOldestPacketAsProbe();
+
+  // Returns true if probe packets are still owed after a probe timeout.
+  bool HasPendingProbes() const;
+
+  // Cancels pending retransmissions of packets whose frame has passed its
+  // deadline at |now|, was generated more than |max_frame_age| ago, or was
+  // already dropped by its stream.
+  // Returns the number of retransmissions cancelled.
+  size_t DiscardExpiredRetransmissions(uint64_t now, uint64_t max_frame_age = INFINITETIME);
+
+  // Cancels the next pending retransmission if it would be discarded by
+  // DiscardExpiredRetransmissions.  Returns true if it was cancelled.
+  // Checked before each retransmission is served, so that retransmissions
+  // of frames that expired meanwhile do not go out ahead of fresh data.
+  bool DiscardNextRetransmissionIfExpired(uint64_t now, uint64_t max_frame_age = INFINITETIME);
+
+  // Records that frame |pic_index| of |stream_id| expired with |bytes| of
+  // it undelivered, |packets| packets of which were dropped.
+  void RecordExpiredFrame(StreamId stream_id, PacketNumber pic_index, PacketCount packets, ByteCount bytes);
+
+  // Frames of |stream_id| below this PicIndex have expired and will not be
+  // sent again.
+  PacketNumber GetLeastUnexpiredPicIndex(StreamId stream_id) const;
+
   // Returns true if there are pending retransmissions.
   // Not const because retransmissions may be cancelled before returning.
   bool HasPendingRetransmissions() const;
@@ -55,6 +98,16 @@ public:
   // been acked by the peer.
   PacketNumber GetLeastUnacked() const;
 
+  // Fills in the ack policy to request from the peer: about
+  // kAcksPerRoundTrip acks per round trip, and an ack every other packet in
+  // slow start, when the window grows on every ack.
+  void GetAckFrequency(AckFrequencyFrame *frame) const;
+
+  // Largest packet acked by an ack frame that arrived, to echo to the peer.
+  PacketNumber largest_packet_peer_knows_is_acked() const {
+    return largest_packet_peer_knows_is_acked_;
+  }
+
   // Called when we have sent bytes to the peer.  This informs the manager both
   // the number of bytes sent and if they were retransmitted.  Returns true if
   // the sender should reset the retransmission timer.
@@ -99,10 +152,33 @@ public:
 
   size_t GetConsecutiveTlpCount() const;
 
+  size_t GetConsecutivePtoCount() const;
+
+  // Uses the probe timeout instead of tail loss probes and RTOs when true.
+  void SetUsePto(bool use_pto);
+
+  bool UsePto() const;
+
   void OnApplicationLimited();
 
   const SendAlgorithmInterface *GetSendAlgorithm() const;
 
+  // Enables switching the send algorithm at runtime according to the path
+  // class reported by the controller policy.
+  void EnableControllerSwitching(bool enable);
+
+  // Lets a send algorithm that takes over at runtime start from the
+  // bandwidth and min_rtt of the previous one.  Off by default.
+  void SetBandwidthResumption(bool enabled);
+
+  // Replaces the send algorithm with one of |congestion_control_type|, seeding
+  // it with the bandwidth and min_rtt of the current one if bandwidth
+  // resumption is enabled.  Returns false if the type is already in use or
+  // cannot be created.
+  bool SwitchSendAlgorithm(CongestionControlType congestion_control_type);
+
+  const ControllerPolicy &GetControllerPolicy() const;
+
 private:
 
   // The retransmission timer is a single timer which switches modes depending
@@ -115,6 +191,9 @@ private:
     // Re-invoke the loss detection when a packet is not acked before the
     // loss detection algorithm expects.
     LOSS_MODE,
+    // A probe timeout, which sends new or the oldest data without declaring
+    // any packet lost.
+    PTO_MODE,
   };
 
   typedef linked_hash_map<PacketNumber, TransmissionType> PendingRetransmissionMap;
@@ -138,6 +217,22 @@ private:
   // Returns the retransmission timeout, after which a full RTO occurs.
   const uint64_t GetRetransmissionDelay() const;
 
+  // Returns the probe timeout without backoff.
+  const uint64_t GetProbeTimeoutDelay() const;
+
+  // Returns true if the packets just declared lost span more than
+  // kPersistentCongestionThreshold probe timeouts without any packet between
+  // them being acked.
+  bool DetectPersistentCongestion() const;
+
+  // Invokes the congestion event for the losses just detected, and hands
+  // persistent congestion to the send algorithm if it was detected.
+  void OnLossesDetected(bool rtt_updated, ByteCount prior_in_flight, uint64_t event_time);
+
+  // Called when |packet_number|, declared lost, turns out to have arrived.
+  // Undoes the loss recovery once every loss that started it proved spurious.
+  void OnLossProvedSpurious(PacketNumber packet_number);
+
   // Returns the newest transmission associated with a packet.
   PacketNumber GetNewestRetransmission(PacketNumber packet_number, const TransmissionInfo &transmission_info) const;
                                       
@@ -149,6 +244,9 @@ private:
   // necessary.
   void InvokeLossDetection(uint64_t time);
 
+  // Retransmits or discards the packet declared lost at |time|.
+  void OnPacketLost(PacketNumber packet_number, uint64_t time);
+
   // Invokes OnCongestionEvent if |rtt_updated| is true, there are pending acks,
   // or pending losses.  Clears pending acks and pending losses afterwards.
   // |prior_in_flight| is the number of bytes in flight before the losses or
@@ -161,6 +259,22 @@ private:
   // |info| due to receipt by the peer.
   void MarkPacketHandled(PacketNumber packet_number, TransmissionInfo *info, uint64_t ack_delay_time);
                         
+  // Returns true if the frame carried by |info| is past its deadline, or
+  // its stream never retransmits.
+  static bool IsExpired(const TransmissionInfo &info, uint64_t now);
+
+  // Stops tracking the data of |packet_number| because its frame expired.
+  void DiscardExpiredPacket(PacketNumber packet_number, const TransmissionInfo &info);
+
+  // Returns true if the retransmission of |info| is not worth sending at
+  // |now|: its frame is past its deadline, was generated more than
+  // |max_frame_age| ago, or its stream already dropped the frame.
+  bool IsExpiredRetransmission(const TransmissionInfo &info, uint64_t now, uint64_t max_frame_age) const;
+
+  // Cancels the pending retransmission at |it|, whose frame expired, and
+  // returns the next one.
+  PendingRetransmissionMap::iterator CancelExpiredRetransmission(PendingRetransmissionMap::iterator it);
+
   // Request that |packet_number| be retransmitted after the other pending
   // retransmissions.  Does not add it to the retransmissions if it's already
   // a pending retransmission.
@@ -176,6 +290,10 @@ private:
   // TransmissionInfo |info|.
   void RecordSpuriousRetransmissions(const TransmissionInfo& info, PacketNumber acked_packet_number);                                   
 
+  // Asks the controller policy whether the send algorithm should be replaced,
+  // and replaces it if so.
+  void MaybeSwitchSendAlgorithm(uint64_t now);
+
   // Sets the send algorithm to the given congestion control type and points the
   // pacing sender at |send_algorithm_|. Can be called any number of times.
   void SetSendAlgorithm(CongestionControlType congestion_control_type);
@@ -208,6 +326,7 @@ private:
   std::unique_ptr<SendAlgorithmInterface> send_algorithm_;
 
   GeneralLossAlgorithm general_loss_algorithm_;
+  RackLossAlgorithm rack_loss_algorithm_;
   LossDetectionInterface* loss_algorithm_;
 
   // Least packet number which the peer is still waiting for.
@@ -220,7 +339,9 @@ private:
   size_t consecutive_rto_count_;
   // Number of times the tail loss probe has been sent.
   size_t consecutive_tlp_count_;
-  // Number of pending transmissions of TLP, RTO packets.
+  // Number of times the probe timeout has fired in a row without receiving an ack.
+  size_t consecutive_pto_count_;
+  // Number of pending transmissions of TLP, RTO and PTO packets.
   size_t pending_timer_transmission_count_;
   // Maximum number of tail loss probes to send before firing an RTO.
   size_t max_tail_loss_probes_;
@@ -233,6 +354,11 @@ private:
   // If true, cancel pending retransmissions if they're larger than
   // largest_newly_acked.
   bool undo_pending_retransmits_;
+  // If true, a single probe timeout replaces the TLP and RTO modes.
+  bool use_pto_;
+  // Time of the first RTT sample.  Only losses after it count towards
+  // persistent congestion.
+  uint64_t first_rtt_sample_time_;
 
   // Vectors packets acked and lost as a result of the last congestion event.
   SendAlgorithmInterface::CongestionVector packets_acked_;
@@ -245,9 +371,23 @@ private:
   // Calls into |send_algorithm_| for the underlying congestion control.
   PacingSender pacing_sender_;
 
-  // The largest acked value that was sent in an ack, which has then been acked.
+  // The largest acked value of the acks received from the peer.  It is echoed
+  // in every packet sent, which tells the peer its acks arrived so it can
+  // stop reporting older packets.
   PacketNumber largest_packet_peer_knows_is_acked_;
 
+  // Smallest PicIndex which has not expired, by stream.
+  std::map<StreamId, PacketNumber> least_unexpired_pic_index_;
+
+  // Packets declared lost during the current loss recovery and not proven
+  // spurious yet.  Empty outside recovery.
+  std::set<PacketNumber> loss_episode_packets_;
+
+  // Classifies the path and picks the send algorithm for it.
+  ControllerPolicy controller_policy_;
+  bool enable_controller_switching_;
+  bool bandwidth_resumption_;
+
 };
 }
 }
@@ -0,0 +1,235 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2008 INRIA
+ *
+ * Author: daibo <daibo@yy.com>
+ */
+
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+
+#include <algorithm>
+
+#include "stream-source.h"
+#include "udp-bbr-sender.h"
+
+namespace ns3
+{
+NS_LOG_COMPONENT_DEFINE("StreamSource");
+
+namespace
+{
+// Packets of each pic of a bulk transfer.
+const uint16_t kBulkDataPicPackets = 16;
+// Pics of a bulk transfer queued at a time.
+const size_t kBulkDataQueuedPics = 2;
+}
+
+StreamSource::StreamSource()
+    : m_pic_seq(0),
+      m_sender(nullptr),
+      m_streamId(0),
+      m_reliability(bbr::kPartiallyReliable)
+{
+}
+
+void StreamSource::SetStream(bbr::StreamId stream_id, bbr::StreamReliability reliability, UdpBbrSender *sender)
+{
+    m_streamId = stream_id;
+    m_reliability = reliability;
+    m_sender = sender;
+}
+
+void StreamSource::QueuePic(PicData &pic, uint64_t now)
+{
+    pic.PicSeq = m_pic_seq++;
+    pic.PicGenTime = now;
+    pic.PicCurPktSeq = 0;
+    // Reliable pics are sent however late they are.
+    uint64_t deadline = m_reliability == bbr::kReliable ? 0 : m_sender->GetSendDeadline(pic.Priority);
+    pic.PicExpireTime = deadline == 0 ? 0 : now + deadline;
+    m_PicDataBuf.Push(pic);
+}
+
+void StreamSource::DropExpiredPics(uint64_t now)
+{
+    // Pics are queued in generation order, so expired ones are at the front.
+    while (!m_PicDataBuf.empty() && m_PicDataBuf.front().PicExpireTime != 0 &&
+           m_PicDataBuf.front().PicExpireTime <= now)
+    {
+        const PicData &pic = m_PicDataBuf.front();
+        const uint16_t unsent_pkts = PicQueue::GetUnsentPackets(pic);
+        const ByteCount unsent_bytes = PicQueue::GetUnsentBytes(pic);
+        NS_LOG_INFO("Drop expired stream " << m_streamId << " PicIndex " << pic.PicSeq
+                    << " unsent pkts " << unsent_pkts
+                    << " unsent bytes " << unsent_bytes);
+        m_sender->OnPicExpired(m_streamId, pic.PicSeq, unsent_pkts, unsent_bytes);
+
+        m_PicDataBuf.PopFront();
+    }
+}
+
+bool StreamSource::HasReleasedPacket(uint64_t now)
+{
+    DropExpiredPics(now);
+    if (m_PicDataBuf.empty())
+    {
+        return false;
+    }
+    const PicData &pic = m_PicDataBuf.front();
+    return PicQueue::GetReleaseTime(pic, pic.PicCurPktSeq) <= now;
+}
+
+bool StreamSource::PeekNextPriority(bbr::ProtocolSendPriority *priority)
+{
+    if (!HasReleasedPacket(Simulator::Now().GetMilliSeconds()))
+    {
+        return false;
+    }
+    *priority = m_PicDataBuf.front().Priority;
+    return true;
+}
+
+bool StreamSource::GetNextPacket(PicDataPacket &data)
+{
+    if (!HasReleasedPacket(Simulator::Now().GetMilliSeconds()))
+    {
+        return false;
+    }
+    PicData &pic = m_PicDataBuf.front();
+    int size = PicQueue::GetPacketLength(pic, pic.PicCurPktSeq);
+    data.stream_id = m_streamId;
+    data.reliability = m_reliability;
+    data.data_length = size;
+    data.priority = pic.Priority;
+    data.expire_time = pic.PicExpireTime;
+    data.payload.assign(size, 'P');
+
+    data.PicType = pic.CurType;
+    data.PicIndex = pic.PicSeq;
+    data.PicDataLen = pic.PicDataLen;
+    data.PicPktNum = pic.PicPktNum;
+    data.PicCurPktSeq = pic.PicCurPktSeq;
+    data.PicGenTime = pic.PicGenTime;
+
+    if (++pic.PicCurPktSeq == pic.PicPktNum)
+    {
+        m_PicDataBuf.PopFront();
+    }
+    return true;
+}
+
+uint64_t StreamSource::GetCurMaxPicQueueDelay(uint64_t now)
+{
+    if (m_PicDataBuf.empty())
+    {
+        return 0;
+    }
+    // Packets held back by their pic's release span are not late.
+    const PicData &pic = m_PicDataBuf.front();
+    const uint64_t release_time = PicQueue::GetReleaseTime(pic, pic.PicCurPktSeq);
+    return release_time > now ? 0 : now - release_time;
+}
+
+AudioSource::AudioSource()
+    : m_bitrate(DataRate("32kb/s")),
+      m_frameInterval(20),
+      m_running(false)
+{
+}
+
+void AudioSource::Setup(DataRate bitrate, uint64_t frame_interval)
+{
+    m_bitrate = bitrate;
+    m_frameInterval = std::max<uint64_t>(1, frame_interval);
+}
+
+void AudioSource::StartApp()
+{
+    if (!m_running)
+    {
+        m_running = true;
+        EnqueuePic();
+    }
+}
+
+void AudioSource::StopApp()
+{
+    m_running = false;
+    if (m_enqueueEvent.IsRunning())
+    {
+        Simulator::Cancel(m_enqueueEvent);
+    }
+}
+
+void AudioSource::EnqueuePic()
+{
+    uint64_t now = Simulator::Now().GetMilliSeconds();
+    const uint64_t bytes = m_bitrate.GetBitRate() * m_frameInterval / (8 * bbr::kNumMillisPerSecond);
+
+    PicData pic_data;
+    pic_data.CurType = pic_type_real;
+    pic_data.Priority = bbr::kPriorityAudio;
+    pic_data.PicNumLayers = 1;
+    PicQueue::SetDataLen(&pic_data, std::max<uint64_t>(1, std::min<uint64_t>(bytes, 0xFFFF)));
+    pic_data.PicLayerEnd[0] = pic_data.PicDataLen;
+    pic_data.PicReleaseSpan = 0;
+    QueuePic(pic_data, now);
+
+    m_enqueueEvent = Simulator::Schedule(MilliSeconds(m_frameInterval), &AudioSource::EnqueuePic, this);
+    m_sender->TryToSendData();
+}
+
+BulkDataSource::BulkDataSource()
+    : m_totalBytes(0),
+      m_bytesQueued(0),
+      m_running(false)
+{
+}
+
+void BulkDataSource::Setup(uint64_t total_bytes)
+{
+    m_totalBytes = total_bytes;
+    m_bytesQueued = 0;
+}
+
+void BulkDataSource::StartApp()
+{
+    if (!m_running)
+    {
+        m_running = true;
+        Refill();
+        m_sender->TryToSendData();
+    }
+}
+
+void BulkDataSource::StopApp()
+{
+    m_running = false;
+}
+
+bool BulkDataSource::PeekNextPriority(bbr::ProtocolSendPriority *priority)
+{
+    Refill();
+    return StreamSource::PeekNextPriority(priority);
+}
+
+void BulkDataSource::Refill()
+{
+    uint64_t now = Simulator::Now().GetMilliSeconds();
+    while (m_running && m_bytesQueued < m_totalBytes && m_PicDataBuf.size() < kBulkDataQueuedPics)
+    {
+        const uint64_t bytes = std::min<uint64_t>(m_totalBytes - m_bytesQueued,
+                                                  kBulkDataPicPackets * DEFAULT_PAYLOAD_SIZE);
+        PicData pic_data;
+        pic_data.CurType = pic_type_real;
+        pic_data.Priority = bbr::kPriorityBulkData;
+        pic_data.PicNumLayers = 1;
+        PicQueue::SetDataLen(&pic_data, bytes);
+        pic_data.PicLayerEnd[0] = pic_data.PicDataLen;
+        pic_data.PicReleaseSpan = 0;
+        QueuePic(pic_data, now);
+        m_bytesQueued += bytes;
+    }
+}
+}
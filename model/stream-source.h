@@ -0,0 +1,113 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2008 INRIA
+ *
+ * Author: daibo <daibo@yy.com>
+ */
+#ifndef STREAM_SOURCE_H
+#define STREAM_SOURCE_H
+
+#include "ns3/event-id.h"
+#include "ns3/data-rate.h"
+
+#include "bbr-common.h"
+#include "packets.h"
+#include "pic-queue.h"
+
+namespace ns3
+{
+class UdpBbrSender;
+
+// One stream of a connection: a source of pics queued until the send
+// scheduler picks their packets.  Each stream numbers its pics on its own
+// and the receiver reassembles and plays them out apart, so a late or lost
+// pic of one stream never holds back the others.  The streams share the
+// congestion controller; the scheduler serves them by the send class of
+// their next packet.
+class StreamSource
+{
+  public:
+    StreamSource();
+    virtual ~StreamSource() {}
+
+    void SetStream(bbr::StreamId stream_id, bbr::StreamReliability reliability, UdpBbrSender *sender);
+    bbr::StreamId GetStreamId() const { return m_streamId; }
+    bbr::StreamReliability GetReliability() const { return m_reliability; }
+
+    virtual void StartApp() = 0;
+    virtual void StopApp() = 0;
+
+    // Drops expired pics, then returns false if no packet may be sent yet,
+    // or sets |priority| to the send class of the next packet.
+    virtual bool PeekNextPriority(bbr::ProtocolSendPriority *priority);
+    // Fills in the next packet but its data_seq, which is per connection.
+    bool GetNextPacket(bbr::PicDataPacket &data);
+
+    // Time the next packet has been waiting at |now|.
+    uint64_t GetCurMaxPicQueueDelay(uint64_t now);
+
+  protected:
+    // Numbers |pic|, generated at |now|, sets its deadline from its send
+    // class and queues it.  The caller sets the other fields.
+    void QueuePic(bbr::PicData &pic, uint64_t now);
+    // Drops queued pics whose deadline has passed at |now|.
+    void DropExpiredPics(uint64_t now);
+    // Drops expired pics, then returns true if the next packet may be sent
+    // at |now|.
+    bool HasReleasedPacket(uint64_t now);
+
+    bbr::PicQueue m_PicDataBuf;               // Queued pics, and the recently sent ones
+    uint32_t m_pic_seq;                       // increased pic seq
+    UdpBbrSender* m_sender;
+
+  private:
+    bbr::StreamId m_streamId;
+    bbr::StreamReliability m_reliability;
+};
+
+// Constant bitrate voice, one small pic per frame interval.
+class AudioSource : public StreamSource
+{
+  public:
+    AudioSource();
+
+    void Setup(DataRate bitrate, uint64_t frame_interval);
+    virtual void StartApp();
+    virtual void StopApp();
+
+  private:
+    void EnqueuePic();
+
+    DataRate m_bitrate;
+    uint64_t m_frameInterval;                 // ms
+    bool m_running;
+    EventId m_enqueueEvent;
+};
+
+// A bulk transfer, e.g. a file or chat history, which has data to send
+// until all of it is queued.  It is cut into pics of a few packets, no more
+// than two of which are queued at a time.
+class BulkDataSource : public StreamSource
+{
+  public:
+    BulkDataSource();
+
+    void Setup(uint64_t total_bytes);
+    virtual void StartApp();
+    virtual void StopApp();
+
+    virtual bool PeekNextPriority(bbr::ProtocolSendPriority *priority);
+
+    uint64_t GetBytesQueued() const { return m_bytesQueued; }
+
+  private:
+    // Queues the next pics of the transfer, if any.
+    void Refill();
+
+    uint64_t m_totalBytes;
+    uint64_t m_bytesQueued;
+    bool m_running;
+};
+}
+
+#endif
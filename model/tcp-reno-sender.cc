@@ -0,0 +1,274 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2008 INRIA
+ *
+ * Author: daibo <daibo@yy.com>
+ */
+#include <algorithm>
+#include <sstream>
+#include "ns3/core-module.h"
+
+#include "tcp-reno-sender.h"
+
+namespace ns3
+{
+NS_LOG_COMPONENT_DEFINE("TcpRenoSender");
+namespace bbr
+{
+// Constants based on TCP defaults.
+const ByteCount kMaxSegmentSize = kDefaultTCPMSS;
+const ByteCount kMinimumCongestionWindow = 2 * kMaxSegmentSize;
+// The congestion window is multiplied by this factor on loss.
+const float kRenoBeta = 0.5f;
+// Pacing gains, relative to congestion_window / srtt.
+const float kSlowStartPacingGain = 2.0f;
+const float kCongestionAvoidancePacingGain = 1.25f;
+// Grow in slow start while more than this many segments can still be sent.
+const ByteCount kMaxBurstBytes = 3 * kMaxSegmentSize;
+
+TcpRenoSender::TcpRenoSender(const RttStats *rtt_stats,
+                             const UnackedPacketMap *unacked_packets,
+                             PacketCount initial_tcp_congestion_window,
+                             PacketCount max_tcp_congestion_window)
+    : rtt_stats_(rtt_stats),
+      unacked_packets_(unacked_packets),
+      congestion_window_(initial_tcp_congestion_window * kMaxSegmentSize),
+      min_congestion_window_(kMinimumCongestionWindow),
+      max_congestion_window_(max_tcp_congestion_window * kMaxSegmentSize),
+      initial_congestion_window_(initial_tcp_congestion_window * kMaxSegmentSize),
+      initial_max_congestion_window_(max_tcp_congestion_window * kMaxSegmentSize),
+      slowstart_threshold_(max_tcp_congestion_window * kMaxSegmentSize),
+      num_acked_bytes_(0),
+      largest_sent_packet_number_(0),
+      largest_acked_packet_number_(0),
+      largest_sent_at_last_cutback_(0),
+      prior_congestion_window_(0),
+      prior_slowstart_threshold_(0),
+      bandwidth_resumption_(false)
+{
+}
+
+TcpRenoSender::~TcpRenoSender() {}
+
+bool TcpRenoSender::InSlowStart() const
+{
+    return congestion_window_ < slowstart_threshold_;
+}
+
+bool TcpRenoSender::InRecovery() const
+{
+    return largest_acked_packet_number_ != 0 &&
+           largest_sent_at_last_cutback_ != 0 &&
+           largest_acked_packet_number_ <= largest_sent_at_last_cutback_;
+}
+
+void TcpRenoSender::SetInitialCongestionWindowInPackets(PacketCount congestion_window)
+{
+    if (largest_acked_packet_number_ == 0)
+    {
+        initial_congestion_window_ = congestion_window * kMaxSegmentSize;
+        congestion_window_ = initial_congestion_window_;
+    }
+}
+
+void TcpRenoSender::AdjustNetworkParameters(Bandwidth bandwidth, uint64_t rtt)
+{
+    if (!bandwidth_resumption_ || bandwidth.IsZero() || rtt == 0)
+    {
+        return;
+    }
+    // The path model is already known, so resume in congestion avoidance at
+    // the bandwidth-delay product instead of slow starting past it.
+    const ByteCount bdp = bandwidth * rtt;
+    congestion_window_ = std::max(min_congestion_window_, std::min(max_congestion_window_, bdp));
+    slowstart_threshold_ = congestion_window_;
+    num_acked_bytes_ = 0;
+}
+
+void TcpRenoSender::OnCongestionEvent(bool /*rtt_updated*/,
+                                      ByteCount prior_in_flight,
+                                      uint64_t /*event_time*/,
+                                      const CongestionVector &acked_packets,
+                                      const CongestionVector &lost_packets)
+{
+    for (const auto &packet : lost_packets)
+    {
+        OnPacketLost(packet.first);
+    }
+    for (const auto &packet : acked_packets)
+    {
+        OnPacketAcked(packet.first, packet.second, prior_in_flight);
+    }
+}
+
+void TcpRenoSender::OnPacketAcked(PacketNumber acked_packet_number,
+                                  ByteCount acked_bytes,
+                                  ByteCount prior_in_flight)
+{
+    largest_acked_packet_number_ = std::max(acked_packet_number, largest_acked_packet_number_);
+    if (InRecovery())
+    {
+        // No congestion window growth during recovery.
+        return;
+    }
+    MaybeIncreaseCwnd(acked_bytes, prior_in_flight);
+}
+
+void TcpRenoSender::OnPacketLost(PacketNumber lost_packet_number)
+{
+    // Only the first loss of an episode reduces the window.
+    if (largest_sent_at_last_cutback_ != 0 && lost_packet_number <= largest_sent_at_last_cutback_)
+    {
+        return;
+    }
+    prior_congestion_window_ = congestion_window_;
+    prior_slowstart_threshold_ = slowstart_threshold_;
+    congestion_window_ = std::max(min_congestion_window_,
+                                  static_cast<ByteCount>(congestion_window_ * kRenoBeta));
+    slowstart_threshold_ = congestion_window_;
+    largest_sent_at_last_cutback_ = largest_sent_packet_number_;
+    num_acked_bytes_ = 0;
+    NS_LOG_INFO("loss of " << lost_packet_number << " cwnd " << congestion_window_);
+}
+
+void TcpRenoSender::MaybeIncreaseCwnd(ByteCount acked_bytes, ByteCount prior_in_flight)
+{
+    if (!IsCwndLimited(prior_in_flight) || congestion_window_ >= max_congestion_window_)
+    {
+        return;
+    }
+    if (InSlowStart())
+    {
+        congestion_window_ += kMaxSegmentSize;
+        return;
+    }
+    // One segment per congestion window of acked bytes.
+    num_acked_bytes_ += acked_bytes;
+    if (num_acked_bytes_ >= congestion_window_)
+    {
+        num_acked_bytes_ -= congestion_window_;
+        congestion_window_ += kMaxSegmentSize;
+    }
+}
+
+bool TcpRenoSender::IsCwndLimited(ByteCount bytes_in_flight) const
+{
+    if (bytes_in_flight >= congestion_window_)
+    {
+        return true;
+    }
+    const ByteCount available_bytes = congestion_window_ - bytes_in_flight;
+    const bool slow_start_limited = InSlowStart() && bytes_in_flight > congestion_window_ / 2;
+    return slow_start_limited || available_bytes <= kMaxBurstBytes;
+}
+
+bool TcpRenoSender::OnPacketSent(uint64_t /*sent_time*/,
+                                 ByteCount /*bytes_in_flight*/,
+                                 PacketNumber packet_number,
+                                 ByteCount /*bytes*/,
+                                 HasRetransmittableData is_retransmittable)
+{
+    if (is_retransmittable != HAS_RETRANSMITTABLE_DATA)
+    {
+        return false;
+    }
+    largest_sent_packet_number_ = packet_number;
+    return true;
+}
+
+void TcpRenoSender::OnRetransmissionTimeout(bool packets_retransmitted)
+{
+    largest_sent_at_last_cutback_ = 0;
+    if (!packets_retransmitted)
+    {
+        return;
+    }
+    slowstart_threshold_ = std::max(min_congestion_window_, congestion_window_ / 2);
+    congestion_window_ = min_congestion_window_;
+    num_acked_bytes_ = 0;
+}
+
+void TcpRenoSender::OnPersistentCongestion()
+{
+    if (prior_congestion_window_ == 0)
+    {
+        prior_congestion_window_ = congestion_window_;
+        prior_slowstart_threshold_ = slowstart_threshold_;
+    }
+    slowstart_threshold_ = std::max(min_congestion_window_, congestion_window_ / 2);
+    congestion_window_ = min_congestion_window_;
+    num_acked_bytes_ = 0;
+}
+
+void TcpRenoSender::UndoLossRecovery()
+{
+    NS_LOG_INFO("undo recovery, cwnd " << congestion_window_ << " prior " << prior_congestion_window_);
+    congestion_window_ = std::max(congestion_window_, prior_congestion_window_);
+    slowstart_threshold_ = std::max(slowstart_threshold_, prior_slowstart_threshold_);
+    largest_sent_at_last_cutback_ = 0;
+    prior_congestion_window_ = 0;
+    prior_slowstart_threshold_ = 0;
+}
+
+void TcpRenoSender::OnConnectionMigration()
+{
+    congestion_window_ = initial_congestion_window_;
+    max_congestion_window_ = initial_max_congestion_window_;
+    slowstart_threshold_ = initial_max_congestion_window_;
+    num_acked_bytes_ = 0;
+    largest_sent_at_last_cutback_ = 0;
+    prior_congestion_window_ = 0;
+    prior_slowstart_threshold_ = 0;
+}
+
+uint64_t TcpRenoSender::TimeUntilSend(uint64_t /* now */, ByteCount bytes_in_flight)
+{
+    if (bytes_in_flight < GetCongestionWindow())
+    {
+        return 0;
+    }
+    return INFINITETIME;
+}
+
+Bandwidth TcpRenoSender::PacingRate(ByteCount /* bytes_in_flight */) const
+{
+    const uint64_t srtt = rtt_stats_->smoothed_rtt() > 0 ? rtt_stats_->smoothed_rtt()
+                                                          : rtt_stats_->initial_rtt_ms();
+    const Bandwidth bandwidth = Bandwidth::FromBytesAndTimeDelta(congestion_window_, srtt);
+    return bandwidth * (InSlowStart() ? kSlowStartPacingGain : kCongestionAvoidancePacingGain);
+}
+
+Bandwidth TcpRenoSender::BandwidthEstimate() const
+{
+    if (rtt_stats_->smoothed_rtt() <= 0)
+    {
+        return Bandwidth::Zero();
+    }
+    return Bandwidth::FromBytesAndTimeDelta(congestion_window_, rtt_stats_->smoothed_rtt());
+}
+
+ByteCount TcpRenoSender::GetCongestionWindow() const
+{
+    return congestion_window_;
+}
+
+ByteCount TcpRenoSender::GetSlowStartThreshold() const
+{
+    return slowstart_threshold_;
+}
+
+CongestionControlType TcpRenoSender::GetCongestionControlType() const
+{
+    return kRenoBytes;
+}
+
+std::string TcpRenoSender::GetDebugState() const
+{
+    std::ostringstream stream;
+    stream << "cwnd " << congestion_window_
+           << " ssthresh " << slowstart_threshold_
+           << " recovery " << InRecovery();
+    return stream.str();
+}
+}
+}
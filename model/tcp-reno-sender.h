@@ -0,0 +1,116 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2008 INRIA
+ *
+ * Author: daibo <daibo@yy.com>
+ */
+#ifndef TCP_RENO_SENDER_H
+#define TCP_RENO_SENDER_H
+
+#include <string>
+
+#include "bbr-common.h"
+#include "send-algorithm-interface.h"
+#include "rtt-stats.h"
+#include "unacked-packet-map.h"
+
+namespace ns3
+{
+namespace bbr
+{
+class RttStats;
+
+// TcpRenoSender implements loss-based Reno congestion control in bytes:
+// slow start up to the slow start threshold, one MSS of growth per
+// congestion window acked afterwards, and a multiplicative decrease once per
+// loss episode.  It is the alternative to BBR the controller policy switches
+// to on paths where a loss-based controller competes better.
+class TcpRenoSender : public SendAlgorithmInterface
+{
+  public:
+    TcpRenoSender(const RttStats *rtt_stats,
+                  const UnackedPacketMap *unacked_packets,
+                  PacketCount initial_tcp_congestion_window,
+                  PacketCount max_tcp_congestion_window);
+    ~TcpRenoSender() override;
+
+    // Start implementation of SendAlgorithmInterface.
+    bool InSlowStart() const override;
+    bool InRecovery() const override;
+    bool IsProbingForMoreBandwidth() const override { return false; }
+    void SetInitialCongestionWindowInPackets(PacketCount congestion_window) override;
+
+    void AdjustNetworkParameters(Bandwidth bandwidth, uint64_t rtt) override;
+    void SetBandwidthResumption(bool enabled) override { bandwidth_resumption_ = enabled; }
+
+    void OnCongestionEvent(bool rtt_updated,
+                           ByteCount prior_in_flight,
+                           uint64_t event_time,
+                           const CongestionVector &acked_packets,
+                           const CongestionVector &lost_packets) override;
+    bool OnPacketSent(uint64_t sent_time,
+                      ByteCount bytes_in_flight,
+                      PacketNumber packet_number,
+                      ByteCount bytes,
+                      HasRetransmittableData is_retransmittable) override;
+    void OnRetransmissionTimeout(bool packets_retransmitted) override;
+    void OnPersistentCongestion() override;
+    void UndoLossRecovery() override;
+    // Reno only reacts to loss, so the peer's delivery rate is not used.
+    void OnPeerDeliveryRate(Bandwidth delivery_rate) override {}
+    void OnConnectionMigration() override;
+    uint64_t TimeUntilSend(uint64_t now, ByteCount bytes_in_flight) override;
+    Bandwidth PacingRate(ByteCount bytes_in_flight) const override;
+    Bandwidth BandwidthEstimate() const override;
+    ByteCount GetCongestionWindow() const override;
+    ByteCount GetSlowStartThreshold() const override;
+    CongestionControlType GetCongestionControlType() const override;
+    std::string GetDebugState() const override;
+    void OnApplicationLimited(ByteCount bytes_in_flight) override {}
+    // End implementation of SendAlgorithmInterface.
+
+  private:
+    void OnPacketAcked(PacketNumber acked_packet_number,
+                       ByteCount acked_bytes,
+                       ByteCount prior_in_flight);
+    void OnPacketLost(PacketNumber lost_packet_number);
+
+    // Grows the congestion window for |acked_bytes| newly acked bytes.
+    void MaybeIncreaseCwnd(ByteCount acked_bytes, ByteCount prior_in_flight);
+
+    // Whether the window was fully used when the acked data was sent, so
+    // that the acks say something about the path.
+    bool IsCwndLimited(ByteCount bytes_in_flight) const;
+
+    const RttStats *rtt_stats_;
+    const UnackedPacketMap *unacked_packets_;
+
+    ByteCount congestion_window_;
+    ByteCount min_congestion_window_;
+    ByteCount max_congestion_window_;
+    ByteCount initial_congestion_window_;
+    ByteCount initial_max_congestion_window_;
+    ByteCount slowstart_threshold_;
+
+    // Bytes acked since the window last grew in congestion avoidance.
+    ByteCount num_acked_bytes_;
+
+    PacketNumber largest_sent_packet_number_;
+    PacketNumber largest_acked_packet_number_;
+    // Losses of packets sent before the last cutback belong to the same
+    // episode and do not reduce the window again.
+    PacketNumber largest_sent_at_last_cutback_;
+
+    // State before the last cutback, restored if its losses prove spurious.
+    ByteCount prior_congestion_window_;
+    ByteCount prior_slowstart_threshold_;
+
+    // Whether AdjustNetworkParameters sets the window to the BDP.
+    bool bandwidth_resumption_;
+
+    DISALLOW_COPY_AND_ASSIGN(TcpRenoSender);
+};
+}
+}
+
+#endif
@@ -20,6 +20,7 @@ const uint32_t IPV4_UDP_OVERHEAD = IPV4_HEADER_SIZE + UDP_HEADER_SIZE;
 
 const uint8_t pic_type_real = 1;
 const uint8_t pic_type_fake = 0;
+const uint8_t pic_type_fec = 2;
 
 // syncodec parameters
 const uint32_t SYNCODEC_DEFAULT_FPS = 30;
@@ -29,7 +30,8 @@ enum SyncodecType {
     SYNCODEC_TYPE_STATS,
     SYNCODEC_TYPE_TRACE,
     SYNCODEC_TYPE_SHARING,
-    SYNCODEC_TYPE_HYBRID
+    SYNCODEC_TYPE_HYBRID,
+    SYNCODEC_TYPE_GOP
 };
 
 /**
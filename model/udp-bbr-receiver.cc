@@ -18,12 +18,16 @@
 #include "ns3/socket-factory.h"
 #include "ns3/packet.h"
 #include "ns3/uinteger.h"
+#include "ns3/enum.h"
+#include "ns3/boolean.h"
 
 #include "packet-header.h"
 #include "udp-bbr-receiver.h"
 #include "ack-frame.h"
-#include "stop-waiting-frame.h"
 #include "received-packet-manager.h"
+#include "fec-frame.h"
+#include "nack-frame.h"
+#include "udp-bbr-constants.h"
 
 namespace ns3
 {
@@ -42,23 +46,136 @@ UdpBbrReceiver::GetTypeId(void)
                                           "Port on which we listen for incoming packets.",
                                           UintegerValue(100),
                                           MakeUintegerAccessor(&UdpBbrReceiver::m_port),
-                                          MakeUintegerChecker<uint16_t>());
-    /*
+                                          MakeUintegerChecker<uint16_t>())
+                            .AddAttribute("ConnectionIdleTimeout",
+                                          "Time without packets after which a connection is closed, in ms.",
+                                          UintegerValue(30000),
+                                          MakeUintegerAccessor(&UdpBbrReceiver::m_connectionIdleTimeout),
+                                          MakeUintegerChecker<uint64_t>(1))
+                            .AddAttribute("MaxPooledConnections",
+                                          "Closed connections whose state is kept for reuse by new ones.",
+                                          UintegerValue(64),
+                                          MakeUintegerAccessor(&UdpBbrReceiver::m_maxPooledConnections),
+                                          MakeUintegerChecker<uint32_t>())
+                            .AddAttribute("MaxAckRanges",
+                                          "Ack ranges reported in each ack, zero for no limit.  The oldest are dropped first.",
+                                          UintegerValue(kDefaultMaxAckRanges),
+                                          MakeUintegerAccessor(&UdpBbrReceiver::m_maxAckRanges),
+                                          MakeUintegerChecker<uint32_t>())
+                            .AddAttribute("MaxAckTimestamps",
+                                          "Receive timestamps reported in each ack.  The oldest are dropped first.",
+                                          UintegerValue(kDefaultMaxAckTimestamps),
+                                          MakeUintegerAccessor(&UdpBbrReceiver::m_maxAckTimestamps),
+                                          MakeUintegerChecker<uint32_t>())
+                            .AddAttribute("AckTimestampPolicy",
+                                          "Which received packets have their receive time reported.",
+                                          EnumValue(bbr::kAckTimestampsAll),
+                                          MakeEnumAccessor(&UdpBbrReceiver::m_ackTimestampPolicy),
+                                          MakeEnumChecker(bbr::kAckTimestampsAll, "All",
+                                                          bbr::kAckTimestampsEveryNth, "EveryNth",
+                                                          bbr::kAckTimestampsLargest, "Largest"))
+                            .AddAttribute("AckTimestampInterval",
+                                          "Packets per reported receive time with the EveryNth policy.",
+                                          UintegerValue(4),
+                                          MakeUintegerAccessor(&UdpBbrReceiver::m_ackTimestampInterval),
+                                          MakeUintegerChecker<uint32_t>(1))
+                            .AddAttribute("Nack",
+                                          "Nack packets missing within a frame as soon as they are found.",
+                                          BooleanValue(true),
+                                          MakeBooleanAccessor(&UdpBbrReceiver::m_nackEnabled),
+                                          MakeBooleanChecker())
+                            .AddAttribute("NackReorderingThreshold",
+                                          "Packets received above a missing one before it is nacked.",
+                                          UintegerValue(2),
+                                          MakeUintegerAccessor(&UdpBbrReceiver::m_nackReorderingThreshold),
+                                          MakeUintegerChecker<uint32_t>(1))
+                            .AddAttribute("MinPlayoutDelay",
+                                          "Lower bound of the playout delay from frame generation to rendering, in ms.",
+                                          UintegerValue(50),
+                                          MakeUintegerAccessor(&UdpBbrReceiver::m_minPlayoutDelay),
+                                          MakeUintegerChecker<uint64_t>())
+                            .AddAttribute("MaxPlayoutDelay",
+                                          "Upper bound of the playout delay from frame generation to rendering, in ms.",
+                                          UintegerValue(500),
+                                          MakeUintegerAccessor(&UdpBbrReceiver::m_maxPlayoutDelay),
+                                          MakeUintegerChecker<uint64_t>())
+                            .AddAttribute("DeliveryRateWindow",
+                                          "Window over which the delivery rate reported to the sender is measured, in ms.",
+                                          UintegerValue(200),
+                                          MakeUintegerAccessor(&UdpBbrReceiver::m_deliveryRateWindow),
+                                          MakeUintegerChecker<uint64_t>(1))
                             .AddTraceSource("Bandwidth",
-                                            "Bandwidth",
+                                            "Delivery rate reported to the sender, in bits per second.",
                                             MakeTraceSourceAccessor(&UdpBbrReceiver::m_bandwidth),
-                                            "ns3::TracedValueCallback::Uint32");
-                                            */
+                                            "ns3::TracedValueCallback::Uint32")
+                            .AddTraceSource("FrameComplete",
+                                            "PicIndex and completion latency in ms of each complete frame.",
+                                            MakeTraceSourceAccessor(&UdpBbrReceiver::m_frameCompleteTrace),
+                                            "ns3::UdpBbrReceiver::FrameCompleteCallback");
     return tid;
 }
 
+UdpBbrReceiver::Stream::Stream(StreamId stream_id)
+    : id(stream_id),
+      least_unexpired_pic(0)
+{
+}
+
+UdpBbrReceiver::Connection::Connection(uint16_t packet_window_size)
+    : lossCounter(nullptr)
+{
+    Reset(0, packet_window_size);
+}
+
+UdpBbrReceiver::Connection::~Connection()
+{
+    delete lossCounter;
+    for (auto &it : streams)
+    {
+        delete it.second;
+    }
+}
+
+void UdpBbrReceiver::Connection::Reset(ConnectionId connection_id, uint16_t packet_window_size)
+{
+    id = connection_id;
+    from = Address();
+    last_packet_time = 0;
+    // PacketLossCounter cannot be cleared.
+    delete lossCounter;
+    lossCounter = new PacketLossCounter(packet_window_size);
+    received = 0;
+    num_packets_received_since_last_ack_sent = 0;
+    deliveryRate.Clear();
+    receivedPacketManager.Clear();
+    ack_alarm = SimpleAlarm();
+    headerContext.Clear();
+    for (auto &it : streams)
+    {
+        delete it.second;
+    }
+    streams.clear();
+    ackFrequencyReceived = false;
+    ackFrequencySeq = 0;
+    ackElicitingThreshold = kMaxRetransmittablePacketsBeforeAck;
+    maxAckDelay = std::min(kMaxDelayedAckTimeMs, kMinRetransmissionTimeMs / 2);
+    reorderingThreshold = 0;
+}
+
 UdpBbrReceiver::UdpBbrReceiver()
-    : m_lossCounter(248),
+    : m_packetWindowSize(248),
       m_timer(Timer::REMOVE_ON_DESTROY),
-      m_received(0),
-      m_num_packets_received_since_last_ack_sent(0),
-      m_num_bytes_received_since_last_ack_sent(0),
-      m_last_ack_sent_time(0)
+      m_maxPooledConnections(64),
+      m_connectionIdleTimeout(30000),
+      m_deliveryRateWindow(200),
+      m_nackEnabled(true),
+      m_nackReorderingThreshold(2),
+      m_minPlayoutDelay(50),
+      m_maxPlayoutDelay(500),
+      m_maxAckRanges(kDefaultMaxAckRanges),
+      m_maxAckTimestamps(kDefaultMaxAckTimestamps),
+      m_ackTimestampPolicy(kAckTimestampsAll),
+      m_ackTimestampInterval(4)
 {
     NS_LOG_FUNCTION(this);
     m_timer.SetDelay(MilliSeconds(10));//10ms
@@ -68,33 +185,66 @@ UdpBbrReceiver::UdpBbrReceiver()
 UdpBbrReceiver::~UdpBbrReceiver()
 {
     NS_LOG_FUNCTION(this);
+    for (auto &it : m_connections)
+    {
+        delete it.second;
+    }
+    for (Connection *connection : m_connectionPool)
+    {
+        delete connection;
+    }
 }
 
 uint16_t
 UdpBbrReceiver::GetPacketWindowSize() const
 {
     NS_LOG_FUNCTION(this);
-    return m_lossCounter.GetBitMapSize();
+    return m_packetWindowSize;
 }
 
 void UdpBbrReceiver::SetPacketWindowSize(uint16_t size)
 {
     NS_LOG_FUNCTION(this << size);
-    m_lossCounter.SetBitMapSize(size);
+    m_packetWindowSize = size;
+    for (auto &it : m_connections)
+    {
+        it.second->lossCounter->SetBitMapSize(size);
+    }
 }
 
 uint32_t
 UdpBbrReceiver::GetLost(void) const
 {
     NS_LOG_FUNCTION(this);
-    return m_lossCounter.GetLost();
+    uint32_t lost = 0;
+    for (const auto &it : m_connections)
+    {
+        lost += it.second->lossCounter->GetLost();
+    }
+    return lost;
 }
 
 uint64_t
 UdpBbrReceiver::GetReceived(void) const
 {
     NS_LOG_FUNCTION(this);
-    return m_received;
+    uint64_t received = 0;
+    for (const auto &it : m_connections)
+    {
+        received += it.second->received;
+    }
+    return received;
+}
+
+const PlayoutStats *UdpBbrReceiver::GetPlayoutStats(ConnectionId connection_id, StreamId stream_id) const
+{
+    std::unordered_map<ConnectionId, Connection *>::const_iterator it = m_connections.find(connection_id);
+    if (it == m_connections.end())
+    {
+        return nullptr;
+    }
+    std::map<StreamId, Stream *>::const_iterator stream = it->second->streams.find(stream_id);
+    return stream == it->second->streams.end() ? nullptr : &stream->second->jitterBuffer.stats();
 }
 
 void UdpBbrReceiver::DoDispose(void)
@@ -128,7 +278,6 @@ void UdpBbrReceiver::StartApplication(void)
     }
 
     m_socket6->SetRecvCallback(MakeCallback(&UdpBbrReceiver::HandleRead, this));
-    m_receivedPacketManager = new ReceivedPacketManager();
     m_timer.Schedule();
 }
 
@@ -141,15 +290,104 @@ void UdpBbrReceiver::StopApplication()
         m_socket->SetRecvCallback(MakeNullCallback<void, Ptr<Socket>>());
     }
     m_timer.Cancel();
-    delete m_receivedPacketManager;
+    while (!m_connections.empty())
+    {
+        ReleaseConnection(m_connections.begin()->second);
+    }
+}
+
+UdpBbrReceiver::Connection *UdpBbrReceiver::FindConnection(ConnectionId connection_id)
+{
+    std::unordered_map<ConnectionId, Connection *>::iterator it = m_connections.find(connection_id);
+    return it == m_connections.end() ? nullptr : it->second;
+}
+
+UdpBbrReceiver::Connection *UdpBbrReceiver::OpenConnection(ConnectionId connection_id)
+{
+    Connection *connection = nullptr;
+    if (m_connectionPool.empty())
+    {
+        connection = new Connection(m_packetWindowSize);
+    }
+    else
+    {
+        connection = m_connectionPool.back();
+        m_connectionPool.pop_back();
+    }
+    connection->Reset(connection_id, m_packetWindowSize);
+
+    connection->receivedPacketManager.set_connection_id(connection_id);
+    connection->receivedPacketManager.set_max_ack_ranges(m_maxAckRanges);
+    connection->receivedPacketManager.set_max_ack_timestamps(m_maxAckTimestamps);
+    connection->receivedPacketManager.set_ack_timestamp_policy(m_ackTimestampPolicy, m_ackTimestampInterval);
+    connection->deliveryRate.set_window(m_deliveryRateWindow * kNumMicrosPerMilli);
+
+    m_connections[connection_id] = connection;
+    NS_LOG_INFO("Open connection " << connection_id << ", " << m_connections.size() << " open");
+    return connection;
+}
+
+void UdpBbrReceiver::ReleaseConnection(Connection *connection)
+{
+    NS_LOG_INFO("Close connection " << connection->id << " received " << connection->received
+                << " lost " << connection->lossCounter->GetLost());
+    for (const auto &it : connection->streams)
+    {
+        std::cout << "RcvSide ConnectionId " << connection->id
+                  << " StreamId " << it.first
+                  << " PlayoutStats " << it.second->jitterBuffer.stats() << std::endl;
+    }
+    m_connections.erase(connection->id);
+    UpdateTimerDelay();
+    if (m_connectionPool.size() < m_maxPooledConnections)
+    {
+        m_connectionPool.push_back(connection);
+    }
+    else
+    {
+        delete connection;
+    }
+}
+
+UdpBbrReceiver::Stream *UdpBbrReceiver::GetStream(Connection *connection, StreamId stream_id)
+{
+    std::map<StreamId, Stream *>::iterator it = connection->streams.find(stream_id);
+    if (it != connection->streams.end())
+    {
+        return it->second;
+    }
+    Stream *stream = new Stream(stream_id);
+    stream->jitterBuffer.SetPlayoutDelayBounds(m_minPlayoutDelay, m_maxPlayoutDelay);
+    stream->nackTracker.set_reordering_threshold(m_nackReorderingThreshold);
+    connection->streams[stream_id] = stream;
+    NS_LOG_INFO("Open stream " << stream_id << " of connection " << connection->id);
+    return stream;
 }
 
 void UdpBbrReceiver::OnTimer()
 {
     uint64_t now_ms = Simulator::Now().GetMilliSeconds();
-    if (m_ack_alarm.IsExpired(now_ms))
+    std::vector<Connection *> idle;
+    for (auto &it : m_connections)
+    {
+        Connection *connection = it.second;
+        if (now_ms >= connection->last_packet_time + m_connectionIdleTimeout)
+        {
+            idle.push_back(connection);
+            continue;
+        }
+        if (connection->ack_alarm.IsExpired(now_ms))
+        {
+            SendAck(connection);
+        }
+        for (auto &stream : connection->streams)
+        {
+            stream.second->jitterBuffer.Update(now_ms);
+        }
+    }
+    for (Connection *connection : idle)
     {
-        SendAck();
+        ReleaseConnection(connection);
     }
     m_timer.Schedule();
 }
@@ -158,25 +396,58 @@ void UdpBbrReceiver::HandleRead(Ptr<Socket> socket)
 {
     NS_LOG_FUNCTION(this << socket);
     Ptr<Packet> packet;
+    Address from;
 
-    while ((packet = socket->RecvFrom(m_from)))
+    while ((packet = socket->RecvFrom(from)))
     {
         int type = PeekPackeType(packet);
         int size = packet->GetSize();
+        const ConnectionId connection_id = PeekConnectionId(packet);
         switch (type)
         {
         case kStreamPacket:
         {
+            Connection *connection = FindConnection(connection_id);
+            if (connection == nullptr)
+            {
+                connection = OpenConnection(connection_id);
+            }
+            // Follows the sender to a new address.
+            connection->from = from;
+            connection->last_packet_time = Simulator::Now().GetMilliSeconds();
+
             PacketHeader header;
+            header.m_context = &connection->headerContext;
             packet->RemoveHeader(header);
-            OnStreamPacket(header, size);
+            Stream *stream = GetStream(connection, header.m_stream_id);
+            OnPacketHeader(connection, stream, header);
+            if (header.PicType == pic_type_fec)
+            {
+                FecFrame fec;
+                packet->RemoveHeader(fec);
+                OnFecPacket(connection, stream, header, fec, size);
+            }
+            else
+            {
+                OnStreamPacket(connection, stream, header, size);
+            }
+            if (header.SendsFrameMetadata())
+            {
+                ReleaseHeadersAwaitingFrame(connection, stream, header.PicIndex);
+            }
             break;
         }
-        case kStopWaiting:
+        case kAckFrequencyPacket:
         {
-            StopWaitingFrame header;
-            packet->RemoveHeader(header);
-            m_receivedPacketManager->DontWaitForPacketsBefore(header.least_unacked);
+            Connection *connection = FindConnection(connection_id);
+            if (connection == nullptr)
+            {
+                NS_LOG_WARN("AckFrequency for unknown connection " << connection_id);
+                break;
+            }
+            AckFrequencyFrame frame;
+            packet->RemoveHeader(frame);
+            OnAckFrequency(connection, frame);
             break;
         }
         default:
@@ -185,17 +456,40 @@ void UdpBbrReceiver::HandleRead(Ptr<Socket> socket)
     }
 }
 
-void UdpBbrReceiver::OnStreamPacket(const PacketHeader &header, int size)
+void UdpBbrReceiver::OnPacketHeader(Connection *connection, Stream *stream, const PacketHeader &header)
+{
+    connection->receivedPacketManager.OnAckOfAck(header.m_largest_acked);
+    if (header.m_least_unexpired_pic > stream->least_unexpired_pic)
+    {
+        const PacketNumber least_unexpired_pic = header.m_least_unexpired_pic;
+        NS_LOG_INFO("pics before " << least_unexpired_pic << " of stream " << stream->id << " expired at sender");
+        stream->least_unexpired_pic = least_unexpired_pic;
+        connection->headerContext.RemoveFramesBefore(stream->id, least_unexpired_pic);
+        stream->frameAssembler.RemoveFramesBefore(least_unexpired_pic);
+        stream->nackTracker.RemoveFramesBefore(least_unexpired_pic);
+        stream->jitterBuffer.OnFramesExpired(least_unexpired_pic);
+        stream->headersAwaitingFrame.erase(stream->headersAwaitingFrame.begin(),
+                                           stream->headersAwaitingFrame.lower_bound(least_unexpired_pic));
+    }
+}
+
+void UdpBbrReceiver::OnStreamPacket(Connection *connection, Stream *stream, const PacketHeader &header, int size)
 {
     uint32_t currentSequenceNumber = header.m_data_seq;
-    uint64_t now = Simulator::Now().GetMilliSeconds();
+    uint64_t now_us = Simulator::Now().GetMicroSeconds();
 
-    m_lossCounter.NotifyReceived(currentSequenceNumber);
-    m_received++;
-    ++m_num_packets_received_since_last_ack_sent;
-    m_num_bytes_received_since_last_ack_sent += size;
+    connection->lossCounter->NotifyReceived(currentSequenceNumber);
+    connection->received++;
+    ++connection->num_packets_received_since_last_ack_sent;
+    connection->deliveryRate.OnPacketReceived(now_us, size);
 
-    m_receivedPacketManager->RecordPacketReceived(header, now);
+    connection->receivedPacketManager.RecordPacketReceived(header, now_us);
+    if (m_nackEnabled)
+    {
+        stream->nackTracker.OnFramePacket(header.PicIndex, header.PicCurPktSeq, header.m_packet_seq,
+                                          &connection->receivedPacketManager);
+        MaybeSendNack(connection, stream);
+    }
 
 //    NS_LOG_INFO("RecvData " << this
 //    << " Seq:("
@@ -221,9 +515,13 @@ void UdpBbrReceiver::OnStreamPacket(const PacketHeader &header, int size)
                             << " time "
                             << Simulator::Now().GetMilliSeconds()
                             << " RecvCount "
-                            << m_received
+                            << connection->received
                             << " gen time "
                             << header.PicGenTime
+                            << " ConnectionId "
+                            << connection->id
+                            << " StreamId "
+                            << stream->id
                             << std::endl;
 
     //std::shared_ptr<PicDataPacket> pic_data_packet(new PicDataPacket());
@@ -240,85 +538,222 @@ void UdpBbrReceiver::OnStreamPacket(const PacketHeader &header, int size)
 //    header.PicPktNum = data_packet->PicPktNum;
 //    header.PicCurPktSeq = data_packet->PicCurPktSeq;
 //    header.PicGenTime = data_packet->PicGenTime;
-    if(header.PicPktNum - header.PicCurPktSeq==1){
-        std::cout<< "RcvSide PicIndex "<< header.PicIndex
-                 << " PicPktNum "<< header.PicPktNum
-                 << " PicCurPktSeq "<< header.PicCurPktSeq
-                 << " PicGenTime "<< header.PicGenTime
-                 << " PicRcvTime "<< Simulator::Now().GetMilliSeconds()
-                 << " PicSize "<< header.PicDataLen
-                 << " E2eDelay "<< Simulator::Now().GetMilliSeconds() - header.PicGenTime
-                 << std::endl;
+    if (header.m_has_frame_metadata)
+    {
+        OnFramePacket(connection, stream, header);
+    }
+    else
+    {
+        stream->headersAwaitingFrame[header.PicIndex].push_back(header);
     }
 
-    if (m_receivedPacketManager->ack_frame_updated())
+    if (connection->receivedPacketManager.ack_frame_updated())
     {
-        MaybeSendAck();
+        MaybeSendAck(connection);
     }
 }
 
-void UdpBbrReceiver::MaybeSendAck()
+void UdpBbrReceiver::OnFramePacket(Connection *connection, Stream *stream, const PacketHeader &header)
+{
+    FecDecoder::RecoveredVector recovered;
+    stream->fecDecoder.OnSourcePacket(header.PicIndex, header.PicPktNum, header.PicCurPktSeq, &recovered);
+    OnPacketsRecovered(connection, stream, header, recovered);
+
+    AssembledFrame frame;
+    if (stream->frameAssembler.OnPacket(header, header.PicCurPktSeq, Simulator::Now().GetMilliSeconds(), &frame))
+    {
+        OnFrameComplete(connection, stream, frame, false);
+    }
+}
+
+void UdpBbrReceiver::ReleaseHeadersAwaitingFrame(Connection *connection, Stream *stream, PacketNumber pic_index)
+{
+    std::map<PacketNumber, std::vector<PacketHeader>>::iterator it = stream->headersAwaitingFrame.find(pic_index);
+    if (it == stream->headersAwaitingFrame.end())
+    {
+        return;
+    }
+    std::vector<PacketHeader> headers;
+    headers.swap(it->second);
+    stream->headersAwaitingFrame.erase(it);
+    for (PacketHeader &header : headers)
+    {
+        if (connection->headerContext.ExpandFrameMetadata(&header))
+        {
+            OnFramePacket(connection, stream, header);
+        }
+    }
+}
+
+void UdpBbrReceiver::OnFecPacket(Connection *connection,
+                                 Stream *stream,
+                                 const PacketHeader &header,
+                                 const FecFrame &fec,
+                                 int size)
+{
+    uint64_t now_us = Simulator::Now().GetMicroSeconds();
+
+    connection->received++;
+    ++connection->num_packets_received_since_last_ack_sent;
+    connection->deliveryRate.OnPacketReceived(now_us, size);
+
+    connection->receivedPacketManager.RecordPacketReceived(header, now_us);
+    if (m_nackEnabled)
+    {
+        stream->nackTracker.OnRepairPacket(header.m_packet_seq);
+        MaybeSendNack(connection, stream);
+    }
+
+    FecDecoder::RecoveredVector recovered;
+    stream->fecDecoder.OnRepairPacket(header.PicIndex, header.PicPktNum, fec, &recovered);
+    OnPacketsRecovered(connection, stream, header, recovered);
+
+    if (connection->receivedPacketManager.ack_frame_updated())
+    {
+        MaybeSendAck(connection);
+    }
+}
+
+void UdpBbrReceiver::OnPacketsRecovered(Connection *connection,
+                                        Stream *stream,
+                                        const PacketHeader &header,
+                                        const FecDecoder::RecoveredVector &recovered)
+{
+    for (const auto &packet : recovered)
+    {
+        NS_LOG_INFO("FEC recovered packet " << packet.first
+                    << " PicIndex " << header.PicIndex
+                    << " PicCurPktSeq " << packet.second);
+        connection->receivedPacketManager.RecordPacketRecovered(packet.first);
+
+        AssembledFrame frame;
+        if (stream->frameAssembler.OnPacket(header, packet.second, Simulator::Now().GetMilliSeconds(), &frame))
+        {
+            OnFrameComplete(connection, stream, frame, true);
+        }
+    }
+}
+
+void UdpBbrReceiver::OnFrameComplete(Connection *connection, Stream *stream, const AssembledFrame &frame, bool recovered)
+{
+    std::cout<< "RcvSide PicIndex "<< frame.pic_index
+             << " PicGenTime "<< frame.gen_time
+             << " PicRcvTime "<< frame.complete_time
+             << " PicSize "<< frame.data_len
+             << " E2eDelay "<< frame.complete_time - frame.gen_time
+             << " AssemblyTime "<< frame.complete_time - frame.first_packet_time
+             << (recovered ? " Recovered" : "")
+             << " ConnectionId "<< connection->id
+             << " StreamId "<< stream->id
+             << std::endl;
+    if (stream->id == 0)
+    {
+        m_frameCompleteTrace(frame.pic_index, frame.complete_time - frame.gen_time);
+    }
+    stream->jitterBuffer.OnFrameComplete(frame);
+}
+
+void UdpBbrReceiver::MaybeSendNack(Connection *connection, Stream *stream)
+{
+    NackFrame frame;
+    if (!stream->nackTracker.GetNackFrame(&connection->receivedPacketManager, &frame))
+    {
+        return;
+    }
+    frame.connection_id = connection->id;
+    Ptr<Packet> p = Create<Packet>();
+    p->AddHeader(frame);
+    if (m_socket->SendTo(p, 0, connection->from) >= 0)
+    {
+        NS_LOG_INFO("Send Nack: " << frame);
+    }
+}
+
+void UdpBbrReceiver::OnAckFrequency(Connection *connection, const AckFrequencyFrame &frame)
+{
+    if (connection->ackFrequencyReceived && frame.sequence_number <= connection->ackFrequencySeq)
+    {
+        return;
+    }
+    NS_LOG_INFO("AckFrequency " << frame.ack_eliciting_threshold
+                << " max_ack_delay " << frame.max_ack_delay
+                << " reordering " << frame.reordering_threshold
+                << " connection " << connection->id);
+    connection->ackFrequencyReceived = true;
+    connection->ackFrequencySeq = frame.sequence_number;
+    connection->ackElicitingThreshold = std::max<PacketCount>(1, frame.ack_eliciting_threshold);
+    connection->maxAckDelay = frame.max_ack_delay;
+    connection->reorderingThreshold = frame.reordering_threshold;
+    UpdateTimerDelay();
+    if (connection->num_packets_received_since_last_ack_sent >= connection->ackElicitingThreshold)
+    {
+        SendAck(connection);
+    }
+}
+
+void UdpBbrReceiver::UpdateTimerDelay()
+{
+    // The ack alarms are only checked when the timer fires, which serves
+    // every connection, so it follows the shortest delay requested.
+    uint64_t delay = 10;
+    for (const auto &it : m_connections)
+    {
+        delay = std::min<uint64_t>(delay, std::max<uint64_t>(1, it.second->maxAckDelay));
+    }
+    m_timer.SetDelay(MilliSeconds(delay));
+}
+
+void UdpBbrReceiver::MaybeSendAck(Connection *connection)
 {
     bool should_send = false;
-    if (m_received < kMinReceivedBeforeAckDecimation)
+    // Until the sender sets the policy, ack every packet at first.
+    if (!connection->ackFrequencyReceived && connection->received < kMinReceivedBeforeAckDecimation)
     {
         should_send = true;
     }
     else
     {
-        if (m_num_packets_received_since_last_ack_sent >= kMaxRetransmittablePacketsBeforeAck)
+        if (connection->num_packets_received_since_last_ack_sent >= connection->ackElicitingThreshold)
         {
             should_send = true;
         }
-        else if (!m_ack_alarm.IsSet())
+        else if (connection->reorderingThreshold > 0 &&
+                 connection->receivedPacketManager.ReachedReorderingThreshold(connection->reorderingThreshold))
         {
-            uint64_t ack_delay = std::min(kMaxDelayedAckTimeMs, kMinRetransmissionTimeMs / 2);
-            m_ack_alarm.Update(Simulator::Now().GetMilliSeconds()  + ack_delay);
+            should_send = true;
+        }
+        else if (!connection->ack_alarm.IsSet())
+        {
+            connection->ack_alarm.Update(Simulator::Now().GetMilliSeconds() + connection->maxAckDelay);
         }
     }
 
     if (should_send)
     {
-        SendAck();
+        SendAck(connection);
     }
 }
 
-void UdpBbrReceiver::SendAck()
+void UdpBbrReceiver::SendAck(Connection *connection)
 {
-    uint32_t bandwidth = 0;
-    if (m_last_ack_sent_time == 0) {
-        m_last_ack_sent_time = Simulator::Now().GetMilliSeconds();
-    } else {
-        if (m_num_bytes_received_since_last_ack_sent > 1000000) { // 1MBytes = 8Mbits 
-            bandwidth = m_num_bytes_received_since_last_ack_sent / (Simulator::Now().GetMilliSeconds() - m_last_ack_sent_time + 0.1); 
-            bandwidth *= 8 * 1000;
-            //bandwidth /= 1000.0;
-            NS_LOG_INFO("m_num_bytes_received_since_last_ack_sent=" << m_num_bytes_received_since_last_ack_sent
-                    << " m_last_ack_sent_time=" << m_last_ack_sent_time
-                    << " now=" << Simulator::Now().GetMilliSeconds()
-                    << " ReceiverBandwidth=" << bandwidth
-                    << "bps"
-                    );
-            m_last_ack_sent_time = Simulator::Now().GetMilliSeconds();
-
-            m_num_bytes_received_since_last_ack_sent = 0; 
-        }
-    }
-    m_num_packets_received_since_last_ack_sent = 0;
+    const Bandwidth delivery_rate = connection->deliveryRate.GetDeliveryRate();
+    m_bandwidth = delivery_rate.ToBitsPerSecond();
+    connection->receivedPacketManager.set_delivery_rate(delivery_rate);
+    connection->num_packets_received_since_last_ack_sent = 0;
 
-    const AckFrame *ack_frame = m_receivedPacketManager->GetUpdatedAckFrame(Simulator::Now().GetMilliSeconds());
+    const AckFrame *ack_frame = connection->receivedPacketManager.GetUpdatedAckFrame(Simulator::Now().GetMicroSeconds());
 
     Ptr<Packet> p = Create<Packet>();
     p->AddHeader(*ack_frame);
 
-    if ((m_socket->SendTo(p, 0, m_from)) >= 0)
+    if ((m_socket->SendTo(p, 0, connection->from)) >= 0)
     {
         NS_LOG_INFO("Send Ack: "
                     << *ack_frame
                     << " to address: " 
-                    << InetSocketAddress::ConvertFrom(m_from).GetIpv4());
+                    << InetSocketAddress::ConvertFrom(connection->from).GetIpv4());
 
-        NS_LOG_INFO("Lost pkt num : " << m_lossCounter.GetLost());
+        NS_LOG_INFO("Lost pkt num : " << connection->lossCounter->GetLost());
     }
 }
 }
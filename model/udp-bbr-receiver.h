@@ -7,6 +7,10 @@
 #ifndef UDP_BBR_RECEIVER_H
 #define UDP_BBR_RECEIVER_H
 
+#include <map>
+#include <unordered_map>
+#include <vector>
+
 #include "ns3/application.h"
 #include "ns3/event-id.h"
 #include "ns3/ptr.h"
@@ -14,10 +18,18 @@
 #include "ns3/packet-loss-counter.h"
 #include "ns3/core-module.h"
 #include "ns3/traced-value.h"
+#include "ns3/traced-callback.h"
 
 #include "packet-header.h"
 #include "simple-alarm.h"
 #include "packets.h"
+#include "fec-codec.h"
+#include "ack-frequency-frame.h"
+#include "delivery-rate-estimator.h"
+#include "frame-assembler.h"
+#include "jitter-buffer.h"
+#include "nack-tracker.h"
+#include "received-packet-manager.h"
 
 namespace ns3
 {
@@ -39,6 +51,7 @@ public:
   UdpBbrReceiver();
   virtual ~UdpBbrReceiver();
 
+  // Totals over the open connections.
   uint32_t GetLost(void) const;
   uint64_t GetReceived(void) const;
 
@@ -48,39 +61,142 @@ public:
 
   void OnTimer();
 
+  size_t GetNumConnections() const { return m_connections.size(); }
+
+  // Null if |connection_id| or its stream |stream_id| is not open.
+  const PlayoutStats *GetPlayoutStats(ConnectionId connection_id, StreamId stream_id = 0) const;
+
+  // Signature of the FrameComplete trace: PicIndex, completion latency in ms.
+  // Only the frames of stream 0, the video, are traced.
+  typedef void (*FrameCompleteCallback)(PacketNumber pic_index, uint64_t latency);
+
 protected:
   virtual void DoDispose(void);
 
 private:
+  // Reassembly and playout state of one stream of a connection.  Streams
+  // number their frames on their own, so a frame missing on one stream
+  // never holds back the frames of another.
+  struct Stream
+  {
+    explicit Stream(StreamId stream_id);
+
+    StreamId id;
+    bbr::FecDecoder fecDecoder;
+    // Headers without frame metadata whose frame has not been seen yet, by
+    // PicIndex.
+    std::map<PacketNumber, std::vector<PacketHeader>> headersAwaitingFrame;
+
+    // Pics below this index expired at the sender and will never complete.
+    PacketNumber least_unexpired_pic;
+
+    bbr::NackTracker nackTracker;
+    bbr::FrameAssembler frameAssembler;
+    bbr::JitterBuffer jitterBuffer;
+  };
+
+  // State of one sender, found by the connection ID every packet carries.
+  struct Connection
+  {
+    Connection(uint16_t packet_window_size);
+    ~Connection();
+
+    // Prepares a pooled connection for |connection_id|.
+    void Reset(ConnectionId connection_id, uint16_t packet_window_size);
+
+    ConnectionId id;
+    Address from;                    //!< Address the newest packet came from.
+    uint64_t last_packet_time;       //!< ms
+
+    PacketLossCounter *lossCounter;  //!< Lost packet counter
+    uint64_t received;               //!< Number of received packets
+    // How many consecutive packets have arrived without sending an ack.
+    uint32_t num_packets_received_since_last_ack_sent;
+
+    // Rate packets arrive at, reported to the sender in acks.
+    bbr::DeliveryRateEstimator deliveryRate;
+    bbr::ReceivedPacketManager receivedPacketManager;
+    bbr::SimpleAlarm ack_alarm;
+    bbr::PacketHeaderContext headerContext;
+    // Created by the first packet of each stream.
+    std::map<StreamId, Stream *> streams;
+
+    // Ack policy, set by the sender's newest AckFrequencyFrame.
+    bool ackFrequencyReceived;
+    uint64_t ackFrequencySeq;
+    PacketCount ackElicitingThreshold;
+    uint64_t maxAckDelay; // ms
+    PacketCount reorderingThreshold;
+  };
+
   virtual void StartApplication(void);
   virtual void StopApplication(void);
 
   void HandleRead(Ptr<Socket> socket);
 
-  void OnStreamPacket(const PacketHeader &header, int size);
-  void MaybeSendAck();
-  void SendAck();
+  // Null if |connection_id| is not open.
+  Connection *FindConnection(ConnectionId connection_id);
+  // Opens |connection_id| with pooled state if there is any.
+  Connection *OpenConnection(ConnectionId connection_id);
+  // Closes |connection|, keeping its state for reuse.
+  void ReleaseConnection(Connection *connection);
+  // Opens |stream_id| of |connection| if it is not open yet.
+  Stream *GetStream(Connection *connection, StreamId stream_id);
+
+  // Handles the connection state carried by every packet from the sender.
+  void OnPacketHeader(Connection *connection, Stream *stream, const PacketHeader &header);
+  void OnStreamPacket(Connection *connection, Stream *stream, const PacketHeader &header, int size);
+  // Handles a source packet once the metadata of its frame is known.
+  void OnFramePacket(Connection *connection, Stream *stream, const PacketHeader &header);
+  // Handles the packets of |pic_index| which arrived before its metadata.
+  void ReleaseHeadersAwaitingFrame(Connection *connection, Stream *stream, PacketNumber pic_index);
+  void OnFecPacket(Connection *connection, Stream *stream, const PacketHeader &header, const FecFrame &fec, int size);
+  // Acks source packets restored by FEC for the frame of |header|.
+  void OnPacketsRecovered(Connection *connection,
+                          Stream *stream,
+                          const PacketHeader &header,
+                          const FecDecoder::RecoveredVector &recovered);
+  // Hands a complete frame to the jitter buffer of |stream|.
+  void OnFrameComplete(Connection *connection, Stream *stream, const AssembledFrame &frame, bool recovered);
+  // Nacks the packets found missing within frames of |stream|, if any.
+  void MaybeSendNack(Connection *connection, Stream *stream);
+  // Applies the ack policy requested by the sender.
+  void OnAckFrequency(Connection *connection, const AckFrequencyFrame &frame);
+  // Sets the timer to the shortest ack delay of the open connections.
+  void UpdateTimerDelay();
+  void MaybeSendAck(Connection *connection);
+  void SendAck(Connection *connection);
 
-  Address m_from;
   uint16_t m_port;                 //!< Port on which we listen for incoming packets.
   Ptr<Socket> m_socket;            //!< IPv4 Socket
   Ptr<Socket> m_socket6;           //!< IPv6 Socket
-  PacketLossCounter m_lossCounter; //!< Lost packet counter
+  uint16_t m_packetWindowSize;     //!< Bitmap size of each connection's loss counter.
   Timer m_timer; //10ms
 
-  uint64_t m_received;             //!< Number of received packets
-  // How many consecutive packets have arrived without sending an ack.
-  uint32_t m_num_packets_received_since_last_ack_sent;
+  std::unordered_map<ConnectionId, Connection *> m_connections;
+  // Closed connections kept for reuse, so churn does not reallocate them.
+  std::vector<Connection *> m_connectionPool;
+  uint32_t m_maxPooledConnections; //!< Closed connections kept for reuse.
+  uint64_t m_connectionIdleTimeout; //!< Silence before a connection is closed, in ms.
+
+  uint64_t m_deliveryRateWindow;   //!< Window of the delivery rate estimate, in ms.
 
-  // To caculate receiver bandwidth.
-  uint64_t m_num_bytes_received_since_last_ack_sent;
-  uint64_t m_last_ack_sent_time;
+  bool m_nackEnabled;              //!< Nack packets missing within a frame.
+  uint32_t m_nackReorderingThreshold; //!< Packets above a missing one before it is nacked.
 
-  ReceivedPacketManager *m_receivedPacketManager;
-  bbr::SimpleAlarm m_ack_alarm;
+  uint64_t m_minPlayoutDelay;      //!< Lower bound of the playout delay, in ms.
+  uint64_t m_maxPlayoutDelay;      //!< Upper bound of the playout delay, in ms.
 
-  /*********************/ // For caculate receive bandwidth.
+  uint32_t m_maxAckRanges;
+  uint32_t m_maxAckTimestamps;
+  bbr::AckTimestampPolicy m_ackTimestampPolicy;
+  uint32_t m_ackTimestampInterval;
+
+  // Delivery rate sent in the latest ack, in bits per second.
   TracedValue<uint32_t> m_bandwidth;
+
+  // PicIndex and completion latency in ms of each complete video frame.
+  TracedCallback<PacketNumber, uint64_t> m_frameCompleteTrace;
 };
 }
 
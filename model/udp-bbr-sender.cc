@@ -15,6 +15,9 @@
 #include "ns3/socket-factory.h"
 #include "ns3/packet.h"
 #include "ns3/uinteger.h"
+#include "ns3/boolean.h"
+#include "ns3/double.h"
+#include "ns3/enum.h"
 #include <cstdlib>
 #include <cstdio>
 #include <fstream>
@@ -23,7 +26,9 @@
 #include "sent-packet-manager.h"
 #include "udp-bbr-sender.h"
 #include "ack-frame.h"
-#include "stop-waiting-frame.h"
+#include "nack-frame.h"
+#include "varint.h"
+#include "video-generator.h"
 
 #include <math.h>
 
@@ -33,8 +38,35 @@ NS_LOG_COMPONENT_DEFINE("UdpBbrSenderApplication");
 
 NS_OBJECT_ENSURE_REGISTERED(UdpBbrSender);
 
+namespace
+{
+// Streams of each connection.
+const bbr::StreamId kVideoStreamId = 0;
+const bbr::StreamId kAudioStreamId = 1;
+const bbr::StreamId kDataStreamId = 2;
+
+// Directory and file prefix of the traces of each TraceFamily.
+struct TraceFamilyInfo
+{
+    const char *sub_dir;
+    const char *file_prefix;
+};
+const TraceFamilyInfo kTraceFamilies[] = {
+    {TRACES_SUB_DIR, TRACES_FILE_PREFIX},
+    {TRACES_OTHER_SUB_DIR "/big_buck_bunny", "bbb_offset1900_1080p24fps"},
+    {TRACES_OTHER_SUB_DIR "/elephants_dream", "ed_offset3900_1080p24fps"},
+    {TRACES_OTHER_SUB_DIR "/Foreman_lookahead_1", "Foreman_ProRes"},
+    {TRACES_OTHER_SUB_DIR "/News_lookahead_1", "News_ProRes"},
+    {TRACES_OTHER_SUB_DIR "/Suzie_lookahead_1", "Suzie_ProRes"},
+    {TRACES_OTHER_SUB_DIR "/Concat", "Concat_ProRes"},
+};
+}
+
     MyVideoCodec::MyVideoCodec(){
-        auto innerCodec = new VideoCodecs::TraceBasedCodecWithScaling(TRACES_DIR_PATH, TRACES_FILE_PREFIX, SYNCODEC_DEFAULT_FPS);
+        m_traceDir = VideoCodecs::TraceStore::findTraceDir(TRACES_SUB_DIR);
+        m_traceFilePrefix = TRACES_FILE_PREFIX;
+        NS_ASSERT_MSG (!m_traceDir.empty (), "Traces file not found in candidate paths");
+        auto innerCodec = new VideoCodecs::TraceBasedCodecWithScaling(m_traceDir, m_traceFilePrefix, SYNCODEC_DEFAULT_FPS);
         SetCodec(std::shared_ptr<VideoCodecs::Codec>{innerCodec});
     }
 
@@ -46,9 +78,8 @@ NS_OBJECT_ENSURE_REGISTERED(UdpBbrSender);
         //std::cout << "Increase data rate to " << result / 1000 << " Kbps" << std::endl;
     }
 
-    void MyVideoCodec::Setup(float fps, DataRate max_data_rate, DataRate min_data_rate, DataRate target_data_rate, DataRate step_data_rate, uint64_t timeout, UdpBbrSender* sender)
+    void MyVideoCodec::Setup(float fps, DataRate max_data_rate, DataRate min_data_rate, DataRate target_data_rate, DataRate step_data_rate, UdpBbrSender* sender)
     {
-        m_TimeoutTime = timeout;
         m_dataRate = target_data_rate;
         m_maxDataRate = max_data_rate;
         m_minDataRate = min_data_rate;
@@ -67,7 +98,7 @@ NS_OBJECT_ENSURE_REGISTERED(UdpBbrSender);
         m_nextSendTstmp = 0;
         m_pic_seq = 0;
 
-        m_sender = sender;
+        SetStream(kVideoStreamId, bbr::kPartiallyReliable, sender);
 
 //        auto innerCodec = new VideoCodecs::TraceBasedCodec(TRACES_DIR_PATH, TRACES_FILE_PREFIX, fps);
 //        float result = innerCodec->setTargetRate(m_dataRate.GetBitRate());
@@ -103,7 +134,7 @@ NS_OBJECT_ENSURE_REGISTERED(UdpBbrSender);
         int size = DEFAULT_PAYLOAD_SIZE;
         data.data_seq = m_seqGen.NextSeq();
         data.data_length = size;
-        data.priority = bbr::ProtocolSendPriority::P0;
+        data.priority = bbr::kPriorityFreshData;
         data.expire_time = Simulator::Now().GetMilliSeconds() + 10000;
         data.payload.assign(size, 'X');
 
@@ -117,45 +148,96 @@ NS_OBJECT_ENSURE_REGISTERED(UdpBbrSender);
         return true;
     }
 
-    bool MyVideoCodec::GetNextPacket(PicDataPacket &data)
+    void MyVideoCodec::SetCodec (std::shared_ptr<VideoCodecs::Codec> codec)
     {
-        if(m_PicDataBuf.size() && m_PicDataBuf.front().PktDataLen.size()){ // Has pic data to send
-            int size = m_PicDataBuf.front().PktDataLen.front();
-            data.data_seq = m_seqGen.NextSeq();
-            data.data_length = size;
-            data.priority = bbr::ProtocolSendPriority::P0;
-            data.expire_time = Simulator::Now().GetMilliSeconds() + 10000;
-            data.payload.assign(size, 'P');
+        m_codec = codec;
+        m_layeredCodec = nullptr;
+        m_gopCodec = nullptr;
+        m_activeLayers = 1;
+    }
 
-            data.PicType = m_PicDataBuf.front().CurType;
-            data.PicIndex = m_PicDataBuf.front().PicSeq;
-            data.PicDataLen = m_PicDataBuf.front().PicDataLen;
-            data.PicPktNum = m_PicDataBuf.front().PicPktNum;
-            data.PicCurPktSeq = m_PicDataBuf.front().PicPktNum - m_PicDataBuf.front().PktDataLen.size();
-            data.PicGenTime = m_PicDataBuf.front().PicGenTime;
+    void MyVideoCodec::SetTraceFamily (TraceFamily family)
+    {
+        NS_ASSERT (family < sizeof (kTraceFamilies) / sizeof (kTraceFamilies[0]));
+        m_traceDir = VideoCodecs::TraceStore::findTraceDir (kTraceFamilies[family].sub_dir);
+        m_traceFilePrefix = kTraceFamilies[family].file_prefix;
+        NS_ASSERT_MSG (!m_traceDir.empty (), "Traces file not found in candidate paths");
+        auto innerCodec = new VideoCodecs::TraceBasedCodecWithScaling (m_traceDir, m_traceFilePrefix, SYNCODEC_DEFAULT_FPS);
+        innerCodec->setTargetRate (m_codec->getTargetRate ());
+        SetCodec (std::shared_ptr<VideoCodecs::Codec>{innerCodec});
+    }
 
-            m_PicDataBuf.front().PktDataLen.erase(m_PicDataBuf.front().PktDataLen.begin());
-            if(m_PicDataBuf.front().PktDataLen.size() == 0){// pkt send over,my be do some statics
-                m_PicSendingDataBuf.push_back(m_PicDataBuf.front());
-                m_PicDataBuf.erase(m_PicDataBuf.begin());
+    void MyVideoCodec::SetLayeredCodec (size_t num_layers, VideoCodecs::LayeredTraceCodec::LayerMode mode)
+    {
+        auto layeredCodec = new VideoCodecs::LayeredTraceCodec (m_traceDir, m_traceFilePrefix, SYNCODEC_DEFAULT_FPS,
+                                                                std::min<size_t> (num_layers, bbr::kMaxVideoLayers), mode);
+        layeredCodec->setTargetRate (m_codec->getTargetRate ());
+        SetCodec (std::shared_ptr<VideoCodecs::Codec>{layeredCodec});
+        m_layeredCodec = layeredCodec;
+        m_activeLayers = layeredCodec->getNumLayers ();
+        NS_LOG_INFO ("Layered codec with " << layeredCodec->getNumLayers () << " layers, from "
+                     << layeredCodec->getLayerResolutions ().front () << " to "
+                     << layeredCodec->getLayerResolutions ().back ());
+    }
 
-                //std::cout <<"Sent pic num "<< m_PicSendingDataBuf.size() << std::endl;
-                //std::cout <<"Left pic num "<< m_PicDataBuf.size() << std::endl;
-            }
-            return true;
-        }else{
-            return false;
+    void MyVideoCodec::SetGopStructure (size_t gop_size, size_t b_frames)
+    {
+        NS_ASSERT (m_gopCodec != nullptr);
+        m_gopCodec->setGopStructure (gop_size, b_frames);
+        NS_LOG_INFO ("GOP of " << gop_size << " frames, " << b_frames << " B-frames, keyframe every "
+                     << m_gopCodec->getKeyFrameInterval () << " s");
+    }
+
+    size_t MyVideoCodec::GetNumLayers () const
+    {
+        return m_layeredCodec != nullptr ? m_layeredCodec->getNumLayers () : 1;
+    }
+
+    void MyVideoCodec::GetLayerRates (std::vector<bbr::Bandwidth> *rates) const
+    {
+        rates->clear ();
+        float rate = 0;
+        for (size_t layer = 0; layer < GetNumLayers (); ++layer) {
+            rate += m_layeredCodec != nullptr ? m_layeredCodec->getLayerRate (layer)
+                                              : m_codec->getTargetRate ();
+            rates->push_back (bbr::Bandwidth::FromBitsPerSecond (rate));
         }
     }
 
-    void MyVideoCodec::SetCodec (std::shared_ptr<VideoCodecs::Codec> codec)
+    void MyVideoCodec::SetActiveLayers (size_t active_layers)
     {
-        m_codec = codec;
+        NS_ASSERT (active_layers >= 1 && active_layers <= GetNumLayers ());
+        m_activeLayers = active_layers;
+        // Takes effect on the frames already queued, but the one being sent.
+        const ByteCount dropped = m_PicDataBuf.DropLayers (m_activeLayers);
+        NS_LOG_INFO ("Send " << active_layers << " layers, dropped " << dropped << " queued bytes");
+    }
+
+    void MyVideoCodec::SetKeyFrameShaping (bbr::KeyFrameShaping shaping, uint32_t spread_frames)
+    {
+        m_keyFrameShaper.set_shaping (shaping);
+        m_keyFrameShaper.set_spread_frames (spread_frames);
+    }
+
+    size_t MyVideoCodec::GetNumTraceFrames () const
+    {
+        auto traceCodec = dynamic_cast<VideoCodecs::TraceBasedCodec*> (m_codec.get ());
+        return traceCodec != nullptr ? traceCodec->getNumFrames () : 0;
+    }
+
+    void MyVideoCodec::SetStartFrame (size_t frame_idx)
+    {
+        auto traceCodec = dynamic_cast<VideoCodecs::TraceBasedCodec*> (m_codec.get ());
+        NS_ASSERT (traceCodec != nullptr);
+        traceCodec->setStartFrame (frame_idx);
+        NS_LOG_INFO ("Replay " << m_traceFilePrefix << " traces from frame " << frame_idx
+                     << " of " << traceCodec->getNumFrames ());
     }
 
     void MyVideoCodec::SetCodecType (SyncodecType codecType)
     {
         VideoCodecs::Codec* codec = NULL;
+        VideoCodecs::GopCodec* gopCodec = NULL;
         switch (codecType) {
             case SYNCODEC_TYPE_PERFECT:
             {
@@ -179,29 +261,8 @@ NS_OBJECT_ENSURE_REGISTERED(UdpBbrSender);
             case SYNCODEC_TYPE_TRACE:
             case SYNCODEC_TYPE_HYBRID:
             {
-                const std::vector<std::string> candidatePaths = {
-                        ".",      // If run from top directory (e.g., with gdb), from ns-3.26/
-                        "../",    // If run from with test_new.py with designated directory, from ns-3.26/2017-xyz/
-                        "../..",  // If run with test.py, from ns-3.26/testpy-output/201...
-                };
-
-                const std::string traceSubDir{"src/bbr/model/videocodecs/video_traces/chat_firefox_h264"};
-                std::string traceDir{};
-
-                for (auto c : candidatePaths) {
-                    std::ostringstream currPathOss;
-                    currPathOss << c << "/" << traceSubDir;
-                    struct stat buffer;
-                    if (::stat (currPathOss.str ().c_str (), &buffer) == 0) {
-                        //filename exists
-                        traceDir = currPathOss.str ();
-                        break;
-                    }
-                }
-
-                NS_ASSERT_MSG (!traceDir.empty (), "Traces file not found in candidate paths");
-
-                auto filePrefix = "chat";
+                const std::string& traceDir = m_traceDir;
+                const std::string& filePrefix = m_traceFilePrefix;
                 auto innerCodec = (codecType == SYNCODEC_TYPE_TRACE) ?
                                   new VideoCodecs::TraceBasedCodecWithScaling{
                                           traceDir,        // path to traces directory
@@ -223,12 +284,22 @@ NS_OBJECT_ENSURE_REGISTERED(UdpBbrSender);
                 codec = new VideoCodecs::ShapedPacketizer{innerShCodec, DEFAULT_PACKET_SIZE};
                 break;
             }
+            case SYNCODEC_TYPE_GOP:
+            {
+                // Whole frames, so that the sender knows the type of each
+                VideoClipInfo *clip = VideoGenerator::GetBestClip (0, 0, 0, 0, 0);
+                gopCodec = new VideoCodecs::GopCodec{VideoGenerator::GetClipStore (*clip),
+                                                     SYNCODEC_DEFAULT_FPS};
+                codec = gopCodec;
+                break;
+            }
             default:  // defaults to perfect codec
                 codec = new VideoCodecs::PerfectCodec{DEFAULT_PACKET_SIZE};
         }
 
         // update member variable
-        m_codec = std::shared_ptr<VideoCodecs::Codec>{codec};
+        SetCodec (std::shared_ptr<VideoCodecs::Codec>{codec});
+        m_gopCodec = gopCodec;
     }
 
     void MyVideoCodec::EnqueuePic()
@@ -236,63 +307,58 @@ NS_OBJECT_ENSURE_REGISTERED(UdpBbrSender);
         uint64_t now = Simulator::Now().GetMilliSeconds();
         VideoCodecs::Codec& codec = *m_codec;
 
-        const auto bytesToSend = codec->first.size ();
+        PicData pic_data;
+        auto bytesToSend = codec->first.size ();
+        const bool keyFrame = m_gopCodec != nullptr && m_gopCodec->getFrameType () == 'I';
+        if (m_layeredCodec != nullptr) {
+            // Layers dropped by the sender are not sent until added back.
+            bytesToSend = 0;
+            pic_data.PicNumLayers = m_activeLayers;
+            for (uint8_t layer = 0; layer < m_activeLayers; ++layer) {
+                bytesToSend += m_layeredCodec->getLayerBytes(layer);
+                pic_data.PicLayerEnd[layer] = bytesToSend;
+            }
+        } else {
+            pic_data.PicNumLayers = 1;
+            pic_data.PicLayerEnd[0] = bytesToSend;
+        }
         ++codec; // Advance codec/packetizer to next frame/packet
         //std::cout <<"bytesToSend:------------------- "<< bytesToSend<< std::endl;
         NS_ASSERT (bytesToSend > 0);
-        uint16_t left_len = bytesToSend;
+        auto secsToNextEnqPic = codec->second;
 
-        uint16_t pic_total_pkts = static_cast<uint16_t>(ceil(bytesToSend*1.0/DEFAULT_PACKET_SIZE));
-        uint16_t pic_cur_seq = 0;
+        bbr::ShapedFrame shaped;
+        m_keyFrameShaper.OnFrame(bytesToSend, keyFrame, &shaped);
+        if (shaped.bytes != bytesToSend) {
+            // Intra refresh moved intra data between frames, in every layer alike.
+            for (uint8_t layer = 0; layer < pic_data.PicNumLayers; ++layer) {
+                pic_data.PicLayerEnd[layer] = std::max<uint64_t> (layer + 1,
+                                                                  pic_data.PicLayerEnd[layer] * shaped.bytes / bytesToSend);
+            }
+            bytesToSend = pic_data.PicLayerEnd[pic_data.PicNumLayers - 1];
+        }
 
-        PicData pic_data;
         pic_data.CurType = pic_type_real;
-        pic_data.PicSeq = m_pic_seq;
-        pic_data.PicGenTime = now;
-        pic_data.PicExpireTime = now + m_TimeoutTime;
-        pic_data.PicDataLen = bytesToSend;
-        pic_data.PicPktNum = pic_total_pkts;
-
-        while(left_len > 0){// Generate pkt from pic data
-            //std::cout <<"left len: "<< left_len<< std::endl;
-            if(left_len > DEFAULT_PAYLOAD_SIZE){
-                pic_data.PktDataLen.push_back(DEFAULT_PAYLOAD_SIZE);
-                left_len -= DEFAULT_PAYLOAD_SIZE;
-            }else{
-                pic_data.PktDataLen.push_back(left_len);
-                left_len = 0;
-            }
+        pic_data.Priority = shaped.key_frame ? bbr::kPriorityKeyFrame : bbr::kPriorityFreshData;
+        pic_data.PicReleaseSpan = shaped.release_frames * secsToNextEnqPic * 1000;
+        PicQueue::SetDataLen(&pic_data, bytesToSend);
+        if (m_pic_seq == 0) {
+            m_sender->OnFirstFrameQueued(pic_data.PicPktNum);
         }
-        m_pic_seq++;
-        m_PicDataBuf.push_back(pic_data);// queued new-frame
+        QueuePic(pic_data, now);// queued new-frame
 
         //NS_ASSERT (bytesToSend <= DEFAULT_PACKET_SIZE);
-        m_rateShapingBuf.push_back (bytesToSend);
         m_rateShapingBytes += bytesToSend;
 
 //      NS_LOG_INFO ("MyVideoCodec::EnqueuePic, pic enqueued, pic length: " << bytesToSend
-//                                                                          << ", buffer size: " << m_rateShapingBuf.size ()
+//                                                                          << ", buffer size: " << m_PicDataBuf.size ()
 //                                                                          << ", buffer bytes: " << m_rateShapingBytes);
-        auto secsToNextEnqPic = codec->second;
         Time tNext{Seconds (secsToNextEnqPic)};
         m_enqueueEvent = Simulator::Schedule (tNext, &MyVideoCodec::EnqueuePic, this);
         
         m_sender->TryToSendData();
     }
 
-    uint64_t MyVideoCodec::GetCurMaxPicQueueDelay(uint64_t now){
-
-        if(m_PicDataBuf.size() > 0 ){// timeout event occur
-            if(m_PicDataBuf.front().PicGenTime > now){
-                return 0;
-            }else{
-                return (now - m_PicDataBuf.front().PicGenTime);
-            }
-        }else{
-            return 0;
-        }
-    }
-
 TypeId
 UdpBbrSender::GetTypeId(void)
 {
@@ -314,6 +380,11 @@ UdpBbrSender::GetTypeId(void)
                                           UintegerValue(100),
                                           MakeUintegerAccessor(&UdpBbrSender::m_peerPort),
                                           MakeUintegerChecker<uint16_t>())
+                            .AddAttribute("ConnectionId",
+                                          "Connection ID the receiver tells this sender apart by, zero to pick a unique one.",
+                                          UintegerValue(0),
+                                          MakeUintegerAccessor(&UdpBbrSender::m_connectionId),
+                                          MakeUintegerChecker<uint64_t>(0, bbr::kVarIntMax))
                             .AddAttribute("AppId",
                                           "The Appid",
                                           UintegerValue(100),
@@ -329,6 +400,206 @@ UdpBbrSender::GetTypeId(void)
                                           DataRateValue(DataRate("1Mib/s")),
                                           MakeDataRateAccessor(&UdpBbrSender::m_dataRate),
                                           MakeDataRateChecker())
+                            .AddAttribute("ControllerSwitching",
+                                          "Switch the congestion controller at runtime according to the path classification",
+                                          BooleanValue(false),
+                                          MakeBooleanAccessor(&UdpBbrSender::m_controllerSwitching),
+                                          MakeBooleanChecker())
+                            .AddAttribute("BandwidthResumption",
+                                          "Start a controller switched to at runtime from the bandwidth and min_rtt of the previous one",
+                                          BooleanValue(false),
+                                          MakeBooleanAccessor(&UdpBbrSender::m_bandwidthResumption),
+                                          MakeBooleanChecker())
+                            .AddAttribute("FecScheme",
+                                          "FEC scheme protecting each frame. Redundancy follows the observed loss rate",
+                                          EnumValue(bbr::kFecReedSolomon),
+                                          MakeEnumAccessor(&UdpBbrSender::m_fecScheme),
+                                          MakeEnumChecker(bbr::kFecNone, "None",
+                                                          bbr::kFecXor, "Xor",
+                                                          bbr::kFecReedSolomon, "ReedSolomon"))
+                            .AddAttribute("AckFrequency",
+                                          "Request the receiver's ack policy from the congestion window and RTT",
+                                          BooleanValue(true),
+                                          MakeBooleanAccessor(&UdpBbrSender::m_ackFrequencyEnabled),
+                                          MakeBooleanChecker())
+                            .AddAttribute("MinEncoderRate",
+                                          "Lowest target rate of the encoder, also its initial rate",
+                                          DataRateValue(DataRate("200kb/s")),
+                                          MakeDataRateAccessor(&UdpBbrSender::m_minEncoderRate),
+                                          MakeDataRateChecker())
+                            .AddAttribute("MaxEncoderRate",
+                                          "Highest target rate of the encoder",
+                                          DataRateValue(DataRate("6Mb/s")),
+                                          MakeDataRateAccessor(&UdpBbrSender::m_maxEncoderRate),
+                                          MakeDataRateChecker())
+                            .AddAttribute("EncoderHeadroom",
+                                          "Fraction of the bandwidth estimate left unused by the encoder",
+                                          DoubleValue(0.1),
+                                          MakeDoubleAccessor(&UdpBbrSender::m_encoderHeadroom),
+                                          MakeDoubleChecker<double>(0, 1))
+                            .AddAttribute("EncoderTargetQueueDelay",
+                                          "Age (ms) of the oldest queued frame above which the encoder rate is lowered",
+                                          UintegerValue(100),
+                                          MakeUintegerAccessor(&UdpBbrSender::m_encoderTargetQueueDelay),
+                                          MakeUintegerChecker<uint64_t>())
+                            .AddAttribute("EncoderIncreasesPerSecond",
+                                          "Number of encoder rate increases allowed per second",
+                                          UintegerValue(2),
+                                          MakeUintegerAccessor(&UdpBbrSender::m_encoderIncreasesPerSecond),
+                                          MakeUintegerChecker<uint32_t>())
+                            .AddAttribute("SchedulingMode",
+                                          "How the send scheduler shares the sending rate between packet classes",
+                                          EnumValue(bbr::kStrictPriority),
+                                          MakeEnumAccessor(&UdpBbrSender::m_schedulingMode),
+                                          MakeEnumChecker(bbr::kStrictPriority, "Strict",
+                                                          bbr::kWeightedPriority, "Weighted"))
+                            .AddAttribute("AudioDeadline",
+                                          "Age (ms) of an audio frame after which it is no longer sent, 0 for none",
+                                          UintegerValue(100),
+                                          MakeUintegerAccessor(&UdpBbrSender::m_audioDeadline),
+                                          MakeUintegerChecker<uint64_t>())
+                            .AddAttribute("KeyFrameDeadline",
+                                          "Age (ms) of a keyframe after which it is no longer sent, 0 for none",
+                                          UintegerValue(400),
+                                          MakeUintegerAccessor(&UdpBbrSender::m_keyFrameDeadline),
+                                          MakeUintegerChecker<uint64_t>())
+                            .AddAttribute("RetransmissionDeadline",
+                                          "Age (ms) of a frame after which its packets are no longer retransmitted, 0 for none",
+                                          UintegerValue(150),
+                                          MakeUintegerAccessor(&UdpBbrSender::m_retransmissionDeadline),
+                                          MakeUintegerChecker<uint64_t>())
+                            .AddAttribute("FecRepairDeadline",
+                                          "Age (ms) of a frame after which its repair packets are no longer sent, 0 for none",
+                                          UintegerValue(100),
+                                          MakeUintegerAccessor(&UdpBbrSender::m_fecRepairDeadline),
+                                          MakeUintegerChecker<uint64_t>())
+                            .AddAttribute("FreshDataDeadline",
+                                          "Age (ms) of a frame after which it is no longer sent, 0 for none",
+                                          UintegerValue(200),
+                                          MakeUintegerAccessor(&UdpBbrSender::m_freshDataDeadline),
+                                          MakeUintegerChecker<uint64_t>())
+                            .AddAttribute("BulkDataDeadline",
+                                          "Age (ms) of bulk data after which it is no longer sent, 0 for none",
+                                          UintegerValue(0),
+                                          MakeUintegerAccessor(&UdpBbrSender::m_bulkDataDeadline),
+                                          MakeUintegerChecker<uint64_t>())
+                            .AddAttribute("AudioWeight",
+                                          "Share of the sending rate of audio frames in weighted scheduling",
+                                          UintegerValue(8),
+                                          MakeUintegerAccessor(&UdpBbrSender::m_audioWeight),
+                                          MakeUintegerChecker<uint32_t>(1))
+                            .AddAttribute("KeyFrameWeight",
+                                          "Share of the sending rate of keyframes in weighted scheduling",
+                                          UintegerValue(4),
+                                          MakeUintegerAccessor(&UdpBbrSender::m_keyFrameWeight),
+                                          MakeUintegerChecker<uint32_t>(1))
+                            .AddAttribute("RetransmissionWeight",
+                                          "Share of the sending rate of retransmissions in weighted scheduling",
+                                          UintegerValue(2),
+                                          MakeUintegerAccessor(&UdpBbrSender::m_retransmissionWeight),
+                                          MakeUintegerChecker<uint32_t>(1))
+                            .AddAttribute("FecRepairWeight",
+                                          "Share of the sending rate of FEC repair packets in weighted scheduling",
+                                          UintegerValue(1),
+                                          MakeUintegerAccessor(&UdpBbrSender::m_fecRepairWeight),
+                                          MakeUintegerChecker<uint32_t>(1))
+                            .AddAttribute("FreshDataWeight",
+                                          "Share of the sending rate of new frames in weighted scheduling",
+                                          UintegerValue(4),
+                                          MakeUintegerAccessor(&UdpBbrSender::m_freshDataWeight),
+                                          MakeUintegerChecker<uint32_t>(1))
+                            .AddAttribute("BulkDataWeight",
+                                          "Share of the sending rate of bulk data in weighted scheduling",
+                                          UintegerValue(1),
+                                          MakeUintegerAccessor(&UdpBbrSender::m_bulkDataWeight),
+                                          MakeUintegerChecker<uint32_t>(1))
+                            .AddAttribute("KeyFrameStartupBurst",
+                                          "Send the first frame unpaced, as far as the congestion window allows",
+                                          BooleanValue(true),
+                                          MakeBooleanAccessor(&UdpBbrSender::m_keyFrameStartupBurst),
+                                          MakeBooleanChecker())
+                            .AddAttribute("KeyFrameShaping",
+                                          "How keyframes but the first are kept from filling the path's queue at once",
+                                          EnumValue(bbr::kKeyFrameUnshaped),
+                                          MakeEnumAccessor(&UdpBbrSender::m_keyFrameShaping),
+                                          MakeEnumChecker(bbr::kKeyFrameUnshaped, "Unshaped",
+                                                          bbr::kKeyFrameSpread, "Spread",
+                                                          bbr::kKeyFrameIntraRefresh, "IntraRefresh"))
+                            .AddAttribute("KeyFrameSpreadFrames",
+                                          "Frame intervals a shaped keyframe is spread over",
+                                          UintegerValue(3),
+                                          MakeUintegerAccessor(&UdpBbrSender::m_keyFrameSpreadFrames),
+                                          MakeUintegerChecker<uint32_t>(1))
+                            .AddAttribute("VideoLayers",
+                                          "Layers of each frame, 1 for a single-layer codec",
+                                          UintegerValue(1),
+                                          MakeUintegerAccessor(&UdpBbrSender::m_videoLayers),
+                                          MakeUintegerChecker<uint32_t>(1, bbr::kMaxVideoLayers))
+                            .AddAttribute("LayerMode",
+                                          "Dependencies between the layers of a frame",
+                                          EnumValue(VideoCodecs::LayeredTraceCodec::SVC),
+                                          MakeEnumAccessor(&UdpBbrSender::m_layerMode),
+                                          MakeEnumChecker(VideoCodecs::LayeredTraceCodec::SVC, "Svc",
+                                                          VideoCodecs::LayeredTraceCodec::SIMULCAST, "Simulcast"))
+                            .AddAttribute("TraceFamily",
+                                          "Video traces replayed by the encoder",
+                                          EnumValue(kTraceChat),
+                                          MakeEnumAccessor(&UdpBbrSender::m_traceFamily),
+                                          MakeEnumChecker(kTraceChat, "Chat",
+                                                          kTraceBigBuckBunny, "BigBuckBunny",
+                                                          kTraceElephantsDream, "ElephantsDream",
+                                                          kTraceForeman, "Foreman",
+                                                          kTraceNews, "News",
+                                                          kTraceSuzie, "Suzie",
+                                                          kTraceConcat, "Concat"))
+                            .AddAttribute("VideoCodec",
+                                          "Codec of the video stream: trace replay, or the GOP-structured clip",
+                                          EnumValue(SYNCODEC_TYPE_TRACE),
+                                          MakeEnumAccessor(&UdpBbrSender::m_codecType),
+                                          MakeEnumChecker(SYNCODEC_TYPE_TRACE, "Trace",
+                                                          SYNCODEC_TYPE_GOP, "Gop"))
+                            .AddAttribute("GopSize",
+                                          "Keyframe interval in frames of the Gop codec, 0 to keep the frame types of the clip",
+                                          UintegerValue(0),
+                                          MakeUintegerAccessor(&UdpBbrSender::m_gopSize),
+                                          MakeUintegerChecker<uint32_t>())
+                            .AddAttribute("GopBFrames",
+                                          "B-frames between successive I- or P-frames of the Gop codec, if GopSize is set",
+                                          UintegerValue(0),
+                                          MakeUintegerAccessor(&UdpBbrSender::m_gopBFrames),
+                                          MakeUintegerChecker<uint32_t>())
+                            .AddAttribute("RandomTraceStart",
+                                          "Start the video traces at a random frame, so that flows replaying the same traces do not send their keyframes at once",
+                                          BooleanValue(true),
+                                          MakeBooleanAccessor(&UdpBbrSender::m_randomTraceStart),
+                                          MakeBooleanChecker())
+                            .AddAttribute("AudioStream",
+                                          "Send an audio stream along with the video",
+                                          BooleanValue(false),
+                                          MakeBooleanAccessor(&UdpBbrSender::m_audioEnabled),
+                                          MakeBooleanChecker())
+                            .AddAttribute("AudioRate",
+                                          "Bitrate of the audio stream",
+                                          DataRateValue(DataRate("32kb/s")),
+                                          MakeDataRateAccessor(&UdpBbrSender::m_audioRate),
+                                          MakeDataRateChecker())
+                            .AddAttribute("AudioFrameInterval",
+                                          "Time (ms) between two audio frames",
+                                          UintegerValue(20),
+                                          MakeUintegerAccessor(&UdpBbrSender::m_audioFrameInterval),
+                                          MakeUintegerChecker<uint64_t>(1))
+                            .AddAttribute("AudioReliability",
+                                          "Whether lost audio packets are retransmitted",
+                                          EnumValue(bbr::kUnreliable),
+                                          MakeEnumAccessor(&UdpBbrSender::m_audioReliability),
+                                          MakeEnumChecker(bbr::kReliable, "Reliable",
+                                                          bbr::kPartiallyReliable, "PartiallyReliable",
+                                                          bbr::kUnreliable, "Unreliable"))
+                            .AddAttribute("DataStreamBytes",
+                                          "Size of a reliable bulk data stream sent along with the video, 0 for none",
+                                          UintegerValue(0),
+                                          MakeUintegerAccessor(&UdpBbrSender::m_dataStreamBytes),
+                                          MakeUintegerChecker<uint64_t>())
                             .AddTraceSource("Rtt",
                                             "round trip time",
                                             MakeTraceSourceAccessor(&UdpBbrSender::m_traceRtt),
@@ -347,10 +618,27 @@ UdpBbrSender::GetTypeId(void)
 }
 
 static bool app_onoff = false;
+// Connection IDs picked for senders without one.
+static bbr::ConnectionId next_connection_id = 1;
 
 UdpBbrSender::UdpBbrSender()
-: m_timer(Timer::REMOVE_ON_DESTROY),
-  stop_waiting_count_(0)
+: m_connectionId(0),
+  m_timer(Timer::REMOVE_ON_DESTROY),
+  m_ackFrequencyEnabled(true),
+  m_lastAckFrequencyTime(0),
+  m_keyFrameStartupBurst(true),
+  m_keyFrameShaping(bbr::kKeyFrameUnshaped),
+  m_keyFrameSpreadFrames(3),
+  m_audioEnabled(false),
+  m_audioRate(DataRate("32kb/s")),
+  m_audioFrameInterval(20),
+  m_audioReliability(bbr::kUnreliable),
+  m_dataStreamBytes(0),
+  m_traceFamily(kTraceChat),
+  m_randomTraceStart(true),
+  m_codecType(SYNCODEC_TYPE_TRACE),
+  m_gopSize(0),
+  m_gopBFrames(0)
 {
     NS_LOG_FUNCTION(this);
     m_sent = 0;
@@ -360,18 +648,14 @@ UdpBbrSender::UdpBbrSender()
     m_traceRtt = 0;
     m_bytesInFlight = 0;
     m_bandwidth = 0;
+    m_traceStartRng = CreateObject<UniformRandomVariable>();
 
     //m_timer.SetDelay(MilliSeconds(1));//10ms
     //m_timer.SetFunction(&UdpBbrSender::OnTimer, this);
-    m_video_codec.Setup(30. , DataRate("2.0Mb/s"), DataRate("2.0Mb/s"), DataRate("0.2Mb/s"), DataRate("0.2Mb/s"), 200, this);
+    m_video_codec.Setup(30. , DataRate("2.0Mb/s"), DataRate("2.0Mb/s"), DataRate("0.2Mb/s"), DataRate("0.2Mb/s"), this);
     m_total_bytes_sent = 0;
     m_total_pkts_sent = 0;
 
-    m_sampleQueue = PicSentInfoSampleQueue();
-    m_streamStatus = VideoStreamAccessDelayStatus();
-
-    //m_timer_updateStreamStatus.SetDelay(MilliSeconds(100));//100ms
-    //m_timer_updateStreamStatus.SetFunction(&UdpBbrSender::OnTimerUpdateStreamStatus, this);
 }
 
 UdpBbrSender::~UdpBbrSender()
@@ -398,6 +682,27 @@ void UdpBbrSender::DoDispose(void)
     Application::DoDispose();
 }
 
+int64_t UdpBbrSender::AssignStreams(int64_t stream)
+{
+    NS_LOG_FUNCTION(this << stream);
+    m_traceStartRng->SetStream(stream);
+    return 1;
+}
+
+void UdpBbrSender::OnFirstFrameQueued(PacketCount packets)
+{
+    if (m_keyFrameStartupBurst)
+    {
+        NS_LOG_INFO("AppId " << m_appId << " first frame of " << packets << " packets sent unpaced");
+        m_sentPacketManager->AllowUnpacedBurst(packets);
+    }
+}
+
+uint64_t UdpBbrSender::GetSendDeadline(bbr::ProtocolSendPriority priority) const
+{
+    return m_scheduler.deadline(priority);
+}
+
 float UdpBbrSender::setTargetRate(float newRateBps){
     return m_video_codec.setTargetRate(newRateBps);
 }
@@ -443,11 +748,79 @@ void UdpBbrSender::StartApplication(void)
             );
     m_socket->SetAllowBroadcast(true);
 
-    m_sentPacketManager = new bbr::SentPacketManager(&stats_, bbr::kBBR, bbr::kAdaptiveTime);
+    if (m_connectionId == 0)
+    {
+        m_connectionId = next_connection_id++;
+    }
+    m_sentPacketManager = new bbr::SentPacketManager(&stats_, bbr::kBBR, bbr::kRack);
+    m_sentPacketManager->EnableControllerSwitching(m_controllerSwitching);
+    m_sentPacketManager->SetBandwidthResumption(m_bandwidthResumption);
+    m_fecEncoder.set_scheme(m_fecScheme);
+    m_scheduler.set_mode(m_schedulingMode);
+    m_scheduler.set_deadline(bbr::kPriorityAudio, m_audioDeadline);
+    m_scheduler.set_deadline(bbr::kPriorityKeyFrame, m_keyFrameDeadline);
+    m_scheduler.set_deadline(bbr::kPriorityRetransmission, m_retransmissionDeadline);
+    m_scheduler.set_deadline(bbr::kPriorityFecRepair, m_fecRepairDeadline);
+    m_scheduler.set_deadline(bbr::kPriorityFreshData, m_freshDataDeadline);
+    m_scheduler.set_deadline(bbr::kPriorityBulkData, m_bulkDataDeadline);
+    m_scheduler.set_weight(bbr::kPriorityAudio, m_audioWeight);
+    m_scheduler.set_weight(bbr::kPriorityKeyFrame, m_keyFrameWeight);
+    m_scheduler.set_weight(bbr::kPriorityRetransmission, m_retransmissionWeight);
+    m_scheduler.set_weight(bbr::kPriorityFecRepair, m_fecRepairWeight);
+    m_scheduler.set_weight(bbr::kPriorityFreshData, m_freshDataWeight);
+    m_scheduler.set_weight(bbr::kPriorityBulkData, m_bulkDataWeight);
+    if (m_codecType == SYNCODEC_TYPE_GOP)
+    {
+        m_video_codec.SetCodecType(SYNCODEC_TYPE_GOP);
+        m_video_codec.SetGopStructure(m_gopSize, m_gopBFrames);
+    }
+    else
+    {
+        if (m_traceFamily != kTraceChat)
+        {
+            m_video_codec.SetTraceFamily(m_traceFamily);
+        }
+        if (m_videoLayers > 1)
+        {
+            m_video_codec.SetLayeredCodec(m_videoLayers, m_layerMode);
+        }
+    }
+    m_video_codec.SetKeyFrameShaping(m_keyFrameShaping, m_keyFrameSpreadFrames);
+    m_layerController.set_headroom(m_encoderHeadroom);
+    m_layerController.set_target_queue_delay(m_encoderTargetQueueDelay);
+    m_layerController.Reset(m_video_codec.GetNumLayers());
+    m_rateController.set_min_rate(bbr::Bandwidth::FromBitsPerSecond(m_minEncoderRate.GetBitRate()));
+    m_rateController.set_max_rate(bbr::Bandwidth::FromBitsPerSecond(m_maxEncoderRate.GetBitRate()));
+    m_rateController.set_headroom(m_encoderHeadroom);
+    m_rateController.set_target_queue_delay(m_encoderTargetQueueDelay);
+    m_rateController.set_max_increases_per_second(m_encoderIncreasesPerSecond);
+    m_rateController.Reset(bbr::Bandwidth::FromBitsPerSecond(m_minEncoderRate.GetBitRate()));
+    setTargetRate(m_rateController.target_rate().ToBitsPerSecond());
+    const size_t trace_frames = m_video_codec.GetNumTraceFrames();
+    if (m_randomTraceStart && trace_frames > 0)
+    {
+        m_video_codec.SetStartFrame(m_traceStartRng->GetInteger(0, trace_frames - 1));
+    }
     //m_timer.Schedule();
-    //m_timer_updateStreamStatus.Schedule();
 
-    m_video_codec.StartApp();
+    m_streams.clear();
+    m_streams.push_back(&m_video_codec);
+    if (m_audioEnabled)
+    {
+        m_audioSource.SetStream(kAudioStreamId, m_audioReliability, this);
+        m_audioSource.Setup(m_audioRate, m_audioFrameInterval);
+        m_streams.push_back(&m_audioSource);
+    }
+    if (m_dataStreamBytes > 0)
+    {
+        m_dataSource.SetStream(kDataStreamId, bbr::kReliable, this);
+        m_dataSource.Setup(m_dataStreamBytes);
+        m_streams.push_back(&m_dataSource);
+    }
+    for (StreamSource *stream : m_streams)
+    {
+        stream->StartApp();
+    }
 }
 
 void UdpBbrSender::ConnectionSucceeded(Ptr<Socket> socket)
@@ -477,99 +850,11 @@ void UdpBbrSender::StopApplication(void)
     //m_timer.Cancel();
     delete m_sentPacketManager;
 
-    m_video_codec.StopApp();
-}
-
-    void UdpBbrSender::OnTimerUpdateStreamStatus()
+    for (StreamSource *stream : m_streams)
     {
-        return;
-        std::cout << "In  UdpBbrSender::OnTimerUpdateStreamStatus()" <<  std::endl;
-        uint64_t now_ms = Simulator::Now().GetMilliSeconds();
-        //time-based
-        if(m_sampleQueue.SampleQueue.size() > 25){ // has samples
-            int sampleNum = m_sampleQueue.SampleQueue.size();
-            int64_t ProcessTime = m_sampleQueue.NewlyUpdateTime;
-            int64_t ProcessAccessDelay = 0;
-            while (!m_sampleQueue.SampleQueue.empty()){
-                ProcessAccessDelay += m_sampleQueue.SampleQueue.front().PicAccessDelay;
-                m_sampleQueue.SampleQueue.pop_front();
-            }
-            //std::cout << "ProcessAccessDelay1 " << ProcessAccessDelay << "sampleNum " << sampleNum << std::endl;
-            ProcessAccessDelay /= sampleNum;
-            std::cout << "ProcessAccessDelay " << ProcessAccessDelay << "sampleNum " << sampleNum << std::endl;
-            if(m_streamStatus.IsValid){// Common process
-                float Acceleration = (ProcessAccessDelay - (int64_t)m_streamStatus.InitProcessAccessDelay)*1.0/
-                                     (ProcessTime - (int64_t)m_streamStatus.InitProcessTime);
-
-                std::cout << "ProcessAccessDelay - m_streamStatus.InitProcessAccessDelay " << ProcessAccessDelay - (int64_t)m_streamStatus.InitProcessAccessDelay << std::endl;
-                std::cout << "ProcessTime - m_streamStatus.InitProcessTime " << ProcessTime - (int64_t)m_streamStatus.InitProcessTime << std::endl;
-
-                std::cout << "Acceleration " << Acceleration << std::endl;
-                std::cout << "m_streamStatus.MaxAcceleration " << m_streamStatus.MaxAcceleration << std::endl;
-                std::cout << "m_streamStatus.MinAcceleration " << m_streamStatus.MinAcceleration << std::endl;
-                std::cout << "m_streamStatus.MaxAccelerationContinueUpdateCount " << m_streamStatus.MaxAccelerationContinueUpdateCount << std::endl;
-                std::cout << "m_streamStatus.MinAccelerationContinueUpdateCount " << m_streamStatus.MinAccelerationContinueUpdateCount << std::endl;
-                std::cout << "m_streamStatus.InitProcessAccessDelay " << m_streamStatus.InitProcessAccessDelay <<  std::endl;
-                std::cout << "m_streamStatus.InitProcessTime " << m_streamStatus.InitProcessTime <<  std::endl;
-
-                if(Acceleration > m_streamStatus.MaxAcceleration){
-                    m_streamStatus.MaxAcceleration = Acceleration;
-                    m_streamStatus.MaxAccelerationContinueUpdateCount ++;
-                    m_streamStatus.MinAccelerationContinueUpdateCount = 0;
-
-                    //m_streamStatus.InitProcessAccessDelay = m_streamStatus.LatestProcessAccessDelay;
-                    //m_streamStatus.InitProcessTime = m_streamStatus.LatestProcessTime;
-
-                    m_streamStatus.MaxAcceleration = 0.0;
-
-                    if(m_streamStatus.MaxAccelerationContinueUpdateCount > 2){
-                        float bandwidth = m_sentPacketManager->BandwidthEstimate().ToBitsPerSecond()*1.0;
-                        float result = setTargetRate(bandwidth - 100000.0);
-                        //float result = setTargetRate(bandwidth);
-                        std::cout << "Decrease data rate to " << result / 1000 << " Kbps" << std::endl;
-                        m_streamStatus.MaxAccelerationContinueUpdateCount = 0;
-                        //m_streamStatus.MaxAcceleration = 0.0;
-                    }
-                } else if(Acceleration < m_streamStatus.MinAcceleration){
-                    m_streamStatus.MinAcceleration = Acceleration;
-                    m_streamStatus.MaxAccelerationContinueUpdateCount = 0;
-                    m_streamStatus.MinAccelerationContinueUpdateCount ++;
-
-                    //m_streamStatus.InitProcessAccessDelay = m_streamStatus.LatestProcessAccessDelay;
-                    //m_streamStatus.InitProcessTime = m_streamStatus.LatestProcessTime;
-
-                    if(m_streamStatus.MinAccelerationContinueUpdateCount > 2){
-                        float bandwidth = m_sentPacketManager->BandwidthEstimate().ToBitsPerSecond()*1.0;
-                        float result = setTargetRate(bandwidth);
-                        std::cout << "Increase 2 data rate to " << result / 1000 << " Kbps" << std::endl;
-                    }
-                }else{
-                    m_streamStatus.MaxAccelerationContinueUpdateCount = 0;
-                    m_streamStatus.MinAccelerationContinueUpdateCount = 0;
-
-                    m_streamStatus.InitProcessAccessDelay = m_streamStatus.LatestProcessAccessDelay;
-                    m_streamStatus.InitProcessTime = m_streamStatus.LatestProcessTime;
-                }
-
-            }else{// Init
-                m_streamStatus.InitProcessAccessDelay = ProcessAccessDelay;
-                m_streamStatus.InitProcessTime = m_sampleQueue.NewlyUpdateTime;
-
-                std::cout << "m_streamStatus.InitProcessAccessDelay " << m_streamStatus.InitProcessAccessDelay <<  std::endl;
-                std::cout << "m_streamStatus.InitProcessTime " << m_streamStatus.InitProcessTime <<  std::endl;
-
-                m_streamStatus.MinAcceleration = 100000;//100s
-                m_streamStatus.MaxAcceleration = 0;
-
-                m_streamStatus.IsValid = true;
-
-                std::cout << "In  UdpBbrSender::OnTimerUpdateStreamStatus() init" <<  std::endl;
-            }
-            m_streamStatus.LatestProcessAccessDelay = ProcessAccessDelay;
-            m_streamStatus.LatestProcessTime = m_sampleQueue.NewlyUpdateTime;
-        }
-        m_timer_updateStreamStatus.Schedule();
+        stream->StopApp();
     }
+}
 
 void UdpBbrSender::OnTimer()
 {
@@ -580,48 +865,27 @@ void UdpBbrSender::OnTimer()
         OnRetransmissionTimeout();
     }
 
-    bool unlimited = SendRetransmissions();
+    bool unlimited = SendScheduledPackets();
 
-    //
-    unlimited |= SendQueuedPackets();
+    // Probe with the oldest data until the owed probes are sent, if there
+    // was no new data to probe with.
+    while (!unlimited && m_sentPacketManager->HasPendingProbes() &&
+           m_sentPacketManager->MaybeRetransmitOldestPacketAsProbe())
+    {
+        unlimited = SendScheduledPackets();
+    }
 
     if (!unlimited)
     {
         m_sentPacketManager->OnApplicationLimited();
-        // Get current bandwidth and set it to codec
-        float bandwidth = m_sentPacketManager->BandwidthEstimate().ToBitsPerSecond()*1.0;
-        //float result = setTargetRate(bandwidth + 100000);
-        // if(bandwidth > 100*1000.0 && bandwidth <= 600*1000.0){
-        //     bandwidth = 600*1000.0;
-        // }else if(bandwidth > 600*1000.0 && bandwidth <= 700*1000.0){
-        //     bandwidth = 700*1000.0;
-        // }else if(bandwidth > 700*1000.0 && bandwidth <= 800*1000.0){
-        //     bandwidth = 800*1000.0;
-        // }else if(bandwidth > 800*1000.0 && bandwidth <= 1000*1000.0){
-        //     bandwidth = 1000*1000.0;
-        // }else if(bandwidth > 1000*1000.0 && bandwidth <= 1200*1000.0){
-        //     bandwidth = 1200*1000.0;
-        // }else if(bandwidth > 1200*1000.0 && bandwidth <= 1500*1000.0){
-        //     bandwidth = 1500*1000.0;
-        // }else{
-        //     bandwidth = 2000*1000.0;
-        // }
-
-        float result = setTargetRate(bandwidth + 100*1000.0);
-        std::cout << "Increase data rate to " << result / 1000 << " Kbps" << std::endl;
     }
+    UpdateEncoderRate(!unlimited);
 
     if (!m_resend_alarm.IsSet())
     {
         SetRetransmissionAlarm();
     }
 
-    if (stop_waiting_count_ > kStopWaitingThreshold)
-    {
-        SendStopWaitingFrame();
-        stop_waiting_count_ = 0;
-    }
-
     m_timer.Schedule();
 }
 
@@ -633,31 +897,57 @@ void UdpBbrSender::TryToSendData(){
         OnRetransmissionTimeout();
     }
 
-    bool unlimited = SendRetransmissions();
+    bool unlimited = SendScheduledPackets();
 
-    //
-    unlimited |= SendQueuedPackets();
+    // Probe with the oldest data until the owed probes are sent, if there
+    // was no new data to probe with.
+    while (!unlimited && m_sentPacketManager->HasPendingProbes() &&
+           m_sentPacketManager->MaybeRetransmitOldestPacketAsProbe())
+    {
+        unlimited = SendScheduledPackets();
+    }
 
     if (!unlimited)
     {
         m_sentPacketManager->OnApplicationLimited();
-        float bandwidth = m_sentPacketManager->BandwidthEstimate().ToBitsPerSecond()*1.0;
-        float result = setTargetRate(bandwidth + 100*1000.0);
-        std::cout << "Increase data rate to " << result / 1000 << " Kbps" << std::endl;
     }
+    UpdateEncoderRate(!unlimited);
 
     if (!m_resend_alarm.IsSet())
     {
         SetRetransmissionAlarm();
     }
+}
+
 
-    if (stop_waiting_count_ > kStopWaitingThreshold)
+void UdpBbrSender::UpdateEncoderRate(bool app_limited)
+{
+    uint64_t now_ms = Simulator::Now().GetMilliSeconds();
+    const bbr::Bandwidth bandwidth = m_sentPacketManager->BandwidthEstimate();
+    const uint64_t queue_delay = m_video_codec.GetCurMaxPicQueueDelay(now_ms);
+    bbr::Bandwidth target = bbr::Bandwidth::Zero();
+    if (m_rateController.OnUpdate(now_ms, bandwidth, queue_delay, app_limited, &target))
     {
-        SendStopWaitingFrame();
-        stop_waiting_count_ = 0;
+        float result = setTargetRate(target.ToBitsPerSecond());
+        NS_LOG_INFO("AppId " << m_appId << " encoder rate " << target.ToKBitsPerSecond()
+                    << " Kbps, accepted " << result / 1000 << " Kbps");
     }
-}
 
+    // Layers are dropped at once, without waiting for the encoder to follow.
+    if (m_video_codec.GetNumLayers() > 1)
+    {
+        std::vector<bbr::Bandwidth> layer_rates;
+        m_video_codec.GetLayerRates(&layer_rates);
+        size_t active_layers = 0;
+        if (m_layerController.OnUpdate(now_ms, bandwidth, queue_delay, app_limited,
+                                       layer_rates, &active_layers))
+        {
+            m_video_codec.SetActiveLayers(active_layers);
+            NS_LOG_INFO("AppId " << m_appId << " sending " << active_layers << " of "
+                        << m_video_codec.GetNumLayers() << " layers");
+        }
+    }
+}
 
 void UdpBbrSender::SetRetransmissionAlarm()
 {
@@ -667,169 +957,174 @@ void UdpBbrSender::SetRetransmissionAlarm()
 
 void UdpBbrSender::OnRetransmissionTimeout()
 {
-    size_t n = m_sentPacketManager->GetConsecutiveRtoCount();
-    NS_ASSERT_MSG(n < 3, "consecutive retransmission timeouts: " << n);
+    // The probe timeout backs off on its own, so repeated timeouts are only
+    // worth a warning.
+    size_t n = m_sentPacketManager->GetConsecutivePtoCount();
+    if (n >= kMaxRetransmissions)
+    {
+        NS_LOG_WARN("consecutive probe timeouts: " << n);
+    }
 
     m_sentPacketManager->OnRetransmissionTimeout();
 
-    m_sentPacketManager->MaybeRetransmitTailLossProbe();
+    // A probe timeout prefers new data and falls back to the oldest packet
+    // in TryToSendData/OnTimer; only a tail loss probe retransmits here.
+    if (!m_sentPacketManager->UsePto())
+    {
+        m_sentPacketManager->MaybeRetransmitTailLossProbe();
+    }
 }
 
-bool UdpBbrSender::SendRetransmissions()
+bool UdpBbrSender::SendScheduledPackets()
 {
-    bool unlimited = true;
-    while (!m_sentPacketManager->TimeUntilSend(Simulator::Now().GetMilliSeconds()))
+    uint64_t now_ms = Simulator::Now().GetMilliSeconds();
+    // Never resend data the receiver can no longer play out, nor
+    // retransmissions too old to be worth delaying fresher data for.
+    uint64_t retransmission_deadline = m_scheduler.deadline(bbr::kPriorityRetransmission);
+    uint64_t max_frame_age = retransmission_deadline == 0 ? INFINITETIME : retransmission_deadline;
+    size_t expired = m_sentPacketManager->DiscardExpiredRetransmissions(now_ms, max_frame_age);
+    if (expired > 0)
     {
-        if (m_sentPacketManager->HasPendingRetransmissions())
+        NS_LOG_INFO("cancelled " << expired << " expired retransmissions");
+    }
+
+    while (!m_sentPacketManager->TimeUntilSend(now_ms))
+    {
+        while (!m_fecRepairs.empty() &&
+               ((m_fecRepairs.front().expire_time != 0 && m_fecRepairs.front().expire_time <= now_ms) ||
+                !m_scheduler.IsWithinDeadline(bbr::kPriorityFecRepair,
+                                              m_fecRepairs.front().header.PicGenTime, now_ms)))
         {
-            bbr::PacketHeader pending = m_sentPacketManager->NextPendingRetransmission();
-            pending.m_packet_seq = m_seqNumGen.NextSeq();
-            pending.m_sent_time = Simulator::Now().GetMilliSeconds();
-
-            std::cout<< "Retransmit PicIndex "<< pending.m_data_packet->PicIndex
-                     << " PicPktNum "<< pending.m_data_packet->PicPktNum
-                     << " PicCurPktSeq "<< pending.m_data_packet->PicCurPktSeq
-                     << " PicGenTime "<< pending.m_data_packet->PicGenTime
-                     << " PicSentTime "<< Simulator::Now().GetMilliSeconds()
-                     << " PicSize "<< pending.m_data_packet->PicDataLen
-                     << " AccessDelay "<< Simulator::Now().GetMilliSeconds() - pending.m_data_packet->PicGenTime
-                     << std::endl;
+            m_fecRepairs.pop_front();
+        }
+
+        bool backlogged[bbr::kNumSendPriorities] = {false};
+        backlogged[bbr::kPriorityRetransmission] = m_sentPacketManager->HasPendingRetransmissions();
+        backlogged[bbr::kPriorityFecRepair] = !m_fecRepairs.empty();
+        for (StreamSource *stream : m_streams)
+        {
+            bbr::ProtocolSendPriority fresh_priority;
+            if (stream->PeekNextPriority(&fresh_priority))
+            {
+                backlogged[fresh_priority] = true;
+            }
+        }
 
-            HandleSend(pending);
+        bbr::ProtocolSendPriority priority;
+        if (!m_scheduler.SelectNext(backlogged, &priority))
+        {
+            return false;
         }
-        else
+        ByteCount bytes = 0;
+        switch (priority)
         {
-            unlimited = false;
+        case bbr::kPriorityRetransmission:
+            // Frames expire while fresh data is sent, so check again before
+            // a stale retransmission goes out ahead of the current frame.
+            if (m_sentPacketManager->DiscardNextRetransmissionIfExpired(now_ms, max_frame_age))
+            {
+                NS_LOG_INFO("cancelled an expired retransmission");
+                continue;
+            }
+            bytes = SendRetransmission();
+            break;
+        case bbr::kPriorityFecRepair:
+            bytes = SendFecRepair();
+            break;
+        default:
+            bytes = SendNewData(priority);
             break;
         }
+        m_scheduler.OnPacketSent(priority, bytes);
     }
-    return unlimited;
+    return true;
 }
 
-bool UdpBbrSender::SendQueuedPackets()
+ByteCount UdpBbrSender::SendRetransmission()
 {
-    // First check if queued data has time out
-    uint64_t min_access_delay = m_video_codec.GetCurMaxPicQueueDelay(Simulator::Now().GetMilliSeconds());
-    min_access_delay = 0;
-    if(min_access_delay > 200){// Decrease codec output rate
-        // Get current bandwidth and set it to codec
-        float bandwidth = m_sentPacketManager->BandwidthEstimate().ToBitsPerSecond()*1.0;
-
-//        if(bandwidth > 800*1000.0 && bandwidth <= 1000*1000.0){
-//            bandwidth = 1000*1000.0;
-//        }else if(bandwidth > 1000*1000.0 && bandwidth <= 1200*1000.0){
-//            bandwidth = 1200*1000.0;
-//        }else{
-//            bandwidth = 1500*1000.0;
-//        }
-
-        // if(bandwidth > 600*1000.0 && bandwidth <= 700*1000.0){
-        //     bandwidth = 600*1000.0;
-        // }else if(bandwidth > 700*1000.0 && bandwidth <= 800*1000.0){
-        //     bandwidth = 700*1000.0;
-        // }else if(bandwidth > 800*1000.0 && bandwidth <= 1000*1000.0){
-        //     bandwidth = 800*1000.0;
-        // }else if(bandwidth > 1000*1000.0 && bandwidth <= 1200*1000.0){
-        //     bandwidth = 1000*1000.0;
-        // }else if(bandwidth > 1200*1000.0 && bandwidth <= 1500*1000.0){
-        //     bandwidth = 1200*1000.0;
-        // }else if(bandwidth > 1500*1000.0 && bandwidth <= 2000*1000.0){
-        //     bandwidth = 1500*1000.0;
-        // }else{
-        //     bandwidth = 2000*1000.0;
-        // }
-
-        // //bandwidth = 920*1000.0;
-        float result = setTargetRate(bandwidth - 100*1000.0);
-        // //float result = setTargetRate(bandwidth - 100000);
-        std::cout << "Decrease data rate to " << bandwidth / 1000 << " Kbps" << std::endl;
-    }
-
-    bool unlimited = true;
-    while(!m_sentPacketManager->TimeUntilSend(Simulator::Now().GetMilliSeconds()))
-    {
-        //std::shared_ptr<DataPacket> data_packet(new DataPacket());
-        std::shared_ptr<PicDataPacket> data_packet(new PicDataPacket());
-        //bool got = m_app.GetNextPacket(*data_packet);
-        bool update_data_rate = false;
-        //bool got = m_video_codec.GetNextPacket(*data_packet);
-        //if (got) // get real or fake data
-        if (true)
-        {
-            bbr::PacketHeader header;
-            header.m_packet_seq = m_seqNumGen.NextSeq();
-            header.m_old_packet_seq = 0;
-            header.m_transmission_type = bbr::NOT_RETRANSMISSION;
-            header.m_sent_time = Simulator::Now().GetMilliSeconds();
-            //header.m_data_length = data_packet->data_length;
-            header.m_data_length = DEFAULT_PAYLOAD_SIZE;
-            header.m_data_packet = data_packet;
-            //header.m_data_seq = data_packet->data_seq;
-            header.m_data_seq = header.m_packet_seq;
-
-
-            //header.PicType = data_packet->PicType;
-            header.PicType = pic_type_real;
-            //header.PicIndex = data_packet->PicIndex;
-            header.PicIndex = data_packet->PicIndex;
-            //header.PicDataLen = data_packet->PicDataLen;
-            header.PicPktNum = data_packet->PicPktNum;
-            header.PicCurPktSeq = data_packet->PicCurPktSeq;
-            //header.PicGenTime = data_packet->PicGenTime;
-            header.PicGenTime = Simulator::Now().GetMilliSeconds();
-            //
-            HandleSend(header);
-            ;
-        }
-        else
+    bbr::PacketHeader pending = m_sentPacketManager->NextPendingRetransmission();
+    pending.m_packet_seq = m_seqNumGen.NextSeq();
+    pending.m_sent_time = Simulator::Now().GetMilliSeconds();
+
+    std::cout<< "Retransmit PicIndex "<< pending.m_data_packet->PicIndex
+             << " PicPktNum "<< pending.m_data_packet->PicPktNum
+             << " PicCurPktSeq "<< pending.m_data_packet->PicCurPktSeq
+             << " PicGenTime "<< pending.m_data_packet->PicGenTime
+             << " PicSentTime "<< Simulator::Now().GetMilliSeconds()
+             << " PicSize "<< pending.m_data_packet->PicDataLen
+             << " AccessDelay "<< Simulator::Now().GetMilliSeconds() - pending.m_data_packet->PicGenTime
+             << std::endl;
+
+    HandleSend(pending);
+    return pending.m_data_length;
+}
+
+ByteCount UdpBbrSender::SendFecRepair()
+{
+    // Repair packets go right after the frame they protect.
+    bbr::FecRepairPacket repair = m_fecRepairs.front();
+    m_fecRepairs.pop_front();
+    repair.header.m_packet_seq = m_seqNumGen.NextSeq();
+    repair.header.m_sent_time = Simulator::Now().GetMilliSeconds();
+    HandleSend(repair.header, &repair.frame);
+    return repair.header.m_data_length;
+}
+
+ByteCount UdpBbrSender::SendNewData(bbr::ProtocolSendPriority priority)
+{
+    StreamSource *source = nullptr;
+    for (StreamSource *stream : m_streams)
+    {
+        bbr::ProtocolSendPriority next_priority;
+        if (stream->PeekNextPriority(&next_priority) && next_priority == priority)
         {
-            // std::cout << "Applimited !" << std::endl;
-            // if(!update_data_rate){
-            //     update_data_rate = true;
-
-            //     float bandwidth = m_sentPacketManager->BandwidthEstimate().ToBitsPerSecond()*1.0;
-            //     if(bandwidth<= 2000*1000.0){// less than max data rate
-            //         float result = setTargetRate(bandwidth);
-            //         std::cout << "Increase 2 data rate to " << bandwidth / 1000 << " Kbps" << std::endl;
-            //     }else{
-            //         return false;
-            //     }
-            // }
-            // m_video_codec.GetRedundantPacket(*data_packet);
-
-            unlimited = false;
+            source = stream;
             break;
         }
-
-        // bbr::PacketHeader header;
-        // header.m_packet_seq = m_seqNumGen.NextSeq();
-        // header.m_old_packet_seq = 0;
-        // header.m_transmission_type = bbr::NOT_RETRANSMISSION;
-        // header.m_sent_time = Simulator::Now().GetMilliSeconds();
-        // header.m_data_length = data_packet->data_length;
-        // //header.m_data_length = DEFAULT_PAYLOAD_SIZE;
-        // header.m_data_packet = data_packet;
-        // header.m_data_seq = data_packet->data_seq;
-
-        // header.PicType = data_packet->PicType;
-        // //header.PicType = pic_type_real;
-        // header.PicIndex = data_packet->PicIndex;
-        // header.PicDataLen = data_packet->PicDataLen;
-        // header.PicPktNum = data_packet->PicPktNum;
-        // header.PicCurPktSeq = data_packet->PicCurPktSeq;
-        // header.PicGenTime = data_packet->PicGenTime;
-        // //
-        // HandleSend(header);
-        //unlimited = false;
-        //break;
-    }
-
-    return unlimited;
+    }
+    NS_ASSERT(source != nullptr);
+    std::shared_ptr<PicDataPacket> data_packet(new PicDataPacket());
+    bool got = source->GetNextPacket(*data_packet);
+    NS_ASSERT(got);
+    data_packet->data_seq = m_dataSeqGen.NextSeq();
+
+    bbr::PacketHeader header;
+    header.m_packet_seq = m_seqNumGen.NextSeq();
+    header.m_old_packet_seq = 0;
+    header.m_transmission_type = bbr::NOT_RETRANSMISSION;
+    header.m_sent_time = Simulator::Now().GetMilliSeconds();
+    header.m_data_length = data_packet->data_length;
+    header.m_data_packet = data_packet;
+    header.m_data_seq = data_packet->data_seq;
+    header.m_stream_id = data_packet->stream_id;
+
+    header.PicType = data_packet->PicType;
+    header.PicIndex = data_packet->PicIndex;
+    header.PicDataLen = data_packet->PicDataLen;
+    header.PicPktNum = data_packet->PicPktNum;
+    header.PicCurPktSeq = data_packet->PicCurPktSeq;
+    header.PicGenTime = data_packet->PicGenTime;
+    //
+    HandleSend(header);
+    // Only the video is protected, the other streams' packets are too few
+    // per frame for repair packets to pay off.
+    if (header.m_stream_id == kVideoStreamId)
+    {
+        m_fecEncoder.OnSourcePacketSent(header, &m_fecRepairs);
+    }
+    return header.m_data_length;
 }
 
-void UdpBbrSender::HandleSend(PacketHeader &header)
+void UdpBbrSender::HandleSend(PacketHeader &header, const FecFrame *fec)
 {
+    header.m_connection_id = m_connectionId;
+    header.m_largest_acked = m_sentPacketManager->largest_packet_peer_knows_is_acked();
+    header.m_least_unexpired_pic = m_sentPacketManager->GetLeastUnexpiredPicIndex(header.m_stream_id);
     Ptr<Packet> packet = Create<Packet>(header.m_data_length);
+    if (fec)
+    {
+        packet->AddHeader(*fec);
+    }
     packet->AddHeader(header);
 
     //send
@@ -858,32 +1153,8 @@ void UdpBbrSender::HandleSend(PacketHeader &header)
                      << " PicSentTime "<< Simulator::Now().GetMilliSeconds()
                      << " PicSize "<< header.PicDataLen
                      << " AccessDelay "<< Simulator::Now().GetMilliSeconds() - header.m_data_packet->PicGenTime
+                     << " StreamId "<< header.m_stream_id
                      << std::endl;
-
-
-//            if(header.PicIndex >= m_sampleQueue.MaxPicIndexSent){// not used the retransmit time
-//                PicSentInfo newSample = PicSentInfo();
-//                newSample.PicIndex = header.PicIndex;
-//                newSample.PicDataLen = header.PicDataLen;
-//                newSample.PicAccessDelay = Simulator::Now().GetMilliSeconds() - header.m_data_packet->PicGenTime;
-//                newSample.PicAccessTime = Simulator::Now().GetMilliSeconds();
-//
-//                //
-//                m_sampleQueue.SampleQueue.push_back(newSample);
-//                m_sampleQueue.MaxPicIndexSent = header.PicIndex;
-//                m_sampleQueue.NewlyUpdateTime = Simulator::Now().GetMilliSeconds();
-//
-//                std::cout<< "SenderSide PicIndex "<< header.m_data_packet->PicIndex
-//                         << " PicPktNum "<< header.m_data_packet->PicPktNum
-//                         << " PicCurPktSeq "<< header.m_data_packet->PicCurPktSeq
-//                         << " PicGenTime "<< header.m_data_packet->PicGenTime
-//                         << " PicSentTime "<< Simulator::Now().GetMilliSeconds()
-//                         << " PicSize "<< header.PicDataLen
-//                         << " AccessDelay "<< Simulator::Now().GetMilliSeconds() - header.m_data_packet->PicGenTime
-//                         << std::endl;
-//
-//
-//            }
         }
 
         std::cout<<"SendData " << this
@@ -899,7 +1170,7 @@ void UdpBbrSender::HandleSend(PacketHeader &header)
                                 << " type "
                                 << int(header.m_transmission_type)
                                 << " gen time "
-                                << header.m_data_packet->PicGenTime
+                                << header.PicGenTime
                                 <<std::endl;
     }
     else
@@ -910,7 +1181,7 @@ void UdpBbrSender::HandleSend(PacketHeader &header)
                                                          header.m_old_packet_seq,
                                                          Simulator::Now().GetMilliSeconds(),
                                                          header.m_transmission_type,
-                                                         HAS_RETRANSMITTABLE_DATA);
+                                                         header.m_data_packet ? HAS_RETRANSMITTABLE_DATA : NO_RETRANSMITTABLE_DATA);
     if (reset_alarm || !m_resend_alarm.IsSet())
     {
         SetRetransmissionAlarm();
@@ -932,6 +1203,12 @@ void UdpBbrSender::HandleRead(Ptr<Socket> socket)
     while ((packet = socket->RecvFrom(m_from)))
     {
         int type = PeekPackeType(packet);
+        const bbr::ConnectionId connection_id = PeekConnectionId(packet);
+        if (connection_id != m_connectionId)
+        {
+            NS_LOG_WARN("packet of connection " << connection_id << " dropped");
+            continue;
+        }
         switch (type)
         {
         case kAckPacket:
@@ -943,44 +1220,62 @@ void UdpBbrSender::HandleRead(Ptr<Socket> socket)
             TryToSendData();
             break;
         }
+        case kNackPacket:
+        {
+            NackFrame nack_frame;
+            packet->RemoveHeader(nack_frame);
+            NS_LOG_INFO("Nack " << nack_frame);
+            m_sentPacketManager->OnIncomingNack(nack_frame, Simulator::Now().GetMilliSeconds());
+            SetRetransmissionAlarm();
+            TryToSendData();
+            break;
+        }
         default:
             NS_LOG_WARN("unsupported packet type: " << type);
         }
     }
 }
 
-void UdpBbrSender::SendStopWaitingFrame()
+void UdpBbrSender::MaybeSendAckFrequency(uint64_t now)
 {
-    StopWaitingFrame frame;
-    frame.least_unacked = m_sentPacketManager->GetLeastUnacked();
-    Ptr<Packet> packet = Create<Packet>();
-    packet->AddHeader(frame);
-
-    if ((m_socket->Send(packet)) >= 0)
+    if (!m_ackFrequencyEnabled)
     {
-        NS_LOG_INFO("send stop-waiting " << frame.least_unacked);
+        return;
     }
-    else
+    bbr::AckFrequencyFrame frame;
+    m_sentPacketManager->GetAckFrequency(&frame);
+    if (m_lastAckFrequencyTime != 0 && frame.SamePolicy(m_ackFrequency) &&
+        now < m_lastAckFrequencyTime + kAckFrequencyRefreshMs)
+    {
+        return;
+    }
+    frame.connection_id = m_connectionId;
+    frame.sequence_number = m_ackFrequency.sequence_number + 1;
+    Ptr<Packet> packet = Create<Packet>();
+    packet->AddHeader(frame);
+    if (m_socket->Send(packet) >= 0)
     {
-        NS_LOG_INFO("send stop-waiting error " << frame.least_unacked);
+        NS_LOG_INFO("Send AckFrequency " << frame.ack_eliciting_threshold
+                    << " max_ack_delay " << frame.max_ack_delay
+                    << " reordering " << frame.reordering_threshold);
+        m_ackFrequency = frame;
+        m_lastAckFrequencyTime = now;
     }
 }
 
+void UdpBbrSender::OnPicExpired(bbr::StreamId stream_id, PacketNumber pic_index, PacketCount packets, ByteCount bytes)
+{
+    m_sentPacketManager->RecordExpiredFrame(stream_id, pic_index, packets, bytes);
+}
+
 void UdpBbrSender::OnAckPacket(const AckFrame &ack_frame)
 {
     uint64_t now = Simulator::Now().GetMilliSeconds();
     m_sentPacketManager->OnIncomingAck(ack_frame, now);
+    m_fecEncoder.UpdateLossRate(stats_);
+    MaybeSendAckFrequency(now);
     SetRetransmissionAlarm();
 
-    if (!ack_frame.packets.Empty() && m_sentPacketManager->GetLeastUnacked() > ack_frame.packets.Min())
-    {
-        ++stop_waiting_count_;
-    }
-    else 
-    {
-        stop_waiting_count_ = 0;
-    }
-
     m_traceRtt = m_sentPacketManager->GetRttStats()->latest_rtt();
     m_bytesInFlight = m_sentPacketManager->GetBytesInFlight();
     m_bandwidth = m_sentPacketManager->BandwidthEstimate().ToBitsPerSecond();
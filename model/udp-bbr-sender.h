@@ -18,7 +18,15 @@
 #include "ns3/core-module.h"
 #include "connection-stats.h"
 #include "packet-header.h"
+#include "fec-codec.h"
+#include "ack-frequency-frame.h"
 #include "simple-alarm.h"
+#include "pic-queue.h"
+#include "encoder-rate-controller.h"
+#include "keyframe-shaper.h"
+#include "layer-controller.h"
+#include "send-scheduler.h"
+#include "stream-source.h"
 
 #include "ns3/socket.h"
 #include "bbr-common.h"
@@ -48,36 +56,49 @@ using namespace bbr;
 class UdpBbrSender;
 
 
-    class MyVideoCodec{
+    class MyVideoCodec : public StreamSource{
     public:
         MyVideoCodec();
-        void Setup(float fps, DataRate max_data_rate, DataRate min_data_rate, DataRate target_data_rate, DataRate step_data_rate,uint64_t timeout, UdpBbrSender* sender);
-        void StartApp();
-        void StopApp();
-        bool GetNextPacket(PicDataPacket &data);
+        void Setup(float fps, DataRate max_data_rate, DataRate min_data_rate, DataRate target_data_rate, DataRate step_data_rate, UdpBbrSender* sender);
+        virtual void StartApp();
+        virtual void StopApp();
 
         bool GetRedundantPacket(PicDataPacket &data); // for fake data
 
         void SetCodec(std::shared_ptr<VideoCodecs::Codec> codec);
         void SetCodecType(SyncodecType codecType);
+        // Replays the traces of |family| from now on.
+        void SetTraceFamily(TraceFamily family);
+        // Switches to a layered trace codec, all of whose layers are sent.
+        void SetLayeredCodec(size_t num_layers, VideoCodecs::LayeredTraceCodec::LayerMode mode);
+        // Imposes a GOP of |gop_size| frames with |b_frames| B-frames between
+        // anchors on the clip codec, see SYNCODEC_TYPE_GOP.  A GOP size of 0
+        // keeps the frame types of the clip.
+        void SetGopStructure(size_t gop_size, size_t b_frames);
+
+        size_t GetNumLayers() const;
+        // Sets |rates| to the rates of layers 0..i together, for each layer i.
+        void GetLayerRates(std::vector<bbr::Bandwidth> *rates) const;
+        // Sends the lowest |active_layers| layers only, from the queued pics on.
+        void SetActiveLayers(size_t active_layers);
+        void SetKeyFrameShaping(bbr::KeyFrameShaping shaping, uint32_t spread_frames);
+
+        // Frames of the replayed traces, 0 if the codec replays none.
+        size_t GetNumTraceFrames() const;
+        // Continues the replayed traces from frame |frame_idx|.
+        void SetStartFrame(size_t frame_idx);
 
         float setTargetRate(float newRateBps);
-        uint64_t GetCurMaxPicQueueDelay(uint64_t now);
 
     private:
         void SendPacket();
         void HandleTimeout();
         void EnqueuePic();
 
-        std::vector<PicData> m_PicDataBuf;
-        std::vector<PicData> m_PicSendingDataBuf;
-        std::vector<PicData> m_PicACKedDataBuf;
         uint32_t m_NewestPicIndex;
         uint32_t m_SendingPicIndex;
         uint32_t m_NewestSentPicIndex;
 
-        std::vector<PicData> m_DroppedPicDataBuf; // Dropped pic data because of sending timeout
-        uint64_t m_TimeoutTime;                   // Timeout time for each pic ms
 
         DataRate m_dataRate;
         DataRate m_minDataRate;
@@ -92,19 +113,21 @@ class UdpBbrSender;
 
         /*--------------------------------------------------*/
         uint32_t m_pkt_gened;                       // total pkt gene
-        uint32_t m_pic_seq;                         // increased pic seq
 
+        std::string m_traceDir;                     // Traces replayed by trace codecs
+        std::string m_traceFilePrefix;
         std::shared_ptr<VideoCodecs::Codec> m_codec;//add
+        VideoCodecs::LayeredTraceCodec* m_layeredCodec; // m_codec if layered, else null
+        VideoCodecs::GopCodec* m_gopCodec;          // m_codec if it replays a clip, else null
+        uint8_t m_activeLayers;                     // Layers sent of each pic
+        bbr::KeyFrameShaper m_keyFrameShaper;       // Tells and reshapes keyframes
         EventId m_enqueueEvent;                     //add
         EventId m_sendOversleepEvent;               //add
 
-        UdpBbrSender* m_sender;                     //add
-        
 
         double m_rVin;                              //bps//add
         double m_rSend;                             //bps//add
         std::deque<Ptr<Packet>> m_PktBuf;           //add
-        std::deque<uint32_t> m_rateShapingBuf;      //add
         uint32_t m_rateShapingBytes;                //add
         uint64_t m_nextSendTstmp;                   //add
     };
@@ -114,53 +137,6 @@ class UdpBbrSender : public Application
 {
   public:
 
-    struct PicSentInfo
-    {
-        PicSentInfo() : PicIndex(0),PicDataLen(0),PicAccessTime(0),PicAccessDelay(0)
-        {
-        }
-        ~PicSentInfo() {}
-
-        PacketNumber PicIndex;           // Global frame index for this picture
-        uint16_t     PicDataLen;         // Frame Data len
-        uint64_t     PicAccessTime;      // Current pkt first sent time
-        uint64_t     PicAccessDelay;     // Current pkt first sent time
-    };
-    struct PicSentInfoSampleQueue
-    {
-        PicSentInfoSampleQueue() : MaxPicIndexSent(0),NewlyUpdateTime(0)
-        {
-        }
-        ~PicSentInfoSampleQueue() {}
-
-        PacketNumber MaxPicIndexSent;
-        uint64_t     NewlyUpdateTime;
-        std::deque<PicSentInfo> SampleQueue;
-    };
-
-    struct VideoStreamAccessDelayStatus{
-        VideoStreamAccessDelayStatus()
-                :InitProcessTime(0),LatestProcessTime(0),
-                 InitProcessAccessDelay(0),LatestProcessAccessDelay(0),
-                 MaxAcceleration(0.0),MinAcceleration(0.0),
-                 MaxAccelerationContinueUpdateCount(0),
-                 MinAccelerationContinueUpdateCount(0),
-                 IsValid(false)
-        {
-        }
-        ~VideoStreamAccessDelayStatus(){}
-
-        uint64_t InitProcessTime;
-        uint64_t InitProcessAccessDelay;
-        uint64_t LatestProcessTime;
-        uint64_t LatestProcessAccessDelay;
-        float MaxAcceleration;
-        float MinAcceleration;
-        uint16_t MaxAccelerationContinueUpdateCount; //
-        uint16_t MinAccelerationContinueUpdateCount; //
-        bool IsValid;
-    };
-
     static TypeId GetTypeId(void);
 
     UdpBbrSender();
@@ -175,10 +151,24 @@ class UdpBbrSender : public Application
 
     void TryToSendData();
 
-    void OnTimerUpdateStreamStatus();
-
     float setTargetRate(float newRateBps);
 
+    // Age of a frame after which packets of |priority| are no longer sent,
+    // zero for none.
+    uint64_t GetSendDeadline(bbr::ProtocolSendPriority priority) const;
+
+    // Called by a stream when its pic |pic_index| expires with |packets|
+    // packets and |bytes| bytes of it still queued.
+    void OnPicExpired(bbr::StreamId stream_id, PacketNumber pic_index, PacketCount packets, ByteCount bytes);
+
+    // Called by the video stream when its first frame, of |packets|
+    // packets, is queued.
+    void OnFirstFrameQueued(PacketCount packets);
+
+    // Assigns a fixed random variable stream number to the random variables
+    // used by this sender, and returns the number of streams assigned.
+    int64_t AssignStreams(int64_t stream);
+
   protected:
     virtual void DoDispose(void);
 
@@ -195,14 +185,21 @@ class UdpBbrSender : public Application
   // remaining unacked packets.
   void OnRetransmissionTimeout();
 
-  // send any retransmissions, return true if not data-limited
-  bool SendRetransmissions();
-  // send any queued packets, return true if not data-limited
-  bool SendQueuedPackets();
+  // Feeds the bandwidth estimate and the frame queue delay to the encoder
+  // rate controller, and retunes the codec if the target changed.
+  void UpdateEncoderRate(bool app_limited);
+
+  // Sends packets, each of the class picked by the send scheduler, while
+  // the pacing sender allows.  Returns true if not data-limited.
+  bool SendScheduledPackets();
+  // Each sends one packet of its class and returns its length.
+  ByteCount SendRetransmission();
+  ByteCount SendFecRepair();
+  // Sends from the first stream whose next packet is of |priority|.
+  ByteCount SendNewData(bbr::ProtocolSendPriority priority);
   // 
-  void HandleSend(PacketHeader &header);
+  void HandleSend(PacketHeader &header, const FecFrame *fec = nullptr);
 
-  void SendStopWaitingFrame();
 
   void ConnectionSucceeded(Ptr<Socket> socket); // Called when the connections has succeeded
   void ConnectionFailed(Ptr<Socket> socket); // Called when the connection has failed.
@@ -214,27 +211,44 @@ class UdpBbrSender : public Application
     void HandleRead(Ptr<Socket> socket);
 
     void OnAckPacket(const AckFrame &ack_frame);
+    // Sends the ack policy for the current window and RTT if it changed, or
+    // if the last request is old enough to have been lost.
+    void MaybeSendAckFrequency(uint64_t now);
 
   private:
     Ptr<Socket> m_socket;  //!< Socket
     Address m_from;
     Address m_peerAddress; //!< Remote peer address
     uint16_t m_peerPort;   //!< Remote peer port
+    bbr::ConnectionId m_connectionId; //!< Connection ID carried by every packet
     bool m_pending;
     Timer m_timer; //10ms
-    Timer m_timer_updateStreamStatus; //1000ms
 
     bbr::SimpleAlarm m_resend_alarm;
     bbr::SentPacketManager *m_sentPacketManager;
     bbr::SequenceNumberGenerator m_seqNumGen;
+    bbr::SequenceNumberGenerator m_dataSeqGen; // data_seq of new packets, over all streams
     bbr::ConnectionStats stats_;
-    size_t stop_waiting_count_;
 
     uint32_t m_size;  //!< Size of the sent packet (including the Header)
     uint32_t m_sent;  //!< Counter for sent packets
     Time m_startTime; //!<
     Time m_duration;  //!< Udp packet sending duration
     DataRate m_dataRate; //!< sending data rate;
+    bool m_controllerSwitching; //!< switch congestion controller by path class
+    bool m_bandwidthResumption; //!< seed a switched-to controller with the path model
+    FecScheme m_fecScheme; //!< FEC scheme protecting each frame
+
+    bbr::FecEncoder m_fecEncoder;
+    std::deque<bbr::FecRepairPacket> m_fecRepairs; // Repair packets waiting to be sent.
+
+    bool m_ackFrequencyEnabled; //!< request the receiver's ack policy
+    bbr::AckFrequencyFrame m_ackFrequency; // Last ack policy sent.
+    uint64_t m_lastAckFrequencyTime;
+
+    bool m_keyFrameStartupBurst; //!< send the first frame unpaced
+    bbr::KeyFrameShaping m_keyFrameShaping; //!< how later keyframes are shaped
+    uint32_t m_keyFrameSpreadFrames; //!< frames a shaped keyframe is spread over
 
     //Trace
     TracedValue<uint32_t> m_traceRtt;
@@ -242,14 +256,47 @@ class UdpBbrSender : public Application
     TracedValue<uint32_t> m_bandwidth;
 
     MyVideoCodec m_video_codec;
+    AudioSource m_audioSource;
+    BulkDataSource m_dataSource;
+    std::vector<StreamSource *> m_streams; // Open streams, the video first
+    bool m_audioEnabled; //!< send an audio stream along with the video
+    DataRate m_audioRate; //!< bitrate of the audio stream
+    uint64_t m_audioFrameInterval; //!< ms between audio frames
+    bbr::StreamReliability m_audioReliability; //!< how lost audio packets are handled
+    uint64_t m_dataStreamBytes; //!< size of the bulk data stream, 0 for none
+    bbr::EncoderRateController m_rateController;
+    bbr::SendScheduler m_scheduler;
+    bbr::LayerController m_layerController;
+    uint32_t m_videoLayers; //!< layers of each frame
+    VideoCodecs::LayeredTraceCodec::LayerMode m_layerMode; //!< SVC or simulcast layers
+    TraceFamily m_traceFamily; //!< video traces replayed
+    bool m_randomTraceStart; //!< start the traces at a random frame
+    Ptr<UniformRandomVariable> m_traceStartRng; // Picks the first frame of the traces
+    SyncodecType m_codecType; //!< trace or GOP-structured clip codec
+    uint32_t m_gopSize; //!< frames between keyframes of the clip codec, 0 for the clip's
+    uint32_t m_gopBFrames; //!< B-frames between anchors of the clip codec
+    bbr::SchedulingMode m_schedulingMode; //!< strict or weighted priority scheduling
+    uint64_t m_audioDeadline; //!< ms, per packet class
+    uint64_t m_keyFrameDeadline;
+    uint64_t m_retransmissionDeadline;
+    uint64_t m_fecRepairDeadline;
+    uint64_t m_freshDataDeadline;
+    uint64_t m_bulkDataDeadline;
+    uint32_t m_audioWeight; //!< weighted scheduling share, per packet class
+    uint32_t m_keyFrameWeight;
+    uint32_t m_retransmissionWeight;
+    uint32_t m_fecRepairWeight;
+    uint32_t m_freshDataWeight;
+    uint32_t m_bulkDataWeight;
+    DataRate m_minEncoderRate; //!< lowest encoder target rate
+    DataRate m_maxEncoderRate; //!< highest encoder target rate
+    double m_encoderHeadroom; //!< fraction of the bandwidth left unused by the encoder
+    uint64_t m_encoderTargetQueueDelay; //!< frame queue delay (ms) lowering the encoder rate
+    uint32_t m_encoderIncreasesPerSecond; //!< encoder rate increases allowed per second
     //static
     uint64_t m_total_bytes_sent;
     uint64_t m_total_pkts_sent;
 
-    // for advance control
-    PicSentInfoSampleQueue          m_sampleQueue;
-    VideoStreamAccessDelayStatus    m_streamStatus;
-
     uint32_t m_appId;
 };
 }
@@ -0,0 +1,64 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2008 INRIA
+ *
+ * Author: daibo <daibo@yy.com>
+ */
+#include "ns3/core-module.h"
+
+#include "varint.h"
+
+namespace ns3
+{
+namespace bbr
+{
+uint32_t GetVarIntLength(uint64_t value)
+{
+    NS_ASSERT_MSG(value <= kVarIntMax, "varint overflow " << value);
+    if (value < (UINT64_C(1) << 6))
+    {
+        return 1;
+    }
+    if (value < (UINT64_C(1) << 14))
+    {
+        return 2;
+    }
+    if (value < (UINT64_C(1) << 30))
+    {
+        return 4;
+    }
+    return 8;
+}
+
+void WriteVarInt(Buffer::Iterator &i, uint64_t value)
+{
+    switch (GetVarIntLength(value))
+    {
+    case 1:
+        i.WriteU8(value);
+        break;
+    case 2:
+        i.WriteHtonU16(0x4000 | value);
+        break;
+    case 4:
+        i.WriteHtonU32(0x80000000 | value);
+        break;
+    default:
+        i.WriteHtonU64(UINT64_C(0xC000000000000000) | value);
+        break;
+    }
+}
+
+uint64_t ReadVarInt(Buffer::Iterator &i)
+{
+    const uint8_t first = i.ReadU8();
+    const uint32_t length = 1u << (first >> 6);
+    uint64_t value = first & 0x3F;
+    for (uint32_t k = 1; k < length; ++k)
+    {
+        value = (value << 8) | i.ReadU8();
+    }
+    return value;
+}
+}
+}
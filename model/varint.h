@@ -0,0 +1,32 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2008 INRIA
+ *
+ * Author: daibo <daibo@yy.com>
+ */
+#ifndef VARINT_H
+#define VARINT_H
+
+#include <stdint.h>
+
+#include "ns3/buffer.h"
+
+namespace ns3
+{
+namespace bbr
+{
+// QUIC variable-length integers (RFC 9000, section 16).  The two most
+// significant bits of the first byte give the length of the encoding, 1, 2,
+// 4 or 8 bytes, leaving 6, 14, 30 or 62 bits for the value.
+const uint64_t kVarIntMax = (UINT64_C(1) << 62) - 1;
+
+// Number of bytes |value| is encoded in.
+uint32_t GetVarIntLength(uint64_t value);
+
+void WriteVarInt(Buffer::Iterator &i, uint64_t value);
+
+uint64_t ReadVarInt(Buffer::Iterator &i);
+}
+}
+
+#endif
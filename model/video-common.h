@@ -16,8 +16,11 @@
 
 using namespace ns3::bbr;
 
-#define TRACES_DIR_PATH "/home/shilei/software/ns3/src/bbr/model/videocodecs/video_traces/chat_firefox_h264/"
+// Relative to the ns-3 top directory, see VideoCodecs::TraceStore::findTraceDir.
+#define TRACES_SUB_DIR "src/bbr/model/videocodecs/video_traces/chat_firefox_h264"
 #define TRACES_FILE_PREFIX "chat"
+// Further trace families, each in a subdirectory.
+#define TRACES_OTHER_SUB_DIR "src/bbr/model/videocodecs/video_traces/other"
 
 namespace ns3
 {
@@ -29,6 +32,18 @@ enum FrameType
     BFrame,
 };
 
+// Video traces a sender replays, see UdpBbrSender's TraceFamily attribute.
+enum TraceFamily
+{
+    kTraceChat = 0,
+    kTraceBigBuckBunny,
+    kTraceElephantsDream,
+    kTraceForeman,
+    kTraceNews,
+    kTraceSuzie,
+    kTraceConcat,
+};
+
 struct FrameInfo
 {
     int m_type;
@@ -37,6 +52,23 @@ struct FrameInfo
     FrameInfo() = default;
 };
 
+// A video clip encoded with a fixed GOP structure, see model/clips.
+struct VideoClipInfo
+{
+    int m_width;
+    int m_height;
+    int m_frame_rate;
+    int m_gop_size;
+    int m_code_rate;                        // kbps
+    std::vector<FrameInfo> m_frame_array;   // m_type is a FrameType
+};
+
+// The clips compiled into the simulator.
+extern std::vector<VideoClipInfo *> g_video_clips;
+
+// How much |right| differs from |left|, the larger the more.
+uint32_t VideoClipDiff(VideoClipInfo &left, VideoClipInfo &right);
+
 struct PESInfo
 {
     PacketNumber m_pes_seq;
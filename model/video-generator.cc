@@ -5,6 +5,8 @@
  * Author: daibo <daibo@yy.com>
  */
 
+#include <sstream>
+
 #include "video-generator.h"
 
 namespace ns3
@@ -70,6 +72,47 @@ VideoGenerator::GetBestClip(int width, int height,
     return g_video_clips[best];
 }
 
+std::shared_ptr<const VideoCodecs::TraceStore>
+VideoGenerator::GetClipStore(const VideoClipInfo &clip)
+{
+    std::ostringstream name;
+    name << "clip_" << clip.m_width << "x" << clip.m_height << "_" << clip.m_frame_rate << "fps_"
+         << clip.m_gop_size << "_" << clip.m_code_rate << "kbps";
+
+    // The store knows resolutions by label, which go by the frame height.
+    const VideoCodecs::TraceStore::Labels2Res &labels = VideoCodecs::TraceStore::labels2Res();
+    size_t res = 0;
+    while (res + 1 < labels.size() && static_cast<int>(labels[res].second.second) < clip.m_height)
+    {
+        res++;
+    }
+
+    std::vector<uint32_t> sizes;
+    std::vector<char> types;
+    for (const FrameInfo &frame : clip.m_frame_array)
+    {
+        sizes.push_back(frame.m_size);
+        switch (frame.m_type)
+        {
+        case IFrame:
+            types.push_back('I');
+            break;
+        case PFrame:
+            types.push_back('P');
+            break;
+        case BFrame:
+            types.push_back('B');
+            break;
+        default:
+            types.push_back('U');
+            break;
+        }
+    }
+    return VideoCodecs::TraceStore::get(name.str(), labels[res].first,
+                                        clip.m_code_rate * 1000UL, sizes, types,
+                                        clip.m_frame_rate);
+}
+
 void VideoGenerator::Start()
 {
     if (m_state)
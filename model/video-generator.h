@@ -8,8 +8,10 @@
 #define VIDEO_GENERATOR_H
 
 #include <deque>
+#include <memory>
 
 #include "ns3/core-module.h"
+#include "ns3/video-codecs.h"
 #include "video-common.h"
 
 namespace ns3
@@ -22,6 +24,9 @@ class VideoGenerator
 
     static VideoClipInfo *GetBestClip(int width, int height,
                                        int frame_rate, int gop_size, int code_rate);
+    // Frame sizes and types of |clip| in the trace store the codecs share,
+    // see VideoCodecs::GopCodec.
+    static std::shared_ptr<const VideoCodecs::TraceStore> GetClipStore(const VideoClipInfo &clip);
 
     void Start();
     void Stop();
@@ -31,7 +31,11 @@
 #include <cmath>
 #include <cassert>
 #include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
+#include <unistd.h>
 
 #define INITIAL_RATE 100.  // Initial (very low) target rate set by default in codecs, in bps
 #define EPSILON 1e-10  // Used to check floats/doubles for zero
@@ -177,7 +181,317 @@ void SimpleFpsBasedCodec::nextPacketOrFrame() {
 
 
 
-TraceBasedCodec::Labels2Res TraceBasedCodec::m_labels2Res;
+TraceStore::Registry& TraceStore::registry() {
+    static Registry registry;
+    return registry;
+}
+
+std::shared_ptr<const TraceStore> TraceStore::get(const std::string& path,
+                                                  const std::string& filePrefix) {
+    const Registry::key_type key(path, filePrefix);
+    std::shared_ptr<const TraceStore> store = registry()[key].lock();
+    if (!store) {
+        store.reset(new TraceStore(path, filePrefix));
+        registry()[key] = store;
+    }
+    return store;
+}
+
+std::string TraceStore::findTraceDir(const std::string& subDir) {
+    const char* envDir = std::getenv("BBR_TRACES_DIR");
+    if (envDir != NULL && *envDir != '\0') {
+        return envDir;
+    }
+    static const char* const candidatePaths[] = { ".", "..", "../.." };
+    for (size_t i = 0; i < sizeof(candidatePaths) / sizeof(candidatePaths[0]); ++i) {
+        const std::string dir = std::string(candidatePaths[i]) + "/" + subDir;
+        struct stat buffer;
+        if (::stat(dir.c_str(), &buffer) == 0 && S_ISDIR(buffer.st_mode)) {
+            return dir;
+        }
+    }
+    return std::string();
+}
+
+const TraceStore::Labels2Res& TraceStore::labels2Res() {
+    static Labels2Res labels2Res;
+    if (labels2Res.empty()) {
+        // All resolutions have 16:9 aspect ratio
+        labels2Res.push_back(std::make_pair("90p", std::make_pair(160, 90)));
+        labels2Res.push_back(std::make_pair("180p", std::make_pair(320, 180)));
+        labels2Res.push_back(std::make_pair("240p", std::make_pair(426, 240)));
+        labels2Res.push_back(std::make_pair("360p", std::make_pair(640, 360)));
+        labels2Res.push_back(std::make_pair("540p", std::make_pair(960, 540)));
+        labels2Res.push_back(std::make_pair("720p", std::make_pair(1280, 720)));
+        labels2Res.push_back(std::make_pair("1080p", std::make_pair(1920, 1080)));
+    }
+    return labels2Res;
+}
+
+namespace {
+
+/** Header of a binary trace file. */
+struct BinaryTraceHeader {
+    char magic[8];
+    uint32_t byteOrder; /**< BINARY_TRACE_BYTE_ORDER, as written by the host. */
+    uint32_t numTraces;
+};
+
+/** Index entry of one video trace in a binary trace file. Offsets are from the file start. */
+struct BinaryTraceEntry {
+    uint32_t resolution; /**< index in #TraceStore::labels2Res. */
+    uint32_t numFrames;
+    uint64_t bitrate;    /**< bps */
+    uint64_t sizesOffset;      /**< uint32_t frame sizes (bytes) */
+    uint64_t timestampsOffset; /**< float frame timestamps (secs) */
+    uint64_t typesOffset;      /**< char frame types */
+};
+
+const char BINARY_TRACE_MAGIC[8] = { 'S', 'Y', 'N', 'T', 'R', 'C', '0', '1' };
+const uint32_t BINARY_TRACE_BYTE_ORDER = 0x01020304;
+
+/** One video trace, before it is written to an image. */
+struct ImageTrace {
+    BinaryTraceEntry entry;
+    std::vector<uint32_t> sizes;
+    std::vector<float> timestamps;
+    std::vector<char> types;
+};
+
+/** Write @p traces as an image in the binary trace format. */
+void writeImage(std::vector<ImageTrace>& traces, std::vector<char>& image) {
+    // Sizes and timestamps are 4-byte aligned, as the header and the index are.
+    uint64_t offset = sizeof(BinaryTraceHeader) + traces.size() * sizeof(BinaryTraceEntry);
+    for (size_t i = 0; i < traces.size(); ++i) {
+        traces[i].entry.sizesOffset = offset;
+        offset += traces[i].sizes.size() * sizeof(uint32_t);
+    }
+    for (size_t i = 0; i < traces.size(); ++i) {
+        traces[i].entry.timestampsOffset = offset;
+        offset += traces[i].timestamps.size() * sizeof(float);
+    }
+    for (size_t i = 0; i < traces.size(); ++i) {
+        traces[i].entry.typesOffset = offset;
+        offset += traces[i].types.size();
+    }
+
+    image.assign(offset, 0);
+    BinaryTraceHeader header;
+    std::memcpy(header.magic, BINARY_TRACE_MAGIC, sizeof(header.magic));
+    header.byteOrder = BINARY_TRACE_BYTE_ORDER;
+    header.numTraces = traces.size();
+    std::memcpy(&image[0], &header, sizeof(header));
+    for (size_t i = 0; i < traces.size(); ++i) {
+        const ImageTrace& trace = traces[i];
+        std::memcpy(&image[sizeof(header) + i * sizeof(BinaryTraceEntry)],
+                    &trace.entry, sizeof(trace.entry));
+        if (trace.entry.numFrames == 0) {
+            continue;
+        }
+        std::memcpy(&image[trace.entry.sizesOffset], trace.sizes.data(),
+                    trace.sizes.size() * sizeof(uint32_t));
+        std::memcpy(&image[trace.entry.timestampsOffset], trace.timestamps.data(),
+                    trace.timestamps.size() * sizeof(float));
+        std::memcpy(&image[trace.entry.typesOffset], trace.types.data(), trace.types.size());
+    }
+}
+
+}
+
+std::shared_ptr<const TraceStore> TraceStore::get(const std::string& name,
+                                                  const ResLabel& resolution,
+                                                  Bitrate bitrate,
+                                                  const std::vector<uint32_t>& sizes,
+                                                  const std::vector<char>& types,
+                                                  double fps) {
+    // No directory is named after an empty path, so tables never share a trace directory's store.
+    const Registry::key_type key(std::string(), name);
+    std::shared_ptr<const TraceStore> store = registry()[key].lock();
+    if (store) {
+        return store;
+    }
+
+    const Labels2Res& labels = labels2Res();
+    size_t res = 0;
+    while (res < labels.size() && labels[res].first != resolution) {
+        ++res;
+    }
+    assert(res < labels.size());
+    assert(sizes.size() == types.size() && fps > 0.);
+    std::vector<ImageTrace> traces(1);
+    ImageTrace& trace = traces.back();
+    trace.sizes = sizes;
+    trace.types = types;
+    for (size_t i = 0; i < sizes.size(); ++i) {
+        trace.timestamps.push_back(float(i / fps));
+    }
+    trace.entry.resolution = res;
+    trace.entry.numFrames = sizes.size();
+    trace.entry.bitrate = bitrate;
+
+    TraceStore* tables = new TraceStore();
+    store.reset(tables);
+    writeImage(traces, tables->m_parsedImage);
+    tables->m_image = tables->m_parsedImage.data();
+    tables->m_imageSize = tables->m_parsedImage.size();
+    const bool loaded = tables->loadIndex();
+    assert(loaded);
+    (void) loaded;
+    registry()[key] = store;
+    return store;
+}
+
+TraceStore::TraceStore() :
+    m_image(NULL), m_imageSize(0), m_mapped(false) {}
+
+TraceStore::TraceStore(const std::string& path, const std::string& filePrefix) :
+    m_image(NULL), m_imageSize(0), m_mapped(false) {
+    const std::string binaryFile = path + "/" + filePrefix + BINARY_TRACE_SUFFIX;
+    if (!mapImage(binaryFile) || !loadIndex()) {
+        if (m_mapped) {
+            std::cerr << "Ignoring invalid binary trace file " << binaryFile << std::endl;
+            ::munmap(const_cast<char*>(m_image), m_imageSize);
+            m_mapped = false;
+            m_traceData.clear();
+            m_resolutions.clear();
+        }
+        const bool built = buildImage(path, filePrefix, m_parsedImage);
+        assert(built); //TODO: Turn this into meaningful error
+        (void) built;
+        m_image = m_parsedImage.data();
+        m_imageSize = m_parsedImage.size();
+        const bool loaded = loadIndex();
+        assert(loaded);
+        (void) loaded;
+    }
+    assert(!m_resolutions.empty());
+}
+
+TraceStore::~TraceStore() {
+    if (m_mapped) {
+        ::munmap(const_cast<char*>(m_image), m_imageSize);
+    }
+}
+
+bool TraceStore::compile(const std::string& path,
+                         const std::string& filePrefix,
+                         const std::string& outFile) {
+    std::vector<char> image;
+    if (!buildImage(path, filePrefix, image)) {
+        return false;
+    }
+    std::ofstream fout(outFile.c_str(), std::ios::binary | std::ios::trunc);
+    fout.write(image.data(), image.size());
+    return bool(fout);
+}
+
+bool TraceStore::buildImage(const std::string& path,
+                            const std::string& filePrefix,
+                            std::vector<char>& image) {
+    std::vector<ImageTrace> traces;
+    const Labels2Res& labels = labels2Res();
+    for (size_t res = 0; res < labels.size(); ++res) {
+        for (Bitrate bitrate = TRACE_MIN_BITRATE;
+             bitrate < TRACE_MAX_BITRATE;
+             bitrate += TRACE_BITRATE_STEP) {
+            std::ostringstream fullName;
+            fullName << path << "/" << filePrefix << "_" << labels[res].first << "_" << bitrate << ".txt";
+            std::ifstream fin(fullName.str().c_str());
+            if (!fin) {
+                continue;
+            }
+            traces.push_back(ImageTrace());
+            ImageTrace& trace = traces.back();
+            for (FrameDataIterator it(fin); it; ++it) {
+                const FrameDataIterator::value_type r = *it;
+                trace.sizes.push_back(r.m_size);
+                trace.timestamps.push_back(r.m_ts);
+                trace.types.push_back(r.m_frameType);
+            }
+            trace.entry.resolution = res;
+            trace.entry.numFrames = trace.sizes.size();
+            //* 1000: from kbps to bps
+            trace.entry.bitrate = bitrate * 1000;
+        }
+    }
+    if (traces.empty()) {
+        return false;
+    }
+
+    writeImage(traces, image);
+    return true;
+}
+
+bool TraceStore::mapImage(const std::string& filename) {
+    const int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat buffer;
+    if (::fstat(fd, &buffer) != 0 || buffer.st_size < off_t(sizeof(BinaryTraceHeader))) {
+        ::close(fd);
+        return false;
+    }
+    void* addr = ::mmap(NULL, buffer.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (addr == MAP_FAILED) {
+        return false;
+    }
+    m_image = static_cast<const char*>(addr);
+    m_imageSize = buffer.st_size;
+    m_mapped = true;
+    return true;
+}
+
+bool TraceStore::loadIndex() {
+    if (m_imageSize < sizeof(BinaryTraceHeader)) {
+        return false;
+    }
+    const BinaryTraceHeader* header = reinterpret_cast<const BinaryTraceHeader*>(m_image);
+    if (std::memcmp(header->magic, BINARY_TRACE_MAGIC, sizeof(header->magic)) != 0 ||
+        header->byteOrder != BINARY_TRACE_BYTE_ORDER ||
+        (m_imageSize - sizeof(BinaryTraceHeader)) / sizeof(BinaryTraceEntry) < header->numTraces) {
+        return false;
+    }
+    const BinaryTraceEntry* entries =
+        reinterpret_cast<const BinaryTraceEntry*>(m_image + sizeof(BinaryTraceHeader));
+    const Labels2Res& labels = labels2Res();
+    std::vector<bool> resolutionPresent(labels.size(), false);
+    for (uint32_t i = 0; i < header->numTraces; ++i) {
+        const BinaryTraceEntry& e = entries[i];
+        if (e.resolution >= labels.size() ||
+            e.sizesOffset % sizeof(uint32_t) != 0 ||
+            e.timestampsOffset % sizeof(float) != 0 ||
+            e.sizesOffset + uint64_t(e.numFrames) * sizeof(uint32_t) > m_imageSize ||
+            e.timestampsOffset + uint64_t(e.numFrames) * sizeof(float) > m_imageSize ||
+            e.typesOffset + e.numFrames > m_imageSize) {
+            return false;
+        }
+        const FrameSequence seq(reinterpret_cast<const uint32_t*>(m_image + e.sizesOffset),
+                                reinterpret_cast<const float*>(m_image + e.timestampsOffset),
+                                m_image + e.typesOffset,
+                                e.numFrames);
+        m_traceData[labels[e.resolution].first].insert(std::make_pair(Bitrate(e.bitrate), seq));
+        resolutionPresent[e.resolution] = true;
+    }
+    for (size_t res = 0; res < labels.size(); ++res) {
+        if (resolutionPresent[res]) {
+            m_resolutions.push_back(labels[res].first);
+        }
+    }
+    return !m_resolutions.empty();
+}
+
+const TraceStore::BitrateMap& TraceStore::bitrates(const ResLabel& resolution) const {
+    return m_traceData.at(resolution);
+}
+
+bool TraceStore::hasResolution(const ResLabel& resolution) const {
+    return m_traceData.find(resolution) != m_traceData.end();
+}
+
+
+
 const float TraceBasedCodec::m_lowBppThresh = .091;
 const float TraceBasedCodec::m_highBppThresh = .175;
 
@@ -186,25 +500,15 @@ TraceBasedCodec::TraceBasedCodec(const std::string& path,
                                  const std::string& filePrefix,
                                  double fps,
                                  bool fixed) :
-    CodecWithFps(fps, NULL, NULL), m_fixedModeEnabled(fixed), m_currentFrameIdx(0) {
-    static class FillResolutions_ {
-        void addLabelAndResolution(const ResLabel& label, const Resolution reso) {
-            m_labels2Res.push_back(std::make_pair(label, reso));
-        }
-    public:
-        FillResolutions_() {
-            assert(m_labels2Res.empty());
-            // All resolutions have 16:9 aspect ratio
-            addLabelAndResolution("90p", std::make_pair(160, 90));
-            addLabelAndResolution("180p", std::make_pair(320, 180));
-            addLabelAndResolution("240p", std::make_pair(426, 240));
-            addLabelAndResolution("360p", std::make_pair(640, 360));
-            addLabelAndResolution("540p", std::make_pair(960, 540));
-            addLabelAndResolution("720p", std::make_pair(1280, 720));
-            addLabelAndResolution("1080p", std::make_pair(1920, 1080));
-        }
-    } fillRes_;
-    readTraceDataFromDir(path, filePrefix);
+    TraceBasedCodec(TraceStore::get(path, filePrefix), fps, fixed) {}
+
+TraceBasedCodec::TraceBasedCodec(std::shared_ptr<const TraceStore> traceStore,
+                                 double fps,
+                                 bool fixed) :
+    CodecWithFps(fps, NULL, NULL), m_fixedModeEnabled(fixed),
+    m_traceStore(traceStore), m_currentFrameIdx(0) {
+    // Initialize 1st layer index to lowest resolution found
+    m_currentResIt = m_traceStore->resolutions().begin();
     setResolutionForFixedMode();
     if (m_fixedModeEnabled) {
         setFixedMode(true); // Start with the middle resolution
@@ -221,7 +525,7 @@ TraceBasedCodec::~TraceBasedCodec() {}
 void TraceBasedCodec::setFixedMode(bool fixed) {
     m_fixedModeEnabled = fixed;
     if (fixed) {
-        assert(m_traceData.find(*m_fixedResIt) != m_traceData.end());
+        assert(m_traceStore->hasResolution(*m_fixedResIt));
         m_currentResIt = m_fixedResIt;
     }
 }
@@ -231,32 +535,48 @@ bool TraceBasedCodec::getFixedMode() const {
 }
 
 void TraceBasedCodec::setResolutionForFixedMode() {
-    std::vector<ResLabel>::const_iterator it = m_resolutions.begin();
-    std::advance(it, m_resolutions.size() / 2);
-    assert(it != m_resolutions.end());
-    assert(m_traceData.find(*it) != m_traceData.end());
+    const std::vector<ResLabel>& resolutions = m_traceStore->resolutions();
+    std::vector<ResLabel>::const_iterator it = resolutions.begin();
+    std::advance(it, resolutions.size() / 2);
+    assert(it != resolutions.end());
+    assert(m_traceStore->hasResolution(*it));
     m_fixedResIt = it;
 }
 
 bool TraceBasedCodec::setResolutionForFixedMode(ResLabel resolution) {
-    std::vector<ResLabel>::const_iterator it = std::find(m_resolutions.begin(),
-                                                         m_resolutions.end(),
+    const std::vector<ResLabel>& resolutions = m_traceStore->resolutions();
+    std::vector<ResLabel>::const_iterator it = std::find(resolutions.begin(),
+                                                         resolutions.end(),
                                                          resolution);
-    if (it == m_resolutions.end()) {
+    if (it == resolutions.end()) {
         return false;
     }
-    assert(m_traceData.find(resolution) != m_traceData.end());
+    assert(m_traceStore->hasResolution(resolution));
     m_fixedResIt = it;
     return true;
 }
 
+size_t TraceBasedCodec::getNumFrames() const {
+    return m_traceStore->bitrates(*m_currentResIt).begin()->second.size();
+}
+
+void TraceBasedCodec::setStartFrame(size_t frameIdx) {
+    const size_t numFrames = getNumFrames();
+    assert(numFrames > N_FRAMES_EXCLUDED);
+    if (frameIdx >= numFrames) {
+        frameIdx = N_FRAMES_EXCLUDED + (frameIdx - N_FRAMES_EXCLUDED) % (numFrames - N_FRAMES_EXCLUDED);
+    }
+    m_currentFrameIdx = frameIdx;
+    nextPacketOrFrame(); // Replace the frame already read
+}
+
 bool TraceBasedCodec::isValid() const {
     return traceDataIsValid() && CodecWithFps::isValid();
 }
 
 void TraceBasedCodec::decreaseResolution() {
     //PrintResolutionAndBitrate ();
-    if (m_currentResIt != m_resolutions.begin()) {
+    if (m_currentResIt != m_traceStore->resolutions().begin()) {
         --m_currentResIt;
         matchBitrate();
         printResolutionAndBitrate();
@@ -270,7 +590,7 @@ void TraceBasedCodec::decreaseResolution() {
 void TraceBasedCodec::increaseResolution() {
     //PrintResolutionAndBitrate ();
     ++m_currentResIt;
-    if (m_currentResIt != m_resolutions.end()) {
+    if (m_currentResIt != m_traceStore->resolutions().end()) {
         matchBitrate();
         const double newBpp = getCurrentBpp();
         if (newBpp < m_lowBppThresh) {
@@ -307,12 +627,12 @@ void TraceBasedCodec::adjustResolution() {
 }
 
 unsigned long TraceBasedCodec::getFrameBytes(Bitrate rate) {
-    const FrameSequence& seq = m_traceData.at(*m_currentResIt)[rate];
+    const FrameSequence& seq = m_traceStore->bitrates(*m_currentResIt).at(rate);
     assert(seq.size() > N_FRAMES_EXCLUDED);
     if (m_currentFrameIdx >= seq.size()) {
         m_currentFrameIdx = N_FRAMES_EXCLUDED;
     }
-    const unsigned long frameBytes = seq[m_currentFrameIdx++].m_size;
+    const unsigned long frameBytes = seq.frameSize(m_currentFrameIdx++);
     assert(frameBytes > 0);
     return frameBytes;
 }
@@ -328,16 +648,18 @@ void TraceBasedCodec::nextPacketOrFrame() {
 }
 
 bool TraceBasedCodec::traceDataIsValid() const {
-    bool result = !m_resolutions.empty() && m_currentResIt != m_resolutions.end();
-    assert(m_traceData.find(*m_currentResIt) != m_traceData.end());
+    const std::vector<ResLabel>& resolutions = m_traceStore->resolutions();
+    bool result = !resolutions.empty() && m_currentResIt != resolutions.end();
+    assert(m_traceStore->hasResolution(*m_currentResIt));
     return result;
 }
 
 double TraceBasedCodec::getPixelsPerFrame(ResLabel resolution) {
+    const Labels2Res& labels2Res = TraceStore::labels2Res();
     Labels2Res::const_iterator it;
-    for (it = m_labels2Res.begin(); it->first != resolution && it != m_labels2Res.end(); ++it) {
+    for (it = labels2Res.begin(); it != labels2Res.end() && it->first != resolution; ++it) {
     }
-    assert(it != m_labels2Res.end());
+    assert(it != labels2Res.end());
     return it->second.first * it->second.second;
 }
 
@@ -369,7 +691,7 @@ void TraceBasedCodec::printResolutionAndBitrate() const {
 void TraceBasedCodec::matchBitrate() {
     // Look up appropriate bitrate
     BitrateMap::const_reverse_iterator it;
-    const BitrateMap& currentMap = m_traceData.at(*m_currentResIt);
+    const BitrateMap& currentMap = m_traceStore->bitrates(*m_currentResIt);
     // Find greatest rate less than the target rate
     // Both stored and target bitrates are in bps
     for (it = currentMap.rbegin();
@@ -379,46 +701,6 @@ void TraceBasedCodec::matchBitrate() {
     m_matchedRate = (it != currentMap.rend() ? it->first : currentMap.begin()->first);
 }
 
-void TraceBasedCodec::readTraceDataFromDir(const std::string& path, const std::string& filePrefix) {
-    for (Labels2Res::const_iterator it = m_labels2Res.begin(); it != m_labels2Res.end(); ++it) {
-        bool resolutionPresent = false;
-        for (Bitrate bitrate = TRACE_MIN_BITRATE;
-             bitrate < TRACE_MAX_BITRATE;
-             bitrate += TRACE_BITRATE_STEP) {
-            std::ostringstream fullName;
-            fullName << path << "/" << filePrefix << "_" << it->first << "_" << bitrate << ".txt";
-            struct stat buffer;
-            if (::stat(fullName.str().c_str(), &buffer) == 0) { //filename exists
-                //* 1000: from kbps to bps
-                readTraceDataFromFile(fullName.str(), it->first, bitrate * 1000);
-                resolutionPresent = true;
-            }
-        }
-        if (resolutionPresent) {
-            m_resolutions.push_back(it->first);
-        }
-    }
-    // Initialize 1st layer index to lowest resolution found
-    assert(!m_resolutions.empty()); //TODO: Turn this into meaningful error
-    m_currentResIt = m_resolutions.begin();
-}
-
-void TraceBasedCodec::readTraceDataFromFile(const std::string& filename, const ResLabel& resolution, Bitrate bitrate) {
-    std::ifstream fin(filename.c_str());
-    assert(fin);
-
-    std::cout << "Reading traces file " << filename << std::endl;
-    FrameDataIterator it(fin);
-
-    while (it) {
-        const FrameDataIterator::value_type r = *it;
-        m_traceData[resolution][bitrate].push_back(r);
-        ++it;
-    }
-}
-
-
-
 TraceBasedCodecWithScaling::TraceBasedCodecWithScaling(const std::string& path,
                                                        const std::string& filePrefix,
                                                        double fps,
@@ -449,19 +731,19 @@ void TraceBasedCodecWithScaling::nextPacketOrFrame() {
         assert(m_lowRate <= m_targetRate);
         assert(m_targetRate < m_highRate);
 
-        const FrameSequence& lowSeq = m_traceData.at(*m_currentResIt)[m_lowRate];
+        const FrameSequence& lowSeq = m_traceStore->bitrates(*m_currentResIt).at(m_lowRate);
         assert(lowSeq.size() > N_FRAMES_EXCLUDED);
         if (m_currentFrameIdx >= lowSeq.size()) {
             m_currentFrameIdx = N_FRAMES_EXCLUDED;
         }
 
-        const FrameSequence& highSeq = m_traceData.at(*m_currentResIt)[m_highRate];
+        const FrameSequence& highSeq = m_traceStore->bitrates(*m_currentResIt).at(m_highRate);
         // Frame sequence should be the same, otherwise it doesn't make sense to interpolate
         assert(lowSeq.size() == highSeq.size());
 
-        const double lowSize = lowSeq[m_currentFrameIdx].m_size;
+        const double lowSize = lowSeq.frameSize(m_currentFrameIdx);
         assert(0 < lowSize);
-        const double highSize = highSeq[m_currentFrameIdx++].m_size;
+        const double highSize = highSeq.frameSize(m_currentFrameIdx++);
         if (lowSize > highSize) {
             std::cout << "Warning: Frame size (" << lowSize << ")@" << m_lowRate <<
             " is bigger than size (" << highSize << ")@" << m_highRate << std::endl;
@@ -498,7 +780,7 @@ void TraceBasedCodecWithScaling::matchBitrate() {
     // m_highRate <- 0 if it cannot be greater than target rate
     // A rate set to 0 means "invalid"
     // All bitrates are in bps
-    const BitrateMap& currentMap = m_traceData.at(*m_currentResIt);
+    const BitrateMap& currentMap = m_traceStore->bitrates(*m_currentResIt);
     assert(currentMap.size() > 0);
     m_lowRate = 0;
     BitrateMap::const_iterator it;
@@ -510,6 +792,290 @@ void TraceBasedCodecWithScaling::matchBitrate() {
     m_highRate = (it != currentMap.end() ? it->first : 0);
 }
 
+LayeredTraceCodec::LayeredTraceCodec(const std::string& path,
+                                     const std::string& filePrefix,
+                                     double fps,
+                                     size_t numLayers,
+                                     LayerMode mode) :
+    CodecWithFps(fps, NULL, NULL),
+    TraceBasedCodec(path, filePrefix, fps, true),
+    m_layerMode(mode) {
+    const std::vector<ResLabel>& resolutions = m_traceStore->resolutions();
+    numLayers = std::min(std::max<size_t>(numLayers, 1), resolutions.size());
+    std::vector<ResLabel> layerResolutions;
+    for (size_t layer = 0; layer < numLayers; ++layer) {
+        // Spread evenly, the top layer at the highest resolution
+        const size_t idx = (numLayers == 1) ?
+                           resolutions.size() - 1 :
+                           layer * (resolutions.size() - 1) / (numLayers - 1);
+        layerResolutions.push_back(resolutions[idx]);
+    }
+    const bool accepted = setLayerResolutions(layerResolutions);
+    assert(accepted);
+    (void) accepted;
+    // The superclass already read the first frame, without layers
+    m_currentFrameIdx = 0;
+    nextPacketOrFrame();
+    assert(isValid());
+}
+
+LayeredTraceCodec::~LayeredTraceCodec() {}
+
+float LayeredTraceCodec::setTargetRate(float newRateBps) {
+    const float result = TraceBasedCodec::setTargetRate(newRateBps);
+    allocateRates();
+    return result;
+}
+
+bool LayeredTraceCodec::setLayerResolutions(const std::vector<ResLabel>& resolutions) {
+    if (resolutions.empty()) {
+        return false;
+    }
+    for (size_t layer = 0; layer < resolutions.size(); ++layer) {
+        if (!m_traceStore->hasResolution(resolutions[layer])) {
+            return false;
+        }
+        if (layer > 0 &&
+            getPixelsPerFrame(resolutions[layer]) <= getPixelsPerFrame(resolutions[layer - 1])) {
+            return false;
+        }
+    }
+    m_layerResolutions = resolutions;
+    m_layerRates.assign(resolutions.size(), 0);
+    m_layerBytes.assign(resolutions.size(), 0);
+    allocateRates();
+    return true;
+}
+
+size_t LayeredTraceCodec::getNumLayers() const {
+    return m_layerResolutions.size();
+}
+
+LayeredTraceCodec::LayerMode LayeredTraceCodec::getLayerMode() const {
+    return m_layerMode;
+}
+
+const std::vector<LayeredTraceCodec::ResLabel>& LayeredTraceCodec::getLayerResolutions() const {
+    return m_layerResolutions;
+}
+
+float LayeredTraceCodec::getLayerRate(size_t layer) const {
+    return m_layerRates.at(layer);
+}
+
+unsigned long LayeredTraceCodec::getLayerBytes(size_t layer) const {
+    return m_layerBytes.at(layer);
+}
+
+int LayeredTraceCodec::getReferenceLayer(size_t layer) const {
+    assert(layer < m_layerResolutions.size());
+    return (m_layerMode == SVC && layer > 0) ? int(layer) - 1 : -1;
+}
+
+void LayeredTraceCodec::allocateRates() {
+    double totalWeight = 0.;
+    for (size_t layer = 0; layer < m_layerResolutions.size(); ++layer) {
+        totalWeight += pow(getPixelsPerFrame(m_layerResolutions[layer]), .75);
+    }
+    for (size_t layer = 0; layer < m_layerResolutions.size(); ++layer) {
+        const double weight = pow(getPixelsPerFrame(m_layerResolutions[layer]), .75);
+        m_layerRates[layer] = m_targetRate * weight / totalWeight;
+    }
+}
+
+double LayeredTraceCodec::getScaledFrameBytes(const ResLabel& resolution, double rate) const {
+    const BitrateMap& currentMap = m_traceStore->bitrates(resolution);
+    assert(currentMap.size() > 0);
+    // Rates immediately higher than and immediately lower than (or equal to) the target rate
+    BitrateMap::const_iterator high = currentMap.upper_bound(Bitrate(rate));
+    if (high == currentMap.begin()) {
+        //Linear scaling
+        assert(m_currentFrameIdx < high->second.size());
+        return rate / double(high->first) * high->second.frameSize(m_currentFrameIdx);
+    }
+    BitrateMap::const_iterator low = high;
+    --low;
+    assert(m_currentFrameIdx < low->second.size());
+    const double lowSize = low->second.frameSize(m_currentFrameIdx);
+    if (high == currentMap.end()) {
+        //Linear scaling
+        return rate / double(low->first) * lowSize;
+    }
+    // Frame sequence should be the same, otherwise it doesn't make sense to interpolate
+    assert(low->second.size() == high->second.size());
+    const double highSize = high->second.frameSize(m_currentFrameIdx);
+    const double highWeight = (rate - low->first) / double(high->first - low->first);
+    //Linear interpolation
+    return highSize * highWeight + lowSize * (1. - highWeight);
+}
+
+void LayeredTraceCodec::nextPacketOrFrame() {
+    const FrameSequence& baseSeq = m_traceStore->bitrates(m_layerResolutions[0]).begin()->second;
+    assert(baseSeq.size() > N_FRAMES_EXCLUDED);
+    if (m_currentFrameIdx >= baseSeq.size()) {
+        m_currentFrameIdx = N_FRAMES_EXCLUDED;
+    }
+
+    unsigned long frameBytes = 0;
+    double lowerLayersRate = 0.;
+    double lowerLayersBytes = 0.;
+    for (size_t layer = 0; layer < m_layerResolutions.size(); ++layer) {
+        double layerBytes;
+        if (m_layerMode == SVC) {
+            // What the frame of this layer's resolution adds to the frame of the layer below
+            lowerLayersRate += m_layerRates[layer];
+            const double bytes = getScaledFrameBytes(m_layerResolutions[layer], lowerLayersRate);
+            layerBytes = bytes - lowerLayersBytes;
+            lowerLayersBytes = bytes;
+        } else {
+            layerBytes = getScaledFrameBytes(m_layerResolutions[layer], m_layerRates[layer]);
+        }
+        // We set the minimum to 1 byte, since a layer can be arbitrarily small
+        m_layerBytes[layer] = std::max(1., layerBytes);
+        frameBytes += m_layerBytes[layer];
+    }
+    ++m_currentFrameIdx;
+
+    const double secsToNextFrame = 1. / m_fps;
+
+    m_currentPacketOrFrame.first.resize(frameBytes, 0);
+    m_currentPacketOrFrame.second = secsToNextFrame;
+}
+
+namespace {
+
+/** Index of frame type @p type in #GopCodec::m_typeBytes . */
+size_t frameTypeIndex(char type) {
+    return type == 'I' ? 0 : (type == 'B' ? 2 : 1);
+}
+
+}
+
+GopCodec::GopCodec(std::shared_ptr<const TraceStore> traceStore, double fps) :
+    CodecWithFps(fps, NULL, NULL),
+    TraceBasedCodec(traceStore, fps, true),
+    m_gopSize(0), m_bFrames(0), m_gopFrameIdx(0), m_forceKeyFrame(true), m_frameType('I'),
+    m_numKeyFrames(0), m_meanFrameBytes(0.) {
+    const FrameSequence& clip = getClip();
+    double totalBytes[3] = { 0., 0., 0. };
+    size_t numFrames[3] = { 0, 0, 0 };
+    for (size_t i = 0; i < clip.size(); ++i) {
+        const size_t type = frameTypeIndex(getClipFrameType(i));
+        totalBytes[type] += clip.frameSize(i);
+        ++numFrames[type];
+    }
+    m_numKeyFrames = numFrames[0];
+    // Types missing from the clip are sized after the others
+    m_typeBytes[1] = numFrames[1] > 0 ? totalBytes[1] / numFrames[1] :
+                     (totalBytes[0] + totalBytes[2]) / clip.size();
+    m_typeBytes[0] = numFrames[0] > 0 ? totalBytes[0] / numFrames[0] : m_typeBytes[1];
+    m_typeBytes[2] = numFrames[2] > 0 ? totalBytes[2] / numFrames[2] : m_typeBytes[1] / 2.;
+    updateMeanFrameBytes();
+    // The superclass already read the first frame, without its type
+    m_currentFrameIdx = 0;
+    nextPacketOrFrame();
+    assert(isValid());
+}
+
+GopCodec::~GopCodec() {}
+
+void GopCodec::setGopStructure(size_t gopSize, size_t bFrames) {
+    m_gopSize = gopSize;
+    m_bFrames = bFrames;
+    // The current frame starts the new GOP if it is an I-frame
+    m_gopFrameIdx = (m_frameType == 'I' && m_gopSize > 1) ? 1 : 0;
+    updateMeanFrameBytes();
+}
+
+size_t GopCodec::getGopSize() const {
+    return m_gopSize;
+}
+
+size_t GopCodec::getBFrames() const {
+    return m_bFrames;
+}
+
+double GopCodec::getKeyFrameInterval() const {
+    const double frames = m_gopSize > 0 ?
+                          double(m_gopSize) :
+                          double(getClip().size()) / std::max<size_t>(m_numKeyFrames, 1);
+    return frames / m_fps;
+}
+
+char GopCodec::getFrameType() const {
+    return m_frameType;
+}
+
+void GopCodec::setStartFrame(size_t frameIdx) {
+    m_currentFrameIdx = frameIdx % getClip().size();
+    m_forceKeyFrame = true;
+    nextPacketOrFrame(); // Replace the frame already read
+}
+
+const TraceStore::FrameSequence& GopCodec::getClip() const {
+    return m_traceStore->bitrates(*m_currentResIt).begin()->second;
+}
+
+char GopCodec::getClipFrameType(size_t idx) const {
+    const char type = getClip().frameType(idx);
+    return (type == 'I' || type == 'B') ? type : 'P';
+}
+
+double GopCodec::getTypeBytes(char type) const {
+    return m_typeBytes[frameTypeIndex(type)];
+}
+
+void GopCodec::updateMeanFrameBytes() {
+    double totalBytes = 0.;
+    if (m_gopSize == 0) {
+        const FrameSequence& clip = getClip();
+        for (size_t i = 0; i < clip.size(); ++i) {
+            totalBytes += clip.frameSize(i);
+        }
+        m_meanFrameBytes = totalBytes / clip.size();
+        return;
+    }
+    // One I-frame, then a P-frame after every m_bFrames B-frames
+    totalBytes = getTypeBytes('I');
+    for (size_t i = 1; i < m_gopSize; ++i) {
+        totalBytes += getTypeBytes(i % (m_bFrames + 1) == 0 ? 'P' : 'B');
+    }
+    m_meanFrameBytes = totalBytes / m_gopSize;
+}
+
+void GopCodec::nextPacketOrFrame() {
+    const FrameSequence& clip = getClip();
+    if (m_currentFrameIdx >= clip.size()) {
+        m_currentFrameIdx = 0;
+    }
+    if (m_forceKeyFrame) {
+        m_frameType = 'I';
+        m_gopFrameIdx = 0;
+        m_forceKeyFrame = false;
+    } else if (m_gopSize == 0) {
+        m_frameType = getClipFrameType(m_currentFrameIdx);
+    } else {
+        m_frameType = m_gopFrameIdx == 0 ? 'I' :
+                      (m_gopFrameIdx % (m_bFrames + 1) == 0 ? 'P' : 'B');
+    }
+    if (m_gopSize > 0) {
+        m_gopFrameIdx = (m_gopFrameIdx + 1) % m_gopSize;
+    }
+
+    // Resize the clip frame to the type it is output as, then to the target bitrate
+    const char clipType = getClipFrameType(m_currentFrameIdx);
+    double frameBytes = clip.frameSize(m_currentFrameIdx) * getTypeBytes(m_frameType) /
+                        getTypeBytes(clipType);
+    frameBytes *= m_targetRate / (8. * m_fps * m_meanFrameBytes);
+    ++m_currentFrameIdx;
+
+    const double secsToNextFrame = 1. / m_fps;
+
+    // We set the minimum to 1 byte, since a frame can be arbitrarily small
+    m_currentPacketOrFrame.first.resize(std::max(1., frameBytes), 0);
+    m_currentPacketOrFrame.second = secsToNextFrame;
+}
+
 ShapedPacketizer::ShapedPacketizer(Codec* innerCodec,
                                    unsigned long payloadSize,
                                    unsigned int perPacketOverhead) :
@@ -51,6 +51,7 @@
 #include <utility>
 #include <cstdint>
 #include <memory>
+#include <string>
 
 /**
  * @defgroup TraceBasedCodecConst These are defined as constants for the moment. Later on, they
@@ -62,6 +63,7 @@
 #define TRACE_MAX_BITRATE 6000 /**< Maximum bitrate when scanning a trace file directory (kbps). */
 #define TRACE_BITRATE_STEP 100 /**< Step used when scanning a trace file directory (kbps). */
 #define N_FRAMES_EXCLUDED 20 /**< Number of initial frames to exclude when trace wraps around. */
+#define BINARY_TRACE_SUFFIX ".bintrace" /**< Suffix of compiled binary trace files. */
 
 /*@}*/
 
@@ -359,12 +361,150 @@ protected:
 
 
 
+/**
+ * Immutable, process-wide store of the video traces of one directory and file prefix.
+ *
+ * All #TraceBasedCodec instances using the same directory and prefix share a single store,
+ * loaded by the first of them. The store is reference counted: it is freed when the last
+ * codec using it is destroyed. Codecs only keep a cursor (current resolution and frame index)
+ * into it.
+ *
+ * The store is an image in a binary trace format: a header, an index with one entry per video
+ * trace (resolution and bitrate), then the frame sizes, timestamps and types of all traces as
+ * contiguous arrays. If the directory contains a binary trace file compiled by #compile (named
+ * after the prefix, with suffix #BINARY_TRACE_SUFFIX), it is memory-mapped read-only: nothing is
+ * parsed, and pages are read from disk as frames are used. Otherwise, the text trace files are
+ * parsed into an image in memory. Binary trace files use the host byte order and have to be
+ * compiled again whenever the text trace files change.
+ *
+ * @note ns-3 simulations are single-threaded, so the registry is not locked.
+ */
+class TraceStore {
+public:
+    typedef std::string ResLabel;
+    typedef std::pair<unsigned int, /* height */
+                      unsigned int  /* width */
+                      > Resolution;
+    //Can't use a map because we want the keys ordered by their insertion
+    typedef std::vector<std::pair<ResLabel, Resolution> > Labels2Res;
+    typedef unsigned long Bitrate;
+
+    /**
+     * Read-only view of the frames of one video trace, pointing into the store's image.
+     */
+    class FrameSequence {
+    public:
+        FrameSequence(const uint32_t* sizes, const float* timestamps, const char* types,
+                      size_t numFrames) :
+            m_sizes(sizes), m_timestamps(timestamps), m_types(types), m_numFrames(numFrames) {}
+
+        size_t size() const { return m_numFrames; }
+        /** Size in bytes of frame @p i. */
+        unsigned long frameSize(size_t i) const { return m_sizes[i]; }
+        /** Timestamp (in seconds) of frame @p i. */
+        float timestamp(size_t i) const { return m_timestamps[i]; }
+        /** Type of frame @p i. I = I-frame; P = P-frame; B = B-frame; U = Unknown. */
+        char frameType(size_t i) const { return m_types[i]; }
+
+    private:
+        const uint32_t* m_sizes;
+        const float* m_timestamps;
+        const char* m_types;
+        size_t m_numFrames;
+    };
+
+    typedef std::map<Bitrate, FrameSequence> BitrateMap;
+    typedef std::map<ResLabel, BitrateMap> ResolutionMap;
+
+    ~TraceStore();
+
+    /**
+     * Return the store of the video traces in directory @p path whose files start with
+     * @p filePrefix, loading them if no codec is using them yet.
+     */
+    static std::shared_ptr<const TraceStore> get(const std::string& path,
+                                                 const std::string& filePrefix);
+
+    /**
+     * Return the store of a single video trace given as tables, e.g. a clip compiled into the
+     * simulator, building it if no codec is using it yet. Stores are shared by @p name.
+     *
+     * @param [in] name The name of the video trace.
+     * @param [in] resolution The resolution of the video trace, one of #labels2Res .
+     * @param [in] bitrate The bitrate (bps) the video trace was encoded at.
+     * @param [in] sizes The size in bytes of each frame.
+     * @param [in] types The type of each frame, see #FrameSequence::frameType .
+     * @param [in] fps The frame rate of the video trace, to set the frame timestamps.
+     */
+    static std::shared_ptr<const TraceStore> get(const std::string& name,
+                                                 const ResLabel& resolution,
+                                                 Bitrate bitrate,
+                                                 const std::vector<uint32_t>& sizes,
+                                                 const std::vector<char>& types,
+                                                 double fps);
+
+    /**
+     * Compile the text trace files in directory @p path whose names start with @p filePrefix
+     * into the binary trace file @p outFile.
+     *
+     * @retval true on success, false if there are no trace files or @p outFile cannot be written.
+     */
+    static bool compile(const std::string& path,
+                        const std::string& filePrefix,
+                        const std::string& outFile);
+
+    /**
+     * Look for the trace directory @p subDir relative to the directories simulations are
+     * usually run from (the ns-3 top directory, or one or two levels below it). The
+     * environment variable BBR_TRACES_DIR, if set, takes precedence.
+     *
+     * @retval The directory found, or an empty string if there is none.
+     */
+    static std::string findTraceDir(const std::string& subDir);
+
+    /** The resolutions known to the codecs, in increasing order. */
+    static const Labels2Res& labels2Res();
+
+    /** Resolutions with at least one video trace, in increasing order. */
+    const std::vector<ResLabel>& resolutions() const { return m_resolutions; }
+
+    /** Video traces of @p resolution, by bitrate (bps). */
+    const BitrateMap& bitrates(const ResLabel& resolution) const;
+
+    bool hasResolution(const ResLabel& resolution) const;
+
+private:
+    typedef std::map<std::pair<std::string, std::string>, std::weak_ptr<const TraceStore> > Registry;
+
+    TraceStore();
+    TraceStore(const std::string& path, const std::string& filePrefix);
+    TraceStore(const TraceStore&);
+    void operator=(const TraceStore&);
+
+    static bool buildImage(const std::string& path,
+                           const std::string& filePrefix,
+                           std::vector<char>& image);
+    bool mapImage(const std::string& filename);
+    bool loadIndex();
+    static Registry& registry();
+
+    std::vector<char> m_parsedImage; /**< image parsed from text trace files, if not mapped. */
+    const char* m_image;
+    size_t m_imageSize;
+    bool m_mapped;
+    ResolutionMap m_traceData; /**< index of the video traces in the image. */
+    std::vector<ResLabel> m_resolutions;
+};
+
+
+
 /**
  * This codec is an advanced synthetic codec implementation in the syncodecs family.
  * It produces a sequence of frames with realistic sizes. The sequence of frame sizes correspond
  * to real codec output from a video sequence obtained offline.
  *
- * Upon initialization, the codec parses a group of video trace files and loads them in memory.
+ * Upon initialization, the codec gets the group of video trace files from a shared #TraceStore ,
+ * which parses them and loads them in memory the first time they are used.
  * Each trace file contains information on the sequence of frames produced by a real codec.
  * Each line of the file corresponds to a frame record, where several fields can be
  * found (see #FrameDataIterator for further information on the format of the trace file).
@@ -462,12 +602,8 @@ protected:
  *       on video compression (ISBN-13:978-0976259503).
  */
 class TraceBasedCodec : virtual public CodecWithFps {
-    typedef std::string ResLabel;
-    typedef std::pair<unsigned int, /* height */
-                      unsigned int  /* width */
-                      > Resolution;
-    //Can't use a map because we want the keys ordered by their insertion
-    typedef std::vector<std::pair<ResLabel, Resolution> > Labels2Res;
+    typedef TraceStore::ResLabel ResLabel;
+    typedef TraceStore::Labels2Res Labels2Res;
 
 public:
     /**
@@ -532,11 +668,40 @@ public:
      */
     bool setResolutionForFixedMode(ResLabel res);
 
+    /**
+     * Obtain the number of frames of the video traces at the current resolution. Past the last
+     * frame, the codec loops back to frame #N_FRAMES_EXCLUDED.
+     *
+     * @retval The number of frames.
+     */
+    size_t getNumFrames() const;
+
+    /**
+     * Make frame @p frameIdx of the video traces the current frame. Indexes past the last
+     * frame wrap around the looped part of the traces, so that any index is valid.
+     *
+     * Codecs replaying the same traces from different frames do not produce their
+     * I-frames at the same time.
+     *
+     * @param [in] frameIdx The index of the frame to continue from.
+     */
+    virtual void setStartFrame(size_t frameIdx);
+
 protected:
-    typedef unsigned long Bitrate;
-    typedef std::vector<LineRecord> FrameSequence;
-    typedef std::map<Bitrate, FrameSequence> BitrateMap;
-    typedef std::map<ResLabel, BitrateMap> ResolutionMap;
+    typedef TraceStore::Bitrate Bitrate;
+    typedef TraceStore::FrameSequence FrameSequence;
+    typedef TraceStore::BitrateMap BitrateMap;
+
+    /**
+     * Class constructor for subclasses that get their video traces from a store themselves.
+     *
+     * @param [in] traceStore The video traces.
+     * @param [in] fps The number of frames per second at which the codec is to operate.
+     * @param [in] fixed See the public constructor.
+     */
+    TraceBasedCodec(std::shared_ptr<const TraceStore> traceStore,
+                    double fps,
+                    bool fixed);
 
     /**
      * Internal implementation of the class's boolean cast. It extends its superclass's behavior
@@ -598,30 +763,21 @@ protected:
     static double getPixelsPerFrame(ResLabel resolution);
 
     bool m_fixedModeEnabled; /**< true if currently in fixed resolution mode. */
-    ResolutionMap m_traceData; /**< data structure that holds all video traces in memory. */
+    std::shared_ptr<const TraceStore> m_traceStore; /**< Video traces, shared by all codecs. */
     size_t m_currentFrameIdx; /**< Internal pointer to the current frame of the video trace. */
     /**
      * Number of pixels per frame for the resolution above which Waggoner's rule applies.
      */
     double m_limitPixelsPerFrame;
-    /**
-     * Resolutions for which the codec has at least a video trace.
-     */
-    std::vector<ResLabel> m_resolutions;
     std::vector<ResLabel>::const_iterator m_currentResIt; /**< Points to the current resolution */
     std::vector<ResLabel>::const_iterator m_fixedResIt; /**< Points to resolution for fixed mode */
 
 private:
-    static Labels2Res m_labels2Res;
     static const float m_lowBppThresh;
     static const float m_highBppThresh;
     void decreaseResolution();
     void increaseResolution();
     bool traceDataIsValid() const;
-    void readTraceDataFromDir(const std::string& path, const std::string& filePrefix);
-    void readTraceDataFromFile(const std::string& filename,
-                               const ResLabel& resolution,
-                               Bitrate bitrate);
 
     Bitrate m_matchedRate;
 };
@@ -706,6 +862,206 @@ private:
 };
 
 
+/**
+ * This codec extends the #TraceBasedCodec to output layered frames, as a scalable (SVC) or a
+ * simulcast encoder would. Every frame is made of a number of layers, each at one of the
+ * resolutions the codec has video traces for: the base layer (layer 0) at the lowest one, then
+ * the enhancement layers in increasing order of resolution.
+ *
+ * The codec's target bitrate is split among the layers in proportion to their number of pixels
+ * raised to the power of .75 (Waggoner's rule, see #TraceBasedCodec ). The frame sizes of each
+ * layer are obtained from the video traces of its resolution, with the scaling and interpolation
+ * of #TraceBasedCodecWithScaling . There are two modes:
+ * <ul>
+ *   <li> SVC: each enhancement layer is predicted from the layer below it. Layers 0 to <i>l</i>
+ *        together make up a frame at the resolution of layer <i>l</i> and at the sum of their
+ *        bitrates, so the size of layer <i>l</i> is what this frame adds to the one of layer
+ *        <i>l-1</i>. A layer can only be decoded along with all the layers below it. </li>
+ *   <li> Simulcast: each layer is an independent stream at its own resolution and bitrate,
+ *        and can be decoded alone. </li>
+ * </ul>
+ *
+ * The size of the frame reported by the codec (operators "*" and "->") is the sum of the
+ * sizes of its layers, which are returned by #getLayerBytes . This allows the user to drop
+ * enhancement layers as soon as the network calls for it, without retuning the codec.
+ *
+ * The resolutions of the layers are fixed, so the fixed and variable resolution modes of the
+ * superclass have no effect on this codec.
+ */
+class LayeredTraceCodec : public TraceBasedCodec {
+public:
+    typedef TraceStore::ResLabel ResLabel;
+
+    /** Dependencies between the layers of a frame. */
+    enum LayerMode {
+        SVC = 0,   /**< Each enhancement layer depends on the layer below it. */
+        SIMULCAST, /**< Layers are independent streams. */
+    };
+
+    /**
+     * Class constructor.
+     *
+     * @param [in] path The path to the directory where the files containing video traces are located.
+     * @param [in] filePrefix The common prefix that all video trace files must have.
+     * @param [in] fps The number of frames per second at which the codec is to operate.
+     * @param [in] numLayers The number of layers of each frame. It is limited to the number of
+     *                       resolutions with video traces, and the layers are spread evenly
+     *                       over those resolutions, the top layer at the highest one.
+     * @param [in] mode The dependencies between the layers.
+     */
+    LayeredTraceCodec(const std::string& path,
+                      const std::string& filePrefix,
+                      double fps,
+                      size_t numLayers,
+                      LayerMode mode = SVC);
+
+    /** Class destructor. Called after the subclasses' destructor is called */
+    virtual ~LayeredTraceCodec();
+
+    virtual float setTargetRate(float newRateBps);
+
+    /**
+     * Set the resolution of each layer, from the base layer up. Takes effect from the next frame.
+     *
+     * @param [in] resolutions Resolutions in strictly increasing order, all with video traces.
+     * @retval true if the codec accepts the resolutions, false otherwise. In the latter case,
+     *         no effect in the codec.
+     */
+    bool setLayerResolutions(const std::vector<ResLabel>& resolutions);
+
+    size_t getNumLayers() const;
+    LayerMode getLayerMode() const;
+    const std::vector<ResLabel>& getLayerResolutions() const;
+
+    /** Bitrate (bps) allocated to layer @p layer. */
+    float getLayerRate(size_t layer) const;
+
+    /** Size in bytes of layer @p layer of the current frame. */
+    unsigned long getLayerBytes(size_t layer) const;
+
+    /**
+     * Obtain the layer that layer @p layer is predicted from.
+     *
+     * @retval The index of the reference layer, or -1 if @p layer can be decoded alone.
+     */
+    int getReferenceLayer(size_t layer) const;
+
+protected:
+    /** Internal implementation of the layered codec. */
+    virtual void nextPacketOrFrame();
+
+private:
+    /** Split the target bitrate among the layers. */
+    void allocateRates();
+
+    /**
+     * Size of the current frame at @p resolution, scaled or interpolated to @p rate from the
+     * video traces of that resolution.
+     */
+    double getScaledFrameBytes(const ResLabel& resolution, double rate) const;
+
+    LayerMode m_layerMode;
+    std::vector<ResLabel> m_layerResolutions; /**< Resolution of each layer, base layer first. */
+    std::vector<float> m_layerRates; /**< Bitrate (bps) of each layer. */
+    std::vector<unsigned long> m_layerBytes; /**< Layer sizes (bytes) of the current frame. */
+};
+
+
+/**
+ * This codec extends the #TraceBasedCodec to replay a GOP-structured video clip: a single video
+ * trace, at one resolution and bitrate, whose frames are typed I, P or B. Unlike the other trace
+ * based codecs, it reports the type of the current frame (see #getFrameType ), so that the user
+ * can tell I-frames, which the following frames depend on, from the others.
+ *
+ * The frame sizes of the clip are scaled to the codec's target bitrate: every frame is scaled by
+ * the ratio of the target frame size (the target bitrate over the frame rate) to the mean frame
+ * size of the sequence of frame types the codec outputs.
+ *
+ * By default, the frame types are those of the clip. With #setGopStructure , the user imposes a
+ * GOP structure instead: an I-frame every <i>gopSize</i> frames, and <i>bFrames</i> B-frames
+ * between successive I- or P-frames. A frame whose type is not the one it has in the clip takes
+ * the size of the clip frame, scaled by the ratio of the mean sizes of both types in the clip.
+ * If the clip has no B-frames, a B-frame is taken to be half the size of a P-frame.
+ *
+ * When the internal index reaches the last frame of the clip, it wraps to the first: a clip is a
+ * whole number of GOPs. The first frame, and the first one after #setStartFrame , is always
+ * an I-frame, as nothing can be decoded before one.
+ *
+ * The codec has a single resolution, so the fixed and variable resolution modes of the superclass
+ * have no effect on it.
+ */
+class GopCodec : public TraceBasedCodec {
+public:
+    /**
+     * Class constructor.
+     *
+     * @param [in] traceStore The video trace of the clip (see #TraceStore::get ). Only the
+     *                        first video trace of its lowest resolution is used.
+     * @param [in] fps The number of frames per second at which the codec is to operate.
+     */
+    GopCodec(std::shared_ptr<const TraceStore> traceStore, double fps);
+
+    /** Class destructor. Called after the subclasses' destructor is called */
+    virtual ~GopCodec();
+
+    /**
+     * Set the GOP structure of the frames from the next one on.
+     *
+     * @param [in] gopSize The number of frames from an I-frame to the next, i.e., the keyframe
+     *                     interval in frames. 0 to use the frame types of the clip.
+     * @param [in] bFrames The number of B-frames between successive I- or P-frames. Ignored if
+     *                     @p gopSize is 0.
+     */
+    void setGopStructure(size_t gopSize, size_t bFrames);
+
+    /** The number of frames from an I-frame to the next, or 0 if those of the clip are used. */
+    size_t getGopSize() const;
+    size_t getBFrames() const;
+
+    /**
+     * Obtain the mean time between I-frames, from the GOP size or, if it is 0, from the clip.
+     *
+     * @retval The keyframe interval in seconds.
+     */
+    double getKeyFrameInterval() const;
+
+    /**
+     * Obtain the type of the current frame.
+     *
+     * @retval 'I', 'P' or 'B'.
+     */
+    char getFrameType() const;
+
+    virtual void setStartFrame(size_t frameIdx);
+
+protected:
+    /** Internal implementation of the GOP-structured codec. */
+    virtual void nextPacketOrFrame();
+
+private:
+    /** The video trace of the clip. */
+    const FrameSequence& getClip() const;
+
+    /** Type of frame @p idx of the clip: I, P or B; frames of unknown type are taken as P. */
+    char getClipFrameType(size_t idx) const;
+
+    /** Mean size of the frames of type @p type in the clip. */
+    double getTypeBytes(char type) const;
+
+    /** Compute the mean frame size of the frame types output. */
+    void updateMeanFrameBytes();
+
+    size_t m_gopSize;
+    size_t m_bFrames;
+    size_t m_gopFrameIdx; /**< Position of the next frame in its GOP. */
+    bool m_forceKeyFrame; /**< true if the next frame is to be an I-frame. */
+    char m_frameType; /**< Type of the current frame. */
+    double m_typeBytes[3]; /**< Mean sizes of the I-, P- and B-frames of the clip. */
+    size_t m_numKeyFrames; /**< Number of I-frames in the clip. */
+    double m_meanFrameBytes; /**< Mean size of the frames output, before scaling. */
+};
+
+
 /**
  * This codec is part of the group of packetizers. It is aware of the maximum payload that it
  * should output.
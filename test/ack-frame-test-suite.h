@@ -0,0 +1,88 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "../model/ack-frame.h"
+#include "../model/varint.h"
+
+// An essential include is test.h
+#include "ns3/test.h"
+
+// Do not put your test classes in namespace ns3.  You may find it useful
+// to use the using directive to access the ns3 namespace directly
+using namespace ns3;
+using namespace ns3::bbr;
+
+class AckFrameTestCase : public TestCase
+{
+  public:
+    AckFrameTestCase();
+    virtual ~AckFrameTestCase() {}
+
+  private:
+    virtual void DoRun(void);
+};
+
+AckFrameTestCase::AckFrameTestCase()
+    : TestCase("ack frame encoding of wide gaps and many ranges")
+{
+}
+
+void AckFrameTestCase::DoRun(void)
+{
+    AckFrame ack;
+    ack.connection_id = 900;
+    ack.largest_observed = 5000000;
+    ack.ack_delay_time = 7000;
+    ack.last_update_time = 123456789;
+    // 300 ranges, the oldest 100000 packets below the others.
+    ack.packets.Add(1000, 1010);
+    for (PacketNumber k = 0; k < 299; ++k)
+    {
+        ack.packets.Add(101010 + 3 * k, 101012 + 3 * k);
+    }
+    ack.packets.Add(4999990, 5000001);
+    ack.received_packet_times.push_back(std::make_pair(4999990, 123400000));
+    ack.received_packet_times.push_back(std::make_pair(5000000, 123456001));
+    ack.recovered_packets.push_back(1005);
+    ack.delivery_rate = Bandwidth::FromBytesPerSecond(1250000);
+
+    Buffer buffer;
+    buffer.AddAtStart(ack.GetSerializedSize());
+    ack.Serialize(buffer.Begin());
+    AckFrame decoded;
+    NS_TEST_ASSERT_MSG_EQ(decoded.Deserialize(buffer.Begin()), ack.GetSerializedSize(), "wrong size");
+
+    NS_TEST_ASSERT_MSG_EQ(decoded.connection_id, ack.connection_id, "wrong connection id");
+    NS_TEST_ASSERT_MSG_EQ(decoded.largest_observed, ack.largest_observed, "wrong largest observed");
+    NS_TEST_ASSERT_MSG_EQ(decoded.ack_delay_time, ack.ack_delay_time, "wrong ack delay");
+    NS_TEST_ASSERT_MSG_EQ(decoded.packets.NumIntervals(), 301u, "ranges lost");
+    NS_TEST_ASSERT_MSG_EQ(decoded.packets.Min(), 1000u, "oldest range lost");
+    NS_TEST_ASSERT_MSG_EQ(decoded.packets.Contains(1010), false, "range too long");
+    NS_TEST_ASSERT_MSG_EQ(decoded.packets.Contains(101010 + 3 * 150), true, "range missing");
+    NS_TEST_ASSERT_MSG_EQ(decoded.packets.Contains(101012 + 3 * 150), false, "gap missing");
+    NS_TEST_ASSERT_MSG_EQ(decoded.packets.LastIntervalLength(), 11u, "wrong first range");
+    NS_TEST_ASSERT_MSG_EQ(decoded.received_packet_times.size(), 2u, "timestamps lost");
+    NS_TEST_ASSERT_MSG_EQ(decoded.received_packet_times[0].second, 123400000u, "wrong timestamp");
+    NS_TEST_ASSERT_MSG_EQ(decoded.received_packet_times[1].second, 123456001u, "timestamp rounded");
+    NS_TEST_ASSERT_MSG_EQ(decoded.recovered_packets.size(), 1u, "recovered packets lost");
+    NS_TEST_ASSERT_MSG_EQ(decoded.recovered_packets[0], 1005u, "wrong recovered packet");
+    NS_TEST_ASSERT_MSG_EQ(decoded.delivery_rate.ToBitsPerSecond(), 10000000, "wrong delivery rate");
+
+    // An unknown delivery rate costs one byte.
+    AckFrame no_rate;
+    no_rate.largest_observed = 1;
+    no_rate.packets.Add(1);
+    const uint32_t size_without_rate = no_rate.GetSerializedSize();
+    no_rate.delivery_rate = ack.delivery_rate;
+    NS_TEST_ASSERT_MSG_EQ(no_rate.GetSerializedSize(), size_without_rate + GetVarIntLength(1250000) - 1,
+                          "delivery rate not optional");
+
+    // The ack delay keeps sub-millisecond precision, rounded down to
+    // 2^ack_delay_exponent microseconds.
+    no_rate.ack_delay_time = 1234;
+    Buffer delay_buffer;
+    delay_buffer.AddAtStart(no_rate.GetSerializedSize());
+    no_rate.Serialize(delay_buffer.Begin());
+    AckFrame delay_decoded;
+    delay_decoded.Deserialize(delay_buffer.Begin());
+    NS_TEST_ASSERT_MSG_EQ(delay_decoded.ack_delay_time, 1232u, "ack delay not encoded in microseconds");
+}
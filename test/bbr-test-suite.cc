@@ -5,6 +5,22 @@
 
 #include "packet-number-queue-test-suite.h"
 #include "packet-number-indexed-queue-test-suite.h"
+#include "controller-policy-test-suite.h"
+#include "rack-loss-algorithm-test-suite.h"
+#include "fec-codec-test-suite.h"
+#include "packet-header-test-suite.h"
+#include "ack-frame-test-suite.h"
+#include "jitter-buffer-test-suite.h"
+#include "packet-time-ring-test-suite.h"
+#include "delivery-rate-estimator-test-suite.h"
+#include "nack-tracker-test-suite.h"
+#include "pic-queue-test-suite.h"
+#include "encoder-rate-controller-test-suite.h"
+#include "send-scheduler-test-suite.h"
+#include "layer-controller-test-suite.h"
+#include "keyframe-shaper-test-suite.h"
+#include "video-generator-test-suite.h"
+#include "sent-packet-manager-test-suite.h"
 
 // Do not put your test classes in namespace ns3.  You may find it useful
 // to use the using directive to access the ns3 namespace directly
@@ -64,6 +80,28 @@ BbrTestSuite::BbrTestSuite ()
   AddTestCase (new PNQAddRemoveCase, TestCase::QUICK);
   AddTestCase (new PNQWrapAroundCase, TestCase::QUICK);
   AddTestCase (new PNIQTestCase, TestCase::QUICK);
+  AddTestCase (new ControllerPolicyTestCase, TestCase::QUICK);
+  AddTestCase (new RackLossAlgorithmTestCase, TestCase::QUICK);
+  AddTestCase (new FecCodecTestCase, TestCase::QUICK);
+  AddTestCase (new PacketHeaderTestCase, TestCase::QUICK);
+  AddTestCase (new AckFrameTestCase, TestCase::QUICK);
+  AddTestCase (new JitterBufferTestCase, TestCase::QUICK);
+  AddTestCase (new PacketTimeRingTestCase, TestCase::QUICK);
+  AddTestCase (new DeliveryRateEstimatorTestCase, TestCase::QUICK);
+  AddTestCase (new NackTrackerTestCase, TestCase::QUICK);
+  AddTestCase (new PicQueueTestCase, TestCase::QUICK);
+  AddTestCase (new EncoderRateControllerTestCase, TestCase::QUICK);
+  AddTestCase (new SendSchedulerTestCase, TestCase::QUICK);
+  AddTestCase (new LayerControllerTestCase, TestCase::QUICK);
+  AddTestCase (new KeyFrameShaperTestCase, TestCase::QUICK);
+  AddTestCase (new VideoGeneratorTestCase, TestCase::QUICK);
+  AddTestCase (new GopCodecTestCase, TestCase::QUICK);
+  AddTestCase (new SentPacketManagerSwitchTestCase, TestCase::QUICK);
+  AddTestCase (new SentPacketManagerPtoTestCase, TestCase::QUICK);
+  AddTestCase (new SentPacketManagerPtoExpiredTestCase, TestCase::QUICK);
+  AddTestCase (new SentPacketManagerUndoTestCase, TestCase::QUICK);
+  AddTestCase (new SentPacketManagerStartupTestCase, TestCase::QUICK);
+  AddTestCase (new SentPacketManagerExpiryTestCase, TestCase::QUICK);
 }
 
 // Do not forget to allocate an instance of this TestSuite
@@ -0,0 +1,108 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "../model/controller-policy.h"
+#include "../model/rtt-stats.h"
+
+// An essential include is test.h
+#include "ns3/test.h"
+
+// Do not put your test classes in namespace ns3.  You may find it useful
+// to use the using directive to access the ns3 namespace directly
+using namespace ns3;
+using namespace ns3::bbr;
+
+class ControllerPolicyTestCase : public TestCase
+{
+  public:
+    ControllerPolicyTestCase();
+    virtual ~ControllerPolicyTestCase() {}
+
+  private:
+    virtual void DoRun(void);
+};
+
+ControllerPolicyTestCase::ControllerPolicyTestCase()
+    : TestCase("controller policy path classification and switching")
+{
+}
+
+void ControllerPolicyTestCase::DoRun(void)
+{
+    RttStats rtt_stats;
+    rtt_stats.UpdateRtt(100, 0, 1000);
+    const Bandwidth bandwidth = Bandwidth::FromKBitsPerSecond(1000);
+
+    ControllerPolicy policy;
+    CongestionControlType target = kBBR;
+    NS_TEST_ASSERT_MSG_EQ(policy.path_class(), kPathUnknown, "classified without samples");
+
+    // 5% loss at a stable RTT, one event per round.
+    uint64_t now = 1000;
+    for (int i = 0; i < 3; ++i, now += 100)
+    {
+        policy.OnCongestionEvent(now, rtt_stats, bandwidth, 10000, 9500, 500);
+    }
+    NS_TEST_ASSERT_MSG_EQ(policy.path_class(), kPathUnknown, "classified before enough rounds");
+    for (int i = 0; i < 3; ++i, now += 100)
+    {
+        policy.OnCongestionEvent(now, rtt_stats, bandwidth, 10000, 9500, 500);
+    }
+    NS_TEST_ASSERT_MSG_EQ(policy.path_class(), kPathRandomLoss, "not classified as random loss");
+    NS_TEST_ASSERT_MSG_EQ(policy.ShouldSwitch(kBBR, now, &target), false, "switch to the same controller");
+
+    policy.SetControllerForPathClass(kPathRandomLoss, kCubicBytes);
+    NS_TEST_ASSERT_MSG_EQ(policy.ShouldSwitch(kBBR, now, &target), true, "no switch recommended");
+    NS_TEST_ASSERT_MSG_EQ(target, kCubicBytes, "wrong controller recommended");
+
+    // Hysteresis: no further switch within the dwell time.
+    policy.OnSwitched(now);
+    NS_TEST_ASSERT_MSG_EQ(policy.ShouldSwitch(kBBR, now + 1000, &target), false, "switched within dwell time");
+
+    // App-limited rounds are not classified.
+    for (int i = 0; i < 8; ++i, now += 100)
+    {
+        policy.OnApplicationLimited();
+        policy.OnCongestionEvent(now, rtt_stats, bandwidth, 10000, 10000, 0);
+    }
+    NS_TEST_ASSERT_MSG_EQ(policy.path_class(), kPathRandomLoss, "app-limited rounds were classified");
+
+    // RTT inflated by 100ms over a 12500 byte BDP.
+    RttStats inflated_rtt_stats;
+    inflated_rtt_stats.UpdateRtt(100, 0, 1000);
+    for (int i = 0; i < 50; ++i)
+    {
+        inflated_rtt_stats.UpdateRtt(200, 0, 1000);
+    }
+    const ByteCount bdp = 12500;
+
+    // The sender's own excess in flight explains the inflation, as while
+    // BBR probes, so the path is not bufferbloated.
+    ControllerPolicy own_queue_policy;
+    now = 1000;
+    for (int i = 0; i < 8; ++i, now += 200)
+    {
+        own_queue_policy.OnCongestionEvent(now, inflated_rtt_stats, bandwidth, 2 * bdp, 10000, 0);
+    }
+    NS_TEST_ASSERT_MSG_EQ(own_queue_policy.path_class(), kPathClean, "own queue taken for bufferbloat");
+
+    // Rounds in which the sender probes for bandwidth say nothing about
+    // queueing either.
+    ControllerPolicy probing_policy;
+    now = 1000;
+    for (int i = 0; i < 8; ++i, now += 200)
+    {
+        probing_policy.OnProbingForBandwidth();
+        probing_policy.OnCongestionEvent(now, inflated_rtt_stats, bandwidth, bdp, 10000, 0);
+    }
+    NS_TEST_ASSERT_MSG_EQ(probing_policy.path_class(), kPathClean, "probing rounds taken for bufferbloat");
+
+    // Queueing beyond what the sender has in flight is bufferbloat, and is
+    // still served by BBR rather than by a controller filling the queue.
+    for (int i = 0; i < 8; ++i, now += 200)
+    {
+        probing_policy.OnCongestionEvent(now, inflated_rtt_stats, bandwidth, bdp, 10000, 0);
+    }
+    NS_TEST_ASSERT_MSG_EQ(probing_policy.path_class(), kPathBufferbloat, "queueing not detected");
+    NS_TEST_ASSERT_MSG_EQ(probing_policy.ShouldSwitch(kBBR, now, &target), false,
+                          "switched away from BBR on bufferbloat");
+}
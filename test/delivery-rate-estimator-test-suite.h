@@ -0,0 +1,56 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "../model/delivery-rate-estimator.h"
+
+// An essential include is test.h
+#include "ns3/test.h"
+
+// Do not put your test classes in namespace ns3.  You may find it useful
+// to use the using directive to access the ns3 namespace directly
+using namespace ns3;
+using namespace ns3::bbr;
+
+class DeliveryRateEstimatorTestCase : public TestCase
+{
+  public:
+    DeliveryRateEstimatorTestCase();
+    virtual ~DeliveryRateEstimatorTestCase() {}
+
+  private:
+    virtual void DoRun(void);
+};
+
+DeliveryRateEstimatorTestCase::DeliveryRateEstimatorTestCase()
+    : TestCase("receiver delivery rate estimate")
+{
+}
+
+void DeliveryRateEstimatorTestCase::DoRun(void)
+{
+    DeliveryRateEstimator estimator;
+    uint64_t now = 1000000;
+    estimator.OnPacketReceived(now, 1000);
+    NS_TEST_ASSERT_MSG_EQ(estimator.GetDeliveryRate().IsZero(), true, "estimate from one packet");
+
+    // Frames of ten 1000 byte packets 1 ms apart, every 33 ms: the idle time
+    // between frames does not count.
+    for (int frame = 0; frame < 5; ++frame)
+    {
+        for (int k = 0; k < 10; ++k)
+        {
+            now += 1000;
+            estimator.OnPacketReceived(now, 1000);
+        }
+        now += 23000;
+    }
+    NS_TEST_ASSERT_MSG_EQ(estimator.GetDeliveryRate().ToBytesPerSecond(), 1000000, "idle gaps counted");
+
+    // The path slows down to 2 ms per packet, and the window forgets the
+    // faster arrivals.
+    for (int k = 0; k < 200; ++k)
+    {
+        now += 2000;
+        estimator.OnPacketReceived(now, 1000);
+    }
+    NS_TEST_ASSERT_MSG_EQ(estimator.GetDeliveryRate().ToBytesPerSecond(), 500000, "window not sliding");
+}
@@ -0,0 +1,74 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "../model/encoder-rate-controller.h"
+
+// An essential include is test.h
+#include "ns3/test.h"
+
+// Do not put your test classes in namespace ns3.  You may find it useful
+// to use the using directive to access the ns3 namespace directly
+using namespace ns3;
+using namespace ns3::bbr;
+
+class EncoderRateControllerTestCase : public TestCase
+{
+  public:
+    EncoderRateControllerTestCase();
+    virtual ~EncoderRateControllerTestCase() {}
+
+  private:
+    virtual void DoRun(void);
+};
+
+EncoderRateControllerTestCase::EncoderRateControllerTestCase()
+    : TestCase("encoder rate controller steps, backoff and hysteresis")
+{
+}
+
+void EncoderRateControllerTestCase::DoRun(void)
+{
+    EncoderRateController controller;
+    controller.Reset(Bandwidth::FromKBitsPerSecond(200));
+    Bandwidth target = Bandwidth::Zero();
+
+    // Increases are limited in size and in number per second.
+    NS_TEST_ASSERT_MSG_EQ(controller.OnUpdate(2000, Bandwidth::FromKBitsPerSecond(1000), 0, false, &target),
+                          true, "no increase below the bandwidth");
+    NS_TEST_ASSERT_MSG_EQ(target.ToKBitsPerSecond(), 220, "increase not limited to one step");
+    NS_TEST_ASSERT_MSG_EQ(controller.OnUpdate(2100, Bandwidth::FromKBitsPerSecond(1000), 0, false, &target),
+                          false, "increase budget not enforced");
+    NS_TEST_ASSERT_MSG_EQ(controller.OnUpdate(2500, Bandwidth::FromKBitsPerSecond(1000), 0, false, &target),
+                          true, "no increase after the budget interval");
+    NS_TEST_ASSERT_MSG_EQ(target.ToKBitsPerSecond(), 242, "wrong second step");
+
+    // A drop of the bandwidth is followed at once, with headroom.
+    NS_TEST_ASSERT_MSG_EQ(controller.OnUpdate(2600, Bandwidth::FromKBitsPerSecond(200), 0, false, &target),
+                          true, "no decrease on a bandwidth drop");
+    NS_TEST_ASSERT_MSG_EQ(target.ToKBitsPerSecond(), 180, "headroom not applied");
+    NS_TEST_ASSERT_MSG_EQ(controller.OnUpdate(3000, Bandwidth::FromKBitsPerSecond(1000), 0, false, &target),
+                          false, "increase right after a decrease");
+
+    // Changes within the hysteresis band are ignored.
+    NS_TEST_ASSERT_MSG_EQ(controller.OnUpdate(3100, Bandwidth::FromKBitsPerSecond(195), 0, false, &target),
+                          false, "retuned within the hysteresis band");
+
+    // A frame queue older than the target halves the rate at most, then
+    // gets time to drain.
+    NS_TEST_ASSERT_MSG_EQ(controller.OnUpdate(4000, Bandwidth::FromKBitsPerSecond(1000), 300, false, &target),
+                          true, "no backoff on queue delay");
+    NS_TEST_ASSERT_MSG_EQ(target.ToKBitsPerSecond(), 100, "backoff not bounded by the minimum rate");
+    NS_TEST_ASSERT_MSG_EQ(controller.OnUpdate(4050, Bandwidth::FromKBitsPerSecond(1000), 300, false, &target),
+                          false, "queue not given time to drain");
+
+    // A new flow may increase at once, there was no decrease to hold for.
+    controller.Reset(Bandwidth::FromKBitsPerSecond(200));
+    NS_TEST_ASSERT_MSG_EQ(controller.OnUpdate(100, Bandwidth::FromKBitsPerSecond(1000), 0, false, &target),
+                          true, "first increase held back");
+    NS_TEST_ASSERT_MSG_EQ(target.ToKBitsPerSecond(), 220, "wrong first step");
+
+    // App-limited estimates only measure the encoder, so the rate is probed upward.
+    controller.Reset(Bandwidth::FromKBitsPerSecond(1000));
+    NS_TEST_ASSERT_MSG_EQ(controller.OnUpdate(2000, Bandwidth::FromKBitsPerSecond(1000), 0, true, &target),
+                          true, "no probing while app-limited");
+    NS_TEST_ASSERT_MSG_EQ(target.ToKBitsPerSecond(), 1100, "wrong probing step");
+}
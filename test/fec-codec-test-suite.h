@@ -0,0 +1,91 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "../model/fec-codec.h"
+#include "../model/udp-bbr-constants.h"
+
+// An essential include is test.h
+#include "ns3/test.h"
+
+// Do not put your test classes in namespace ns3.  You may find it useful
+// to use the using directive to access the ns3 namespace directly
+using namespace ns3;
+using namespace ns3::bbr;
+
+class FecCodecTestCase : public TestCase
+{
+  public:
+    FecCodecTestCase();
+    virtual ~FecCodecTestCase() {}
+
+  private:
+    virtual void DoRun(void);
+};
+
+FecCodecTestCase::FecCodecTestCase()
+    : TestCase("fec redundancy adaptation and frame recovery")
+{
+}
+
+void FecCodecTestCase::DoRun(void)
+{
+    FecEncoder encoder;
+    encoder.set_scheme(kFecReedSolomon);
+    ConnectionStats stats;
+    std::deque<FecRepairPacket> repairs;
+
+    // No repair packets on a loss-free path.
+    stats.packets_sent = 100;
+    encoder.UpdateLossRate(stats);
+    NS_TEST_ASSERT_MSG_EQ(encoder.GetNumRepairPackets(10), 0u, "repair packets without loss");
+
+    // 10% loss, half of it recovered by the peer.
+    stats.packets_sent = 200;
+    stats.packets_lost = 5;
+    stats.packets_fec_recovered = 5;
+    encoder.UpdateLossRate(stats);
+    NS_TEST_ASSERT_MSG_EQ(encoder.GetNumRepairPackets(10), 1u, "wrong redundancy for 10 packets");
+    NS_TEST_ASSERT_MSG_EQ(encoder.GetNumRepairPackets(20), 2u, "wrong redundancy for 20 packets");
+
+    // Frame 7 of four packets sent as packets 11-14.
+    for (uint16_t seq = 0; seq < 4; ++seq)
+    {
+        PacketHeader header;
+        header.m_packet_seq = 11 + seq;
+        header.m_data_length = 1000;
+        header.m_data_packet = std::make_shared<PicDataPacket>();
+        header.m_data_packet->PicIndex = 7;
+        header.m_data_packet->PicPktNum = 4;
+        header.m_data_packet->PicCurPktSeq = seq;
+        encoder.OnSourcePacketSent(header, &repairs);
+    }
+    NS_TEST_ASSERT_MSG_EQ(repairs.size(), 1u, "no repair packet after the last source packet");
+    NS_TEST_ASSERT_MSG_EQ(repairs.front().header.PicType, pic_type_fec, "repair packet not marked");
+    NS_TEST_ASSERT_MSG_EQ(repairs.front().frame.protected_packets.size(), 4u, "wrong protected packets");
+
+    // Reed-Solomon restores a lost packet from any repair packet.
+    FecDecoder decoder;
+    FecDecoder::RecoveredVector recovered;
+    decoder.OnSourcePacket(7, 4, 0, &recovered);
+    decoder.OnSourcePacket(7, 4, 1, &recovered);
+    decoder.OnSourcePacket(7, 4, 3, &recovered);
+    decoder.OnRepairPacket(7, 4, repairs.front().frame, &recovered);
+    NS_TEST_ASSERT_MSG_EQ(recovered.size(), 1u, "lost packet not recovered");
+    NS_TEST_ASSERT_MSG_EQ(recovered.front().first, 13u, "wrong packet number recovered");
+    NS_TEST_ASSERT_MSG_EQ(recovered.front().second, 2u, "wrong packet recovered");
+
+    // XOR parities restore one packet of each class.
+    FecFrame parity;
+    parity.scheme = kFecXor;
+    parity.num_repair = 2;
+    parity.protected_packets = repairs.front().frame.protected_packets;
+    recovered.clear();
+    decoder.OnSourcePacket(8, 4, 0, &recovered);
+    parity.repair_index = 0;
+    decoder.OnRepairPacket(8, 4, parity, &recovered);
+    parity.repair_index = 1;
+    decoder.OnRepairPacket(8, 4, parity, &recovered);
+    NS_TEST_ASSERT_MSG_EQ(recovered.size(), 1u, "two losses of one class recovered");
+    decoder.OnSourcePacket(8, 4, 1, &recovered);
+    NS_TEST_ASSERT_MSG_EQ(recovered.size(), 2u, "parity not used after a late packet");
+    NS_TEST_ASSERT_MSG_EQ(decoder.packets_recovered(), 3u, "wrong recovered count");
+}
@@ -0,0 +1,131 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "../model/frame-assembler.h"
+#include "../model/jitter-buffer.h"
+#include "../model/udp-bbr-constants.h"
+
+// An essential include is test.h
+#include "ns3/test.h"
+
+// Do not put your test classes in namespace ns3.  You may find it useful
+// to use the using directive to access the ns3 namespace directly
+using namespace ns3;
+using namespace ns3::bbr;
+
+class JitterBufferTestCase : public TestCase
+{
+  public:
+    JitterBufferTestCase();
+    virtual ~JitterBufferTestCase() {}
+
+  private:
+    virtual void DoRun(void);
+
+    // Delivers every packet of frame |pic_index| at |now|.
+    void CompleteFrame(PacketNumber pic_index, uint64_t now);
+
+    FrameAssembler assembler_;
+    JitterBuffer jitter_buffer_;
+};
+
+namespace
+{
+// Frames of three packets, generated every 33 ms.
+PacketHeader MakeFrameHeader(PacketNumber pic_index)
+{
+    PacketHeader header;
+    header.PicType = pic_type_real;
+    header.PicIndex = pic_index;
+    header.PicDataLen = 3000;
+    header.PicPktNum = 3;
+    header.PicGenTime = pic_index * 33;
+    return header;
+}
+}
+
+JitterBufferTestCase::JitterBufferTestCase()
+    : TestCase("frame reassembly and playout")
+{
+}
+
+void JitterBufferTestCase::CompleteFrame(PacketNumber pic_index, uint64_t now)
+{
+    const PacketHeader header = MakeFrameHeader(pic_index);
+    AssembledFrame frame;
+    for (uint16_t seq = 0; seq < header.PicPktNum; ++seq)
+    {
+        if (assembler_.OnPacket(header, seq, now, &frame))
+        {
+            jitter_buffer_.OnFrameComplete(frame);
+        }
+    }
+}
+
+void JitterBufferTestCase::DoRun(void)
+{
+    jitter_buffer_.SetPlayoutDelayBounds(100, 100);
+
+    // Frame 0 completes with its last packet to arrive, not its last one.
+    const PacketHeader header = MakeFrameHeader(0);
+    AssembledFrame frame;
+    NS_TEST_ASSERT_MSG_EQ(assembler_.OnPacket(header, 2, 20, &frame), false, "complete after one packet");
+    NS_TEST_ASSERT_MSG_EQ(assembler_.OnPacket(header, 0, 22, &frame), false, "complete after two packets");
+    NS_TEST_ASSERT_MSG_EQ(assembler_.OnPacket(header, 0, 23, &frame), false, "duplicate completes the frame");
+    NS_TEST_ASSERT_MSG_EQ(assembler_.OnPacket(header, 1, 25, &frame), true, "frame not complete");
+    NS_TEST_ASSERT_MSG_EQ(frame.complete_time, 25u, "wrong completion time");
+    NS_TEST_ASSERT_MSG_EQ(frame.first_packet_time, 20u, "wrong first packet time");
+    NS_TEST_ASSERT_MSG_EQ(assembler_.OnPacket(header, 2, 30, &frame), false, "frame completed twice");
+    jitter_buffer_.OnFrameComplete(frame);
+
+    // Frame 2 never completes.
+    CompleteFrame(1, 60);
+    PacketHeader lost = MakeFrameHeader(2);
+    NS_TEST_ASSERT_MSG_EQ(assembler_.OnPacket(lost, 0, 90, &frame), false, "incomplete frame completed");
+    CompleteFrame(3, 120);
+    CompleteFrame(4, 150);
+
+    jitter_buffer_.Update(99);
+    NS_TEST_ASSERT_MSG_EQ(jitter_buffer_.stats().frames_rendered, 0u, "frame rendered early");
+    jitter_buffer_.Update(133);
+    NS_TEST_ASSERT_MSG_EQ(jitter_buffer_.stats().frames_rendered, 2u, "frames not rendered when due");
+
+    // Frame 3 waits one frame interval for frame 2, then frame 2 is skipped.
+    jitter_buffer_.Update(220);
+    NS_TEST_ASSERT_MSG_EQ(jitter_buffer_.stats().frames_rendered, 2u, "missing frame not waited for");
+    jitter_buffer_.Update(233);
+    NS_TEST_ASSERT_MSG_EQ(jitter_buffer_.stats().frames_rendered, 4u, "frames after a gap not rendered");
+    NS_TEST_ASSERT_MSG_EQ(jitter_buffer_.stats().frames_skipped, 1u, "missing frame not skipped");
+    NS_TEST_ASSERT_MSG_EQ(jitter_buffer_.stats().freeze_count, 0u, "skip taken for a freeze");
+
+    // Frame 5 completes 268 ms after the last render: a freeze.
+    CompleteFrame(5, 500);
+    jitter_buffer_.Update(500);
+    NS_TEST_ASSERT_MSG_EQ(jitter_buffer_.stats().freeze_count, 1u, "freeze not detected");
+    NS_TEST_ASSERT_MSG_EQ(jitter_buffer_.stats().total_freeze_duration, 268u, "wrong freeze duration");
+    NS_TEST_ASSERT_MSG_EQ(jitter_buffer_.stats().frames_late, 1u, "late frame not counted");
+
+    // Frame 6 expired at the sender, so frame 7 does not wait for it.
+    NS_TEST_ASSERT_MSG_EQ(assembler_.OnPacket(MakeFrameHeader(6), 0, 505, &frame), false, "frame completed");
+    NS_TEST_ASSERT_MSG_EQ(assembler_.RemoveFramesBefore(7), 2u, "incomplete frames not dropped");
+    NS_TEST_ASSERT_MSG_EQ(assembler_.OnPacket(MakeFrameHeader(6), 1, 506, &frame), false, "expired frame kept");
+    jitter_buffer_.OnFramesExpired(7);
+    CompleteFrame(7, 520);
+    jitter_buffer_.Update(520);
+    NS_TEST_ASSERT_MSG_EQ(jitter_buffer_.stats().frames_rendered, 6u, "frame after expired one not rendered");
+    NS_TEST_ASSERT_MSG_EQ(jitter_buffer_.stats().frames_skipped, 2u, "expired frame not skipped");
+    NS_TEST_ASSERT_MSG_EQ(jitter_buffer_.stats().frames_completed, 6u, "wrong completed frames");
+    NS_TEST_ASSERT_MSG_EQ(jitter_buffer_.stats().max_completion_latency, 335u, "wrong max latency");
+
+    // Frames 8-19 expired and frame 20 is due at 760: the skip is counted
+    // once, when frame 20 renders, however often the buffer is updated.
+    jitter_buffer_.OnFramesExpired(20);
+    CompleteFrame(20, 600);
+    jitter_buffer_.Update(600);
+    jitter_buffer_.Update(700);
+    jitter_buffer_.Update(759);
+    NS_TEST_ASSERT_MSG_EQ(jitter_buffer_.stats().frames_rendered, 6u, "frame rendered before it is due");
+    NS_TEST_ASSERT_MSG_EQ(jitter_buffer_.stats().frames_skipped, 2u, "skip counted before the render");
+    jitter_buffer_.Update(760);
+    NS_TEST_ASSERT_MSG_EQ(jitter_buffer_.stats().frames_rendered, 7u, "frame not rendered when due");
+    NS_TEST_ASSERT_MSG_EQ(jitter_buffer_.stats().frames_skipped, 14u, "expired frames skipped more than once");
+}
@@ -0,0 +1,77 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "../model/keyframe-shaper.h"
+
+// An essential include is test.h
+#include "ns3/test.h"
+
+// Do not put your test classes in namespace ns3.  You may find it useful
+// to use the using directive to access the ns3 namespace directly
+using namespace ns3;
+using namespace ns3::bbr;
+
+class KeyFrameShaperTestCase : public TestCase
+{
+  public:
+    KeyFrameShaperTestCase();
+    virtual ~KeyFrameShaperTestCase() {}
+
+  private:
+    virtual void DoRun(void);
+};
+
+KeyFrameShaperTestCase::KeyFrameShaperTestCase()
+    : TestCase("keyframe shaper tells keyframes and spreads them")
+{
+}
+
+void KeyFrameShaperTestCase::DoRun(void)
+{
+    KeyFrameShaper shaper;
+    shaper.set_shaping(kKeyFrameSpread);
+    shaper.set_spread_frames(4);
+    ShapedFrame frame;
+
+    // The first frame is a keyframe, but is sent at once.
+    shaper.OnFrame(20000, false, &frame);
+    NS_TEST_ASSERT_MSG_EQ(frame.key_frame, true, "first frame not a keyframe");
+    NS_TEST_ASSERT_MSG_EQ(frame.release_frames, 0u, "first frame spread");
+    for (int i = 0; i < 10; ++i)
+    {
+        shaper.OnFrame(4000, false, &frame);
+        NS_TEST_ASSERT_MSG_EQ(frame.key_frame, false, "small frame taken for a keyframe");
+    }
+    NS_TEST_ASSERT_MSG_EQ(shaper.average_frame_bytes(), 4000u, "wrong average frame size");
+
+    // A large frame is a keyframe even if the codec does not say so.
+    shaper.OnFrame(20000, false, &frame);
+    NS_TEST_ASSERT_MSG_EQ(frame.key_frame, true, "large frame not a keyframe");
+    NS_TEST_ASSERT_MSG_EQ(frame.release_frames, 4u, "keyframe not spread");
+    NS_TEST_ASSERT_MSG_EQ(frame.bytes, 20000u, "spread keyframe resized");
+    shaper.OnFrame(5000, true, &frame);
+    NS_TEST_ASSERT_MSG_EQ(frame.release_frames, 4u, "keyframe of the codec not spread");
+    NS_TEST_ASSERT_MSG_EQ(shaper.average_frame_bytes(), 4000u, "keyframes averaged");
+
+    // Intra refresh moves the excess of a keyframe to it and the next frames.
+    shaper.set_shaping(kKeyFrameIntraRefresh);
+    ByteCount total = 0;
+    shaper.OnFrame(20000, false, &frame);
+    NS_TEST_ASSERT_MSG_EQ(frame.release_frames, 0u, "refreshed keyframe spread");
+    NS_TEST_ASSERT_MSG_EQ(frame.bytes, 8000u, "wrong refreshed keyframe size");
+    total += frame.bytes;
+    for (int i = 0; i < 3; ++i)
+    {
+        shaper.OnFrame(4000, false, &frame);
+        NS_TEST_ASSERT_MSG_EQ(frame.key_frame, true, "frame with intra data not a keyframe");
+        total += frame.bytes;
+    }
+    NS_TEST_ASSERT_MSG_EQ(total, 32000u, "intra data lost");
+    shaper.OnFrame(4000, false, &frame);
+    NS_TEST_ASSERT_MSG_EQ(frame.key_frame, false, "refresh longer than the spread");
+    NS_TEST_ASSERT_MSG_EQ(frame.bytes, 4000u, "frame resized after the refresh");
+
+    // Nothing is reshaped after a reset, until the average is known again.
+    shaper.Reset();
+    shaper.OnFrame(20000, false, &frame);
+    NS_TEST_ASSERT_MSG_EQ(frame.bytes, 20000u, "first frame after a reset resized");
+}
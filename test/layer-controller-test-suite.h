@@ -0,0 +1,77 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "../model/layer-controller.h"
+
+// An essential include is test.h
+#include "ns3/test.h"
+
+// Do not put your test classes in namespace ns3.  You may find it useful
+// to use the using directive to access the ns3 namespace directly
+using namespace ns3;
+using namespace ns3::bbr;
+
+class LayerControllerTestCase : public TestCase
+{
+  public:
+    LayerControllerTestCase();
+    virtual ~LayerControllerTestCase() {}
+
+  private:
+    virtual void DoRun(void);
+};
+
+LayerControllerTestCase::LayerControllerTestCase()
+    : TestCase("layer controller drops at once and adds back slowly")
+{
+}
+
+void LayerControllerTestCase::DoRun(void)
+{
+    LayerController controller;
+    controller.Reset(3);
+    size_t layers = 0;
+    // Layers 0..i together need 300, 1000 and 2000 kbps.
+    std::vector<Bandwidth> rates;
+    rates.push_back(Bandwidth::FromKBitsPerSecond(300));
+    rates.push_back(Bandwidth::FromKBitsPerSecond(1000));
+    rates.push_back(Bandwidth::FromKBitsPerSecond(2000));
+
+    NS_TEST_ASSERT_MSG_EQ(controller.OnUpdate(1000, Bandwidth::FromKBitsPerSecond(2500), 0, false, rates, &layers),
+                          false, "layers changed with enough bandwidth");
+
+    // A bandwidth drop removes every layer above it at once.
+    NS_TEST_ASSERT_MSG_EQ(controller.OnUpdate(1100, Bandwidth::FromKBitsPerSecond(500), 0, false, rates, &layers),
+                          true, "layers kept above the bandwidth");
+    NS_TEST_ASSERT_MSG_EQ(layers, 1u, "not dropped down to the base layer");
+    NS_TEST_ASSERT_MSG_EQ(controller.OnUpdate(1200, Bandwidth::FromKBitsPerSecond(100), 1000, false, rates, &layers),
+                          false, "base layer dropped");
+
+    // Layers come back one at a time, after a hold time and with headroom.
+    NS_TEST_ASSERT_MSG_EQ(controller.OnUpdate(2000, Bandwidth::FromKBitsPerSecond(2500), 0, false, rates, &layers),
+                          false, "layer added during the hold time");
+    NS_TEST_ASSERT_MSG_EQ(controller.OnUpdate(3200, Bandwidth::FromKBitsPerSecond(1050), 0, false, rates, &layers),
+                          false, "layer added without headroom");
+    NS_TEST_ASSERT_MSG_EQ(controller.OnUpdate(3300, Bandwidth::FromKBitsPerSecond(2500), 0, false, rates, &layers),
+                          true, "layer not added back");
+    NS_TEST_ASSERT_MSG_EQ(layers, 2u, "more than one layer added");
+    NS_TEST_ASSERT_MSG_EQ(controller.OnUpdate(3400, Bandwidth::FromKBitsPerSecond(2500), 0, false, rates, &layers),
+                          false, "layers added too often");
+    NS_TEST_ASSERT_MSG_EQ(controller.OnUpdate(4300, Bandwidth::FromKBitsPerSecond(2500), 0, false, rates, &layers),
+                          true, "top layer not added back");
+    NS_TEST_ASSERT_MSG_EQ(layers, 3u, "wrong layer count");
+
+    // A long frame queue drops one layer per target queue delay.
+    NS_TEST_ASSERT_MSG_EQ(controller.OnUpdate(5000, Bandwidth::FromKBitsPerSecond(2500), 150, false, rates, &layers),
+                          true, "layer kept with a long queue");
+    NS_TEST_ASSERT_MSG_EQ(layers, 2u, "more than one layer dropped");
+    NS_TEST_ASSERT_MSG_EQ(controller.OnUpdate(5050, Bandwidth::FromKBitsPerSecond(2500), 150, false, rates, &layers),
+                          false, "queue not given time to drain");
+    NS_TEST_ASSERT_MSG_EQ(controller.OnUpdate(5100, Bandwidth::FromKBitsPerSecond(2500), 150, false, rates, &layers),
+                          true, "layer kept with a lasting queue");
+    NS_TEST_ASSERT_MSG_EQ(layers, 1u, "wrong layer count");
+
+    // App-limited estimates never drop a layer.
+    controller.Reset(3);
+    NS_TEST_ASSERT_MSG_EQ(controller.OnUpdate(1000, Bandwidth::FromKBitsPerSecond(500), 0, true, rates, &layers),
+                          false, "layer dropped on an app-limited estimate");
+}
@@ -0,0 +1,131 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "../model/nack-frame.h"
+#include "../model/nack-tracker.h"
+#include "../model/received-packet-manager.h"
+
+// An essential include is test.h
+#include "ns3/test.h"
+
+// Do not put your test classes in namespace ns3.  You may find it useful
+// to use the using directive to access the ns3 namespace directly
+using namespace ns3;
+using namespace ns3::bbr;
+
+class NackTrackerTestCase : public TestCase
+{
+  public:
+    NackTrackerTestCase();
+    virtual ~NackTrackerTestCase() {}
+
+  private:
+    virtual void DoRun(void);
+
+    // Receives packet |pic_cur_pkt_seq| of |pic_index| as |packet_number|
+    // and returns the packets nacked.
+    std::vector<PacketNumber> Receive(PacketNumber pic_index, uint16_t pic_cur_pkt_seq, PacketNumber packet_number);
+    // Receives |packet_number| of another stream of the connection.
+    void ReceiveOther(PacketNumber packet_number);
+    // Receives a repair packet of the stream as |packet_number|.
+    void ReceiveRepair(PacketNumber packet_number);
+
+    ReceivedPacketManager manager_;
+    NackTracker tracker_;
+};
+
+NackTrackerTestCase::NackTrackerTestCase()
+    : TestCase("receiver nacks of packets missing within a frame")
+{
+}
+
+std::vector<PacketNumber> NackTrackerTestCase::Receive(PacketNumber pic_index,
+                                                       uint16_t pic_cur_pkt_seq,
+                                                       PacketNumber packet_number)
+{
+    PacketHeader header;
+    header.m_packet_seq = packet_number;
+    manager_.RecordPacketReceived(header, packet_number * 1000);
+    tracker_.OnFramePacket(pic_index, pic_cur_pkt_seq, packet_number, &manager_);
+    NackFrame frame;
+    tracker_.GetNackFrame(&manager_, &frame);
+    return frame.missing_packets;
+}
+
+void NackTrackerTestCase::ReceiveOther(PacketNumber packet_number)
+{
+    PacketHeader header;
+    header.m_packet_seq = packet_number;
+    manager_.RecordPacketReceived(header, packet_number * 1000);
+}
+
+void NackTrackerTestCase::ReceiveRepair(PacketNumber packet_number)
+{
+    ReceiveOther(packet_number);
+    tracker_.OnRepairPacket(packet_number);
+}
+
+void NackTrackerTestCase::DoRun(void)
+{
+    // Frame 5 sent as packets 10-14, 11 lost.
+    NS_TEST_ASSERT_MSG_EQ(Receive(5, 0, 10).empty(), true, "nack without a gap");
+    NS_TEST_ASSERT_MSG_EQ(Receive(5, 2, 12).empty(), true, "nack within the reordering threshold");
+    std::vector<PacketNumber> nacked = Receive(5, 3, 13);
+    NS_TEST_ASSERT_MSG_EQ(nacked.size(), 1u, "gap not nacked");
+    NS_TEST_ASSERT_MSG_EQ(nacked[0], 11u, "wrong packet nacked");
+    NS_TEST_ASSERT_MSG_EQ(Receive(5, 4, 14).empty(), true, "packet nacked twice");
+
+    // Frame 6 sent as packets 15-18, its first two packets lost.
+    nacked = Receive(6, 2, 17);
+    NS_TEST_ASSERT_MSG_EQ(nacked.size(), 1u, "leading gap not nacked");
+    NS_TEST_ASSERT_MSG_EQ(nacked[0], 15u, "wrong leading packet nacked");
+    nacked = Receive(6, 3, 18);
+    NS_TEST_ASSERT_MSG_EQ(nacked.size(), 1u, "second leading packet not nacked");
+    NS_TEST_ASSERT_MSG_EQ(nacked[0], 16u, "wrong second leading packet nacked");
+    NS_TEST_ASSERT_MSG_EQ(tracker_.packets_nacked(), 3u, "wrong nacked count");
+
+    // From here on the packets of another stream interleave with the frames.
+    // Frame 7 sent as packets 20, 22, 24 and 26; 22 and the other stream's 23
+    // lost.  The gap holds two missing packets for one skipped in the frame.
+    ReceiveOther(19);
+    NS_TEST_ASSERT_MSG_EQ(Receive(7, 0, 20).empty(), true, "nack without a gap");
+    ReceiveOther(21);
+    NS_TEST_ASSERT_MSG_EQ(Receive(7, 2, 24).empty(), true, "ambiguous gap nacked");
+    ReceiveOther(25);
+    NS_TEST_ASSERT_MSG_EQ(Receive(7, 3, 26).empty(), true, "ambiguous gap nacked late");
+
+    // Frame 8 sent as packets 28 and 30, 28 lost.  Its leading gap reaches
+    // back past the other stream's 29 and 27.
+    ReceiveOther(27);
+    ReceiveOther(29);
+    nacked = Receive(8, 1, 30);
+    NS_TEST_ASSERT_MSG_EQ(nacked.size(), 1u, "interleaved leading gap not nacked");
+    NS_TEST_ASSERT_MSG_EQ(nacked[0], 28u, "wrong interleaved leading packet nacked");
+
+    // Frame 9 sent as packets 31, 33 and 34, the other stream's 32 lost.
+    NS_TEST_ASSERT_MSG_EQ(Receive(9, 0, 31).empty(), true, "nack without a gap");
+    NS_TEST_ASSERT_MSG_EQ(Receive(9, 1, 33).empty(), true, "other stream's packet nacked");
+    NS_TEST_ASSERT_MSG_EQ(Receive(9, 2, 34).empty(), true, "other stream's packet nacked late");
+
+    // Frame 10 sent as packets 35, 36, 38 and 39 with repair packet 37; 36
+    // lost and left to the repair packet.
+    NS_TEST_ASSERT_MSG_EQ(Receive(10, 0, 35).empty(), true, "nack without a gap");
+    ReceiveRepair(37);
+    NS_TEST_ASSERT_MSG_EQ(Receive(10, 2, 38).empty(), true, "gap with a repair packet nacked");
+    NS_TEST_ASSERT_MSG_EQ(Receive(10, 3, 39).empty(), true, "gap with a repair packet nacked late");
+    NS_TEST_ASSERT_MSG_EQ(tracker_.packets_nacked(), 4u, "wrong interleaved nacked count");
+
+    NackFrame frame;
+    frame.connection_id = 7;
+    frame.missing_packets.push_back(1000000);
+    frame.missing_packets.push_back(1000001);
+    frame.missing_packets.push_back(1000010);
+    Buffer buffer;
+    buffer.AddAtStart(frame.GetSerializedSize());
+    frame.Serialize(buffer.Begin());
+    NackFrame decoded;
+    NS_TEST_ASSERT_MSG_EQ(decoded.Deserialize(buffer.Begin()), frame.GetSerializedSize(), "wrong size");
+    NS_TEST_ASSERT_MSG_EQ(frame.GetSerializedSize(), 9u, "nack frame not compact");
+    NS_TEST_ASSERT_MSG_EQ(decoded.connection_id, 7u, "wrong connection id");
+    NS_TEST_ASSERT_MSG_EQ(decoded.missing_packets.size(), 3u, "packets lost");
+    NS_TEST_ASSERT_MSG_EQ(decoded.missing_packets[2], 1000010u, "wrong packet");
+}
@@ -0,0 +1,145 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "../model/packet-header.h"
+#include "../model/udp-bbr-constants.h"
+
+// An essential include is test.h
+#include "ns3/test.h"
+
+// Do not put your test classes in namespace ns3.  You may find it useful
+// to use the using directive to access the ns3 namespace directly
+using namespace ns3;
+using namespace ns3::bbr;
+
+class PacketHeaderTestCase : public TestCase
+{
+  public:
+    PacketHeaderTestCase();
+    virtual ~PacketHeaderTestCase() {}
+
+  private:
+    virtual void DoRun(void);
+
+    // Serializes |header| and deserializes it with |context|.  Returns the
+    // serialized size.
+    uint32_t RoundTrip(const PacketHeader &header, PacketHeaderContext *context, PacketHeader *decoded);
+};
+
+PacketHeaderTestCase::PacketHeaderTestCase()
+    : TestCase("compact packet header encoding")
+{
+}
+
+uint32_t PacketHeaderTestCase::RoundTrip(const PacketHeader &header,
+                                         PacketHeaderContext *context,
+                                         PacketHeader *decoded)
+{
+    Buffer buffer;
+    buffer.AddAtStart(header.GetSerializedSize());
+    header.Serialize(buffer.Begin());
+    decoded->m_context = context;
+    const uint32_t size = decoded->Deserialize(buffer.Begin());
+    NS_TEST_EXPECT_MSG_EQ(size, header.GetSerializedSize(), "wrong deserialized size");
+    return size;
+}
+
+void PacketHeaderTestCase::DoRun(void)
+{
+    // The example of RFC 9000, appendix A.3.
+    NS_TEST_ASSERT_MSG_EQ(DecodePacketNumber(0x9b32, 2, 0xa82f30ea), 0xa82f9b32u, "wrong packet number");
+    NS_TEST_ASSERT_MSG_EQ(GetPacketNumberLength(0xac5c02, 0xabe8b3), 2u, "wrong packet number length");
+    NS_TEST_ASSERT_MSG_EQ(GetPacketNumberLength(0xace8fe, 0xabe8b3), 4u, "wrong packet number length");
+
+    // The receiver has seen every packet the sender knows is acked.
+    PacketHeaderContext context;
+    context.OnPacketNumber(99990);
+    PacketHeader first;
+    first.m_connection_id = 42;
+    first.m_packet_seq = 100000;
+    first.m_largest_acked = 99950;
+    first.m_sent_time = 20015;
+    first.m_data_seq = 90000;
+    first.m_least_unexpired_pic = 598;
+    first.PicType = pic_type_real;
+    first.PicIndex = 600;
+    first.PicDataLen = 12000;
+    first.PicPktNum = 10;
+    first.PicCurPktSeq = 0;
+    first.PicGenTime = 20000;
+
+    // The first packet of a frame carries its metadata.
+    PacketHeader decoded;
+    const uint32_t first_size = RoundTrip(first, &context, &decoded);
+    NS_TEST_ASSERT_MSG_EQ(first_size < 24, true, "first packet header too large");
+    NS_TEST_ASSERT_MSG_EQ(decoded.m_connection_id, first.m_connection_id, "wrong connection id");
+    NS_TEST_ASSERT_MSG_EQ(decoded.m_packet_seq, first.m_packet_seq, "wrong packet number");
+    NS_TEST_ASSERT_MSG_EQ(decoded.m_largest_acked, first.m_largest_acked, "wrong largest acked");
+    NS_TEST_ASSERT_MSG_EQ(decoded.m_sent_time, first.m_sent_time, "wrong sent time");
+    NS_TEST_ASSERT_MSG_EQ(decoded.m_data_seq, first.m_data_seq, "wrong data seq");
+    NS_TEST_ASSERT_MSG_EQ(decoded.m_least_unexpired_pic, first.m_least_unexpired_pic, "wrong least unexpired pic");
+    NS_TEST_ASSERT_MSG_EQ(decoded.PicDataLen, first.PicDataLen, "wrong PicDataLen");
+    NS_TEST_ASSERT_MSG_EQ(decoded.PicPktNum, first.PicPktNum, "wrong PicPktNum");
+    NS_TEST_ASSERT_MSG_EQ(decoded.PicGenTime, first.PicGenTime, "wrong PicGenTime");
+
+    // The next ones leave it to the receiver.
+    PacketHeader second = first;
+    second.m_packet_seq = 100001;
+    second.m_data_seq = 90001;
+    second.m_sent_time = 20016;
+    second.PicCurPktSeq = 1;
+    PacketHeader decoded_second;
+    const uint32_t second_size = RoundTrip(second, &context, &decoded_second);
+    NS_TEST_ASSERT_MSG_EQ(second_size < first_size, true, "metadata sent twice");
+    NS_TEST_ASSERT_MSG_EQ(decoded_second.m_has_frame_metadata, true, "metadata not restored");
+    NS_TEST_ASSERT_MSG_EQ(decoded_second.PicPktNum, first.PicPktNum, "wrong restored PicPktNum");
+    NS_TEST_ASSERT_MSG_EQ(decoded_second.m_sent_time, second.m_sent_time, "wrong restored sent time");
+    NS_TEST_ASSERT_MSG_EQ(decoded_second.PicCurPktSeq, 1u, "wrong PicCurPktSeq");
+
+    // A packet of a frame whose first packet is missing waits for it.
+    PacketHeader other = second;
+    other.m_packet_seq = 100003;
+    other.PicIndex = 601;
+    other.PicGenTime = 20033;
+    other.m_sent_time = 20040;
+    PacketHeader decoded_other;
+    RoundTrip(other, &context, &decoded_other);
+    NS_TEST_ASSERT_MSG_EQ(decoded_other.m_has_frame_metadata, false, "unknown metadata restored");
+    NS_TEST_ASSERT_MSG_EQ(decoded_other.m_packet_seq, other.m_packet_seq, "wrong packet number");
+
+    PacketHeader retransmission = other;
+    retransmission.m_packet_seq = 100004;
+    retransmission.PicCurPktSeq = 0;
+    PacketHeader decoded_retransmission;
+    RoundTrip(retransmission, &context, &decoded_retransmission);
+    NS_TEST_ASSERT_MSG_EQ(context.ExpandFrameMetadata(&decoded_other), true, "metadata not recorded");
+    NS_TEST_ASSERT_MSG_EQ(decoded_other.PicGenTime, other.PicGenTime, "wrong restored PicGenTime");
+    NS_TEST_ASSERT_MSG_EQ(decoded_other.m_sent_time, other.m_sent_time, "wrong restored sent time");
+
+    // Another stream numbers its pics on its own, at the cost of its ID.
+    PacketHeader audio = first;
+    audio.m_packet_seq = 100005;
+    audio.m_stream_id = 1;
+    audio.PicIndex = 600;
+    audio.PicDataLen = 80;
+    audio.PicPktNum = 1;
+    audio.PicGenTime = 20050;
+    audio.m_sent_time = 20050;
+    PacketHeader decoded_audio;
+    NS_TEST_ASSERT_MSG_EQ(RoundTrip(audio, &context, &decoded_audio), first_size + 1, "wrong stream ID size");
+    NS_TEST_ASSERT_MSG_EQ(decoded_audio.m_stream_id, 1u, "wrong stream ID");
+    NS_TEST_ASSERT_MSG_EQ(decoded_audio.PicIndex, audio.PicIndex, "wrong PicIndex");
+
+    // Its frames do not shadow those of the video.
+    PacketHeader video = second;
+    video.m_packet_seq = 100006;
+    video.PicCurPktSeq = 2;
+    PacketHeader decoded_video;
+    RoundTrip(video, &context, &decoded_video);
+    NS_TEST_ASSERT_MSG_EQ(decoded_video.m_stream_id, 0u, "wrong stream ID");
+    NS_TEST_ASSERT_MSG_EQ(decoded_video.PicDataLen, first.PicDataLen, "metadata of another stream restored");
+    context.RemoveFramesBefore(1, 601);
+    video.m_packet_seq = 100007;
+    video.PicCurPktSeq = 3;
+    RoundTrip(video, &context, &decoded_video);
+    NS_TEST_ASSERT_MSG_EQ(decoded_video.m_has_frame_metadata, true, "frames of another stream removed");
+}
@@ -0,0 +1,79 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "../model/packet-time-ring.h"
+#include "../model/received-packet-manager.h"
+
+// An essential include is test.h
+#include "ns3/test.h"
+
+// Do not put your test classes in namespace ns3.  You may find it useful
+// to use the using directive to access the ns3 namespace directly
+using namespace ns3;
+using namespace ns3::bbr;
+
+class PacketTimeRingTestCase : public TestCase
+{
+  public:
+    PacketTimeRingTestCase();
+    virtual ~PacketTimeRingTestCase() {}
+
+  private:
+    virtual void DoRun(void);
+};
+
+PacketTimeRingTestCase::PacketTimeRingTestCase()
+    : TestCase("ack receive timestamp ring and sampling")
+{
+}
+
+void PacketTimeRingTestCase::DoRun(void)
+{
+    PacketTimeRing ring(3);
+    PacketTimeVector times;
+    for (PacketNumber packet_number = 1; packet_number <= 5; ++packet_number)
+    {
+        ring.Push(packet_number, packet_number * 1000);
+    }
+    NS_TEST_ASSERT_MSG_EQ(ring.size(), 3u, "ring grew past its capacity");
+    ring.CopyTo(&times);
+    NS_TEST_ASSERT_MSG_EQ(times.front().first, 3u, "oldest entries not overwritten");
+    NS_TEST_ASSERT_MSG_EQ(times.back().second, 5000u, "wrong newest entry");
+    ring.RemoveBefore(5);
+    NS_TEST_ASSERT_MSG_EQ(ring.size(), 1u, "old entries not expired");
+    ring.Clear();
+    NS_TEST_ASSERT_MSG_EQ(ring.empty(), true, "ring not cleared");
+
+    // Every received packet, bounded by the capacity.
+    ReceivedPacketManager manager;
+    manager.set_max_ack_timestamps(4);
+    PacketHeader header;
+    for (PacketNumber packet_number = 1; packet_number <= 10; ++packet_number)
+    {
+        header.m_packet_seq = packet_number;
+        manager.RecordPacketReceived(header, packet_number * 1000);
+    }
+    const AckFrame *ack = manager.GetUpdatedAckFrame(11000);
+    NS_TEST_ASSERT_MSG_EQ(ack->received_packet_times.size(), 4u, "timestamps not bounded");
+    NS_TEST_ASSERT_MSG_EQ(ack->received_packet_times.front().first, 7u, "newest timestamps not kept");
+
+    // One packet in three.
+    manager.set_ack_timestamp_policy(kAckTimestampsEveryNth, 3);
+    for (PacketNumber packet_number = 11; packet_number <= 19; ++packet_number)
+    {
+        header.m_packet_seq = packet_number;
+        manager.RecordPacketReceived(header, packet_number * 1000);
+    }
+    ack = manager.GetUpdatedAckFrame(20000);
+    NS_TEST_ASSERT_MSG_EQ(ack->received_packet_times.size(), 3u, "wrong sampled timestamps");
+    NS_TEST_ASSERT_MSG_EQ(ack->received_packet_times.front().first, 13u, "wrong sampled packet");
+
+    // The largest only, a reordered packet is not reported.
+    manager.set_ack_timestamp_policy(kAckTimestampsLargest, 1);
+    header.m_packet_seq = 22;
+    manager.RecordPacketReceived(header, 22000);
+    header.m_packet_seq = 21;
+    manager.RecordPacketReceived(header, 22100);
+    ack = manager.GetUpdatedAckFrame(23000);
+    NS_TEST_ASSERT_MSG_EQ(ack->received_packet_times.size(), 1u, "more than the largest reported");
+    NS_TEST_ASSERT_MSG_EQ(ack->received_packet_times.front().first, 22u, "largest not reported");
+}
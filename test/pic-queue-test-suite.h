@@ -0,0 +1,82 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "../model/pic-queue.h"
+
+// An essential include is test.h
+#include "ns3/test.h"
+
+// Do not put your test classes in namespace ns3.  You may find it useful
+// to use the using directive to access the ns3 namespace directly
+using namespace ns3;
+using namespace ns3::bbr;
+
+class PicQueueTestCase : public TestCase
+{
+  public:
+    PicQueueTestCase();
+    virtual ~PicQueueTestCase() {}
+
+  private:
+    virtual void DoRun(void);
+};
+
+PicQueueTestCase::PicQueueTestCase()
+    : TestCase("pic queue packet cursor and layer dropping")
+{
+}
+
+void PicQueueTestCase::DoRun(void)
+{
+    PicQueue queue;
+    // Enough frames to wrap and grow the ring.
+    for (PacketNumber seq = 0; seq < 20; ++seq)
+    {
+        PicData pic;
+        pic.PicSeq = seq;
+        pic.PicDataLen = 3000;
+        pic.PicPktNum = 3;
+        pic.PicCurPktSeq = 0;
+        pic.PicLastPktLen = 3000 - 2 * DEFAULT_PAYLOAD_SIZE;
+        queue.Push(pic);
+        if (seq % 2 == 0)
+        {
+            queue.PopFront();
+        }
+    }
+    NS_TEST_ASSERT_MSG_EQ(queue.size(), 10u, "wrong queue size");
+    NS_TEST_ASSERT_MSG_EQ(queue.front().PicSeq, 10u, "frames out of order");
+
+    PicData &pic = queue.front();
+    NS_TEST_ASSERT_MSG_EQ(PicQueue::GetPacketLength(pic, 0), DEFAULT_PAYLOAD_SIZE, "wrong packet length");
+    NS_TEST_ASSERT_MSG_EQ(PicQueue::GetPacketLength(pic, 2), 200u, "wrong last packet length");
+    ++pic.PicCurPktSeq;
+    NS_TEST_ASSERT_MSG_EQ(PicQueue::GetUnsentPackets(pic), 2u, "wrong unsent packets");
+    NS_TEST_ASSERT_MSG_EQ(PicQueue::GetUnsentBytes(pic), 1600u, "wrong unsent bytes");
+
+    while (!queue.empty())
+    {
+        queue.PopFront();
+    }
+
+    // Enhancement layers are only dropped from frames not started yet.
+    PicData layered;
+    layered.PicSeq = 20;
+    layered.PicCurPktSeq = 0;
+    layered.PicNumLayers = 2;
+    layered.PicLayerEnd[0] = 1500;
+    layered.PicLayerEnd[1] = 4000;
+    PicQueue::SetDataLen(&layered, 4000);
+    NS_TEST_ASSERT_MSG_EQ(layered.PicPktNum, 3u, "wrong packet count");
+    queue.Push(layered);
+    layered.PicSeq = 21;
+    queue.Push(layered);
+    ++queue.front().PicCurPktSeq;
+    NS_TEST_ASSERT_MSG_EQ(queue.DropLayers(1), 2500u, "wrong bytes dropped");
+    NS_TEST_ASSERT_MSG_EQ(queue.front().PicNumLayers, 2u, "layer dropped from a started frame");
+    queue.PopFront();
+    NS_TEST_ASSERT_MSG_EQ(queue.front().PicNumLayers, 1u, "layer not dropped");
+    NS_TEST_ASSERT_MSG_EQ(queue.front().PicDataLen, 1500u, "wrong frame length");
+    NS_TEST_ASSERT_MSG_EQ(queue.front().PicPktNum, 2u, "wrong frame packet count");
+    NS_TEST_ASSERT_MSG_EQ(PicQueue::GetPacketLength(queue.front(), 1), 100u, "wrong last packet length");
+    NS_TEST_ASSERT_MSG_EQ(queue.DropLayers(1), 0u, "base layer dropped");
+}
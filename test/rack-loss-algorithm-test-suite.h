@@ -0,0 +1,79 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "../model/rack-loss-algorithm.h"
+#include "../model/unacked-packet-map.h"
+#include "../model/packet-header.h"
+#include "../model/rtt-stats.h"
+
+// An essential include is test.h
+#include "ns3/test.h"
+
+// Do not put your test classes in namespace ns3.  You may find it useful
+// to use the using directive to access the ns3 namespace directly
+using namespace ns3;
+using namespace ns3::bbr;
+
+class RackLossAlgorithmTestCase : public TestCase
+{
+  public:
+    RackLossAlgorithmTestCase();
+    virtual ~RackLossAlgorithmTestCase() {}
+
+  private:
+    virtual void DoRun(void);
+};
+
+RackLossAlgorithmTestCase::RackLossAlgorithmTestCase()
+    : TestCase("rack loss detection and reordering window")
+{
+}
+
+void RackLossAlgorithmTestCase::DoRun(void)
+{
+    UnackedPacketMap unacked_packets;
+    RttStats rtt_stats;
+    RackLossAlgorithm rack;
+    SendAlgorithmInterface::CongestionVector lost;
+
+    // Packet n is sent at 1000 + n.
+    for (PacketNumber packet_number = 1; packet_number <= 10; ++packet_number)
+    {
+        PacketHeader header;
+        header.m_packet_seq = packet_number;
+        header.m_data_length = 1000;
+        header.m_sent_time = 1000 + packet_number;
+        header.m_data_packet = std::make_shared<PicDataPacket>();
+        unacked_packets.AddSentPacket(header, 0, NOT_RETRANSMISSION, header.m_sent_time, true);
+    }
+    rtt_stats.UpdateRtt(100, 0, 1110);
+    NS_TEST_ASSERT_MSG_EQ(rack.GetReorderingWindow(rtt_stats), 25u, "reordering window is not min_rtt / 4");
+
+    // Packet 10 is delivered first; nothing has been outstanding for longer
+    // than rtt + reordering window yet.
+    unacked_packets.RemoveFromInFlight(10);
+    rack.DetectLosses(unacked_packets, 1110, rtt_stats, 10, &lost);
+    NS_TEST_ASSERT_MSG_EQ(lost.size(), 0u, "lost packets within the reordering window");
+    NS_TEST_ASSERT_MSG_EQ(rack.GetLossTimeout(), 1126u, "loss timeout is not set for packet 1");
+
+    // Packets sent at or before 1005 have expired by 1130.
+    rack.DetectLosses(unacked_packets, 1130, rtt_stats, 10, &lost);
+    NS_TEST_ASSERT_MSG_EQ(lost.size(), 5u, "wrong number of lost packets");
+    NS_TEST_ASSERT_MSG_EQ(lost.back().first, 5u, "wrong largest lost packet");
+    NS_TEST_ASSERT_MSG_EQ(rack.GetLossTimeout(), 1131u, "loss timeout is not set for packet 6");
+    NS_TEST_ASSERT_MSG_EQ(rack.first_in_flight_cursor(), 6u, "cursor did not move past lost packets");
+    for (const auto &packet : lost)
+    {
+        unacked_packets.RemoveFromInFlight(packet.first);
+    }
+
+    // A spurious loss widens the window once per round trip.
+    rack.SpuriousRetransmitDetected(unacked_packets, 1140, rtt_stats, 3);
+    rack.SpuriousRetransmitDetected(unacked_packets, 1140, rtt_stats, 4);
+    NS_TEST_ASSERT_MSG_EQ(rack.reordering_window_multiplier(), 2u, "window widened more than once");
+    NS_TEST_ASSERT_MSG_EQ(rack.GetReorderingWindow(rtt_stats), 50u, "reordering window did not grow");
+
+    lost.clear();
+    rack.DetectLosses(unacked_packets, 1150, rtt_stats, 10, &lost);
+    NS_TEST_ASSERT_MSG_EQ(lost.size(), 0u, "lost packets within the widened window");
+    NS_TEST_ASSERT_MSG_EQ(rack.GetLossTimeout(), 1156u, "loss timeout ignores the widened window");
+}
@@ -0,0 +1,78 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "../model/send-scheduler.h"
+#include "../model/udp-bbr-constants.h"
+
+// An essential include is test.h
+#include "ns3/test.h"
+
+// Do not put your test classes in namespace ns3.  You may find it useful
+// to use the using directive to access the ns3 namespace directly
+using namespace ns3;
+using namespace ns3::bbr;
+
+class SendSchedulerTestCase : public TestCase
+{
+  public:
+    SendSchedulerTestCase();
+    virtual ~SendSchedulerTestCase() {}
+
+  private:
+    virtual void DoRun(void);
+};
+
+SendSchedulerTestCase::SendSchedulerTestCase()
+    : TestCase("send scheduler priority order, weighted shares and deadlines")
+{
+}
+
+void SendSchedulerTestCase::DoRun(void)
+{
+    SendScheduler scheduler;
+    bool backlogged[kNumSendPriorities] = {false};
+    ProtocolSendPriority priority;
+
+    NS_TEST_ASSERT_MSG_EQ(scheduler.SelectNext(backlogged, &priority), false, "nothing to send");
+
+    // Strict priority always serves the most urgent class.
+    backlogged[kPriorityRetransmission] = true;
+    backlogged[kPriorityFreshData] = true;
+    for (int i = 0; i < 10; ++i)
+    {
+        NS_TEST_ASSERT_MSG_EQ(scheduler.SelectNext(backlogged, &priority), true, "no class picked");
+        NS_TEST_ASSERT_MSG_EQ(priority, kPriorityRetransmission, "retransmission not first");
+        scheduler.OnPacketSent(priority, kMaxPacketSize);
+    }
+    backlogged[kPriorityKeyFrame] = true;
+    scheduler.SelectNext(backlogged, &priority);
+    NS_TEST_ASSERT_MSG_EQ(priority, kPriorityKeyFrame, "keyframe not first");
+
+    // Weighted priority shares the bytes by weight, 3:1 here.
+    scheduler.set_mode(kWeightedPriority);
+    scheduler.set_weight(kPriorityRetransmission, 1);
+    scheduler.set_weight(kPriorityFreshData, 3);
+    backlogged[kPriorityKeyFrame] = false;
+    ByteCount sent[kNumSendPriorities] = {0};
+    for (int i = 0; i < 400; ++i)
+    {
+        scheduler.SelectNext(backlogged, &priority);
+        sent[priority] += kMaxPacketSize;
+        scheduler.OnPacketSent(priority, kMaxPacketSize);
+    }
+    NS_TEST_ASSERT_MSG_EQ(sent[kPriorityRetransmission], 100 * kMaxPacketSize, "wrong retransmission share");
+    NS_TEST_ASSERT_MSG_EQ(sent[kPriorityFreshData], 300 * kMaxPacketSize, "wrong fresh data share");
+    NS_TEST_ASSERT_MSG_EQ(sent[kPriorityFecRepair], 0u, "idle class served");
+
+    // A weight of zero still gets served.
+    scheduler.set_weight(kPriorityRetransmission, 0);
+    NS_TEST_ASSERT_MSG_EQ(scheduler.weight(kPriorityRetransmission), 1u, "zero weight kept");
+
+    // Deadlines are relative to the frame's generation time.
+    NS_TEST_ASSERT_MSG_EQ(scheduler.IsWithinDeadline(kPriorityFecRepair, 1000, 1000000), true,
+                          "no deadline enforced");
+    scheduler.set_deadline(kPriorityFecRepair, 100);
+    NS_TEST_ASSERT_MSG_EQ(scheduler.IsWithinDeadline(kPriorityFecRepair, 1000, 1099), true,
+                          "dropped before the deadline");
+    NS_TEST_ASSERT_MSG_EQ(scheduler.IsWithinDeadline(kPriorityFecRepair, 1000, 1100), false,
+                          "sent past the deadline");
+}
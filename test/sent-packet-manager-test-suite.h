@@ -0,0 +1,406 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "../model/sent-packet-manager.h"
+#include "../model/packet-header.h"
+#include "../model/rtt-stats.h"
+
+// An essential include is test.h
+#include "ns3/test.h"
+
+// Do not put your test classes in namespace ns3.  You may find it useful
+// to use the using directive to access the ns3 namespace directly
+using namespace ns3;
+using namespace ns3::bbr;
+
+namespace
+{
+// Sends a 1000 byte retransmittable packet.
+void SendTestPacket(SentPacketManager *manager, PacketNumber packet_number, uint64_t sent_time)
+{
+    PacketHeader header;
+    header.m_packet_seq = packet_number;
+    header.m_data_length = 1000;
+    header.m_sent_time = sent_time;
+    header.m_data_packet = std::make_shared<PicDataPacket>();
+    header.m_data_packet->data_length = 1000;
+    manager->OnPacketSent(header, 0, sent_time, NOT_RETRANSMISSION, HAS_RETRANSMITTABLE_DATA);
+}
+
+// Sends a 1000 byte packet of frame |pic_index|, generated at |gen_time|.
+void SendFrameTestPacket(SentPacketManager *manager, PacketNumber packet_number, uint64_t sent_time,
+                         PacketNumber pic_index, uint64_t gen_time)
+{
+    PacketHeader header;
+    header.m_packet_seq = packet_number;
+    header.m_data_length = 1000;
+    header.m_sent_time = sent_time;
+    header.m_data_packet = std::make_shared<PicDataPacket>();
+    header.m_data_packet->data_length = 1000;
+    header.m_data_packet->PicIndex = pic_index;
+    header.m_data_packet->PicGenTime = gen_time;
+    manager->OnPacketSent(header, 0, sent_time, NOT_RETRANSMISSION, HAS_RETRANSMITTABLE_DATA);
+}
+
+// Sends the next pending retransmission as |packet_number|, and returns the
+// packet it retransmits.
+PacketNumber RetransmitTestPacket(SentPacketManager *manager, PacketNumber packet_number, uint64_t sent_time)
+{
+    PacketHeader header = manager->NextPendingRetransmission();
+    header.m_packet_seq = packet_number;
+    header.m_sent_time = sent_time;
+    manager->OnPacketSent(header, header.m_old_packet_seq, sent_time,
+                          header.m_transmission_type, HAS_RETRANSMITTABLE_DATA);
+    return header.m_old_packet_seq;
+}
+
+// Acks every packet in [1, largest_observed] except those in |missing|.
+void AckTestPackets(SentPacketManager *manager, PacketNumber largest_observed,
+                    const std::vector<PacketNumber> &missing, uint64_t receive_time,
+                    Bandwidth delivery_rate = Bandwidth::Zero())
+{
+    AckFrame ack_frame;
+    ack_frame.largest_observed = largest_observed;
+    ack_frame.ack_delay_time = 0;
+    ack_frame.delivery_rate = delivery_rate;
+    PacketNumber lower = 1;
+    for (PacketNumber packet_number : missing)
+    {
+        if (lower < packet_number)
+        {
+            ack_frame.packets.Add(lower, packet_number);
+        }
+        lower = packet_number + 1;
+    }
+    ack_frame.packets.Add(lower, largest_observed + 1);
+    manager->OnIncomingAck(ack_frame, receive_time);
+}
+}
+
+class SentPacketManagerSwitchTestCase : public TestCase
+{
+  public:
+    SentPacketManagerSwitchTestCase();
+    virtual ~SentPacketManagerSwitchTestCase() {}
+
+  private:
+    virtual void DoRun(void);
+};
+
+SentPacketManagerSwitchTestCase::SentPacketManagerSwitchTestCase()
+    : TestCase("sent packet manager switches controller and keeps the path model")
+{
+}
+
+void SentPacketManagerSwitchTestCase::DoRun(void)
+{
+    ConnectionStats stats;
+    SentPacketManager manager(&stats, kBBR, kRack);
+    NS_TEST_ASSERT_MSG_EQ(manager.GetControllerPolicy().controller_for_path_class(kPathBufferbloat), kBBR,
+                          "bufferbloat mapped to a queue-filling controller");
+    manager.SetBandwidthResumption(true);
+
+    // One packet every 10ms, each acked 100ms later.
+    for (PacketNumber packet_number = 1; packet_number <= 20; ++packet_number)
+    {
+        SendTestPacket(&manager, packet_number, 1000 + 10 * packet_number);
+        if (packet_number > 10)
+        {
+            const PacketNumber acked = packet_number - 10;
+            AckTestPackets(&manager, acked, std::vector<PacketNumber>(), 1100 + 10 * acked);
+        }
+    }
+    const Bandwidth bandwidth = manager.BandwidthEstimate();
+    NS_TEST_ASSERT_MSG_EQ(bandwidth.IsZero(), false, "no bandwidth estimate before the switch");
+    NS_TEST_ASSERT_MSG_EQ(manager.GetRttStats()->min_rtt(), 100, "wrong min_rtt before the switch");
+
+    NS_TEST_ASSERT_MSG_EQ(manager.SwitchSendAlgorithm(kCubicBytes), false, "switched to a controller that is not built");
+    NS_TEST_ASSERT_MSG_EQ(manager.SwitchSendAlgorithm(kRenoBytes), true, "did not switch to Reno");
+    NS_TEST_ASSERT_MSG_EQ(manager.GetSendAlgorithm()->GetCongestionControlType(), kRenoBytes, "Reno is not in use");
+    NS_TEST_ASSERT_MSG_EQ(stats.congestion_control_switches, 1u, "switch not counted");
+    NS_TEST_ASSERT_MSG_EQ(manager.GetRttStats()->min_rtt(), 100, "min_rtt lost on the switch");
+    NS_TEST_ASSERT_MSG_EQ_TOL(manager.GetSendAlgorithm()->GetCongestionWindow(), bandwidth.ToBytesPerPeriod(100), 1u,
+                              "Reno did not start from the bandwidth-delay product");
+    NS_TEST_ASSERT_MSG_EQ_TOL(manager.BandwidthEstimate().ToBitsPerSecond(), bandwidth.ToBitsPerSecond(), 100,
+                              "bandwidth lost on the switch");
+    NS_TEST_ASSERT_MSG_EQ(manager.InSlowStart(), false, "Reno slow starts past the known bandwidth");
+
+    // And back, without going through STARTUP again from scratch.
+    const Bandwidth reno_bandwidth = manager.BandwidthEstimate();
+    NS_TEST_ASSERT_MSG_EQ(manager.SwitchSendAlgorithm(kBBR), true, "did not switch back to BBR");
+    NS_TEST_ASSERT_MSG_EQ(stats.congestion_control_switches, 2u, "switch back not counted");
+    NS_TEST_ASSERT_MSG_EQ(manager.BandwidthEstimate(), reno_bandwidth, "bandwidth lost on the switch back");
+    NS_TEST_ASSERT_MSG_EQ(manager.GetRttStats()->min_rtt(), 100, "min_rtt lost on the switch back");
+}
+
+class SentPacketManagerPtoTestCase : public TestCase
+{
+  public:
+    SentPacketManagerPtoTestCase();
+    virtual ~SentPacketManagerPtoTestCase() {}
+
+  private:
+    virtual void DoRun(void);
+};
+
+SentPacketManagerPtoTestCase::SentPacketManagerPtoTestCase()
+    : TestCase("sent packet manager probe timeout and persistent congestion")
+{
+}
+
+void SentPacketManagerPtoTestCase::DoRun(void)
+{
+    ConnectionStats stats;
+    SentPacketManager manager(&stats, kBBR, kRack);
+    NS_TEST_ASSERT_MSG_EQ(manager.UsePto(), true, "probe timeout is not the default");
+    AckFrequencyFrame ack_frequency;
+    manager.GetAckFrequency(&ack_frequency);
+    NS_TEST_ASSERT_MSG_EQ(ack_frequency.reordering_threshold, 0u, "reordering threshold sent with RACK");
+
+    // srtt 100, mean deviation 50: PTO = 100 + 4 * 50 + max ack delay.
+    SendTestPacket(&manager, 1, 1000);
+    AckTestPackets(&manager, 1, std::vector<PacketNumber>(), 1100);
+    const uint64_t pto = 100 + 200 + kMaxDelayedAckTimeMs;
+    for (PacketNumber packet_number = 2; packet_number <= 9; ++packet_number)
+    {
+        SendTestPacket(&manager, packet_number, 1200 + 10 * (packet_number - 2));
+    }
+    const ByteCount bytes_in_flight = manager.GetBytesInFlight();
+    NS_TEST_ASSERT_MSG_EQ(manager.GetRetransmissionTime(), 1270 + pto, "PTO is not armed from the last packet sent");
+
+    // The first timeout owes two probes and declares nothing lost.
+    manager.OnRetransmissionTimeout();
+    NS_TEST_ASSERT_MSG_EQ(stats.pto_count, 1u, "probe timeout not counted");
+    NS_TEST_ASSERT_MSG_EQ(manager.GetConsecutivePtoCount(), 1u, "wrong consecutive PTO count");
+    NS_TEST_ASSERT_MSG_EQ(manager.HasPendingProbes(), true, "no probes owed");
+    NS_TEST_ASSERT_MSG_EQ(manager.MaybeRetransmitTailLossProbe(), false, "tail loss probe sent in PTO mode");
+    NS_TEST_ASSERT_MSG_EQ(manager.HasPendingRetransmissions(), false, "PTO queued a retransmission");
+    NS_TEST_ASSERT_MSG_EQ(stats.packets_lost, 0u, "PTO declared packets lost");
+    NS_TEST_ASSERT_MSG_EQ(manager.GetBytesInFlight(), bytes_in_flight, "PTO removed packets from flight");
+
+    // Without new data, the oldest packets go out as the probes.
+    PacketNumber next_packet_number = 10;
+    for (size_t probe = 0; probe < kPtoProbePackets; ++probe)
+    {
+        NS_TEST_ASSERT_MSG_EQ(manager.MaybeRetransmitOldestPacketAsProbe(), true, "no probe queued");
+        NS_TEST_ASSERT_MSG_EQ(RetransmitTestPacket(&manager, next_packet_number++, 1600), 2 + probe,
+                              "probe is not the oldest packet");
+    }
+    NS_TEST_ASSERT_MSG_EQ(manager.HasPendingProbes(), false, "probes still owed");
+    NS_TEST_ASSERT_MSG_EQ(manager.MaybeRetransmitOldestPacketAsProbe(), false, "more probes than owed");
+
+    // The second timeout backs off to twice the PTO, still without loss.
+    NS_TEST_ASSERT_MSG_EQ(manager.GetRetransmissionTime(), 1600 + 2 * pto, "PTO did not back off");
+    manager.OnRetransmissionTimeout();
+    NS_TEST_ASSERT_MSG_EQ(manager.GetConsecutivePtoCount(), 2u, "wrong consecutive PTO count");
+    NS_TEST_ASSERT_MSG_EQ(stats.packets_lost, 0u, "backoff declared packets lost");
+    SendTestPacket(&manager, next_packet_number++, 2250);
+    SendTestPacket(&manager, next_packet_number++, 2300);
+    NS_TEST_ASSERT_MSG_EQ(manager.GetRetransmissionTime(), 2300 + 4 * pto, "PTO did not back off twice");
+
+    // Only the last probe gets through: everything sent from 1200 to 2250
+    // is lost, which spans more than three PTOs.
+    const PacketNumber largest = next_packet_number - 1;
+    std::vector<PacketNumber> missing;
+    for (PacketNumber packet_number = 2; packet_number < largest; ++packet_number)
+    {
+        missing.push_back(packet_number);
+    }
+    AckTestPackets(&manager, largest, missing, 2400);
+    NS_TEST_ASSERT_MSG_EQ(manager.GetConsecutivePtoCount(), 0u, "ack did not reset the backoff");
+    NS_TEST_ASSERT_MSG_EQ(stats.persistent_congestion_count, 1u, "persistent congestion not declared");
+    NS_TEST_ASSERT_MSG_EQ(manager.GetSendAlgorithm()->GetCongestionWindow(), 4 * kDefaultTCPMSS,
+                          "persistent congestion did not collapse the window");
+}
+
+class SentPacketManagerPtoExpiredTestCase : public TestCase
+{
+  public:
+    SentPacketManagerPtoExpiredTestCase();
+    virtual ~SentPacketManagerPtoExpiredTestCase() {}
+
+  private:
+    virtual void DoRun(void);
+};
+
+SentPacketManagerPtoExpiredTestCase::SentPacketManagerPtoExpiredTestCase()
+    : TestCase("sent packet manager probe timeout with only expired data outstanding")
+{
+}
+
+void SentPacketManagerPtoExpiredTestCase::DoRun(void)
+{
+    ConnectionStats stats;
+    SentPacketManager manager(&stats, kBBR, kRack);
+    SendTestPacket(&manager, 1, 1000);
+    AckTestPackets(&manager, 1, std::vector<PacketNumber>(), 1100);
+    const uint64_t pto = 100 + 200 + kMaxDelayedAckTimeMs;
+
+    // Packets of an unreliable stream are expired as soon as they are sent.
+    for (PacketNumber packet_number = 2; packet_number <= 3; ++packet_number)
+    {
+        PacketHeader header;
+        header.m_packet_seq = packet_number;
+        header.m_data_length = 1000;
+        header.m_sent_time = 1200;
+        header.m_data_packet = std::make_shared<PicDataPacket>();
+        header.m_data_packet->data_length = 1000;
+        header.m_data_packet->reliability = kUnreliable;
+        manager.OnPacketSent(header, 0, 1200, NOT_RETRANSMISSION, HAS_RETRANSMITTABLE_DATA);
+    }
+    NS_TEST_ASSERT_MSG_EQ(manager.GetRetransmissionTime(), 1200 + pto, "PTO not armed");
+
+    // The timeout owes probes, but there is nothing to probe with: the
+    // probes are dropped, pacing resumes and the PTO is armed again.
+    manager.OnRetransmissionTimeout();
+    NS_TEST_ASSERT_MSG_EQ(manager.HasPendingProbes(), true, "no probes owed");
+    NS_TEST_ASSERT_MSG_EQ(manager.TimeUntilSend(1600), 0u, "probes paced");
+    NS_TEST_ASSERT_MSG_EQ(manager.MaybeRetransmitOldestPacketAsProbe(), false, "expired packet used as a probe");
+    NS_TEST_ASSERT_MSG_EQ(manager.HasPendingProbes(), false, "probes owed without data to probe with");
+    NS_TEST_ASSERT_MSG_EQ(manager.GetRetransmissionTime(), 1200 + 2 * pto, "PTO not armed again");
+}
+
+class SentPacketManagerUndoTestCase : public TestCase
+{
+  public:
+    SentPacketManagerUndoTestCase();
+    virtual ~SentPacketManagerUndoTestCase() {}
+
+  private:
+    virtual void DoRun(void);
+};
+
+SentPacketManagerUndoTestCase::SentPacketManagerUndoTestCase()
+    : TestCase("sent packet manager undoes recovery once every loss proved spurious")
+{
+}
+
+void SentPacketManagerUndoTestCase::DoRun(void)
+{
+    ConnectionStats stats;
+    // Packet threshold loss detection, so reordering by three is a loss.
+    SentPacketManager manager(&stats, kBBR, kNack);
+    AckFrequencyFrame ack_frequency;
+    manager.GetAckFrequency(&ack_frequency);
+    NS_TEST_ASSERT_MSG_EQ(ack_frequency.reordering_threshold, GeneralLossAlgorithm::kNumberOfNacksBeforeRetransmission,
+                          "wrong reordering threshold with packet threshold loss detection");
+    for (PacketNumber packet_number = 1; packet_number <= 12; ++packet_number)
+    {
+        SendTestPacket(&manager, packet_number, 1000 + packet_number);
+    }
+    AckTestPackets(&manager, 3, std::vector<PacketNumber>(), 1103);
+    const ByteCount congestion_window = manager.GetSendAlgorithm()->GetCongestionWindow();
+
+    // 4 and 6 arrive late and are declared lost.
+    std::vector<PacketNumber> missing;
+    missing.push_back(4);
+    missing.push_back(6);
+    AckTestPackets(&manager, 10, missing, 1110);
+    NS_TEST_ASSERT_MSG_EQ(stats.packets_lost, 2u, "reordered packets not declared lost");
+    NS_TEST_ASSERT_MSG_EQ(manager.GetSendAlgorithm()->InRecovery(), true, "loss did not start recovery");
+    NS_TEST_ASSERT_MSG_EQ(manager.HasPendingRetransmissions(), true, "losses not queued for retransmission");
+
+    // A late ack of 4 alone proves only its own loss spurious: 6 is still
+    // retransmitted and recovery goes on.
+    missing.erase(missing.begin());
+    AckTestPackets(&manager, 10, missing, 1111);
+    NS_TEST_ASSERT_MSG_EQ(stats.loss_recoveries_undone, 0u, "recovery undone before every loss proved spurious");
+    NS_TEST_ASSERT_MSG_EQ(manager.GetSendAlgorithm()->InRecovery(), true, "recovery left early");
+    NS_TEST_ASSERT_MSG_EQ(manager.HasPendingRetransmissions(), true, "unproven loss not retransmitted");
+    NS_TEST_ASSERT_MSG_EQ(manager.NextPendingRetransmission().m_old_packet_seq, 6u, "wrong retransmission pending");
+
+    // Acking 6 as well undoes the recovery.
+    AckTestPackets(&manager, 12, std::vector<PacketNumber>(), 1112);
+    NS_TEST_ASSERT_MSG_EQ(stats.loss_recoveries_undone, 1u, "undo not counted");
+    NS_TEST_ASSERT_MSG_EQ(manager.GetSendAlgorithm()->InRecovery(), false, "still in recovery after the undo");
+    NS_TEST_ASSERT_MSG_EQ(manager.HasPendingRetransmissions(), false, "spurious retransmission still pending");
+    NS_TEST_ASSERT_MSG_EQ(manager.GetSendAlgorithm()->GetCongestionWindow() >= congestion_window, true,
+                          "congestion window not restored");
+}
+
+class SentPacketManagerStartupTestCase : public TestCase
+{
+  public:
+    SentPacketManagerStartupTestCase();
+    virtual ~SentPacketManagerStartupTestCase() {}
+
+  private:
+    virtual void DoRun(void);
+};
+
+SentPacketManagerStartupTestCase::SentPacketManagerStartupTestCase()
+    : TestCase("BBR startup reaches full bandwidth with a lagging peer delivery rate")
+{
+}
+
+void SentPacketManagerStartupTestCase::DoRun(void)
+{
+    ConnectionStats stats;
+    SentPacketManager manager(&stats, kBBR, kNack);
+    // One packet per ms over an 8Mbps path with a 100ms RTT, while the peer
+    // still reports the 1Mbps it measured early on.
+    const Bandwidth delivery_rate = Bandwidth::FromKBitsPerSecond(1000);
+    for (PacketNumber packet_number = 1; packet_number <= 2000 && manager.InSlowStart(); ++packet_number)
+    {
+        SendTestPacket(&manager, packet_number, 1000 + packet_number);
+        if (packet_number > 100)
+        {
+            const PacketNumber acked = packet_number - 100;
+            AckTestPackets(&manager, acked, std::vector<PacketNumber>(), 1100 + acked, delivery_rate);
+        }
+    }
+    NS_TEST_ASSERT_MSG_EQ(manager.InSlowStart(), false, "STARTUP did not reach full bandwidth");
+    NS_TEST_ASSERT_MSG_EQ_TOL(manager.BandwidthEstimate().ToKBitsPerSecond(), 8000, 400,
+                              "STARTUP capped by the peer's delivery rate");
+}
+
+class SentPacketManagerExpiryTestCase : public TestCase
+{
+  public:
+    SentPacketManagerExpiryTestCase();
+    virtual ~SentPacketManagerExpiryTestCase() {}
+
+  private:
+    virtual void DoRun(void);
+};
+
+SentPacketManagerExpiryTestCase::SentPacketManagerExpiryTestCase()
+    : TestCase("sent packet manager skips retransmissions of expired frames before serving them")
+{
+}
+
+void SentPacketManagerExpiryTestCase::DoRun(void)
+{
+    ConnectionStats stats;
+    SentPacketManager manager(&stats, kBBR, kNack);
+    // Frames 1 and 2 generated at 1000, frame 3 at 1050, two packets each.
+    for (PacketNumber packet_number = 1; packet_number <= 6; ++packet_number)
+    {
+        const PacketNumber pic_index = (packet_number + 1) / 2;
+        SendFrameTestPacket(&manager, packet_number, 1050 + packet_number, pic_index,
+                            pic_index < 3 ? 1000 : 1050);
+    }
+    SendTestPacket(&manager, 7, 1057);
+    SendTestPacket(&manager, 8, 1058);
+    std::vector<PacketNumber> missing;
+    missing.push_back(1);
+    missing.push_back(3);
+    missing.push_back(5);
+    AckTestPackets(&manager, 8, missing, 1100);
+    NS_TEST_ASSERT_MSG_EQ(manager.HasPendingRetransmissions(), true, "losses not queued for retransmission");
+
+    // The stream dropped frame 1 while fresh data was sent, so its
+    // retransmission is skipped even without a retransmission deadline.
+    manager.RecordExpiredFrame(0, 1, 0, 0);
+    NS_TEST_ASSERT_MSG_EQ(manager.DiscardNextRetransmissionIfExpired(1100, INFINITETIME), true,
+                          "retransmission of a dropped frame served");
+    // Frame 2 is 100ms old: kept without a deadline, cancelled past 100ms.
+    NS_TEST_ASSERT_MSG_EQ(manager.DiscardNextRetransmissionIfExpired(1100, INFINITETIME), false,
+                          "retransmission cancelled without a deadline");
+    NS_TEST_ASSERT_MSG_EQ(manager.DiscardNextRetransmissionIfExpired(1100, 100), true,
+                          "retransmission past its deadline served");
+    // Frame 3 is still current.
+    NS_TEST_ASSERT_MSG_EQ(manager.DiscardNextRetransmissionIfExpired(1100, 100), false,
+                          "retransmission of the current frame cancelled");
+    NS_TEST_ASSERT_MSG_EQ(manager.NextPendingRetransmission().m_old_packet_seq, 5u, "wrong retransmission pending");
+    NS_TEST_ASSERT_MSG_EQ(stats.frames_expired, 2u, "expired frames miscounted");
+}
@@ -48,4 +48,52 @@ VideoGeneratorTestCase::DoRun (void)
     NS_TEST_ASSERT_MSG_EQ(video_generator.GetN(), num - 1, "");
     NS_TEST_ASSERT_MSG_EQ(frame.m_type, IFrame, "");
     NS_TEST_ASSERT_MSG_EQ(frame.m_size, 130261, "");
-}
\ No newline at end of file
+}
+class GopCodecTestCase : public TestCase
+{
+  public:
+    GopCodecTestCase();
+    virtual ~GopCodecTestCase() {}
+
+  private:
+    virtual void DoRun(void);
+};
+
+GopCodecTestCase::GopCodecTestCase()
+    : TestCase("gop codec replays the clip with its frame types")
+{
+}
+
+void GopCodecTestCase::DoRun(void)
+{
+    VideoClipInfo *clip = VideoGenerator::GetBestClip(0, 0, 0, 0, 0);
+    std::shared_ptr<const VideoCodecs::TraceStore> store = VideoGenerator::GetClipStore(*clip);
+    NS_TEST_ASSERT_MSG_EQ((store == VideoGenerator::GetClipStore(*clip)), true, "clip store not shared");
+
+    // The frame types are those of the clip, and its rate is scaled.
+    VideoCodecs::GopCodec codec(store, clip->m_frame_rate);
+    codec.setTargetRate(2000000);
+    double bytes = 0;
+    for (size_t i = 0; i < clip->m_frame_array.size(); ++i)
+    {
+        const char type = clip->m_frame_array[i].m_type == IFrame ? 'I' : 'P';
+        NS_TEST_ASSERT_MSG_EQ(codec.getFrameType(), type, "wrong frame type");
+        ++codec;
+        bytes += codec->first.size();
+    }
+    NS_TEST_ASSERT_MSG_EQ_TOL(bytes * 8 * clip->m_frame_rate / clip->m_frame_array.size(), 2000000, 100000,
+                              "clip not scaled to the target rate");
+    NS_TEST_ASSERT_MSG_EQ(codec.getFrameType(), 'I', "clip does not loop");
+
+    // A GOP structure overrides the frame types, and starts anew at any frame.
+    codec.setGopStructure(12, 2);
+    codec.setStartFrame(100);
+    std::string types;
+    for (int i = 0; i < 13; ++i)
+    {
+        types += codec.getFrameType();
+        ++codec;
+    }
+    NS_TEST_ASSERT_MSG_EQ(types, "IBBPBBPBBPBBI", "wrong GOP structure");
+    NS_TEST_ASSERT_MSG_EQ_TOL(codec.getKeyFrameInterval(), 0.5, 1e-9, "wrong keyframe interval");
+}